@@ -5,6 +5,7 @@
 ## SPDX-License-Identifier: Apache-2.0
 ################################################################################
 import sys
+import warnings
 import torch
 
 try:
@@ -23,16 +24,173 @@ def is_available():
     except Exception:
         return False
 
-class MigratableMemory:
+class _HostAllocatorScope:
+    """Restores the CPU allocator that was in use on entry when it exits,
+    so that these context managers nest"""
+
+    def __enter__(self):
+        self.prev_allocator = current_host_allocator()
+        self._use()
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        restore_host_allocator(self.prev_allocator)
+
+class MigratableMemory(_HostAllocatorScope):
     """Use LBANNv2's allocator for the given device"""
 
+    def _use(self):
+        use_coherent_host_allocator()
+
+class CachingHostMemory(_HostAllocatorScope):
+    """Use LBANNv2's caching allocator for CPU allocations"""
+
+    def _use(self):
+        use_caching_host_allocator()
+
+class NumaMemory(_HostAllocatorScope):
+    """Use LBANNv2's NUMA-aware allocator with the given placement
+
+    ``policy`` is one of "local" (the allocating thread's node),
+    "interleave" (all online nodes) or "bind" (the given ``node``).
+    """
+
+    def __init__(self, policy="local", node=-1):
+        self.placement = (policy, node)
+
+    def __enter__(self):
+        self.prev_placement = set_numa_placement(*self.placement)
+        super().__enter__()
+
+    def _use(self):
+        use_numa_host_allocator()
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        super().__exit__(exc_type, exc_value, traceback)
+        set_numa_placement(*self.prev_placement)
+
+class ArenaScope:
+    """Carve CPU allocations out of LBANNv2's arena
+
+    When the outermost scope exits, the arena is reset wholesale.
+    Tensors allocated in the scope must not outlive it; any that do
+    are reported with a warning.
+    """
+
+    _depth = 0
+    _prev_allocator = None
+
     def __enter__(self):
-        use_mi300a_host_allocator()
+        begin_arena_scope()
+        if ArenaScope._depth == 0:
+            ArenaScope._prev_allocator = current_host_allocator()
+            use_arena_host_allocator()
+        ArenaScope._depth += 1
 
     def __exit__(self, exc_type, exc_value, traceback):
-        use_pytorch_host_allocator()
+        ArenaScope._depth -= 1
+        if ArenaScope._depth == 0:
+            restore_host_allocator(ArenaScope._prev_allocator)
+            ArenaScope._prev_allocator = None
+        outliving = end_arena_scope()
+        if outliving:
+            warnings.warn(f"{outliving} tensor(s) allocated in an "
+                          "ArenaScope outlived it")
+
+class FileBackedMemory(_HostAllocatorScope):
+    """Use LBANNv2's file-backed allocator for CPU allocations
+
+    Each tensor's storage is a memory-mapped (sparse, unlinked) file
+    in ``directory``, which should be on fast local storage. Use
+    ``mmap_advise`` to hint at how the tensors will be accessed.
+    """
+
+    def __init__(self, directory=None):
+        self.directory = directory
+
+    def _use(self):
+        use_mmap_file_host_allocator(self.directory)
+
+class SharedHostMemory(_HostAllocatorScope):
+    """Use LBANNv2's shared-memory allocator for CPU allocations
+
+    Tensors allocated in this context can be passed to other processes
+    (e.g., from DataLoader workers) without copying: ``share_tensor``
+    makes a small picklable handle, which ``open_shared_tensor`` turns
+    back into a tensor using the same memory.
+    """
+
+    def __init__(self, segment_size=None):
+        self.segment_size = segment_size
+
+    def _use(self):
+        use_shm_host_allocator(self.segment_size)
+
+def share_tensor(t):
+    """Make a picklable handle to a tensor in shared memory
+
+    Each handle must be passed to ``open_shared_tensor`` exactly once.
+    """
+    return (shm_share(t), t.dtype, tuple(t.shape), tuple(t.stride()),
+            t.storage_offset())
+
+def open_shared_tensor(handle):
+    """Open a handle from ``share_tensor``, in any process"""
+    storage, dtype, shape, stride, offset = handle
+    data = shm_open(*storage)
+    return torch.empty(0, dtype=dtype).set_(
+        data.untyped_storage(), offset, shape, stride)
+
+def from_external(ptr, nbytes, dtype=torch.uint8, shape=None, owner=None,
+                  device="cpu"):
+    """Wrap ``nbytes`` of externally owned memory at address ``ptr``
+
+    The memory is not copied, but registered with LBANNv2, so the
+    tensor is treated like LBANNv2 memory. ``owner`` is kept alive
+    until the tensor's storage is freed.
+    """
+    t = wrap_external(ptr, nbytes, owner, torch.device(device)).view(dtype)
+    return t if shape is None else t.view(shape)
+
+def from_buffer(obj, dtype=torch.uint8, shape=None):
+    """Wrap the memory of a contiguous buffer (e.g., a numpy array,
+    an Arrow buffer or a ``SharedMemory.buf``) without copying
+
+    ``obj`` is kept alive until the tensor's storage is freed.
+    """
+    t = wrap_buffer(obj).view(dtype)
+    return t if shape is None else t.view(shape)
 
 
 def make_migratory_tensor(ctor, *args, **kwargs):
     with MigratableMemory():
         return ctor(*args, **kwargs)
+
+def migrate_module(module, device):
+    """Migrate a module's parameters, gradients and buffers in place
+
+    Everything goes through one ``migrate_many`` call, so each source
+    device is synchronized once rather than once per tensor. The
+    ``Parameter`` objects themselves are kept, so optimizers holding
+    them stay valid, and they stay leaves: their data and gradients
+    are detached before migrating. Returns the module.
+    """
+    device = torch.device(device)
+    params = list(module.parameters())
+    grads = [p for p in params if p.grad is not None]
+    buffers = [(mod, name) for mod in module.modules()
+               for name, b in mod._buffers.items() if b is not None]
+
+    migrated = migrate_many(
+        [p.detach() for p in params] + [p.grad.detach() for p in grads]
+        + [mod._buffers[name] for mod, name in buffers], device)
+
+    with torch.no_grad():
+        for p, t in zip(params, migrated):
+            p.data = t
+        migrated = migrated[len(params):]
+        for p, t in zip(grads, migrated):
+            p.grad = t
+        migrated = migrated[len(grads):]
+        for (mod, name), t in zip(buffers, migrated):
+            mod._buffers[name] = t
+    return module
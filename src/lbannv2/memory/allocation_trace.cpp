@@ -0,0 +1,344 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/allocation_trace.hpp"
+
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include <unistd.h>
+
+namespace
+{
+
+struct TraceHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t event_size;
+};
+
+std::int64_t now_ns() noexcept
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+std::uint32_t this_thread_id() noexcept
+{
+  static std::atomic<std::uint32_t> next_id = 0;
+  thread_local std::uint32_t const id = next_id++;
+  return id;
+}
+
+size_t page_size() noexcept
+{
+  static size_t const size = sysconf(_SC_PAGESIZE);
+  return size;
+}
+
+size_t resident_bytes()
+{
+  std::ifstream statm("/proc/self/statm");
+  size_t total = 0UL, resident = 0UL;
+  statm >> total >> resident;
+  return resident * page_size();
+}
+
+void stop_at_exit()
+{
+  lbannv2::AllocationTracer::instance().stop();
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+/** @brief A single-producer ring of events.
+ *
+ *  Only the owning thread pushes. Events are popped (written out)
+ *  under the tracer's file mutex, so there is at most one consumer at
+ *  a time.
+ */
+struct AllocationTracer::Ring
+{
+  static constexpr size_t kCapacity = 4096;
+
+  std::uint64_t generation;
+  std::atomic<std::uint64_t> head = 0;
+  std::atomic<std::uint64_t> tail = 0;
+  std::array<TraceEvent, kCapacity> events;
+};
+
+namespace
+{
+thread_local std::shared_ptr<AllocationTracer::Ring> t_ring;
+}  // namespace
+
+std::atomic<bool> AllocationTracer::s_enabled = false;
+
+void AllocationTracer::start(std::string const& path)
+{
+  std::lock_guard<std::mutex> lock(m_file_mtx);
+  LBANNV2_ASSERT(!m_file,
+                 std::runtime_error,
+                 "An allocation trace is already being recorded");
+
+  std::FILE* const file = std::fopen(path.c_str(), "wb");
+  LBANNV2_ASSERT(file,
+                 std::runtime_error,
+                 "Cannot open allocation trace \"" + path
+                   + "\": " + std::strerror(errno));
+
+  TraceHeader header {{}, kVersion, sizeof(TraceEvent)};
+  std::memcpy(header.magic, kMagic, sizeof(header.magic));
+  std::fwrite(&header, sizeof(header), 1, file);
+
+  static bool const registered = (std::atexit(&stop_at_exit), true);
+  (void) registered;
+
+  {
+    std::lock_guard<std::mutex> rings_lock(m_rings_mtx);
+    m_rings.clear();
+  }
+  m_file = file;
+  m_start_ns.store(now_ns(), std::memory_order_relaxed);
+  m_generation.fetch_add(1, std::memory_order_release);
+  s_enabled.store(true, std::memory_order_release);
+
+  LBANNV2_DEBUG("Recording allocation trace to \"{}\"", path);
+}
+
+void AllocationTracer::stop()
+{
+  s_enabled.store(false, std::memory_order_release);
+  flush();
+
+  std::lock_guard<std::mutex> lock(m_file_mtx);
+  if (m_file)
+  {
+    std::fclose(m_file);
+    m_file = nullptr;
+  }
+}
+
+void AllocationTracer::flush()
+{
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    std::lock_guard<std::mutex> lock(m_rings_mtx);
+    rings = m_rings;
+  }
+
+  std::lock_guard<std::mutex> lock(m_file_mtx);
+  for (auto const& ring : rings)
+    drain(*ring);
+  if (m_file)
+    std::fflush(m_file);
+}
+
+void AllocationTracer::drain(Ring& ring)
+{
+  auto tail = ring.tail.load(std::memory_order_relaxed);
+  auto const head = ring.head.load(std::memory_order_acquire);
+  if (m_file)
+  {
+    // At most two contiguous pieces.
+    while (tail != head)
+    {
+      auto const first = tail % Ring::kCapacity;
+      auto const count =
+        std::min<std::uint64_t>(head - tail, Ring::kCapacity - first);
+      std::fwrite(&ring.events[first], sizeof(TraceEvent), count, m_file);
+      tail += count;
+    }
+  }
+  ring.tail.store(head, std::memory_order_release);
+}
+
+auto AllocationTracer::local_ring() -> Ring&
+{
+  auto const generation = m_generation.load(std::memory_order_acquire);
+  if (!t_ring || t_ring->generation != generation)
+  {
+    t_ring = std::make_shared<Ring>();
+    t_ring->generation = generation;
+    std::lock_guard<std::mutex> lock(m_rings_mtx);
+    m_rings.push_back(t_ring);
+  }
+  return *t_ring;
+}
+
+void AllocationTracer::record(TraceEvent::Kind const kind,
+                              void const* const ptr,
+                              size_t const size,
+                              c10::Device const device,
+                              c10::StreamId const stream) noexcept
+{
+  try
+  {
+    auto& ring = local_ring();
+    auto const head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) == Ring::kCapacity)
+    {
+      std::lock_guard<std::mutex> lock(m_file_mtx);
+      drain(ring);
+    }
+
+    auto& event = ring.events[head % Ring::kCapacity];
+    event.time_ns =
+      now_ns() - m_start_ns.load(std::memory_order_relaxed);
+    event.ptr = reinterpret_cast<std::uintptr_t>(ptr);
+    event.size = size;
+    event.stream = stream;
+    event.thread = this_thread_id();
+    event.kind = kind;
+    event.device_type = static_cast<std::int8_t>(device.type());
+    event.device_index = static_cast<std::int8_t>(device.index());
+    event.reserved = 0;
+    ring.head.store(head + 1, std::memory_order_release);
+  }
+  catch (...)
+  {
+    // Tracing must never break an allocation; drop the event.
+  }
+}
+
+AllocationTracer& AllocationTracer::instance()
+{
+  // Never destroyed: frees may be traced during static destruction.
+  static AllocationTracer* const tracer = new AllocationTracer;
+  return *tracer;
+}
+
+std::vector<TraceEvent> read_allocation_trace(std::string const& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  LBANNV2_ASSERT(file,
+                 std::runtime_error,
+                 "Cannot open allocation trace \"" + path + "\"");
+
+  TraceHeader header;
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  LBANNV2_ASSERT(file
+                   && std::memcmp(header.magic,
+                                  AllocationTracer::kMagic,
+                                  sizeof(header.magic))
+                        == 0,
+                 std::runtime_error,
+                 "\"" + path + "\" is not an allocation trace");
+  LBANNV2_ASSERT(header.version == AllocationTracer::kVersion
+                   && header.event_size == sizeof(TraceEvent),
+                 std::runtime_error,
+                 "Unsupported allocation trace version "
+                   + std::to_string(header.version));
+
+  std::vector<TraceEvent> events;
+  TraceEvent event;
+  while (file.read(reinterpret_cast<char*>(&event), sizeof(event)))
+    events.push_back(event);
+
+  std::stable_sort(
+    events.begin(), events.end(), [](auto const& a, auto const& b) {
+      return a.time_ns < b.time_ns;
+    });
+  return events;
+}
+
+TraceReplayStats replay_allocation_trace(std::span<TraceEvent const> events,
+                                         c10::Allocator& alloc,
+                                         TraceReplayOptions const& opts)
+{
+  using Clock = std::chrono::steady_clock;
+  auto const elapsed_ns = [](Clock::time_point const start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start)
+      .count();
+  };
+
+  struct Live
+  {
+    c10::DataPtr ptr;
+    size_t size;
+  };
+  std::unordered_map<std::uint64_t, Live> live;
+
+  TraceReplayStats stats;
+  size_t const base_rss = resident_bytes();
+  size_t requested = 0UL;
+  size_t count = 0UL;
+  for (auto const& e : events)
+  {
+    switch (e.kind)
+    {
+    case TraceEvent::Alloc:
+    {
+      auto const start = Clock::now();
+      auto ptr = alloc.allocate(e.size);
+      auto const ns = elapsed_ns(start);
+      stats.alloc_ns_total += ns;
+      stats.alloc_ns_max = std::max(stats.alloc_ns_max, ns);
+      ++stats.num_allocs;
+
+      if (opts.touch && ptr.get())
+        for (size_t i = 0; i < e.size; i += page_size())
+          static_cast<volatile char*>(ptr.get())[i] = 0;
+
+      // A pointer reused without a traced free replaces the old one.
+      auto [it, inserted] = live.try_emplace(e.ptr);
+      if (!inserted)
+        requested -= it->second.size;
+      it->second = Live {std::move(ptr), e.size};
+
+      requested += e.size;
+      stats.peak_requested_bytes =
+        std::max(stats.peak_requested_bytes, requested);
+      break;
+    }
+    case TraceEvent::Free:
+    {
+      auto const it = live.find(e.ptr);
+      if (it == live.end())
+      {
+        ++stats.num_unmatched_frees;
+        break;
+      }
+      auto const start = Clock::now();
+      it->second.ptr.clear();
+      auto const ns = elapsed_ns(start);
+      stats.free_ns_total += ns;
+      stats.free_ns_max = std::max(stats.free_ns_max, ns);
+      ++stats.num_frees;
+      requested -= it->second.size;
+      live.erase(it);
+      break;
+    }
+    case TraceEvent::Migrate:
+      ++stats.num_migrates;
+      break;
+    }
+
+    if (opts.rss_interval && ++count % opts.rss_interval == 0)
+    {
+      auto const rss = resident_bytes();
+      if (rss > base_rss)
+        stats.peak_rss_bytes = std::max(stats.peak_rss_bytes, rss - base_rss);
+    }
+  }
+  return stats;
+}
+
+}  // namespace lbannv2
@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <c10/core/Allocator.h>
+#include <c10/core/Device.h>
+#include <c10/core/Stream.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace lbannv2
+{
+
+/** @brief One record of an allocation trace.
+ *
+ *  This is also the on-disk format, so its layout must not change
+ *  without bumping AllocationTracer::kVersion.
+ */
+struct TraceEvent
+{
+  enum Kind : std::uint8_t
+  {
+    Alloc = 0,
+    Free = 1,
+    Migrate = 2,
+  };
+
+  /** @brief Nanoseconds since the trace was started. */
+  std::uint64_t time_ns;
+  /** @brief The (context) pointer. */
+  std::uint64_t ptr;
+  /** @brief Bytes allocated, freed or migrated. */
+  std::uint64_t size;
+  /** @brief The c10::StreamId involved, or 0. */
+  std::int64_t stream;
+  /** @brief A small per-thread id (not the OS thread id). */
+  std::uint32_t thread;
+  /** @brief One of Kind. */
+  std::uint8_t kind;
+  /** @brief The c10::DeviceType (the target, for migrations). */
+  std::int8_t device_type;
+  /** @brief The c10::DeviceIndex. */
+  std::int8_t device_index;
+  std::uint8_t reserved = 0;
+};
+static_assert(sizeof(TraceEvent) == 40);
+
+/** @class AllocationTracer
+ *  @brief Records allocation, free and migration events to a file.
+ *
+ *  Allocations and frees are recorded when memory is added to or
+ *  removed from the PointerRegistry (i.e., by Allocator::allocate()
+ *  and the LBANNv2 deleters); migrations are recorded by migrate().
+ *
+ *  Each thread records into its own fixed-size ring without locking.
+ *  A ring is written out when it fills up (by its own thread), and all
+ *  rings are written out by flush() and stop(). Events recorded while
+ *  the trace is being stopped may be lost.
+ *
+ *  The file is a small header followed by TraceEvents, in order
+ *  within each thread but not across threads; read_allocation_trace()
+ *  sorts them by time. Tracing can be started at import time with
+ *  LBANNV2_ALLOC_TRACE=<path>.
+ */
+class LBANNV2_EXPORT AllocationTracer
+{
+public:
+  static constexpr char kMagic[8] = "LBV2TRC";
+  static constexpr std::uint32_t kVersion = 1;
+
+  /** @brief Whether a trace is being recorded.
+   *
+   *  This is all the hooks check when tracing is off.
+   */
+  static bool enabled() noexcept
+  {
+    return s_enabled.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Start recording to a new file.
+   *
+   *  @throws std::runtime_error if a trace is already being recorded
+   *          or the file cannot be created.
+   */
+  void start(std::string const& path);
+
+  /** @brief Stop recording, writing out all events. */
+  void stop();
+
+  /** @brief Write out all events recorded so far. */
+  void flush();
+
+  /** @brief Record an event. */
+  void record(TraceEvent::Kind kind,
+              void const* ptr,
+              size_t size,
+              c10::Device device,
+              c10::StreamId stream = 0) noexcept;
+
+  static AllocationTracer& instance();
+
+  struct Ring;
+
+private:
+  AllocationTracer() = default;
+  ~AllocationTracer() = default;
+  AllocationTracer(AllocationTracer const&) = delete;
+  AllocationTracer(AllocationTracer&&) = delete;
+  AllocationTracer& operator=(AllocationTracer const&) = delete;
+  AllocationTracer& operator=(AllocationTracer&&) = delete;
+
+  Ring& local_ring();
+  // Requires m_file_mtx.
+  void drain(Ring& ring);
+
+  static std::atomic<bool> s_enabled;
+
+  std::atomic<std::uint64_t> m_generation = 0;
+  std::atomic<std::int64_t> m_start_ns = 0;
+
+  std::mutex m_rings_mtx;
+  std::vector<std::shared_ptr<Ring>> m_rings;
+
+  std::mutex m_file_mtx;
+  std::FILE* m_file = nullptr;
+};  // class AllocationTracer
+
+/** @brief Record an event if a trace is being recorded. */
+inline void trace_allocation_event(TraceEvent::Kind const kind,
+                                   void const* const ptr,
+                                   size_t const size,
+                                   c10::Device const device,
+                                   c10::StreamId const stream = 0) noexcept
+{
+  if (AllocationTracer::enabled())
+    AllocationTracer::instance().record(kind, ptr, size, device, stream);
+}
+
+/** @brief Read a trace file written by AllocationTracer.
+ *
+ *  The events are sorted by time.
+ *
+ *  @throws std::runtime_error if the file is not a valid trace.
+ */
+LBANNV2_EXPORT std::vector<TraceEvent>
+read_allocation_trace(std::string const& path);
+
+/** @brief The results of replaying a trace. */
+struct TraceReplayStats
+{
+  size_t num_allocs = 0UL;
+  size_t num_frees = 0UL;
+  size_t num_migrates = 0UL;
+  /** @brief Frees of pointers the replay never allocated. */
+  size_t num_unmatched_frees = 0UL;
+  /** @brief The largest number of bytes requested at once. */
+  size_t peak_requested_bytes = 0UL;
+  /** @brief The largest growth of the resident set over its size
+   *         before the replay.
+   */
+  size_t peak_rss_bytes = 0UL;
+  double alloc_ns_total = 0.;
+  double alloc_ns_max = 0.;
+  double free_ns_total = 0.;
+  double free_ns_max = 0.;
+
+  /** @brief The fraction of the peak resident set not accounted for
+   *         by requested bytes.
+   */
+  double fragmentation() const noexcept
+  {
+    return peak_rss_bytes > peak_requested_bytes
+             ? 1. - double(peak_requested_bytes) / double(peak_rss_bytes)
+             : 0.;
+  }
+};
+
+/** @brief Options for replay_allocation_trace(). */
+struct TraceReplayOptions
+{
+  /** @brief Write every page of each allocation so it is resident. */
+  bool touch = true;
+  /** @brief Sample the resident set every this many events. */
+  size_t rss_interval = 64UL;
+};
+
+/** @brief Replay the allocations and frees of a trace.
+ *
+ *  Every Alloc is replayed with alloc.allocate() and every Free by
+ *  destroying the matching DataPtr, regardless of the devices in the
+ *  trace. Migrations are only counted. Allocations still live at the
+ *  end of the trace are freed (untimed).
+ */
+LBANNV2_EXPORT TraceReplayStats
+replay_allocation_trace(std::span<TraceEvent const> events,
+                        c10::Allocator& alloc,
+                        TraceReplayOptions const& opts = {});
+
+}  // namespace lbannv2
@@ -6,12 +6,26 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "lbannv2/memory/allocator.hpp"
 
+#include "lbannv2/memory/allocation_trace.hpp"
+#include "lbannv2/memory/arena_allocator.hpp"
+#include "lbannv2/memory/caching_host_allocator.hpp"
+#include "lbannv2/memory/coherent_memory.hpp"
+#include "lbannv2/memory/deferred_free.hpp"
+#include "lbannv2/memory/growable_allocator.hpp"
+#include "lbannv2/memory/huge_page_allocator.hpp"
+#include "lbannv2/memory/memory_budget.hpp"
+#include "lbannv2/memory/mmap_file_allocator.hpp"
+#include "lbannv2/memory/numa_allocator.hpp"
 #include "lbannv2/memory/registry.hpp"
+#include "lbannv2/memory/shm_allocator.hpp"
+#include "lbannv2/memory/slab_allocator.hpp"
 #include "lbannv2/utils/errors.hpp"
 #include "lbannv2/utils/logging.hpp"
 
 #include <c10/core/CPUAllocator.h>
 
+#include <cstring>
+
 #if LBANNV2_HAS_CUDA
 #include <ATen/cuda/CUDAContextLight.h>
 #elif LBANNV2_HAS_ROCM
@@ -22,20 +36,106 @@
 #include "lbannv2/memory/mi300a_allocator.hpp"
 #endif
 
+namespace
+{
+
+constexpr size_t header_size = sizeof(lbannv2::AllocationHeader);
+
+}  // namespace
+
 namespace lbannv2
 {
 
+void* Allocator::raw_alloc_zeroed(size_t const nbytes)
+{
+  LBANNV2_ASSERT(get_device().is_cpu(),
+                 std::runtime_error,
+                 "Allocator: raw_alloc_zeroed() cannot memset device memory");
+  void* const ptr = this->raw_alloc(nbytes);
+  if (ptr)
+    std::memset(ptr, 0, nbytes);
+  return ptr;
+}
+
 c10::DataPtr Allocator::allocate(size_t n)
+{
+  return allocate_impl(n, /*zeroed=*/false);
+}
+
+c10::DataPtr Allocator::allocate_zeroed(size_t n)
+{
+  return allocate_impl(n, /*zeroed=*/true);
+}
+
+c10::DataPtr Allocator::allocate_impl(size_t const n, bool const zeroed)
 {
   // Do the allocation
-  void* const buffer = this->raw_alloc(n);
+  auto& budget = memory_budget();
+  auto const reservation = uses_host_budget()
+                             ? budget.admit(n)
+                             : MemoryBudget::Reservation {};
+  auto const device = this->get_device();
+  if (m_header_layout && n)
+  {
+    // The whole block is registered, so the context is its start.
+    void* const raw = budget.raw_alloc(*this, n + header_size, zeroed);
+    if (m_register_allocations)
+      pointer_registry().add(raw, n + header_size, this, device);
+    return make_headered(raw, n, device);
+  }
+
+  void* const buffer = budget.raw_alloc(*this, n, zeroed);
 
   // Log the allocation
   LBANNV2_TRACE("Allocator::allocate(n={}, ptr={})", n, buffer);
-  pointer_registry().add(buffer, n, this);
+  if (m_register_allocations)
+    pointer_registry().add(buffer, n, this, device);
 
   // Decorate the allocation.
-  return {buffer, buffer, this->raw_deleter(), this->get_device()};
+  return {buffer, buffer, this->raw_deleter(), device};
+}
+
+c10::DataPtr
+Allocator::make_headered(void* const raw, size_t const n, c10::Device device)
+{
+  auto* const header = emplace_allocation_header(raw, this, n);
+  void* const data = header + 1;
+  // Registration traces the allocation otherwise.
+  if (!m_register_allocations)
+    trace_allocation_event(TraceEvent::Alloc, data, n, device);
+
+  LBANNV2_TRACE("Allocator::make_headered(n={}, ptr={})", n, data);
+  return {data, header, &Allocator::delete_headered, device};
+}
+
+void Allocator::delete_headered(void* const ctx)
+{
+  auto* const header = static_cast<AllocationHeader*>(ctx);
+  LBANNV2_ASSERT(header->magic == AllocationHeader::kMagic,
+                 std::runtime_error,
+                 "Allocator::delete_headered: bad allocation header");
+
+  // Catch double frees.
+  header->magic = 0;
+  auto& alloc = static_cast<Allocator&>(*header->allocator);
+  auto const n = header->size;
+  if (alloc.m_register_allocations)
+    pointer_registry().remove(ctx);
+  else
+    trace_allocation_event(
+      TraceEvent::Free, header + 1, n, alloc.get_device());
+
+  release_or_defer(alloc, ctx, n + header_size);
+}
+
+void Allocator::delete_registered(void* const ptr)
+{
+  auto& registry = pointer_registry();
+  auto* const alloc = dynamic_cast<Allocator*>(registry.get_allocator(ptr));
+  LBANNV2_ASSERT(alloc,
+                 std::runtime_error,
+                 "Allocator::delete_registered: not an LBANNv2 allocation");
+  release_or_defer(*alloc, ptr, registry.remove(ptr));
 }
 
 }  // namespace lbannv2
@@ -45,6 +145,26 @@ bool lbannv2::is_managed_ptr(void const* const ptr) noexcept
   return pointer_registry().known(ptr);
 }
 
+bool lbannv2::is_managed_ptr(c10::DataPtr const& ptr) noexcept
+{
+  return allocation_header(ptr) || pointer_registry().known(ptr.get());
+}
+
+lbannv2::AllocationHeader*
+lbannv2::allocation_header(c10::DataPtr const& ptr) noexcept
+{
+  if (ptr.get_deleter() != &Allocator::delete_headered)
+    return nullptr;
+  return static_cast<AllocationHeader*>(ptr.get_context());
+}
+
+c10::Allocator* lbannv2::allocator_of(c10::DataPtr const& ptr)
+{
+  if (auto const* const header = allocation_header(ptr))
+    return header->allocator;
+  return pointer_registry().get_allocator(ptr.get_context());
+}
+
 namespace
 {
 
@@ -52,6 +172,13 @@ c10::Allocator* pt_orig_cpu_alloc_ = nullptr;
 
 }  // namespace
 
+void lbannv2::use_cpu_allocator(c10::Allocator& alloc)
+{
+  if (!pt_orig_cpu_alloc_)
+    pt_orig_cpu_alloc_ = c10::GetCPUAllocator();
+  c10::SetCPUAllocator(&alloc);
+}
+
 void lbannv2::use_mi300a_cpu_allocator()
 {
 #if LBANNV2_WITH_MI300A || LBANNV2_UNKNOWN_MI300A
@@ -59,15 +186,63 @@ void lbannv2::use_mi300a_cpu_allocator()
   if (gpu::is_integrated())
 #endif
   {
-    if (!pt_orig_cpu_alloc_)
-      pt_orig_cpu_alloc_ = c10::GetCPUAllocator();
-    c10::SetCPUAllocator(&MI300Allocator::instance());
+    use_cpu_allocator(MI300Allocator::instance());
     return;
   }
 #endif
   LBANNV2_WARN("No MI300A allocator available");
 }
 
+void lbannv2::use_coherent_host_allocator()
+{
+  if (auto* const domain = coherent_memory_domain())
+  {
+    use_cpu_allocator(domain->host_allocator());
+    return;
+  }
+  LBANNV2_WARN("No coherent memory domain in use");
+}
+
+void lbannv2::use_caching_host_allocator()
+{
+  use_cpu_allocator(CachingHostAllocator::instance());
+}
+
+void lbannv2::use_huge_page_host_allocator()
+{
+  use_cpu_allocator(HugePageAllocator::instance());
+}
+
+void lbannv2::use_numa_host_allocator()
+{
+  use_cpu_allocator(NumaAllocator::instance());
+}
+
+void lbannv2::use_arena_host_allocator()
+{
+  use_cpu_allocator(ArenaAllocator::instance());
+}
+
+void lbannv2::use_mmap_file_host_allocator()
+{
+  use_cpu_allocator(MmapFileAllocator::instance());
+}
+
+void lbannv2::use_slab_host_allocator()
+{
+  use_cpu_allocator(SlabAllocator::instance());
+}
+
+void lbannv2::use_growable_host_allocator()
+{
+  use_cpu_allocator(GrowableAllocator::instance());
+}
+
+void lbannv2::use_shm_host_allocator()
+{
+  use_cpu_allocator(ShmAllocator::instance());
+}
+
 void lbannv2::use_torch_cpu_allocator()
 {
   if (pt_orig_cpu_alloc_)
@@ -9,9 +9,50 @@
 
 #include <c10/core/Allocator.h>
 
+#include <cstdint>
+#include <new>
+
 namespace lbannv2
 {
 
+class Allocator;
+
+/** @brief The header in front of each allocation in the header
+ *         layout (see Allocator::set_header_layout()), and of each
+ *         BasicAllocator allocation.
+ *
+ *  The header is the DataPtr's context, and it keeps the payload at
+ *  the same 64-byte alignment as the raw allocation.
+ */
+struct alignas(64) AllocationHeader
+{
+  static constexpr std::uint64_t kMagic = 0x4c4256324844522eULL;
+
+  std::uint64_t magic;
+  /** @brief The allocator that made the allocation.
+   *
+   *  For allocations with the header-layout deleter (see
+   *  allocation_header()), this is an lbannv2::Allocator.
+   */
+  c10::Allocator* allocator;
+  /** @brief The size requested, excluding the header. */
+  size_t size;
+  /** @brief Free for the owner of the memory to use; initially 0. */
+  std::uint32_t tags;
+};
+static_assert(sizeof(AllocationHeader) == 64);
+
+/** @brief Construct the header of an n-byte allocation at raw, which
+ *         must have room for the header and the allocation.
+ *
+ *  @returns The header; the allocation follows it.
+ */
+inline AllocationHeader* emplace_allocation_header(
+  void* const raw, c10::Allocator* const alloc, size_t const n) noexcept
+{
+  return new (raw) AllocationHeader {AllocationHeader::kMagic, alloc, n, 0U};
+}
+
 /** @class Allocator
  *  @brief A simplistic interface for LBANN allocators.
  */
@@ -22,12 +63,174 @@ public:
   virtual void raw_dealloc(void* ptr) = 0;
   virtual c10::Device get_device() const noexcept = 0;
 
+  /** @brief Deallocate a buffer whose size is known.
+   *
+   *  The default implementation ignores the size.
+   *
+   *  @param[in] ptr A buffer returned by raw_alloc().
+   *  @param[in] nbytes The size that was passed to raw_alloc().
+   */
+  virtual void raw_sized_dealloc(void* ptr, size_t nbytes)
+  {
+    (void) nbytes;
+    raw_dealloc(ptr);
+  }
+
+  /** @brief Allocate a buffer whose contents are zero.
+   *
+   *  The default implementation zeroes the result of raw_alloc() with
+   *  memset, and throws for allocators whose get_device() is not the
+   *  CPU; those, and allocators whose host memory is best zeroed
+   *  elsewhere (e.g., on the MI300A), must override it. Allocators
+   *  that know memory to be zero already (e.g., fresh anonymous
+   *  mappings) should skip the memset.
+   */
+  virtual void* raw_alloc_zeroed(size_t nbytes);
+
+  /** @brief Whether allocate() checks requests against the host
+   *         memory_budget().
+   *
+   *  By default, allocators of CPU memory do. Allocators whose host
+   *  memory is really device memory (e.g., on the MI300A) should
+   *  override this.
+   */
+  virtual bool uses_host_budget() const noexcept
+  {
+    return get_device().is_cpu();
+  }
+
+  /** @brief Allocate and register a buffer.
+   *
+   *  The request is first checked against the memory_budget() (if
+   *  uses_host_budget()), and a failed raw_alloc() is retried once
+   *  after reclaiming memory.
+   *
+   *  @throws OutOfMemory if the request cannot be satisfied.
+   */
   c10::DataPtr allocate(size_t n) final;
+
+  /** @brief Like allocate(), but the buffer is zero-filled.
+   *
+   *  @see raw_alloc_zeroed()
+   */
+  c10::DataPtr allocate_zeroed(size_t n);
+
+  /** @brief Whether new allocations use the header layout. */
+  bool header_layout() const noexcept { return m_header_layout; }
+
+  /** @brief The deleter of allocations in the header layout.
+   *
+   *  This takes the header (the DataPtr's context) and gives the
+   *  whole block to raw_sized_dealloc() of the allocator named in it,
+   *  possibly on another thread (see DeferredFree).
+   */
+  static void delete_headered(void* ctx);
+
+protected:
+  Allocator() = default;
+
+  /** @brief Constructor
+   *
+   *  @param[in] register_allocations If @c false, allocate() does not
+   *             register each allocation with the PointerRegistry.
+   *             The derived class is then responsible for registering
+   *             the memory it hands out, e.g., in larger pieces.
+   */
+  explicit Allocator(bool register_allocations)
+    : m_register_allocations {register_allocations}
+  {}
+
+  /** @brief A deleter for allocations registered by allocate().
+   *
+   *  This finds the allocator and size of ptr in the PointerRegistry,
+   *  deregisters it and passes it to raw_sized_dealloc(), possibly on
+   *  another thread (see DeferredFree). Allocators that are not
+   *  singletons can use it as their raw_deleter(), but must drain
+   *  their deferred frees before they are destroyed.
+   */
+  static void delete_registered(void* ptr);
+
+  /** @brief Use the header layout for new allocations, or stop using
+   *         it.
+   *
+   *  In the header layout, allocate() asks raw_alloc() for an extra
+   *  AllocationHeader in front of each buffer, which records the size
+   *  and the allocator. Freeing such a buffer, or finding its
+   *  allocator with allocator_of(), needs no PointerRegistry lookup.
+   *
+   *  If register_allocations was @c true, each block (header and
+   *  buffer) is registered with the PointerRegistry as one range, so
+   *  lookups of the buffer's addresses resolve to the header, which
+   *  is also the DataPtr's context. Otherwise, as for other
+   *  allocations, the allocator registers the larger regions it
+   *  carves blocks from itself (see CachingHostAllocator).
+   *
+   *  Existing allocations are freed according to the layout they were
+   *  made with.
+   */
+  void set_header_layout(bool enable) noexcept { m_header_layout = enable; }
+
+private:
+  c10::DataPtr allocate_impl(size_t n, bool zeroed);
+  c10::DataPtr make_headered(void* raw, size_t n, c10::Device device);
+
+  bool m_register_allocations = true;
+  bool m_header_layout = false;
 };  // class Allocator
 
+/** @brief Whether ptr is in memory registered with the
+ *         PointerRegistry. */
 LBANNV2_EXPORT bool is_managed_ptr(void const* ptr) noexcept;
 
+/** @brief Whether ptr was allocated by an LBANNv2 allocator.
+ *
+ *  Unlike the overload for addresses, this recognizes allocations in
+ *  the header layout by their deleter, whether or not their memory is
+ *  registered.
+ */
+LBANNV2_EXPORT bool is_managed_ptr(c10::DataPtr const& ptr) noexcept;
+
+/** @brief Get the header of an allocation in the header layout.
+ *
+ *  @returns The header, or nullptr if ptr was not allocated in the
+ *           header layout.
+ */
+LBANNV2_EXPORT AllocationHeader*
+allocation_header(c10::DataPtr const& ptr) noexcept;
+
+/** @brief Get the allocator that made ptr.
+ *
+ *  This reads the header of allocations in the header layout, and
+ *  otherwise looks up ptr's context in the PointerRegistry.
+ *
+ *  @throws UnknownAddress if the allocator cannot be found.
+ */
+LBANNV2_EXPORT c10::Allocator* allocator_of(c10::DataPtr const& ptr);
+
+/** @brief Use the given allocator for CPU allocations.
+ *
+ *  The original (PyTorch) CPU allocator is remembered so that
+ *  use_torch_cpu_allocator() can restore it. The allocator must
+ *  outlive its use.
+ */
+LBANNV2_EXPORT void use_cpu_allocator(c10::Allocator& alloc);
+
 LBANNV2_EXPORT void use_mi300a_cpu_allocator();
+
+/** @brief Use the host allocator of the coherent-memory domain in
+ *         use (see coherent_memory_domain()) for CPU allocations.
+ *
+ *  Memory allocated this way can be migrated to the current device.
+ */
+LBANNV2_EXPORT void use_coherent_host_allocator();
+LBANNV2_EXPORT void use_caching_host_allocator();
+LBANNV2_EXPORT void use_huge_page_host_allocator();
+LBANNV2_EXPORT void use_numa_host_allocator();
+LBANNV2_EXPORT void use_arena_host_allocator();
+LBANNV2_EXPORT void use_mmap_file_host_allocator();
+LBANNV2_EXPORT void use_slab_host_allocator();
+LBANNV2_EXPORT void use_growable_host_allocator();
+LBANNV2_EXPORT void use_shm_host_allocator();
 LBANNV2_EXPORT void use_torch_cpu_allocator();
 
 }  // namespace lbannv2
@@ -0,0 +1,265 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/arena_allocator.hpp"
+
+#include "lbannv2/memory/registry.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+using AA = lbannv2::ArenaAllocator;
+
+constexpr size_t round_up(size_t const n, size_t const m) noexcept
+{
+  return (n + m - 1) / m * m;
+}
+
+size_t get_env_chunk_size()
+{
+  char const* const env = std::getenv("LBANNV2_ARENA_CHUNK_SIZE");
+  if (env && std::strlen(env))
+    return round_up(std::strtoull(env, nullptr, 0), AA::kAlignment);
+  return size_t {64} << 20;
+}
+
+void delete_arena_ptr(void* const ptr)
+{
+  AA::instance().raw_dealloc(ptr);
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+ArenaAllocator::ArenaAllocator()
+  : Allocator {/*register_allocations=*/false},
+    m_chunk_size {get_env_chunk_size()}
+{}
+
+void ArenaAllocator::copy_data(void* const dst,
+                               void const* const src,
+                               size_t const bytes) const
+{
+  std::memcpy(dst, src, bytes);
+}
+
+void* ArenaAllocator::raw_alloc(size_t const nbytes)
+{
+  if (nbytes == 0)
+    return nullptr;
+
+  size_t const size = sizeof(Header) + round_up(nbytes, kAlignment);
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  Chunk* chunk = m_active.empty() ? nullptr : m_active.back().get();
+  if (!chunk || chunk->size - chunk->offset < size)
+    chunk = next_chunk(size);
+
+  auto* const header = reinterpret_cast<Header*>(chunk->base + chunk->offset);
+  header->chunk = chunk;
+  chunk->offset += size;
+  ++chunk->live;
+
+  ++m_stats.live_allocations;
+  m_stats.used_bytes += size;
+  m_stats.peak_used_bytes =
+    std::max(m_stats.peak_used_bytes, m_stats.used_bytes);
+
+  void* const ptr = header + 1;
+  m_live.emplace(ptr, nbytes);
+  LBANNV2_TRACE("ArenaAllocator::raw_alloc(nbytes={}): ptr={}", nbytes, ptr);
+  return ptr;
+}
+
+void ArenaAllocator::raw_dealloc(void* const ptr)
+{
+  if (!ptr)
+    return;
+
+  LBANNV2_TRACE("ArenaAllocator::raw_dealloc(ptr={})", ptr);
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  Chunk* const chunk = (static_cast<Header*>(ptr) - 1)->chunk;
+  m_live.erase(ptr);
+  --chunk->live;
+  --m_stats.live_allocations;
+
+  // A chunk set aside at a reset can go once its last allocation does.
+  if (chunk->live == 0)
+  {
+    auto const it = std::find_if(
+      m_retired.begin(), m_retired.end(), [chunk](auto const& c) {
+        return c.get() == chunk;
+      });
+    if (it != m_retired.end())
+    {
+      chunk->offset = 0UL;
+      m_free.push_back(std::move(*it));
+      m_retired.erase(it);
+    }
+  }
+}
+
+c10::DeleterFnPtr ArenaAllocator::raw_deleter() const
+{
+  return &delete_arena_ptr;
+}
+
+c10::Device ArenaAllocator::get_device() const noexcept
+{
+  return c10::Device {c10::kCPU};
+}
+
+void ArenaAllocator::begin_scope()
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  ++m_depth;
+}
+
+size_t ArenaAllocator::end_scope()
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  LBANNV2_ASSERT(m_depth > 0,
+                 std::runtime_error,
+                 "ArenaAllocator: end_scope() without begin_scope()");
+  return --m_depth == 0 ? reset() : 0UL;
+}
+
+void ArenaAllocator::release_cached()
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  std::vector<void*> bases;
+  bases.reserve(m_free.size());
+  for (auto const& chunk : m_free)
+    bases.push_back(chunk->base);
+  pointer_registry().remove_many(bases);
+
+  for (auto& chunk : m_free)
+    free_chunk(chunk.get());
+  m_free.clear();
+}
+
+auto ArenaAllocator::stats() const -> Stats
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_stats;
+}
+
+auto ArenaAllocator::next_chunk(size_t const nbytes) -> Chunk*
+{
+  // Reuse the first free chunk that's big enough.
+  auto const it =
+    std::find_if(m_free.begin(), m_free.end(), [nbytes](auto const& c) {
+      return c->size >= nbytes;
+    });
+  if (it != m_free.end())
+  {
+    m_active.push_back(std::move(*it));
+    m_free.erase(it);
+    return m_active.back().get();
+  }
+
+  auto chunk = std::make_unique<Chunk>();
+  chunk->size = std::max(m_chunk_size, nbytes);
+  void* base = nullptr;
+  LBANNV2_ASSERT(posix_memalign(&base, kAlignment, chunk->size) == 0,
+                 std::runtime_error,
+                 "ArenaAllocator: out of memory");
+  chunk->base = static_cast<std::byte*>(base);
+
+  try
+  {
+    pointer_registry().add(base, chunk->size, this, get_device(), this);
+  }
+  catch (...)
+  {
+    std::free(base);
+    throw;
+  }
+
+  m_stats.reserved_bytes += chunk->size;
+  ++m_stats.num_chunks;
+  LBANNV2_DEBUG(
+    "ArenaAllocator: new chunk (ptr={}, size={})", base, chunk->size);
+
+  m_active.push_back(std::move(chunk));
+  return m_active.back().get();
+}
+
+bool ArenaAllocator::find_nested(void const* const,
+                                 void const* const ptr,
+                                 void*& begin,
+                                 size_t& size) const noexcept
+{
+  // Allocations never span chunks, and a chunk is only freed once it
+  // has none, so this needs nothing from the chunk itself.
+  std::lock_guard<std::mutex> lock(m_mtx);
+  auto it = m_live.upper_bound(ptr);
+  if (it == m_live.begin())
+    return false;
+  --it;
+  auto const* const first = static_cast<std::byte const*>(it->first);
+  if (static_cast<std::byte const*>(ptr) >= first + it->second)
+    return false;
+
+  begin = const_cast<void*>(it->first);
+  size = it->second;
+  return true;
+}
+
+void ArenaAllocator::free_chunk(Chunk* const chunk)
+{
+  std::free(chunk->base);
+  m_stats.reserved_bytes -= chunk->size;
+  --m_stats.num_chunks;
+}
+
+size_t ArenaAllocator::reset()
+{
+  size_t outliving = 0UL;
+  for (auto& chunk : m_active)
+  {
+    if (chunk->live)
+    {
+      outliving += chunk->live;
+      m_retired.push_back(std::move(chunk));
+    }
+    else
+    {
+      chunk->offset = 0UL;
+      m_free.push_back(std::move(chunk));
+    }
+  }
+  m_active.clear();
+  m_stats.used_bytes = 0UL;
+
+  if (outliving)
+  {
+    m_stats.total_outliving += outliving;
+    LBANNV2_WARN("ArenaAllocator: {} allocation(s) outlived the arena scope; "
+                 "{} chunk(s) will be held until they are freed",
+                 outliving,
+                 m_retired.size());
+  }
+  return outliving;
+}
+
+ArenaAllocator& ArenaAllocator::instance()
+{
+  // Never destroyed: tensors may well outlive static destruction.
+  static ArenaAllocator* const alloc = new ArenaAllocator;
+  return *alloc;
+}
+
+}  // namespace lbannv2
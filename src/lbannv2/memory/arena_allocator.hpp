@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lbannv2
+{
+
+/** @class ArenaAllocator
+ *  @brief A bump allocator for CPU memory that is released in bulk.
+ *
+ *  Allocations are carved, in order, out of large chunks (of
+ *  chunk_size() bytes, or bigger for allocations that would not fit).
+ *  Freeing an allocation does not make its memory reusable; instead,
+ *  when the outermost scope ends (see begin_scope() and end_scope())
+ *  the whole arena is reset and every chunk starts over from the
+ *  beginning.
+ *
+ *  Chunks, rather than individual allocations, are registered with
+ *  the PointerRegistry, with the allocator as their NestedRanges, so
+ *  lookups still resolve to the live allocation containing an
+ *  address (and headers and freed allocations are unknown).
+ *
+ *  Any allocation still alive when the arena is reset has outlived
+ *  its scope. These are reported, and the chunks containing them are
+ *  set aside until their last allocation is freed.
+ *
+ *  The chunk size defaults to 64 MiB and can be set with
+ *  LBANNV2_ARENA_CHUNK_SIZE (in bytes).
+ */
+class LBANNV2_EXPORT ArenaAllocator final : public Allocator,
+                                            private NestedRanges
+{
+public:
+  static constexpr size_t kAlignment = 64;
+
+  struct Stats
+  {
+    /** @brief Bytes held in chunks. */
+    size_t reserved_bytes = 0UL;
+    /** @brief Number of chunks held. */
+    size_t num_chunks = 0UL;
+    /** @brief Bytes handed out since the last reset. */
+    size_t used_bytes = 0UL;
+    /** @brief The most bytes handed out between two resets. */
+    size_t peak_used_bytes = 0UL;
+    /** @brief Allocations not yet freed. */
+    size_t live_allocations = 0UL;
+    /** @brief Allocations that have outlived their scope, in total. */
+    size_t total_outliving = 0UL;
+  };
+
+  void copy_data(void* dst, void const* src, size_t bytes) const final;
+
+  void* raw_alloc(size_t nbytes) final;
+
+  void raw_dealloc(void* ptr) final;
+
+  c10::DeleterFnPtr raw_deleter() const final;
+
+  c10::Device get_device() const noexcept final;
+
+  /** @brief Open a (possibly nested) arena scope. */
+  void begin_scope();
+
+  /** @brief Close an arena scope.
+   *
+   *  Closing the outermost scope resets the arena.
+   *
+   *  @returns The number of allocations that outlived the reset (0 if
+   *           this was not the outermost scope).
+   */
+  size_t end_scope();
+
+  /** @brief Free the chunks that are not in use. */
+  void release_cached();
+
+  size_t chunk_size() const noexcept { return m_chunk_size; }
+
+  Stats stats() const;
+
+  static ArenaAllocator& instance();
+
+private:
+  ArenaAllocator();
+  ~ArenaAllocator() = default;
+  ArenaAllocator(ArenaAllocator const&) = delete;
+  ArenaAllocator(ArenaAllocator&&) = delete;
+  ArenaAllocator& operator=(ArenaAllocator const&) = delete;
+  ArenaAllocator& operator=(ArenaAllocator&&) = delete;
+
+  struct Chunk
+  {
+    std::byte* base;
+    size_t size;
+    size_t offset = 0UL;
+    size_t live = 0UL;
+  };
+
+  /** @brief Precedes every allocation. */
+  struct alignas(kAlignment) Header
+  {
+    Chunk* chunk;
+  };
+
+  bool find_nested(void const* base,
+                   void const* ptr,
+                   void*& begin,
+                   size_t& size) const noexcept final;
+
+  // These require m_mtx to be held. free_chunk() does not deregister
+  // the chunk.
+  Chunk* next_chunk(size_t nbytes);
+  void free_chunk(Chunk* chunk);
+  size_t reset();
+
+  size_t m_chunk_size;
+
+  mutable std::mutex m_mtx;
+  size_t m_depth = 0UL;
+  /** @brief Chunks used since the last reset; the last is current. */
+  std::vector<std::unique_ptr<Chunk>> m_active;
+  /** @brief Empty chunks. */
+  std::vector<std::unique_ptr<Chunk>> m_free;
+  /** @brief Chunks with allocations that outlived a reset. */
+  std::vector<std::unique_ptr<Chunk>> m_retired;
+  /** @brief Live allocations and their sizes, in address order. */
+  std::map<void const*, size_t> m_live;
+  Stats m_stats;
+};  // class ArenaAllocator
+
+}  // namespace lbannv2
@@ -0,0 +1,291 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/policy_layers.hpp>
+#include <lbannv2/memory/registry.hpp>
+#include <lbannv2/utils/logging.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/** @file
+ *
+ *  A host allocator whose pieces are all chosen at compile time.
+ *
+ *  lbannv2::Allocator makes several virtual calls, a registry update
+ *  and a log check on every allocation. BasicAllocator instead takes
+ *  its backing (any layer or stack of layers from policy_layers.hpp),
+ *  its registration policy and its logging policy as template
+ *  parameters. It is final, so callers that know its type get the
+ *  whole allocate/free path inlined, and policies that do nothing
+ *  compile away.
+ *
+ *  A registration policy provides
+ *
+ *  @code
+ *    void on_alloc(void* ptr, size_t nbytes, c10::Allocator* alloc);
+ *    void on_free(void* ptr, size_t nbytes);
+ *    void flush();
+ *  @endcode
+ *
+ *  where ptr is the DataPtr's context (the allocation's header) and
+ *  nbytes includes the header, so that registry lookups of any
+ *  address in the allocation resolve to the context, as
+ *  PointerRegistry::get_context() promises. A logging policy provides
+ *
+ *  @code
+ *    static void on_alloc(void const* ptr, size_t nbytes);
+ *    static void on_free(void const* ptr, size_t nbytes);
+ *  @endcode
+ */
+
+namespace lbannv2
+{
+
+/** @brief Allocations are not registered with the PointerRegistry.
+ *
+ *  They are then invisible to registry lookups, the MemoryBudget and
+ *  allocation traces.
+ */
+struct NoRegistration
+{
+  void on_alloc(void*, size_t, c10::Allocator*) noexcept {}
+  void on_free(void*, size_t) noexcept {}
+  void flush() noexcept {}
+};
+
+/** @brief Each allocation is registered as it is made, as by
+ *         lbannv2::Allocator.
+ */
+struct EagerRegistration
+{
+  void on_alloc(void* const ptr, size_t const nbytes, c10::Allocator* alloc)
+  {
+    pointer_registry().add(ptr, nbytes, alloc, c10::Device {c10::kCPU});
+  }
+  void on_free(void* const ptr, size_t) { pointer_registry().remove(ptr); }
+  void flush() noexcept {}
+};
+
+/** @brief Allocations are registered in batches.
+ *
+ *  Up to kBatchSize allocations are held back and then registered
+ *  with one PointerRegistry::add_many(). An allocation freed before
+ *  its batch is registered never touches the registry, which is the
+ *  common case for short-lived small tensors. If add_many() throws,
+ *  the batch is dropped: its allocations stay unregistered, and
+ *  freeing them is still safe. Freeing any other allocation that is
+ *  not registered throws UnknownAddress, as with EagerRegistration.
+ *
+ *  Registry lookups only see allocations that have been registered;
+ *  call flush() (BasicAllocator::flush_registrations()) before
+ *  relying on them.
+ */
+class LazyRegistration
+{
+public:
+  static constexpr size_t kBatchSize = 64;
+
+  LazyRegistration() { m_pending.reserve(kBatchSize); }
+
+  void on_alloc(void* const ptr, size_t const nbytes, c10::Allocator* alloc)
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_pending.push_back({ptr, nbytes, alloc, c10::Device {c10::kCPU}});
+    if (m_pending.size() >= kBatchSize)
+      flush_locked();
+  }
+
+  void on_free(void* const ptr, size_t)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      // Recent allocations are the likeliest to be freed.
+      for (auto it = m_pending.rbegin(); it != m_pending.rend(); ++it)
+      {
+        if (it->ptr == ptr)
+        {
+          *it = m_pending.back();
+          m_pending.pop_back();
+          return;
+        }
+      }
+      if (!m_dropped.empty() && m_dropped.erase(ptr))
+        return;
+    }
+    // Neither pending nor dropped, so its batch was registered (under
+    // the lock).
+    pointer_registry().remove(ptr);
+  }
+
+  void flush()
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    flush_locked();
+  }
+
+private:
+  void flush_locked()
+  {
+    if (m_pending.empty())
+      return;
+    // Whether or not registration succeeds, the batch is done with.
+    struct Clear
+    {
+      std::vector<PointerRegistry::Registration>& pending;
+      ~Clear() { pending.clear(); }
+    } const clear {m_pending};
+    try
+    {
+      pointer_registry().add_many(m_pending);
+    }
+    catch (...)
+    {
+      for (auto const& r : m_pending)
+        m_dropped.insert(r.ptr);
+      throw;
+    }
+  }
+
+  std::mutex m_mtx;
+  std::vector<PointerRegistry::Registration> m_pending;
+  /** @brief Allocations of batches that failed to register. */
+  std::unordered_set<void const*> m_dropped;
+};  // class LazyRegistration
+
+/** @brief Nothing is logged. */
+struct NoLogging
+{
+  static void on_alloc(void const*, size_t) noexcept {}
+  static void on_free(void const*, size_t) noexcept {}
+};
+
+/** @brief Allocations and frees are logged at trace level. */
+struct TraceLogging
+{
+  static void on_alloc(void const* const ptr, size_t const nbytes)
+  {
+    LBANNV2_TRACE("BasicAllocator::allocate(n={}): ptr={}", nbytes, ptr);
+  }
+  static void on_free(void const* const ptr, size_t const nbytes)
+  {
+    LBANNV2_TRACE("BasicAllocator::free(n={}): ptr={}", nbytes, ptr);
+  }
+};
+
+/** @class BasicAllocator
+ *  @brief A CPU allocator assembled from compile-time policies.
+ *
+ *  Each allocation is preceded by an AllocationHeader recording the
+ *  allocator and the size. The header is the DataPtr's context, so
+ *  the deleter needs no lookup to find either. (The deleter is not
+ *  lbannv2::Allocator's, so allocation_header() does not recognize
+ *  these allocations.)
+ *
+ *  Unlike lbannv2::Allocator, this does not consult the MemoryBudget
+ *  before allocating (though eagerly registered allocations count
+ *  toward its usage). The allocator must outlive its allocations.
+ *
+ *  @tparam Backing Where the memory comes from (a layer or a stack of
+ *          layers; see policy_layers.hpp).
+ *  @tparam Registration How allocations are registered with the
+ *          PointerRegistry: NoRegistration, EagerRegistration or
+ *          LazyRegistration.
+ *  @tparam Logging NoLogging or TraceLogging.
+ */
+template <typename Backing,
+          typename Registration = EagerRegistration,
+          typename Logging = NoLogging>
+class BasicAllocator final : public c10::Allocator
+{
+public:
+  /** @brief Constructor
+   *
+   *  The arguments are forwarded to the backing.
+   */
+  template <typename... Args>
+  explicit BasicAllocator(Args&&... args)
+    : m_backing(std::forward<Args>(args)...)
+  {}
+
+  BasicAllocator(BasicAllocator const&) = delete;
+  BasicAllocator& operator=(BasicAllocator const&) = delete;
+
+  c10::DataPtr allocate(size_t const n) final
+  {
+    c10::Device const device {c10::kCPU};
+    if (n == 0)
+      return {nullptr, nullptr, &BasicAllocator::deleter, device};
+
+    size_t const total = n + sizeof(AllocationHeader);
+    auto* const header =
+      emplace_allocation_header(m_backing.allocate(total), this, n);
+    void* const ptr = header + 1;
+    try
+    {
+      m_registration.on_alloc(header, total, this);
+    }
+    catch (...)
+    {
+      m_backing.deallocate(header, total);
+      throw;
+    }
+    Logging::on_alloc(ptr, n);
+    return {ptr, header, &BasicAllocator::deleter, device};
+  }
+
+  void copy_data(void* const dst,
+                 void const* const src,
+                 size_t const bytes) const final
+  {
+    std::memcpy(dst, src, bytes);
+  }
+
+  /** @brief Register any allocations held back by the registration
+   *         policy.
+   */
+  void flush_registrations() { m_registration.flush(); }
+
+  /** @brief Return memory held in reserve by the backing. */
+  void release_cached() { m_backing.release(); }
+
+  /** @brief Collect the statistics of the backing's layers. */
+  PolicyStats stats() const
+  {
+    PolicyStats out;
+    m_backing.stats(out);
+    return out;
+  }
+
+private:
+  static void deleter(void* const ctx)
+  {
+    if (!ctx)
+      return;
+    auto* const header = static_cast<AllocationHeader*>(ctx);
+    auto& self = static_cast<BasicAllocator&>(*header->allocator);
+    size_t const n = header->size;
+    size_t const total = n + sizeof(AllocationHeader);
+    self.m_registration.on_free(header, total);
+    Logging::on_free(header + 1, n);
+    self.m_backing.deallocate(header, total);
+  }
+
+  Backing m_backing;
+  Registration m_registration;
+};  // class BasicAllocator
+
+}  // namespace lbannv2
@@ -0,0 +1,452 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/caching_host_allocator.hpp"
+
+#include "lbannv2/memory/registry.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/mman.h>
+
+namespace
+{
+
+using CHA = lbannv2::CachingHostAllocator;
+
+constexpr size_t round_up(size_t const n, size_t const m) noexcept
+{
+  return (n + m - 1) / m * m;
+}
+
+// Size classes divide each power of two into four. Returns the class
+// index and the class size for 0 < nbytes <= kSmallSize.
+std::pair<size_t, size_t> small_class(size_t const nbytes) noexcept
+{
+  constexpr size_t min_log2 = std::countr_zero(CHA::kMinBlockSize);
+  if (nbytes <= CHA::kMinBlockSize)
+    return {0UL, CHA::kMinBlockSize};
+
+  // 2^k < nbytes <= 2^(k+1)
+  size_t const k = std::bit_width(nbytes - 1) - 1;
+  size_t const base = size_t {1} << k;
+  size_t const step = base / 4;
+  size_t const j = (nbytes - base + step - 1) / step;
+  return {1 + (k - min_log2) * 4 + (j - 1), base + j * step};
+}
+
+bool get_env_flag(char const* const name)
+{
+  char const* const env = std::getenv(name);
+  return env && std::strlen(env) && std::strcmp(env, "0") != 0;
+}
+
+void delete_caching_host_ptr(void* const ptr)
+{
+  lbannv2::pointer_registry().remove(ptr);
+  CHA::instance().raw_dealloc(ptr);
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+CachingHostAllocator::CachingHostAllocator()
+  : CachingHostAllocator(get_env_flag("LBANNV2_HOST_CACHE_HEADERS"))
+{}
+
+CachingHostAllocator::CachingHostAllocator(bool const headers)
+  : Allocator(/*register_allocations=*/!headers), m_register_segments {headers}
+{
+  set_header_layout(headers);
+  if (get_env_flag("LBANNV2_HOST_CACHE_SCRUB"))
+    set_scrubbing(true);
+}
+
+size_t CachingHostAllocator::round_size(size_t const nbytes) noexcept
+{
+  if (nbytes == 0)
+    return 0;
+  if (nbytes <= kSmallSize)
+    return small_class(nbytes).second;
+  return round_up(nbytes, kMinBlockSize);
+}
+
+void CachingHostAllocator::copy_data(void* const dst,
+                                     void const* const src,
+                                     size_t const bytes) const
+{
+  std::memcpy(dst, src, bytes);
+}
+
+void* CachingHostAllocator::raw_alloc(size_t const nbytes)
+{
+  if (nbytes == 0)
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return alloc_block(nbytes)->ptr;
+}
+
+void* CachingHostAllocator::raw_alloc_zeroed(size_t const nbytes)
+{
+  if (nbytes == 0)
+    return nullptr;
+
+  void* ptr;
+  bool zeroed;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    Block* const block = alloc_block(nbytes);
+    ptr = block->ptr;
+    zeroed = block->zeroed;
+    if (zeroed)
+      m_stats.zero_fill_elided_bytes += nbytes;
+    else
+      m_stats.zero_filled_bytes += nbytes;
+  }
+
+  // The block is ours now, so there's no need to hold the lock.
+  if (!zeroed)
+    std::memset(ptr, 0, nbytes);
+  return ptr;
+}
+
+void CachingHostAllocator::raw_dealloc(void* const ptr)
+{
+  if (!ptr)
+    return;
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  auto const it = m_blocks.find(ptr);
+  LBANNV2_ASSERT(it != m_blocks.end() && it->second->allocated,
+                 std::runtime_error,
+                 "CachingHostAllocator: pointer not allocated here");
+
+  Block* const block = it->second.get();
+  block->allocated = false;
+  block->zeroed = false;
+  m_stats.allocated_bytes -= block->size;
+
+  LBANNV2_TRACE("CachingHostAllocator::raw_dealloc(ptr={})", ptr);
+
+  if (block->small)
+    m_small_free[small_class(block->size).first].push_back(block);
+  else
+  {
+    free_large(block);
+    if (m_scrub_enabled)
+      m_scrub_cv.notify_one();
+  }
+}
+
+c10::DeleterFnPtr CachingHostAllocator::raw_deleter() const
+{
+  return &delete_caching_host_ptr;
+}
+
+c10::Device CachingHostAllocator::get_device() const noexcept
+{
+  return c10::Device {c10::kCPU};
+}
+
+void CachingHostAllocator::empty_cache()
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  release_cached();
+}
+
+void CachingHostAllocator::set_scrubbing(bool const enable)
+{
+  std::thread old;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (enable == m_scrub_enabled)
+      return;
+    m_scrub_enabled = enable;
+    auto const generation = ++m_scrub_generation;
+    if (enable)
+    {
+      m_scrubber = std::thread([this, generation] { scrub(generation); });
+      return;
+    }
+    old = std::move(m_scrubber);
+  }
+  m_scrub_cv.notify_all();
+  old.join();
+}
+
+bool CachingHostAllocator::scrubbing() const
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_scrub_enabled;
+}
+
+auto CachingHostAllocator::stats() const -> Stats
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_stats;
+}
+
+auto CachingHostAllocator::alloc_block(size_t const nbytes) -> Block*
+{
+  Block* const block =
+    nbytes <= kSmallSize ? alloc_small(nbytes) : alloc_large(nbytes);
+  block->allocated = true;
+  m_stats.allocated_bytes += block->size;
+
+  LBANNV2_TRACE(
+    "CachingHostAllocator::alloc_block(nbytes={}): ptr={}, size={}, zeroed={}",
+    nbytes,
+    block->ptr,
+    block->size,
+    block->zeroed);
+  return block;
+}
+
+auto CachingHostAllocator::alloc_small(size_t const nbytes) -> Block*
+{
+  auto const [idx, size] = small_class(nbytes);
+  auto& free_list = m_small_free[idx];
+  if (!free_list.empty())
+  {
+    Block* const block = free_list.back();
+    free_list.pop_back();
+    ++m_stats.cache_hits;
+    return block;
+  }
+
+  ++m_stats.cache_misses;
+  return new_segment(size, /*small=*/true);
+}
+
+auto CachingHostAllocator::alloc_large(size_t const nbytes) -> Block*
+{
+  size_t const size = round_up(nbytes, kMinBlockSize);
+
+  Block key {nullptr, size, false, false};
+  Block* block = nullptr;
+  if (auto const it = m_large_free.lower_bound(&key); it != m_large_free.end())
+  {
+    block = *it;
+    m_large_free.erase(it);
+    ++m_stats.cache_hits;
+  }
+  else
+  {
+    auto const segment_size = size < kMinLargeAlloc
+                                ? kLargeBuffer
+                                : round_up(size, kRoundLarge);
+    block = new_segment(segment_size, /*small=*/false);
+    ++m_stats.cache_misses;
+  }
+
+  // Only split off remainders that could serve a large request on
+  // their own; anything smaller can only be used after coalescing.
+  if (block->size - size > kSmallSize)
+  {
+    void* const rest_ptr = static_cast<std::byte*>(block->ptr) + size;
+    auto rest = std::make_unique<Block>(Block {rest_ptr,
+                                               block->size - size,
+                                               false,
+                                               false,
+                                               block->zeroed,
+                                               false,
+                                               block,
+                                               block->next});
+    if (block->next)
+      block->next->prev = rest.get();
+    block->next = rest.get();
+    block->size = size;
+    m_large_free.insert(rest.get());
+    m_blocks.emplace(rest_ptr, std::move(rest));
+  }
+  return block;
+}
+
+auto CachingHostAllocator::new_segment(size_t const nbytes, bool const small)
+  -> Block*
+{
+  // Large segments are mapped (and so zeroed) and are multiples of
+  // the page size.
+  auto const sys_alloc = [nbytes, small]() -> void* {
+    void* ptr = nullptr;
+    if (small)
+      return posix_memalign(&ptr, kAlignment, nbytes) == 0 ? ptr : nullptr;
+    ptr = mmap(nullptr,
+               nbytes,
+               PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS,
+               -1,
+               0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+  };
+
+  void* ptr = sys_alloc();
+  if (!ptr)
+  {
+    // Give back what we're hoarding and try once more.
+    LBANNV2_DEBUG("CachingHostAllocator: allocation of {} bytes failed; "
+                  "releasing cached memory and retrying",
+                  nbytes);
+    release_cached();
+    ptr = sys_alloc();
+    LBANNV2_ASSERT(
+      ptr, std::runtime_error, "CachingHostAllocator: out of memory");
+  }
+
+  if (m_register_segments)
+  {
+    try
+    {
+      pointer_registry().add(ptr, nbytes, this, get_device());
+    }
+    catch (...)
+    {
+      if (small)
+        std::free(ptr);
+      else
+        munmap(ptr, nbytes);
+      throw;
+    }
+  }
+  m_stats.reserved_bytes += nbytes;
+  ++m_stats.num_segments;
+
+  auto block =
+    std::make_unique<Block>(Block {ptr, nbytes, false, small, !small});
+  Block* const out = block.get();
+  m_blocks.emplace(ptr, std::move(block));
+  return out;
+}
+
+void CachingHostAllocator::free_large(Block* block)
+{
+  // A block being scrubbed is neither allocated nor in the free set;
+  // leave it alone until the scrubber hands it back.
+  if (Block* const prev = block->prev;
+      prev && !prev->allocated && !prev->scrubbing)
+  {
+    m_large_free.erase(prev);
+    prev->zeroed = prev->zeroed && block->zeroed;
+    prev->size += block->size;
+    prev->next = block->next;
+    if (block->next)
+      block->next->prev = prev;
+    void const* const key = block->ptr;
+    m_blocks.erase(key);
+    block = prev;
+  }
+
+  if (Block* const next = block->next;
+      next && !next->allocated && !next->scrubbing)
+  {
+    m_large_free.erase(next);
+    block->zeroed = block->zeroed && next->zeroed;
+    block->size += next->size;
+    block->next = next->next;
+    if (next->next)
+      next->next->prev = block;
+    void const* const key = next->ptr;
+    m_blocks.erase(key);
+  }
+
+  m_large_free.insert(block);
+}
+
+void CachingHostAllocator::release_cached()
+{
+  std::vector<Block*> released;
+  for (auto& free_list : m_small_free)
+  {
+    released.insert(released.end(), free_list.cbegin(), free_list.cend());
+    free_list.clear();
+  }
+
+  // Only whole segments can be given back.
+  for (auto it = m_large_free.begin(); it != m_large_free.end();)
+  {
+    Block* const block = *it;
+    if (block->prev || block->next)
+    {
+      ++it;
+      continue;
+    }
+    it = m_large_free.erase(it);
+    released.push_back(block);
+  }
+
+  if (m_register_segments)
+  {
+    std::vector<void*> ptrs;
+    ptrs.reserve(released.size());
+    for (Block const* const block : released)
+      ptrs.push_back(block->ptr);
+    pointer_registry().remove_many(ptrs);
+  }
+
+  for (Block* const block : released)
+  {
+    void* const ptr = block->ptr;
+    m_stats.reserved_bytes -= block->size;
+    --m_stats.num_segments;
+    if (block->small)
+      std::free(ptr);
+    else
+      munmap(ptr, block->size);
+    m_blocks.erase(ptr);
+  }
+}
+
+auto CachingHostAllocator::find_dirty() const -> Block*
+{
+  for (Block* const block : m_large_free)
+    if (!block->zeroed)
+      return block;
+  return nullptr;
+}
+
+void CachingHostAllocator::scrub(size_t const generation)
+{
+  std::unique_lock<std::mutex> lock(m_mtx);
+  while (true)
+  {
+    Block* block = nullptr;
+    m_scrub_cv.wait(lock, [&] {
+      if (m_scrub_generation != generation)
+        return true;
+      block = find_dirty();
+      return block != nullptr;
+    });
+    if (m_scrub_generation != generation)
+      return;
+
+    // Take the block out of circulation while it's being zeroed.
+    m_large_free.erase(block);
+    block->scrubbing = true;
+    lock.unlock();
+    std::memset(block->ptr, 0, block->size);
+    lock.lock();
+    block->scrubbing = false;
+    block->zeroed = true;
+    m_stats.scrubbed_bytes += block->size;
+    free_large(block);
+  }
+}
+
+CachingHostAllocator& CachingHostAllocator::instance()
+{
+  // Never destroyed: tensors may well outlive static destruction.
+  static CachingHostAllocator* const alloc = new CachingHostAllocator;
+  return *alloc;
+}
+
+}  // namespace lbannv2
@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace lbannv2
+{
+
+/** @class CachingHostAllocator
+ *  @brief A caching allocator for CPU memory.
+ *
+ *  This is loosely modeled on c10's CUDA caching allocator, minus
+ *  the streams. Requests of at most kSmallSize bytes are rounded up
+ *  to a size class (four classes per power of two) and served from a
+ *  per-class free list of whole blocks. Larger requests are carved
+ *  out of segments of kLargeBuffer bytes (or, for requests of at
+ *  least kMinLargeAlloc bytes, the request rounded up to a multiple
+ *  of kRoundLarge bytes). Free large blocks are kept in best-fit
+ *  order, split when the remainder would be large enough to serve
+ *  another large request, and coalesced with free neighbors when
+ *  released.
+ *
+ *  Memory is only returned to the system by empty_cache(), or when an
+ *  allocation fails and the cache is flushed before retrying.
+ *
+ *  Large segments are anonymous mappings, so they start out zeroed.
+ *  The allocator tracks which free large blocks are still known to be
+ *  zero, and raw_alloc_zeroed() skips the memset for those. Freed
+ *  blocks are dirty; optionally, a background thread scrubs dirty
+ *  free large blocks so that later zeroed allocations can skip the
+ *  memset too. Scrubbing is enabled with set_scrubbing() or by setting
+ *  LBANNV2_HOST_CACHE_SCRUB=1.
+ *
+ *  If LBANNV2_HOST_CACHE_HEADERS=1 when the allocator is created, it
+ *  uses the header layout (see Allocator::set_header_layout()) and
+ *  registers whole segments with the PointerRegistry rather than
+ *  individual blocks. Frees then skip the registry entirely, while
+ *  lookups of any address in a segment still work (and find this
+ *  allocator). The MemoryBudget then counts reserved rather than
+ *  allocated bytes.
+ */
+class LBANNV2_EXPORT CachingHostAllocator final : public Allocator
+{
+public:
+  /** @brief Alignment of every block. */
+  static constexpr size_t kAlignment = 64;
+  /** @brief The smallest size class. */
+  static constexpr size_t kMinBlockSize = 512;
+  /** @brief The largest request served from the small pool. */
+  static constexpr size_t kSmallSize = size_t {1} << 20;
+  /** @brief Segment size for large requests below kMinLargeAlloc. */
+  static constexpr size_t kLargeBuffer = size_t {20} << 20;
+  /** @brief Requests at least this big get their own segment. */
+  static constexpr size_t kMinLargeAlloc = size_t {10} << 20;
+  /** @brief Dedicated segments are rounded to a multiple of this. */
+  static constexpr size_t kRoundLarge = size_t {2} << 20;
+
+  struct Stats
+  {
+    /** @brief Bytes obtained from the system. */
+    size_t reserved_bytes = 0UL;
+    /** @brief Bytes in blocks that are handed out. */
+    size_t allocated_bytes = 0UL;
+    /** @brief Number of system allocations currently held. */
+    size_t num_segments = 0UL;
+    /** @brief Requests served from the cache. */
+    size_t cache_hits = 0UL;
+    /** @brief Requests that needed a new system allocation. */
+    size_t cache_misses = 0UL;
+    /** @brief Bytes zeroed by raw_alloc_zeroed() with memset. */
+    size_t zero_filled_bytes = 0UL;
+    /** @brief Bytes raw_alloc_zeroed() knew to be zero already. */
+    size_t zero_fill_elided_bytes = 0UL;
+    /** @brief Bytes zeroed by the background scrubber. */
+    size_t scrubbed_bytes = 0UL;
+  };
+
+  void copy_data(void* dst, void const* src, size_t bytes) const final;
+
+  void* raw_alloc(size_t nbytes) final;
+
+  void* raw_alloc_zeroed(size_t nbytes) final;
+
+  void raw_dealloc(void* ptr) final;
+
+  c10::DeleterFnPtr raw_deleter() const final;
+
+  c10::Device get_device() const noexcept final;
+
+  /** @brief Release all cached memory that is not in use. */
+  void empty_cache();
+
+  /** @brief Start or stop the background scrubber. */
+  void set_scrubbing(bool enable);
+
+  bool scrubbing() const;
+
+  /** @brief Get a snapshot of the cache statistics. */
+  Stats stats() const;
+
+  /** @brief The size actually reserved for a request of nbytes. */
+  static size_t round_size(size_t nbytes) noexcept;
+
+  static CachingHostAllocator& instance();
+
+private:
+  CachingHostAllocator();
+  explicit CachingHostAllocator(bool headers);
+  ~CachingHostAllocator() = default;
+  CachingHostAllocator(CachingHostAllocator const&) = delete;
+  CachingHostAllocator(CachingHostAllocator&&) = delete;
+  CachingHostAllocator& operator=(CachingHostAllocator const&) = delete;
+  CachingHostAllocator& operator=(CachingHostAllocator&&) = delete;
+
+  struct Block
+  {
+    void* ptr;
+    size_t size;
+    bool allocated = false;
+    bool small;
+    // The contents are known to be zero.
+    bool zeroed = false;
+    // Being zeroed by the scrubber, which owns it for the time being.
+    bool scrubbing = false;
+    // Neighbors within a large segment.
+    Block* prev = nullptr;
+    Block* next = nullptr;
+  };
+
+  struct BlockBestFit
+  {
+    bool operator()(Block const* a, Block const* b) const noexcept
+    {
+      return a->size != b->size ? a->size < b->size : a->ptr < b->ptr;
+    }
+  };
+
+  static constexpr size_t kNumSmallClasses = 45;
+
+  // All of these require m_mtx to be held.
+  Block* alloc_block(size_t nbytes);
+  Block* alloc_small(size_t nbytes);
+  Block* alloc_large(size_t nbytes);
+  Block* new_segment(size_t nbytes, bool small);
+  void free_large(Block* block);
+  void release_cached();
+
+  Block* find_dirty() const;
+  void scrub(size_t generation);
+
+  mutable std::mutex m_mtx;
+  std::unordered_map<void const*, std::unique_ptr<Block>> m_blocks;
+  std::array<std::vector<Block*>, kNumSmallClasses> m_small_free;
+  std::set<Block*, BlockBestFit> m_large_free;
+  Stats m_stats;
+
+  // Segments, rather than blocks, are registered.
+  bool const m_register_segments;
+
+  // Scrubber state; guarded by m_mtx.
+  std::thread m_scrubber;
+  std::condition_variable m_scrub_cv;
+  bool m_scrub_enabled = false;
+  // Bumped to tell the current scrubber to exit.
+  size_t m_scrub_generation = 0UL;
+};  // class CachingHostAllocator
+
+}  // namespace lbannv2
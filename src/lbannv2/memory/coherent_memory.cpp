@@ -0,0 +1,399 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/coherent_memory.hpp"
+
+#include "lbannv2/memory/deferred_free.hpp"
+#include "lbannv2/memory/registry.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#if LBANNV2_WITH_MI300A || LBANNV2_UNKNOWN_MI300A
+#include "lbannv2/memory/mi300a_allocator.hpp"
+#include "lbannv2/utils/gpu_utils.hpp"
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace
+{
+
+using ECM = lbannv2::EmulatedCoherentMemory;
+
+// Matches the c10 CPU allocator.
+constexpr size_t heap_alignment = 64;
+
+c10::DeviceIndex get_env_num_devices()
+{
+  char const* const env = std::getenv("LBANNV2_EMULATED_DEVICES");
+  if (env && std::strlen(env))
+    return static_cast<c10::DeviceIndex>(std::atoi(env));
+  return 1;
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+// CoherentMemoryDomain
+
+c10::Device CoherentMemoryDomain::resolve(c10::Device const& d) const
+{
+  if (d.type() == device_type() && !d.has_index())
+    return {d.type(), current_device()};
+  return d;
+}
+
+bool CoherentMemoryDomain::can_migrate(void const* const ptr,
+                                       c10::Device const& d) const
+{
+  auto const tgt = resolve(d);
+  return tgt.is_cpu() || origin(ptr) == tgt;
+}
+
+void CoherentMemoryDomain::rebrand(c10::DataPtr& ptr,
+                                   c10::Device const to,
+                                   c10::Stream const stream)
+{
+  auto const tgt = resolve(to);
+
+  // If no migration actually happens, just short-circuit...
+  if (ptr.device() == tgt)
+    return;
+
+  LBANNV2_ASSERT(can_migrate(ptr.get_context(), tgt),
+                 std::runtime_error,
+                 "lbannv2::migrate_ptr: invalid src/tgt device combo");
+
+  associate(ptr, tgt, stream);
+  ptr.unsafe_set_device(tgt);
+
+  // Keep the registry's per-device accounting honest.
+  try
+  {
+    pointer_registry().unsafe_reset_device(ptr.get_context(), tgt);
+  }
+  catch (UnknownAddress const&)
+  {
+    // ignore -- ptr allocated in Torch
+  }
+}
+
+// EmulatedCoherentMemory
+
+/** @brief Host memory tied to the current emulated device. */
+class EmulatedCoherentMemory::HostAllocator final : public Allocator
+{
+public:
+  explicit HostAllocator(EmulatedCoherentMemory& domain) : m_domain {domain}
+  {}
+
+  void copy_data(void* const dst,
+                 void const* const src,
+                 size_t const bytes) const final
+  {
+    std::memcpy(dst, src, bytes);
+  }
+
+  void* raw_alloc(size_t const nbytes) final
+  {
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, heap_alignment, nbytes ? nbytes : 1) != 0)
+      return nullptr;
+
+    std::lock_guard<std::mutex> lock(m_domain.m_mtx);
+    m_domain.m_allocations.emplace(
+      ptr, Allocation {m_domain.current_device(), 0});
+    ++m_domain.m_stats.num_allocations;
+    return ptr;
+  }
+
+  void raw_dealloc(void* const ptr) final
+  {
+    if (!ptr)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(m_domain.m_mtx);
+      m_domain.m_allocations.erase(ptr);
+      --m_domain.m_stats.num_allocations;
+    }
+    std::free(ptr);
+  }
+
+  c10::DeleterFnPtr raw_deleter() const final { return &delete_ptr; }
+
+  c10::Device get_device() const noexcept final
+  {
+    return c10::Device {c10::kCPU};
+  }
+
+private:
+  // Device work queued before the free may still use the memory, so
+  // a block that has been on a busy device is released after it.
+  static void delete_ptr(void* const ptr)
+  {
+    auto& registry = pointer_registry();
+    auto& alloc = static_cast<HostAllocator&>(*registry.get_allocator(ptr));
+    auto const nbytes = registry.remove(ptr);
+    if (auto event = alloc.pending_work(ptr))
+      DeferredFree::instance().defer_after(
+        alloc, ptr, nbytes, [event = std::move(event)] {
+          event->synchronize();
+        });
+    else
+      release_or_defer(alloc, ptr, nbytes);
+  }
+
+  // An event after the work on the stream of the device the block has
+  // been on, if that stream is busy.
+  std::shared_ptr<HostEvent> pending_work(void const* const ptr)
+  {
+    HostStream* stream = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(m_domain.m_mtx);
+      auto const it = m_domain.m_allocations.find(ptr);
+      if (it == m_domain.m_allocations.end() || !it->second.used_on_device)
+        return nullptr;
+      stream = m_domain.m_streams[it->second.device].get();
+    }
+    if (stream->query())
+      return nullptr;
+
+    auto event = std::make_shared<HostEvent>();
+    event->record(*stream);
+    std::lock_guard<std::mutex> lock(m_domain.m_mtx);
+    ++m_domain.m_stats.num_deferred_frees;
+    return event;
+  }
+
+  EmulatedCoherentMemory& m_domain;
+};  // class EmulatedCoherentMemory::HostAllocator
+
+/** @brief A HostEvent on an emulated device's stream. */
+class EmulatedCoherentMemory::HostFence final
+  : public CoherentMemoryDomain::Fence
+{
+public:
+  HostFence(EmulatedCoherentMemory& domain, HostStream& stream)
+    : m_domain {domain}
+  {
+    m_event.record(stream);
+  }
+
+  bool query() const final { return m_event.query(); }
+
+  void wait() const final { m_event.synchronize(); }
+
+  void wait_on(c10::Stream const stream) const final
+  {
+    if (stream.device().is_cpu())
+      wait();
+    else
+      m_domain.stream(stream.device()).wait(m_event);
+  }
+
+private:
+  EmulatedCoherentMemory& m_domain;
+  HostEvent m_event;
+};  // class EmulatedCoherentMemory::HostFence
+
+EmulatedCoherentMemory::EmulatedCoherentMemory(
+  c10::DeviceIndex const num_devices)
+  : m_num_devices {num_devices},
+    m_host_allocator {std::make_unique<HostAllocator>(*this)}
+{
+  LBANNV2_ASSERT(m_num_devices > 0,
+                 std::runtime_error,
+                 "EmulatedCoherentMemory: need at least one device");
+  m_streams.reserve(m_num_devices);
+  for (c10::DeviceIndex d = 0; d < m_num_devices; ++d)
+    m_streams.push_back(std::make_unique<HostStream>());
+}
+
+EmulatedCoherentMemory::~EmulatedCoherentMemory()
+{
+  // Frees waiting on our streams must not outlive them.
+  DeferredFree::instance().drain(m_host_allocator.get());
+}
+
+std::string EmulatedCoherentMemory::name() const
+{
+  return "emulated";
+}
+
+c10::DeviceType EmulatedCoherentMemory::device_type() const noexcept
+{
+  return c10::kCUDA;
+}
+
+c10::DeviceIndex EmulatedCoherentMemory::current_device() const
+{
+  return m_current_device.load(std::memory_order_relaxed);
+}
+
+void EmulatedCoherentMemory::set_current_device(c10::DeviceIndex const d)
+{
+  LBANNV2_ASSERT(d >= 0 && d < m_num_devices,
+                 std::runtime_error,
+                 "EmulatedCoherentMemory: no such device");
+  m_current_device.store(d, std::memory_order_relaxed);
+}
+
+Allocator& EmulatedCoherentMemory::host_allocator()
+{
+  return *m_host_allocator;
+}
+
+c10::Device EmulatedCoherentMemory::origin(void const* const ptr) const noexcept
+{
+  try
+  {
+    auto& registry = pointer_registry();
+    if (!registry.known(ptr)
+        || registry.get_allocator(ptr) != m_host_allocator.get())
+      return c10::Device {c10::kCPU};
+    auto const* const ctx = registry.get_context(ptr);
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto const it = m_allocations.find(ctx);
+    if (it != m_allocations.end())
+      return c10::Device {device_type(), it->second.device};
+  }
+  catch (...)
+  {
+    // Freed in the meantime.
+  }
+  return c10::Device {c10::kCPU};
+}
+
+c10::Stream EmulatedCoherentMemory::current_stream(c10::Device device) const
+{
+  return c10::Stream {c10::Stream::DEFAULT, resolve(device)};
+}
+
+void EmulatedCoherentMemory::synchronize(c10::Device const device)
+{
+  auto& s = stream(device);
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.num_synchronizations;
+  }
+  s.synchronize();
+}
+
+auto EmulatedCoherentMemory::record(c10::Device const device)
+  -> std::shared_ptr<Fence>
+{
+  return std::make_shared<HostFence>(*this, stream(device));
+}
+
+HostStream& EmulatedCoherentMemory::stream(c10::Device const device)
+{
+  auto const d = resolve(device);
+  LBANNV2_ASSERT(d.type() == device_type() && d.index() < m_num_devices,
+                 std::runtime_error,
+                 "EmulatedCoherentMemory: no such device");
+  return *m_streams[d.index()];
+}
+
+void EmulatedCoherentMemory::associate(c10::DataPtr& ptr,
+                                       c10::Device const& to,
+                                       c10::Stream const stream)
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  auto const it = m_allocations.find(ptr.get_context());
+  if (it != m_allocations.end())
+  {
+    it->second.stream = to.is_cpu() ? 0 : stream.id();
+    it->second.used_on_device |= !to.is_cpu();
+  }
+  if (to.is_cpu())
+    ++m_stats.num_to_host;
+  else
+    ++m_stats.num_to_device;
+}
+
+c10::StreamId EmulatedCoherentMemory::associated_stream(void const* ptr) const
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  auto const it = m_allocations.find(ptr);
+  return it == m_allocations.end() ? 0 : it->second.stream;
+}
+
+auto EmulatedCoherentMemory::stats() const -> Stats
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_stats;
+}
+
+EmulatedCoherentMemory& EmulatedCoherentMemory::instance()
+{
+  // Never destroyed: tensors may well outlive static destruction.
+  static EmulatedCoherentMemory* const domain =
+    new EmulatedCoherentMemory(get_env_num_devices());
+  return *domain;
+}
+
+}  // namespace lbannv2
+
+namespace
+{
+
+lbannv2::CoherentMemoryDomain* default_domain()
+{
+  char const* const env = std::getenv("LBANNV2_COHERENT_MEMORY");
+  std::string const choice = env ? env : "";
+  if (choice == "none")
+    return nullptr;
+  if (choice == "emulated")
+    return &ECM::instance();
+#if LBANNV2_WITH_MI300A || LBANNV2_UNKNOWN_MI300A
+#if LBANNV2_UNKNOWN_MI300A
+  if (lbannv2::gpu::is_integrated())
+#endif
+    return &lbannv2::mi300a_coherent_memory();
+#endif
+  if (choice == "mi300a")
+    LBANNV2_WARN("No MI300A coherent memory available");
+  else if (!choice.empty())
+    LBANNV2_WARN("Unknown LBANNV2_COHERENT_MEMORY \"{}\"", choice);
+  return nullptr;
+}
+
+std::atomic<lbannv2::CoherentMemoryDomain*>& domain_in_use()
+{
+  static std::atomic<lbannv2::CoherentMemoryDomain*> domain =
+    default_domain();
+  return domain;
+}
+
+}  // namespace
+
+lbannv2::CoherentMemoryDomain* lbannv2::coherent_memory_domain()
+{
+  return domain_in_use().load(std::memory_order_acquire);
+}
+
+void lbannv2::set_coherent_memory_domain(CoherentMemoryDomain* const domain)
+{
+  LBANNV2_DEBUG("Using coherent memory domain \"{}\"",
+                domain ? domain->name() : "none");
+  domain_in_use().store(domain, std::memory_order_release);
+}
+
+void lbannv2::migrate_ptr(c10::DataPtr& ptr,
+                          c10::Device const to_device,
+                          c10::Stream const with_stream)
+{
+  auto* const domain = coherent_memory_domain();
+  LBANNV2_ASSERT(domain,
+                 std::runtime_error,
+                 "migrate_ptr needs a coherent memory domain");
+  domain->rebrand(ptr, to_device, with_stream);
+}
@@ -0,0 +1,286 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+
+#include <c10/core/Device.h>
+#include <c10/core/DeviceType.h>
+#include <c10/core/Stream.h>
+
+#include <lbannv2/utils/host_stream.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lbannv2
+{
+
+/** @class CoherentMemoryDomain
+ *  @brief Host memory that some devices can use directly.
+ *
+ *  On architectures where the host and the devices share memory
+ *  coherently (e.g., MI300A), a tensor can move between the host and
+ *  a device by changing the device it claims to be on, without
+ *  copying. A domain provides what that takes:
+ *
+ *    - an allocator for host memory that the devices can use;
+ *    - ownership queries: which device an allocation is tied to;
+ *    - stream association, so that memory is not reused while device
+ *      work on it is pending;
+ *    - fences, so that migration can be ordered after device work
+ *      without blocking the host;
+ *    - the zero-copy rebranding of a DataPtr itself (rebrand()).
+ *
+ *  At most one domain is in use at a time (see
+ *  coherent_memory_domain()), and lbannv2::migrate() goes through it.
+ *  Memory allocated on the host outside of the domain's allocator is
+ *  tied to the host and can only be migrated to it.
+ */
+class LBANNV2_EXPORT CoherentMemoryDomain
+{
+public:
+  /** @class Fence
+   *  @brief A point in the work of a device's stream, like a GPU
+   *         event.
+   */
+  class Fence
+  {
+  public:
+    virtual ~Fence() = default;
+
+    /** @brief Whether the work before the fence has completed. */
+    virtual bool query() const = 0;
+
+    /** @brief Block the host until the work before the fence has
+     *         completed.
+     */
+    virtual void wait() const = 0;
+
+    /** @brief Make later work on a stream wait for the fence.
+     *
+     *  This does not block the host, unless the stream is a CPU
+     *  stream, in which case it is wait().
+     */
+    virtual void wait_on(c10::Stream stream) const = 0;
+  };
+
+  virtual ~CoherentMemoryDomain() = default;
+
+  /** @brief A short name for the domain (e.g., "mi300a"). */
+  virtual std::string name() const = 0;
+
+  /** @brief The type of the devices that share memory with the host. */
+  virtual c10::DeviceType device_type() const noexcept = 0;
+
+  /** @brief The current device (of device_type()). */
+  virtual c10::DeviceIndex current_device() const = 0;
+
+  /** @brief The allocator for host memory that the devices can use.
+   *
+   *  Allocations are tied to the current device.
+   */
+  virtual Allocator& host_allocator() = 0;
+
+  /** @brief The device an allocation is tied to.
+   *
+   *  @param[in] ptr Any address in the allocation.
+   *
+   *  @returns The device, or the CPU if ptr is not device-usable
+   *           memory of this domain.
+   */
+  virtual c10::Device origin(void const* ptr) const noexcept = 0;
+
+  /** @brief The stream on which work for the device is ordered. */
+  virtual c10::Stream current_stream(c10::Device device) const = 0;
+
+  /** @brief Wait for the work on the device's current stream. */
+  virtual void synchronize(c10::Device device) = 0;
+
+  /** @brief Record a fence after the work on the device's current
+   *         stream.
+   */
+  virtual std::shared_ptr<Fence> record(c10::Device device) = 0;
+
+  /** @brief Fill in the current device if d has no index. */
+  c10::Device resolve(c10::Device const& d) const;
+
+  /** @brief Whether the memory at ptr can be rebranded to device d.
+   *
+   *  Anything can be rebranded to the CPU. Memory tied to a device
+   *  can be rebranded to that device only.
+   */
+  bool can_migrate(void const* ptr, c10::Device const& d) const;
+
+  /** @brief Rebrand a DataPtr to a new device without copying.
+   *
+   *  The allocation is associated with the stream (or, for the CPU,
+   *  with the domain's host stream) before its device is changed, and
+   *  the PointerRegistry's per-device accounting is updated.
+   *
+   *  @throws std::runtime_error if the DataPtr cannot be migrated to
+   *          the device.
+   */
+  void rebrand(c10::DataPtr& ptr, c10::Device to, c10::Stream stream);
+
+protected:
+  /** @brief Associate an allocation with the stream that will use it
+   *         on the device it is being rebranded to.
+   *
+   *  @param[in] ptr The allocation.
+   *  @param[in] to The device it is rebranded to (possibly the CPU).
+   *  @param[in] stream The stream on which it will be used; for the
+   *                    CPU, the default stream.
+   */
+  virtual void
+  associate(c10::DataPtr& ptr, c10::Device const& to, c10::Stream stream) = 0;
+};  // class CoherentMemoryDomain
+
+/** @class EmulatedCoherentMemory
+ *  @brief A coherent-memory domain emulated on the host.
+ *
+ *  This lets zero-copy migration, the registry bookkeeping that goes
+ *  with it and the automigrate pass run (and be benchmarked) on
+ *  machines without coherent memory, including CPU-only builds. The
+ *  emulated devices are CUDA devices 0 to num_devices() - 1 whose
+ *  memory is host memory from host_allocator(). Nothing runs on them:
+ *  without device kernels, tensors rebranded to them only support
+ *  metadata operations and migration back to the CPU.
+ *
+ *  Each emulated device has one stream, a HostStream (see stream()).
+ *  Work enqueued on it plays the part of device kernels, so
+ *  synchronization and fences behave as on a real device. The stream
+ *  last associated with each allocation is recorded, and freeing an
+ *  allocation that has been on a device whose stream is busy is
+ *  deferred (see DeferredFree::defer_after()) until the work queued
+ *  there before the free has completed. Since real device kernels
+ *  would dereference host pointers, this domain should not be used
+ *  where the devices are real, discrete GPUs.
+ *
+ *  instance() has LBANNV2_EMULATED_DEVICES devices (1 by default).
+ *  Other domains (e.g., with more devices, for tests) can be made
+ *  directly; each has its own host_allocator(), and must outlive the
+ *  memory allocated with it.
+ */
+class LBANNV2_EXPORT EmulatedCoherentMemory final
+  : public CoherentMemoryDomain
+{
+public:
+  struct Stats
+  {
+    /** @brief Live allocations of host_allocator(). */
+    size_t num_allocations = 0UL;
+    /** @brief Rebrands to a device, in total. */
+    size_t num_to_device = 0UL;
+    /** @brief Rebrands to the CPU, in total. */
+    size_t num_to_host = 0UL;
+    /** @brief Calls to synchronize(), in total. */
+    size_t num_synchronizations = 0UL;
+    /** @brief Frees deferred behind device work, in total. */
+    size_t num_deferred_frees = 0UL;
+  };
+
+  /** @brief Constructor
+   *
+   *  @param[in] num_devices The number of emulated devices (> 0).
+   */
+  explicit EmulatedCoherentMemory(c10::DeviceIndex num_devices);
+  ~EmulatedCoherentMemory();
+  EmulatedCoherentMemory(EmulatedCoherentMemory const&) = delete;
+  EmulatedCoherentMemory(EmulatedCoherentMemory&&) = delete;
+  EmulatedCoherentMemory& operator=(EmulatedCoherentMemory const&) = delete;
+  EmulatedCoherentMemory& operator=(EmulatedCoherentMemory&&) = delete;
+
+  std::string name() const final;
+  c10::DeviceType device_type() const noexcept final;
+  c10::DeviceIndex current_device() const final;
+  Allocator& host_allocator() final;
+  c10::Device origin(void const* ptr) const noexcept final;
+  c10::Stream current_stream(c10::Device device) const final;
+  void synchronize(c10::Device device) final;
+  std::shared_ptr<Fence> record(c10::Device device) final;
+
+  c10::DeviceIndex num_devices() const noexcept { return m_num_devices; }
+
+  /** @brief The stream of an emulated device.
+   *
+   *  @throws std::runtime_error if there is no such device.
+   */
+  HostStream& stream(c10::Device device);
+
+  /** @brief Set the current device. */
+  void set_current_device(c10::DeviceIndex d);
+
+  /** @brief The stream last associated with an allocation.
+   *
+   *  @returns The stream's id, or 0 (the default stream) if none.
+   */
+  c10::StreamId associated_stream(void const* ptr) const;
+
+  Stats stats() const;
+
+  static EmulatedCoherentMemory& instance();
+
+private:
+  void
+  associate(c10::DataPtr& ptr, c10::Device const& to, c10::Stream stream) final;
+
+  class HostAllocator;
+  friend class HostAllocator;
+  class HostFence;
+
+  c10::DeviceIndex const m_num_devices;
+  std::vector<std::unique_ptr<HostStream>> m_streams;
+  std::unique_ptr<HostAllocator> m_host_allocator;
+  std::atomic<c10::DeviceIndex> m_current_device = 0;
+
+  struct Allocation
+  {
+    c10::DeviceIndex device;
+    c10::StreamId stream;
+    /** @brief Whether it has been rebranded to its device, whose
+     *         stream may then have work on it. */
+    bool used_on_device = false;
+  };
+  mutable std::mutex m_mtx;
+  /** @brief The live allocations, by context pointer. */
+  std::unordered_map<void const*, Allocation> m_allocations;
+  Stats m_stats;
+};  // class EmulatedCoherentMemory
+
+/** @brief Get the coherent-memory domain in use.
+ *
+ *  On first use, this is chosen by LBANNV2_COHERENT_MEMORY: "mi300a",
+ *  "emulated" or "none". By default, it is the MI300A domain if this
+ *  is an MI300A build running on one, and none otherwise.
+ *
+ *  @returns The domain, or nullptr if there is none.
+ */
+LBANNV2_EXPORT CoherentMemoryDomain* coherent_memory_domain();
+
+/** @brief Set the coherent-memory domain (nullptr for none).
+ *
+ *  Memory rebranded by the previous domain should be migrated back
+ *  to the CPU first.
+ */
+LBANNV2_EXPORT void set_coherent_memory_domain(CoherentMemoryDomain* domain);
+
+/** @brief Rebrand a DataPtr with the coherent-memory domain in use.
+ *
+ *  @throws std::runtime_error if there is no domain or the DataPtr
+ *          cannot be migrated to the device.
+ */
+LBANNV2_EXPORT void
+migrate_ptr(c10::DataPtr& ptr, c10::Device to_device, c10::Stream with_stream);
+
+}  // namespace lbannv2
@@ -0,0 +1,213 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/deferred_free.hpp"
+
+#include "lbannv2/memory/allocator.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+size_t get_env_threshold()
+{
+  char const* const env = std::getenv("LBANNV2_DEFERRED_FREE_THRESHOLD");
+  if (env && std::strlen(env))
+    return std::strtoull(env, nullptr, 0);
+  return 0UL;
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+DeferredFree::DeferredFree() : m_threshold {get_env_threshold()}
+{
+  LBANNV2_DEBUG("DeferredFree: threshold={}", threshold());
+}
+
+bool DeferredFree::defer(Allocator& alloc, void* const ptr, size_t const nbytes)
+{
+  auto const min_size = threshold();
+  if (!ptr || !min_size || nbytes < min_size)
+    return false;
+
+  enqueue({&alloc, ptr, nbytes, Clock::now(), nullptr});
+  LBANNV2_TRACE("DeferredFree::defer(ptr={}, nbytes={})", ptr, nbytes);
+  return true;
+}
+
+void DeferredFree::defer_after(Allocator& alloc,
+                               void* const ptr,
+                               size_t const nbytes,
+                               Wait wait)
+{
+  if (!ptr)
+    return;
+  enqueue({&alloc, ptr, nbytes, Clock::now(), std::move(wait)});
+  LBANNV2_TRACE("DeferredFree::defer_after(ptr={}, nbytes={})", ptr, nbytes);
+}
+
+#if LBANNV2_HAS_STREAMS
+void DeferredFree::defer_on_stream(Allocator& alloc,
+                                   void* const ptr,
+                                   size_t const nbytes,
+                                   gpu::Stream_t const stream)
+{
+  if (!ptr)
+    return;
+  auto const event = gpu::make_event();
+  try
+  {
+    gpu::record_event(event, stream);
+  }
+  catch (...)
+  {
+    gpu::destroy_event(event);
+    throw;
+  }
+  // Each entry is released exactly once, so the event is destroyed
+  // exactly once.
+  defer_after(alloc, ptr, nbytes, [event] {
+    try
+    {
+      gpu::sync_event(event);
+    }
+    catch (...)
+    {
+      gpu::destroy_event(event);
+      throw;
+    }
+    gpu::destroy_event(event);
+  });
+}
+#endif
+
+void DeferredFree::enqueue(Entry entry)
+{
+  auto const nbytes = entry.size;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    // The worker is started on first use.
+    if (!m_worker.joinable())
+      m_worker = std::thread([this] { work(); });
+    m_queue.push_back(std::move(entry));
+    m_pending_bytes.fetch_add(nbytes, std::memory_order_relaxed);
+    ++m_stats.num_deferred;
+    m_stats.max_queue_depth =
+      std::max(m_stats.max_queue_depth, m_queue.size());
+  }
+  m_cv.notify_all();
+}
+
+size_t DeferredFree::drain(Allocator const* const alloc)
+{
+  std::vector<Entry> entries;
+  {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    auto const mine = [alloc](Entry const& e) {
+      return !alloc || e.alloc == alloc;
+    };
+    std::copy_if(
+      m_queue.cbegin(), m_queue.cend(), std::back_inserter(entries), mine);
+    std::erase_if(m_queue, mine);
+    m_cv.wait(lock, [&] {
+      return !m_in_flight || (alloc && m_in_flight != alloc);
+    });
+    if (!entries.empty())
+      ++m_stats.num_drains;
+  }
+
+  size_t bytes = 0UL;
+  for (auto const& e : entries)
+  {
+    release(e);
+    bytes += e.size;
+  }
+
+  if (bytes)
+    LBANNV2_DEBUG("DeferredFree: drained {} buffers ({} bytes)",
+                  entries.size(),
+                  bytes);
+  return bytes;
+}
+
+auto DeferredFree::stats() const -> Stats
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  Stats out = m_stats;
+  out.queue_depth = m_queue.size();
+  out.pending_bytes = pending_bytes();
+  return out;
+}
+
+void DeferredFree::release(Entry const& entry)
+{
+  try
+  {
+    if (entry.wait)
+      entry.wait();
+    entry.alloc->raw_sized_dealloc(entry.ptr, entry.size);
+  }
+  catch (std::exception const& e)
+  {
+    // There's nobody to report this to; the buffer is lost.
+    LBANNV2_ERROR("DeferredFree: releasing {} failed: {}", entry.ptr, e.what());
+  }
+
+  auto const latency = static_cast<std::uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now()
+                                                         - entry.queued)
+      .count());
+  m_pending_bytes.fetch_sub(entry.size, std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  ++m_stats.num_released;
+  m_stats.total_latency_ns += latency;
+  m_stats.max_latency_ns = std::max(m_stats.max_latency_ns, latency);
+}
+
+void DeferredFree::work()
+{
+  std::unique_lock<std::mutex> lock(m_mtx);
+  while (true)
+  {
+    m_cv.wait(lock, [this] { return !m_queue.empty(); });
+    auto const entry = std::move(m_queue.front());
+    m_queue.pop_front();
+    m_in_flight = entry.alloc;
+
+    lock.unlock();
+    release(entry);
+    lock.lock();
+
+    m_in_flight = nullptr;
+    m_cv.notify_all();
+  }
+}
+
+DeferredFree& DeferredFree::instance()
+{
+  // Never destroyed: the worker runs until the process exits.
+  static DeferredFree* const queue = new DeferredFree;
+  return *queue;
+}
+
+void release_or_defer(Allocator& alloc, void* const ptr, size_t const nbytes)
+{
+  if (!DeferredFree::instance().defer(alloc, ptr, nbytes))
+    alloc.raw_sized_dealloc(ptr, nbytes);
+}
+
+}  // namespace lbannv2
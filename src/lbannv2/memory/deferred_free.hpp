@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/utils/gpu_utils.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace lbannv2
+{
+
+class Allocator;
+
+/** @class DeferredFree
+ *  @brief Releases large host buffers on a background thread.
+ *
+ *  Returning a multi-gigabyte buffer to the system (munmap, or free
+ *  of a mapped chunk) can take milliseconds. When a threshold is set,
+ *  the deleters of the LBANNv2 host allocators hand buffers of at
+ *  least that many bytes to this queue instead of releasing them
+ *  inline; a worker thread then passes them to the owning allocator's
+ *  raw_sized_dealloc(), which may unmap them or put them back in a
+ *  cache.
+ *
+ *  Buffers are deregistered from the PointerRegistry before they are
+ *  queued, so the MemoryBudget counts pending_bytes() separately, and
+ *  one of its default reclaimers calls drain() so that memory
+ *  pressure releases the queue synchronously.
+ *
+ *  Buffers that may still be in use by queued device work are
+ *  deferred whatever their size, with defer_after() (or, with
+ *  streams, defer_on_stream()); they are released once that work has
+ *  completed.
+ *
+ *  The threshold is initialized from LBANNV2_DEFERRED_FREE_THRESHOLD
+ *  (in bytes). It defaults to 0, which disables deferral.
+ */
+class LBANNV2_EXPORT DeferredFree
+{
+public:
+  struct Stats
+  {
+    /** @brief Buffers waiting to be released. */
+    size_t queue_depth = 0UL;
+    /** @brief The largest queue_depth seen. */
+    size_t max_queue_depth = 0UL;
+    /** @brief Bytes queued or being released. */
+    size_t pending_bytes = 0UL;
+    /** @brief Buffers deferred, in total. */
+    size_t num_deferred = 0UL;
+    /** @brief Buffers released, by either the worker or drain(). */
+    size_t num_released = 0UL;
+    /** @brief Calls to drain() that released something. */
+    size_t num_drains = 0UL;
+    /** @brief Total time from queueing to release, in nanoseconds. */
+    std::uint64_t total_latency_ns = 0UL;
+    /** @brief Longest time from queueing to release, in nanoseconds. */
+    std::uint64_t max_latency_ns = 0UL;
+  };
+
+  /** @brief The smallest buffer that is deferred (0 if disabled). */
+  size_t threshold() const noexcept
+  {
+    return m_threshold.load(std::memory_order_relaxed);
+  }
+
+  void set_threshold(size_t nbytes) noexcept
+  {
+    m_threshold.store(nbytes, std::memory_order_relaxed);
+  }
+
+  /** @brief Queue a deregistered buffer for release, if it is large
+   *         enough.
+   *
+   *  @returns @c true if the buffer was queued, @c false if the
+   *           caller should release it.
+   */
+  bool defer(Allocator& alloc, void* ptr, size_t nbytes);
+
+  /** @brief Blocks until a buffer may be released. */
+  using Wait = std::function<void()>;
+
+  /** @brief Queue a deregistered buffer for release once wait()
+   *         returns, whatever its size.
+   *
+   *  wait() is called by whichever thread releases the buffer. If it
+   *  throws, the buffer is not released.
+   */
+  void defer_after(Allocator& alloc, void* ptr, size_t nbytes, Wait wait);
+
+#if LBANNV2_HAS_STREAMS
+  /** @brief Queue a deregistered buffer for release once the work
+   *         enqueued on a stream so far has completed.
+   *
+   *  This is defer_after() with a gpu:: event recorded on the stream.
+   */
+  void defer_on_stream(Allocator& alloc,
+                       void* ptr,
+                       size_t nbytes,
+                       gpu::Stream_t stream);
+#endif
+
+  /** @brief Release queued buffers on the calling thread.
+   *
+   *  This also waits for the buffer the worker is releasing, if any.
+   *
+   *  @param[in] alloc If not null, only this allocator's buffers are
+   *             released (e.g., before it is destroyed).
+   *
+   *  @returns The number of bytes released.
+   */
+  size_t drain(Allocator const* alloc = nullptr);
+
+  /** @brief Bytes queued or being released. */
+  size_t pending_bytes() const noexcept
+  {
+    return m_pending_bytes.load(std::memory_order_relaxed);
+  }
+
+  Stats stats() const;
+
+  static DeferredFree& instance();
+
+private:
+  DeferredFree();
+  ~DeferredFree() = default;
+  DeferredFree(DeferredFree const&) = delete;
+  DeferredFree(DeferredFree&&) = delete;
+  DeferredFree& operator=(DeferredFree const&) = delete;
+  DeferredFree& operator=(DeferredFree&&) = delete;
+
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry
+  {
+    Allocator* alloc;
+    void* ptr;
+    size_t size;
+    Clock::time_point queued;
+    Wait wait;
+  };
+
+  void enqueue(Entry entry);
+  void release(Entry const& entry);
+  void work();
+
+  std::atomic<size_t> m_threshold;
+  std::atomic<size_t> m_pending_bytes = 0UL;
+
+  mutable std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::deque<Entry> m_queue;
+  // The allocator of the entry the worker is releasing, if any.
+  Allocator const* m_in_flight = nullptr;
+  std::thread m_worker;
+  Stats m_stats;
+};  // class DeferredFree
+
+/** @brief Release a deregistered buffer now, or queue it with
+ *         DeferredFree.
+ */
+LBANNV2_EXPORT void
+release_or_defer(Allocator& alloc, void* ptr, size_t nbytes);
+
+}  // namespace lbannv2
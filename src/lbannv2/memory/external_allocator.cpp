@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/external_allocator.hpp"
+
+#include "lbannv2/memory/registry.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <cstring>
+
+namespace
+{
+
+void delete_external_ptr(void* const ptr)
+{
+  lbannv2::ExternalAllocator::instance().raw_dealloc(ptr);
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+// Ranges are registered by wrap(), not allocate().
+ExternalAllocator::ExternalAllocator() : Allocator {false} {}
+
+void ExternalAllocator::copy_data(void* const dst,
+                                  void const* const src,
+                                  size_t const bytes) const
+{
+  std::memcpy(dst, src, bytes);
+}
+
+void* ExternalAllocator::raw_alloc(size_t const)
+{
+  throw std::runtime_error("ExternalAllocator cannot allocate memory");
+}
+
+void ExternalAllocator::raw_dealloc(void* const ptr)
+{
+  if (!ptr)
+    return;
+
+  Range range;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto const it = m_ranges.find(ptr);
+    LBANNV2_ASSERT(it != m_ranges.end(),
+                   std::runtime_error,
+                   "ExternalAllocator: pointer not wrapped here");
+    range = std::move(it->second);
+    m_ranges.erase(it);
+  }
+
+  // Uncount the bytes before deregistering them so that the budget's
+  // usage never drops below what LBANNv2 holds.
+  m_registered_bytes.fetch_sub(range.size, std::memory_order_relaxed);
+  if (range.host)
+    m_host_bytes.fetch_sub(range.size, std::memory_order_relaxed);
+  pointer_registry().remove(ptr);
+
+  LBANNV2_TRACE("ExternalAllocator::raw_dealloc(ptr={})", ptr);
+  if (range.release)
+    range.release();
+}
+
+c10::DeleterFnPtr ExternalAllocator::raw_deleter() const
+{
+  return &delete_external_ptr;
+}
+
+c10::Device ExternalAllocator::get_device() const noexcept
+{
+  return c10::Device {c10::kCPU};
+}
+
+c10::DataPtr ExternalAllocator::wrap(void* const ptr,
+                                     size_t const nbytes,
+                                     Release release,
+                                     c10::Device const device)
+{
+  LBANNV2_ASSERT(ptr,
+                 std::runtime_error,
+                 "ExternalAllocator: cannot wrap a null pointer");
+
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    LBANNV2_ASSERT(!m_ranges.contains(ptr),
+                   std::runtime_error,
+                   "ExternalAllocator: pointer already wrapped");
+    m_ranges.emplace(ptr,
+                     Range {nbytes, std::move(release), device.is_cpu()});
+  }
+
+  try
+  {
+    pointer_registry().add(ptr, nbytes, this, device);
+  }
+  catch (...)
+  {
+    // The caller keeps ownership, so release is not run.
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_ranges.erase(ptr);
+    throw;
+  }
+  m_registered_bytes.fetch_add(nbytes, std::memory_order_relaxed);
+  if (device.is_cpu())
+    m_host_bytes.fetch_add(nbytes, std::memory_order_relaxed);
+
+  LBANNV2_TRACE("ExternalAllocator::wrap(ptr={}, nbytes={})", ptr, nbytes);
+  return {ptr, ptr, &delete_external_ptr, device};
+}
+
+c10::DataPtr ExternalAllocator::wrap(void* const ptr,
+                                     size_t const nbytes,
+                                     std::shared_ptr<void const> owner,
+                                     c10::Device const device)
+{
+  return wrap(
+    ptr,
+    nbytes,
+    [owner = std::move(owner)]() mutable { owner.reset(); },
+    device);
+}
+
+auto ExternalAllocator::stats() const -> Stats
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return {registered_bytes(), m_ranges.size()};
+}
+
+ExternalAllocator& ExternalAllocator::instance()
+{
+  // Never destroyed: tensors may well outlive static destruction.
+  static ExternalAllocator* const alloc = new ExternalAllocator;
+  return *alloc;
+}
+
+}  // namespace lbannv2
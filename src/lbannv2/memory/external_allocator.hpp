@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace lbannv2
+{
+
+/** @class ExternalAllocator
+ *  @brief Registers memory owned by someone else.
+ *
+ *  Buffers from decoders, Arrow, shared memory and the like can be
+ *  wrapped in a DataPtr by wrap(), which registers the range with
+ *  the PointerRegistry under this allocator. They are then
+ *  indistinguishable from LBANNv2 allocations to is_managed_ptr(),
+ *  allocator_of() and registry lookups, so tensors using them (see
+ *  lbannv2::from_external()) take the same paths as LBANNv2 memory.
+ *
+ *  When the DataPtr is deleted, the range is deregistered and the
+ *  release callback given to wrap() is run on the deleting thread.
+ *  The memory is never freed by this allocator, and it cannot
+ *  allocate: allocate() throws.
+ *
+ *  External bytes are registered, but they are not counted against
+ *  the memory_budget(), since LBANNv2 cannot release them.
+ */
+class LBANNV2_EXPORT ExternalAllocator final : public Allocator
+{
+public:
+  /** @brief Called once the wrapped range is no longer used. */
+  using Release = std::function<void()>;
+
+  struct Stats
+  {
+    /** @brief Bytes in wrapped ranges. */
+    size_t registered_bytes = 0UL;
+    /** @brief Wrapped ranges. */
+    size_t num_ranges = 0UL;
+  };
+
+  void copy_data(void* dst, void const* src, size_t bytes) const final;
+
+  /** @brief Throws; external memory cannot be allocated. */
+  void* raw_alloc(size_t nbytes) final;
+
+  /** @brief Runs the release callback of ptr. */
+  void raw_dealloc(void* ptr) final;
+
+  c10::DeleterFnPtr raw_deleter() const final;
+
+  c10::Device get_device() const noexcept final;
+
+  /** @brief Register an external range and wrap it in a DataPtr.
+   *
+   *  @param[in] ptr The beginning of the range.
+   *  @param[in] nbytes The size in bytes of the range.
+   *  @param[in] release Called once the DataPtr has been deleted. It
+   *                     may be empty.
+   *  @param[in] device The device on which the range lives.
+   *
+   *  @throws std::runtime_error if the range overlaps registered
+   *          memory. Nothing is then registered, and release is not
+   *          called.
+   */
+  c10::DataPtr wrap(void* ptr,
+                    size_t nbytes,
+                    Release release,
+                    c10::Device device = c10::Device {c10::kCPU});
+
+  /** @brief Register an external range that is kept alive by owner.
+   *
+   *  The reference to owner is dropped once the DataPtr has been
+   *  deleted.
+   */
+  c10::DataPtr wrap(void* ptr,
+                    size_t nbytes,
+                    std::shared_ptr<void const> owner,
+                    c10::Device device = c10::Device {c10::kCPU});
+
+  /** @brief Bytes in wrapped ranges. */
+  size_t registered_bytes() const noexcept
+  {
+    return m_registered_bytes.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Bytes in wrapped ranges on the host. */
+  size_t registered_host_bytes() const noexcept
+  {
+    return m_host_bytes.load(std::memory_order_relaxed);
+  }
+
+  Stats stats() const;
+
+  static ExternalAllocator& instance();
+
+private:
+  ExternalAllocator();
+  ~ExternalAllocator() = default;
+  ExternalAllocator(ExternalAllocator const&) = delete;
+  ExternalAllocator(ExternalAllocator&&) = delete;
+  ExternalAllocator& operator=(ExternalAllocator const&) = delete;
+  ExternalAllocator& operator=(ExternalAllocator&&) = delete;
+
+  struct Range
+  {
+    size_t size;
+    Release release;
+    bool host;
+  };
+
+  mutable std::mutex m_mtx;
+  std::unordered_map<void const*, Range> m_ranges;
+  std::atomic<size_t> m_registered_bytes = 0UL;
+  std::atomic<size_t> m_host_bytes = 0UL;
+};  // class ExternalAllocator
+
+}  // namespace lbannv2
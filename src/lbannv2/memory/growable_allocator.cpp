@@ -0,0 +1,272 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/growable_allocator.hpp"
+
+#include "lbannv2/memory/deferred_free.hpp"
+#include "lbannv2/memory/memory_budget.hpp"
+#include "lbannv2/memory/registry.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+
+using GA = lbannv2::GrowableAllocator;
+
+size_t page_size() noexcept
+{
+  static size_t const size = sysconf(_SC_PAGESIZE);
+  return size;
+}
+
+size_t round_up_to_page(size_t const n) noexcept
+{
+  return (n + page_size() - 1) / page_size() * page_size();
+}
+
+size_t get_env_reserve_size()
+{
+  char const* const env = std::getenv("LBANNV2_GROWABLE_RESERVE");
+  if (env && std::strlen(env))
+    return std::strtoull(env, nullptr, 0);
+  return size_t {1} << 30;
+}
+
+void delete_growable_ptr(void* const ptr)
+{
+  auto const nbytes = lbannv2::pointer_registry().remove(ptr);
+  lbannv2::release_or_defer(GA::instance(), ptr, nbytes);
+}
+
+[[noreturn]] void throw_oom(char const* const what, size_t const nbytes)
+{
+  throw lbannv2::OutOfMemory(std::string("GrowableAllocator: ") + what
+                             + " failed growing to " + std::to_string(nbytes)
+                             + " bytes (" + std::strerror(errno) + ")");
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+GrowableAllocator::GrowableAllocator()
+  : m_reserve_size {round_up_to_page(get_env_reserve_size())}
+{}
+
+void GrowableAllocator::copy_data(void* const dst,
+                                  void const* const src,
+                                  size_t const bytes) const
+{
+  std::memcpy(dst, src, bytes);
+}
+
+void* GrowableAllocator::raw_alloc(size_t const nbytes)
+{
+  if (nbytes == 0)
+    return nullptr;
+
+  size_t const committed = round_up_to_page(nbytes);
+  size_t const reserved = std::max(committed, reserve_size());
+  void* const ptr = mmap(nullptr,
+                         reserved,
+                         PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                         -1,
+                         0);
+  if (ptr == MAP_FAILED)
+    return nullptr;
+  if (mprotect(ptr, committed, PROT_READ | PROT_WRITE) != 0)
+  {
+    munmap(ptr, reserved);
+    return nullptr;
+  }
+
+  LBANNV2_TRACE("GrowableAllocator::raw_alloc(nbytes={}): ptr={}, "
+                "reserved={}",
+                nbytes,
+                ptr,
+                reserved);
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  m_mappings.emplace(ptr, Mapping {nbytes, committed, reserved});
+  m_stats.reserved_bytes += reserved;
+  m_stats.committed_bytes += committed;
+  ++m_stats.num_allocations;
+  return ptr;
+}
+
+void* GrowableAllocator::raw_alloc_zeroed(size_t const nbytes)
+{
+  // Fresh anonymous mappings are zero-filled by the kernel.
+  return raw_alloc(nbytes);
+}
+
+void GrowableAllocator::raw_dealloc(void* const ptr)
+{
+  if (!ptr)
+    return;
+
+  Mapping mapping;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto const it = m_mappings.find(ptr);
+    LBANNV2_ASSERT(it != m_mappings.end(),
+                   std::runtime_error,
+                   "GrowableAllocator: pointer not allocated here");
+    mapping = it->second;
+    m_mappings.erase(it);
+    m_stats.reserved_bytes -= mapping.reserved;
+    m_stats.committed_bytes -= mapping.committed;
+    --m_stats.num_allocations;
+  }
+
+  LBANNV2_TRACE("GrowableAllocator::raw_dealloc(ptr={})", ptr);
+  munmap(ptr, mapping.reserved);
+}
+
+c10::DeleterFnPtr GrowableAllocator::raw_deleter() const
+{
+  return &delete_growable_ptr;
+}
+
+c10::Device GrowableAllocator::get_device() const noexcept
+{
+  return c10::Device {c10::kCPU};
+}
+
+void GrowableAllocator::set_reserve_size(size_t const nbytes) noexcept
+{
+  m_reserve_size.store(round_up_to_page(nbytes), std::memory_order_relaxed);
+}
+
+void* GrowableAllocator::grow(void* const ptr, size_t const nbytes)
+{
+  // Admit the growth first; reclaimers may free memory from here.
+  size_t old_size;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto const it = m_mappings.find(ptr);
+    LBANNV2_ASSERT(it != m_mappings.end(),
+                   std::runtime_error,
+                   "GrowableAllocator: pointer not allocated here");
+    old_size = it->second.size;
+  }
+  // Held until the growth is registered.
+  auto const reservation = nbytes > old_size
+                             ? memory_budget().admit(nbytes - old_size)
+                             : MemoryBudget::Reservation {};
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  auto const it = m_mappings.find(ptr);
+  LBANNV2_ASSERT(it != m_mappings.end(),
+                 std::runtime_error,
+                 "GrowableAllocator: pointer freed while growing");
+  Mapping mapping = it->second;
+  size_t const committed = round_up_to_page(nbytes);
+  auto* const base = static_cast<std::byte*>(ptr);
+  void* out = ptr;
+
+  if (committed <= mapping.committed)
+  {
+    // Nothing to map.
+  }
+  else if (committed <= mapping.reserved)
+  {
+    if (mprotect(base + mapping.committed,
+                 committed - mapping.committed,
+                 PROT_READ | PROT_WRITE)
+        != 0)
+      throw_oom("mprotect", nbytes);
+    m_stats.committed_bytes += committed - mapping.committed;
+    mapping.committed = committed;
+    ++m_stats.num_grown_in_place;
+  }
+  else
+  {
+    // mremap can only move a single mapping, and the inaccessible
+    // tail of the reservation is a separate one. So the accessible
+    // part is moved (or extended in place, if the kernel can) into a
+    // bigger reservation, the tail of which is then made inaccessible
+    // again.
+    size_t const reserved = 2 * std::max(committed, mapping.reserved);
+    out = mremap(ptr, mapping.committed, reserved, MREMAP_MAYMOVE);
+    if (out == MAP_FAILED)
+      throw_oom("mremap", nbytes);
+    auto* const new_base = static_cast<std::byte*>(out);
+    if (out != ptr && mapping.reserved > mapping.committed)
+      munmap(base + mapping.committed, mapping.reserved - mapping.committed);
+    // The contents have moved, so there is no going back. If the tail
+    // stays accessible, it is counted as committed: it has no guard,
+    // and touching it commits memory.
+    size_t now_committed = committed;
+    if (mprotect(new_base + committed, reserved - committed, PROT_NONE) != 0)
+    {
+      LBANNV2_WARN("GrowableAllocator::grow: could not protect the tail "
+                   "of the reservation at {} (errno={})",
+                   out,
+                   errno);
+      now_committed = reserved;
+    }
+
+    m_stats.reserved_bytes += reserved - mapping.reserved;
+    m_stats.committed_bytes += now_committed - mapping.committed;
+    mapping.committed = now_committed;
+    mapping.reserved = reserved;
+    ++m_stats.num_remapped;
+  }
+
+  mapping.size = nbytes;
+  if (out == ptr)
+  {
+    pointer_registry().resize(ptr, nbytes);
+    it->second = mapping;
+  }
+  else
+  {
+    pointer_registry().move(ptr, out, nbytes);
+    m_mappings.erase(it);
+    m_mappings.emplace(out, mapping);
+  }
+
+  LBANNV2_TRACE("GrowableAllocator::grow(ptr={}, nbytes={}): ptr={}",
+                ptr,
+                nbytes,
+                out);
+  return out;
+}
+
+size_t GrowableAllocator::capacity(void const* const ptr) const
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  auto const it = m_mappings.find(ptr);
+  return it == m_mappings.end() ? 0UL : it->second.reserved;
+}
+
+auto GrowableAllocator::stats() const -> Stats
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_stats;
+}
+
+GrowableAllocator& GrowableAllocator::instance()
+{
+  // Never destroyed: tensors may well outlive static destruction.
+  static GrowableAllocator* const alloc = new GrowableAllocator;
+  return *alloc;
+}
+
+}  // namespace lbannv2
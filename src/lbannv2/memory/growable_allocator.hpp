@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace lbannv2
+{
+
+/** @class GrowableAllocator
+ *  @brief A CPU allocator whose allocations can grow without being
+ *         copied.
+ *
+ *  Each allocation reserves reserve_size() bytes of address space
+ *  (or more, for larger requests) with PROT_NONE and only makes the
+ *  pages it needs accessible. grow() makes more of the reservation
+ *  accessible; only when the reservation runs out is the mapping
+ *  moved, with mremap(2), to a reservation twice the new size (or
+ *  twice the old reservation, if that is bigger). Either way
+ *  the contents are not copied, and the PointerRegistry range is
+ *  updated in a single step.
+ *
+ *  With this as the CPU allocator, lbannv2::resize_() grows the
+ *  storage of CPU tensors in place. (Tensor::resize_() is left alone
+ *  and still copies.)
+ *
+ *  Each allocation costs at least a page and a few system calls, and
+ *  the reservations count against the address space (but not against
+ *  memory), so this is meant for buffers that are appended to, such
+ *  as replay buffers. The reservation size defaults to 1 GiB and can
+ *  be set with LBANNV2_GROWABLE_RESERVE (in bytes).
+ */
+class LBANNV2_EXPORT GrowableAllocator final : public Allocator
+{
+public:
+  struct Stats
+  {
+    /** @brief Address space reserved by live allocations. */
+    size_t reserved_bytes = 0UL;
+    /** @brief The accessible part of the reservations. */
+    size_t committed_bytes = 0UL;
+    /** @brief Live allocations. */
+    size_t num_allocations = 0UL;
+    /** @brief Growths within the reservation, in total. */
+    size_t num_grown_in_place = 0UL;
+    /** @brief Growths that moved the mapping, in total. */
+    size_t num_remapped = 0UL;
+  };
+
+  void copy_data(void* dst, void const* src, size_t bytes) const final;
+
+  void* raw_alloc(size_t nbytes) final;
+
+  void* raw_alloc_zeroed(size_t nbytes) final;
+
+  void raw_dealloc(void* ptr) final;
+
+  c10::DeleterFnPtr raw_deleter() const final;
+
+  c10::Device get_device() const noexcept final;
+
+  /** @brief The address space reserved for new allocations. */
+  size_t reserve_size() const noexcept
+  {
+    return m_reserve_size.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Set the address space reserved for new allocations. */
+  void set_reserve_size(size_t nbytes) noexcept;
+
+  /** @brief Grow an allocation made by this allocator.
+   *
+   *  The first min(old size, nbytes) bytes are preserved. Shrinking
+   *  only updates the registered size.
+   *
+   *  @param[in] ptr The allocation.
+   *  @param[in] nbytes The new size.
+   *
+   *  @returns The address of the allocation, which changes only if
+   *           it had to be remapped.
+   *
+   *  @throws OutOfMemory if the growth does not fit in the
+   *          memory_budget() or the kernel refuses it. The allocation
+   *          is then unchanged.
+   */
+  void* grow(void* ptr, size_t nbytes);
+
+  /** @brief The bytes reserved for an allocation (0 if unknown). */
+  size_t capacity(void const* ptr) const;
+
+  Stats stats() const;
+
+  static GrowableAllocator& instance();
+
+private:
+  GrowableAllocator();
+  ~GrowableAllocator() = default;
+  GrowableAllocator(GrowableAllocator const&) = delete;
+  GrowableAllocator(GrowableAllocator&&) = delete;
+  GrowableAllocator& operator=(GrowableAllocator const&) = delete;
+  GrowableAllocator& operator=(GrowableAllocator&&) = delete;
+
+  struct Mapping
+  {
+    /** @brief The size requested (or grown to). */
+    size_t size;
+    /** @brief The accessible prefix of the reservation. */
+    size_t committed;
+    size_t reserved;
+  };
+
+  std::atomic<size_t> m_reserve_size;
+
+  mutable std::mutex m_mtx;
+  std::unordered_map<void const*, Mapping> m_mappings;
+  Stats m_stats;
+};  // class GrowableAllocator
+
+}  // namespace lbannv2
@@ -0,0 +1,301 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/huge_page_allocator.hpp"
+
+#include "lbannv2/memory/deferred_free.hpp"
+#include "lbannv2/memory/registry.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+
+namespace
+{
+
+using HPA = lbannv2::HugePageAllocator;
+
+// Matches the c10 CPU allocator.
+constexpr size_t heap_alignment = 64;
+
+std::uintptr_t round_up(std::uintptr_t const n, size_t const m) noexcept
+{
+  return (n + m - 1) / m * m;
+}
+
+size_t get_env_threshold()
+{
+  char const* const env = std::getenv("LBANNV2_HUGE_PAGE_THRESHOLD");
+  if (env && std::strlen(env))
+    return std::strtoull(env, nullptr, 0);
+  return HPA::kHugePageSize;
+}
+
+bool get_env_try_hugetlb()
+{
+  char const* const env = std::getenv("LBANNV2_HUGE_PAGE_MODE");
+  return env && std::strcmp(env, "hugetlb") == 0;
+}
+
+using AddrRange = std::pair<std::uintptr_t, std::uintptr_t>;
+
+// Sum the AnonHugePages of the mappings overlapping the given
+// ranges. The kernel may merge adjacent madvised mappings into one
+// VMA, in which case the huge pages of that VMA are attributed to
+// our ranges up to the size of the overlap.
+size_t transparent_backed_bytes(std::vector<AddrRange> const& ranges)
+{
+  std::ifstream smaps("/proc/self/smaps");
+  if (!smaps)
+    return 0UL;
+
+  size_t total = 0UL;
+  size_t overlap = 0UL;
+  std::string line;
+  while (std::getline(smaps, line))
+  {
+    std::uintptr_t lo, hi;
+    unsigned long long kb;
+    if (std::sscanf(line.c_str(), "%" SCNxPTR "-%" SCNxPTR, &lo, &hi) == 2)
+    {
+      overlap = 0UL;
+      for (auto const& [begin, end] : ranges)
+      {
+        auto const a = std::max(lo, begin);
+        auto const b = std::min(hi, end);
+        if (a < b)
+          overlap += b - a;
+      }
+    }
+    else if (overlap
+             && std::sscanf(line.c_str(), "AnonHugePages: %llu kB", &kb) == 1)
+    {
+      total += std::min<size_t>(kb * 1024, overlap);
+    }
+  }
+  return total;
+}
+
+void delete_huge_page_ptr(void* const ptr)
+{
+  auto const nbytes = lbannv2::pointer_registry().remove(ptr);
+  lbannv2::release_or_defer(HPA::instance(), ptr, nbytes);
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+HugePageAllocator::HugePageAllocator()
+  : m_threshold {get_env_threshold()}, m_try_hugetlb {get_env_try_hugetlb()}
+{
+  LBANNV2_DEBUG("HugePageAllocator: threshold={}, try hugetlb? {}",
+                threshold(),
+                m_try_hugetlb);
+}
+
+void HugePageAllocator::copy_data(void* const dst,
+                                  void const* const src,
+                                  size_t const bytes) const
+{
+  std::memcpy(dst, src, bytes);
+}
+
+void* HugePageAllocator::map_huge(size_t const nbytes, Backing& backing)
+{
+#ifdef MAP_HUGETLB
+  if (m_try_hugetlb)
+  {
+    void* const ptr = mmap(nullptr,
+                           nbytes,
+                           PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                           -1,
+                           0);
+    if (ptr != MAP_FAILED)
+    {
+      backing = Backing::HugeTLB;
+      return ptr;
+    }
+    LBANNV2_DEBUG("HugePageAllocator: MAP_HUGETLB failed ({}); "
+                  "falling back to transparent huge pages",
+                  std::strerror(errno));
+  }
+#endif
+
+  // mmap only guarantees page alignment, so overallocate and trim.
+  size_t const len = nbytes + kHugePageSize;
+  void* const raw = mmap(
+    nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  LBANNV2_ASSERT(raw != MAP_FAILED,
+                 std::runtime_error,
+                 "HugePageAllocator: mmap failed");
+
+  auto const raw_addr = reinterpret_cast<std::uintptr_t>(raw);
+  auto const addr = round_up(raw_addr, kHugePageSize);
+  if (size_t const head = addr - raw_addr)
+    munmap(raw, head);
+  if (size_t const tail = raw_addr + len - (addr + nbytes))
+    munmap(reinterpret_cast<void*>(addr + nbytes), tail);
+
+  void* const ptr = reinterpret_cast<void*>(addr);
+#ifdef MADV_HUGEPAGE
+  if (madvise(ptr, nbytes, MADV_HUGEPAGE) != 0)
+    LBANNV2_DEBUG("HugePageAllocator: madvise(MADV_HUGEPAGE) failed ({})",
+                  std::strerror(errno));
+#endif
+  backing = Backing::Transparent;
+  return ptr;
+}
+
+void* HugePageAllocator::raw_alloc(size_t const nbytes)
+{
+  if (nbytes == 0)
+    return nullptr;
+
+  void* ptr = nullptr;
+  Region region {nbytes, Backing::Heap};
+  if (nbytes < threshold())
+  {
+    LBANNV2_ASSERT(posix_memalign(&ptr, heap_alignment, nbytes) == 0,
+                   std::runtime_error,
+                   "HugePageAllocator: out of memory");
+  }
+  else
+  {
+    region.size = round_up(nbytes, kHugePageSize);
+    ptr = map_huge(region.size, region.backing);
+  }
+
+  LBANNV2_TRACE("HugePageAllocator::raw_alloc(nbytes={}): ptr={}, huge={}",
+                nbytes,
+                ptr,
+                region.backing != Backing::Heap);
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  m_regions.emplace(ptr, region);
+  switch (region.backing)
+  {
+  case Backing::Heap:
+    m_stats.small_bytes += region.size;
+    break;
+  case Backing::HugeTLB:
+    m_stats.hugetlb_bytes += region.size;
+    [[fallthrough]];
+  case Backing::Transparent:
+    m_stats.mapped_bytes += region.size;
+    break;
+  }
+  return ptr;
+}
+
+void* HugePageAllocator::raw_alloc_zeroed(size_t const nbytes)
+{
+  void* const ptr = raw_alloc(nbytes);
+  if (!ptr)
+    return ptr;
+
+  // Mapped regions are fresh anonymous memory, so only heap
+  // allocations need to be cleared. (The threshold may have changed
+  // in the meantime, so ask the region.)
+  bool heap;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    heap = m_regions.at(ptr).backing == Backing::Heap;
+  }
+  if (heap)
+    std::memset(ptr, 0, nbytes);
+  return ptr;
+}
+
+void HugePageAllocator::raw_dealloc(void* const ptr)
+{
+  if (!ptr)
+    return;
+
+  Region region;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto const it = m_regions.find(ptr);
+    LBANNV2_ASSERT(it != m_regions.end(),
+                   std::runtime_error,
+                   "HugePageAllocator: pointer not allocated here");
+    region = it->second;
+    m_regions.erase(it);
+    switch (region.backing)
+    {
+    case Backing::Heap:
+      m_stats.small_bytes -= region.size;
+      break;
+    case Backing::HugeTLB:
+      m_stats.hugetlb_bytes -= region.size;
+      [[fallthrough]];
+    case Backing::Transparent:
+      m_stats.mapped_bytes -= region.size;
+      break;
+    }
+  }
+
+  LBANNV2_TRACE("HugePageAllocator::raw_dealloc(ptr={})", ptr);
+
+  if (region.backing == Backing::Heap)
+    std::free(ptr);
+  else
+    munmap(ptr, region.size);
+}
+
+c10::DeleterFnPtr HugePageAllocator::raw_deleter() const
+{
+  return &delete_huge_page_ptr;
+}
+
+c10::Device HugePageAllocator::get_device() const noexcept
+{
+  return c10::Device {c10::kCPU};
+}
+
+auto HugePageAllocator::stats() const -> Stats
+{
+  Stats out;
+  std::vector<AddrRange> transparent;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    out = m_stats;
+    for (auto const& [ptr, region] : m_regions)
+    {
+      if (region.backing != Backing::Transparent)
+        continue;
+      auto const addr = reinterpret_cast<std::uintptr_t>(ptr);
+      transparent.emplace_back(addr, addr + region.size);
+    }
+  }
+
+  out.huge_backed_bytes =
+    out.hugetlb_bytes
+    + (transparent.empty() ? 0UL : transparent_backed_bytes(transparent));
+  return out;
+}
+
+HugePageAllocator& HugePageAllocator::instance()
+{
+  // Never destroyed: tensors may well outlive static destruction.
+  static HugePageAllocator* const alloc = new HugePageAllocator;
+  return *alloc;
+}
+
+}  // namespace lbannv2
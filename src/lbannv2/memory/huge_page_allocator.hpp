@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+namespace lbannv2
+{
+
+/** @class HugePageAllocator
+ *  @brief A CPU allocator that backs large buffers with huge pages.
+ *
+ *  Allocations of at least threshold() bytes are rounded up to a
+ *  multiple of kHugePageSize and mapped at a kHugePageSize-aligned
+ *  address. If requested (LBANNV2_HUGE_PAGE_MODE=hugetlb), these are
+ *  first tried with MAP_HUGETLB, which only succeeds if the system
+ *  has huge pages reserved. Otherwise (or if that fails) the mapping
+ *  is made with normal pages and madvise(MADV_HUGEPAGE), leaving it
+ *  to the kernel's transparent huge page support to back it.
+ *
+ *  Smaller allocations are ordinary aligned heap allocations.
+ *
+ *  The default threshold is kHugePageSize; it can be set with
+ *  LBANNV2_HUGE_PAGE_THRESHOLD (in bytes) or set_threshold().
+ */
+class LBANNV2_EXPORT HugePageAllocator final : public Allocator
+{
+public:
+  static constexpr size_t kHugePageSize = size_t {2} << 20;
+
+  struct Stats
+  {
+    /** @brief Bytes in allocations below the threshold. */
+    size_t small_bytes = 0UL;
+    /** @brief Bytes mapped for allocations above the threshold. */
+    size_t mapped_bytes = 0UL;
+    /** @brief The part of mapped_bytes that came from MAP_HUGETLB. */
+    size_t hugetlb_bytes = 0UL;
+    /** @brief The part of mapped_bytes actually backed by huge
+     *         pages (hugetlb pages plus transparent huge pages).
+     */
+    size_t huge_backed_bytes = 0UL;
+  };
+
+  void copy_data(void* dst, void const* src, size_t bytes) const final;
+
+  void* raw_alloc(size_t nbytes) final;
+
+  void* raw_alloc_zeroed(size_t nbytes) final;
+
+  void raw_dealloc(void* ptr) final;
+
+  c10::DeleterFnPtr raw_deleter() const final;
+
+  c10::Device get_device() const noexcept final;
+
+  /** @brief The smallest allocation that gets huge pages. */
+  size_t threshold() const noexcept
+  {
+    return m_threshold.load(std::memory_order_relaxed);
+  }
+
+  void set_threshold(size_t nbytes) noexcept
+  {
+    m_threshold.store(nbytes, std::memory_order_relaxed);
+  }
+
+  /** @brief Get a snapshot of the allocator's statistics.
+   *
+   *  Finding the transparent huge page backing means reading
+   *  /proc/self/smaps, so this is not cheap.
+   */
+  Stats stats() const;
+
+  static HugePageAllocator& instance();
+
+private:
+  HugePageAllocator();
+  ~HugePageAllocator() = default;
+  HugePageAllocator(HugePageAllocator const&) = delete;
+  HugePageAllocator(HugePageAllocator&&) = delete;
+  HugePageAllocator& operator=(HugePageAllocator const&) = delete;
+  HugePageAllocator& operator=(HugePageAllocator&&) = delete;
+
+  enum class Backing
+  {
+    Heap,
+    Transparent,
+    HugeTLB,
+  };
+
+  struct Region
+  {
+    size_t size;
+    Backing backing;
+  };
+
+  void* map_huge(size_t nbytes, Backing& backing);
+
+  std::atomic<size_t> m_threshold;
+  bool m_try_hugetlb;
+
+  mutable std::mutex m_mtx;
+  std::map<void const*, Region> m_regions;
+  Stats m_stats;
+};  // class HugePageAllocator
+
+}  // namespace lbannv2
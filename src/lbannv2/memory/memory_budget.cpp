@@ -0,0 +1,443 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/memory_budget.hpp"
+
+#include "lbannv2/memory/allocator.hpp"
+#include "lbannv2/memory/arena_allocator.hpp"
+#include "lbannv2/memory/caching_host_allocator.hpp"
+#include "lbannv2/memory/deferred_free.hpp"
+#include "lbannv2/memory/external_allocator.hpp"
+#include "lbannv2/memory/policy_allocator.hpp"
+#include "lbannv2/memory/registry.hpp"
+#include "lbannv2/memory/slab_allocator.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <c10/util/Type.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <typeinfo>
+#include <utility>
+
+#include <malloc.h>
+
+namespace
+{
+
+using Pressure = lbannv2::MemoryBudget::Pressure;
+
+// Set while this thread runs the reclaimers.
+thread_local bool t_in_reclaim = false;
+
+struct ReclaimGuard
+{
+  ReclaimGuard() { t_in_reclaim = true; }
+  ~ReclaimGuard() { t_in_reclaim = false; }
+};
+
+[[maybe_unused]] char const* to_string(Pressure const pressure) noexcept
+{
+  switch (pressure)
+  {
+  case Pressure::Soft:
+    return "soft";
+  case Pressure::Hard:
+    return "hard";
+  case Pressure::Failed:
+    return "failed";
+  }
+  return "unknown";
+}
+
+size_t get_env_size(char const* const var, size_t const default_value)
+{
+  char const* const env = std::getenv(var);
+  if (env && std::strlen(env))
+    return std::strtoull(env, nullptr, 0);
+  return default_value;
+}
+
+// v1 reports "no limit" as a huge, page-aligned number.
+constexpr size_t kCgroupV1Unlimited = size_t {1} << 62;
+
+std::optional<size_t> read_cgroup_limit(std::string const& path)
+{
+  std::ifstream file(path);
+  std::string value;
+  if (!(file >> value) || value == "max")
+    return std::nullopt;
+
+  auto const limit = std::strtoull(value.c_str(), nullptr, 10);
+  if (limit == 0 || limit >= kCgroupV1Unlimited)
+    return std::nullopt;
+  return limit;
+}
+
+// The smallest limit on the path from dir+cgroup to dir.
+std::optional<size_t> min_limit_to_root(std::string const& dir,
+                                        std::string cgroup,
+                                        std::string const& file)
+{
+  std::optional<size_t> out;
+  while (true)
+  {
+    while (!cgroup.empty() && cgroup.back() == '/')
+      cgroup.pop_back();
+
+    if (auto const limit = read_cgroup_limit(dir + cgroup + "/" + file))
+      out = std::min(out.value_or(*limit), *limit);
+
+    if (cgroup.empty())
+      break;
+    cgroup.erase(cgroup.rfind('/'));
+  }
+  return out;
+}
+
+bool has_memory_controller(std::string const& controllers)
+{
+  std::istringstream iss(controllers);
+  std::string controller;
+  while (std::getline(iss, controller, ','))
+    if (controller == "memory")
+      return true;
+  return false;
+}
+
+size_t reclaim_deferred_frees(Pressure, size_t)
+{
+  return lbannv2::DeferredFree::instance().drain();
+}
+
+size_t reclaim_host_caches(Pressure, size_t)
+{
+  size_t freed = 0UL;
+
+  auto& caching = lbannv2::CachingHostAllocator::instance();
+  auto const before = caching.stats();
+  caching.empty_cache();
+  freed += before.reserved_bytes - caching.stats().reserved_bytes;
+
+  auto& arena = lbannv2::ArenaAllocator::instance();
+  auto const arena_before = arena.stats().reserved_bytes;
+  arena.release_cached();
+  freed += arena_before - arena.stats().reserved_bytes;
+
+  freed += lbannv2::SlabAllocator::instance().release_cached();
+
+  if (auto* const policy = lbannv2::current_policy_allocator())
+  {
+    freed += policy->stats().cached_bytes;
+    policy->release_cached();
+  }
+  return freed;
+}
+
+size_t reclaim_malloc_trim(Pressure, size_t)
+{
+  malloc_trim(0);
+  return 0UL;
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+// Reservation
+
+MemoryBudget::Reservation::Reservation(Reservation&& other) noexcept
+  : m_budget {std::exchange(other.m_budget, nullptr)},
+    m_bytes {std::exchange(other.m_bytes, 0UL)}
+{}
+
+auto MemoryBudget::Reservation::operator=(Reservation&& other) noexcept
+  -> Reservation&
+{
+  std::swap(m_budget, other.m_budget);
+  std::swap(m_bytes, other.m_bytes);
+  return *this;
+}
+
+MemoryBudget::Reservation::~Reservation()
+{
+  if (m_budget)
+    m_budget->m_reserved.fetch_sub(m_bytes, std::memory_order_relaxed);
+}
+
+// MemoryBudget
+
+MemoryBudget::MemoryBudget() = default;
+
+void MemoryBudget::set_limits(size_t const soft, size_t const hard)
+{
+  m_soft_limit.store(soft, std::memory_order_relaxed);
+  m_hard_limit.store(hard, std::memory_order_relaxed);
+  m_soft_fired.store(false, std::memory_order_relaxed);
+}
+
+size_t MemoryBudget::usage() const noexcept
+{
+  return held() + m_reserved.load(std::memory_order_relaxed);
+}
+
+size_t MemoryBudget::held() const noexcept
+{
+  // External bytes are uncounted before they are deregistered, but
+  // the two counters are read at different times.
+  size_t const held = pointer_registry().host_bytes_registered()
+                      + DeferredFree::instance().pending_bytes();
+  size_t const external =
+    ExternalAllocator::instance().registered_host_bytes();
+  return held > external ? held - external : 0UL;
+}
+
+bool MemoryBudget::try_reserve(size_t const nbytes,
+                               size_t const limit) noexcept
+{
+  auto reserved = m_reserved.load(std::memory_order_relaxed);
+  do
+  {
+    if (held() + reserved + nbytes > limit)
+      return false;
+  } while (!m_reserved.compare_exchange_weak(
+    reserved, reserved + nbytes, std::memory_order_relaxed));
+  return true;
+}
+
+size_t MemoryBudget::add_reclaimer(Reclaimer reclaimer)
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  auto const handle = m_next_handle++;
+  m_reclaimers.emplace_back(handle, std::move(reclaimer));
+  return handle;
+}
+
+void MemoryBudget::remove_reclaimer(size_t const handle)
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  std::erase_if(m_reclaimers,
+                [handle](auto const& r) { return r.first == handle; });
+}
+
+size_t MemoryBudget::reclaim(Pressure const pressure, size_t const nbytes)
+{
+  if (t_in_reclaim)
+    return 0UL;
+
+  // Another thread's reclaimer may be waiting for something this
+  // thread holds (e.g., the GIL), so do not wait for it.
+  std::unique_lock<std::mutex> reclaim_lock(m_reclaim_mtx, std::try_to_lock);
+  if (!reclaim_lock.owns_lock())
+  {
+    LBANNV2_DEBUG("MemoryBudget::reclaim: already reclaiming; skipped");
+    return 0UL;
+  }
+  decltype(m_reclaimers) reclaimers;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    reclaimers = m_reclaimers;
+  }
+
+  ReclaimGuard guard;
+  size_t freed = 0UL;
+  for (auto const& [handle, reclaimer] : reclaimers)
+  {
+    try
+    {
+      freed += reclaimer(pressure, nbytes);
+    }
+    catch (std::exception const& e)
+    {
+      LBANNV2_WARN("MemoryBudget: reclaimer {} failed: {}", handle, e.what());
+    }
+  }
+
+  LBANNV2_DEBUG("MemoryBudget::reclaim(pressure={}, nbytes={}): freed={}",
+                to_string(pressure),
+                nbytes,
+                freed);
+  return freed;
+}
+
+auto MemoryBudget::admit(size_t const nbytes) -> Reservation
+{
+  auto const soft = soft_limit();
+  auto const hard = hard_limit();
+  if ((!soft && !hard) || t_in_reclaim)
+    return {};
+
+  if (soft)
+  {
+    auto const wanted = usage() + nbytes;
+    if (wanted <= soft)
+      m_soft_fired.store(false, std::memory_order_relaxed);
+    else if (!m_soft_fired.exchange(true, std::memory_order_relaxed))
+      reclaim(Pressure::Soft, wanted - soft);
+  }
+
+  if (!hard)
+  {
+    m_reserved.fetch_add(nbytes, std::memory_order_relaxed);
+    return {this, nbytes};
+  }
+
+  if (!try_reserve(nbytes, hard))
+  {
+    auto const wanted = usage() + nbytes;
+    reclaim(Pressure::Hard, wanted > hard ? wanted - hard : 0UL);
+    if (!try_reserve(nbytes, hard))
+      throw OutOfMemory("Allocation of " + std::to_string(nbytes)
+                        + " bytes would exceed the hard memory limit of "
+                        + std::to_string(hard) + " bytes.\n" + diagnostic());
+  }
+  return {this, nbytes};
+}
+
+void* MemoryBudget::raw_alloc(Allocator& alloc,
+                              size_t const nbytes,
+                              bool const zeroed)
+{
+  auto const try_alloc = [&] {
+    return zeroed ? alloc.raw_alloc_zeroed(nbytes) : alloc.raw_alloc(nbytes);
+  };
+
+  std::string why = "allocator returned nullptr";
+  try
+  {
+    void* const ptr = try_alloc();
+    if (ptr || !nbytes)
+      return ptr;
+  }
+  catch (std::exception const& e)
+  {
+    why = e.what();
+    LBANNV2_DEBUG("MemoryBudget: allocation of {} bytes failed ({}); "
+                  "reclaiming and retrying",
+                  nbytes,
+                  e.what());
+  }
+
+  if (!t_in_reclaim)
+  {
+    reclaim(Pressure::Failed, nbytes);
+    try
+    {
+      void* const ptr = try_alloc();
+      if (ptr)
+        return ptr;
+    }
+    catch (std::exception const& e)
+    {
+      why = e.what();
+    }
+  }
+
+  throw OutOfMemory("Allocation of " + std::to_string(nbytes)
+                    + " bytes failed after reclaiming memory (" + why
+                    + ").\n" + diagnostic());
+}
+
+std::string MemoryBudget::diagnostic() const
+{
+  auto const stats = pointer_registry().stats();
+
+  std::ostringstream oss;
+  oss << "LBANNv2 holds " << stats.total.current_bytes << " bytes in "
+      << stats.total.current_allocations << " allocations (peak "
+      << stats.total.peak_bytes << " bytes); soft limit " << soft_limit()
+      << " bytes, hard limit " << hard_limit() << " bytes.";
+
+  for (auto const& [device, device_stats] : stats.by_device)
+  {
+    if (device_stats.current_allocations)
+      oss << "\n  " << device.str() << ": " << device_stats.current_bytes
+          << " bytes in " << device_stats.current_allocations
+          << " allocations";
+  }
+
+  // Largest holders first.
+  std::vector<std::pair<c10::Allocator*, MemoryStats>> by_allocator(
+    stats.by_allocator.cbegin(), stats.by_allocator.cend());
+  std::sort(by_allocator.begin(),
+            by_allocator.end(),
+            [](auto const& a, auto const& b) {
+              return a.second.current_bytes > b.second.current_bytes;
+            });
+  for (auto const& [alloc, alloc_stats] : by_allocator)
+  {
+    if (!alloc_stats.current_allocations)
+      continue;
+    oss << "\n  ";
+    if (alloc)
+      oss << c10::demangle(typeid(*alloc).name()) << " ";
+    oss << "(" << static_cast<void const*>(alloc)
+        << "): " << alloc_stats.current_bytes << " bytes in "
+        << alloc_stats.current_allocations << " allocations";
+  }
+  return oss.str();
+}
+
+std::optional<size_t> cgroup_memory_limit(std::string const& proc_cgroup,
+                                          std::string const& cgroup_root)
+{
+  std::ifstream file(proc_cgroup);
+  std::optional<size_t> out;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    // <id>:<controllers>:<path>
+    auto const first = line.find(':');
+    auto const second = line.find(':', first + 1);
+    if (first == std::string::npos || second == std::string::npos)
+      continue;
+    auto const id = line.substr(0, first);
+    auto const controllers = line.substr(first + 1, second - first - 1);
+    auto const path = line.substr(second + 1);
+
+    std::optional<size_t> limit;
+    if (id == "0" && controllers.empty())
+      limit = min_limit_to_root(cgroup_root, path, "memory.max");
+    else if (has_memory_controller(controllers))
+      limit = min_limit_to_root(
+        cgroup_root + "/memory", path, "memory.limit_in_bytes");
+
+    if (limit)
+      out = std::min(out.value_or(*limit), *limit);
+  }
+  return out;
+}
+
+MemoryBudget& memory_budget()
+{
+  static MemoryBudget* const budget = [] {
+    // Never destroyed: allocations may happen during static
+    // destruction.
+    auto* const b = new MemoryBudget;
+    auto const hard = get_env_size("LBANNV2_MEMORY_HARD_LIMIT", 0UL);
+    auto const soft = get_env_size("LBANNV2_MEMORY_SOFT_LIMIT", hard / 5 * 4);
+    b->set_limits(soft, hard);
+    // Drain first: deferred frees may refill the caches.
+    b->add_reclaimer(&reclaim_deferred_frees);
+    b->add_reclaimer(&reclaim_host_caches);
+    b->add_reclaimer(&reclaim_malloc_trim);
+    LBANNV2_DEBUG("MemoryBudget: soft limit {} bytes, hard limit {} bytes",
+                  soft,
+                  hard);
+    if (auto const cgroup = cgroup_memory_limit())
+      LBANNV2_DEBUG("MemoryBudget: the cgroup memory limit is {} bytes",
+                    *cgroup);
+    return b;
+  }();
+  return *budget;
+}
+
+}  // namespace lbannv2
@@ -0,0 +1,241 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace lbannv2
+{
+
+class Allocator;
+
+/** @brief Thrown when an allocation cannot be satisfied, even after
+ *         reclaiming memory.
+ *
+ *  The message describes the contents of the PointerRegistry at the
+ *  time of the failure.
+ */
+struct LBANNV2_EXPORT OutOfMemory : std::runtime_error
+{
+  using std::runtime_error::runtime_error;
+};
+
+/** @class MemoryBudget
+ *  @brief Limits the memory held by LBANNv2 allocators, reclaiming
+ *         memory as the limits are approached.
+ *
+ *  The budget covers host memory. Its "usage" is the number of bytes
+ *  registered with the PointerRegistry on the host, plus those
+ *  waiting in the DeferredFree queue and those admitted but not yet
+ *  registered, less the external host memory registered by the
+ *  ExternalAllocator.
+ *  Every Allocator::allocate() of an allocator that uses the host
+ *  budget (see Allocator::uses_host_budget()) checks the request
+ *  against two limits (0 disables a limit):
+ *
+ *    - Crossing the soft limit runs the reclaimers once, after which
+ *      the allocation proceeds. They run again the next time the
+ *      soft limit is crossed after usage has dropped below it.
+ *    - Exceeding the hard limit runs the reclaimers; if usage is still
+ *      too high afterwards, the allocation throws OutOfMemory.
+ *
+ *  Independently of the limits, an allocation whose raw allocation
+ *  fails is retried once after running the reclaimers.
+ *
+ *  Admission reserves the bytes it admits until the allocator has
+ *  registered them, so concurrent allocations cannot all fit under a
+ *  limit that only one of them fits under.
+ *
+ *  A reclaimer is a callback that is told how much pressure there is
+ *  and roughly how many bytes are wanted. It might empty an
+ *  allocator's cache, or spill tensors to a slower tier. Allocations
+ *  made by reclaimers bypass the budget. By default, the budget has
+ *  reclaimers that drain the DeferredFree queue, empty the caches of
+ *  the LBANNv2 host allocators and call malloc_trim(3).
+ *
+ *  The limits are initialized from LBANNV2_MEMORY_HARD_LIMIT and
+ *  LBANNV2_MEMORY_SOFT_LIMIT (in bytes). If the soft limit is not
+ *  set, it defaults to 80% of the hard limit; if neither is set, the
+ *  budget is unlimited. The memory limit of the process's cgroup
+ *  (see cgroup_memory_limit()) is not used as a default: it also
+ *  covers memory LBANNv2 does not see (the interpreter, libtorch,
+ *  other allocators), so a budget derived from it would fail later
+ *  than the kernel's OOM killer. It is only logged, as a hint for
+ *  choosing limits.
+ */
+class LBANNV2_EXPORT MemoryBudget
+{
+public:
+  /** @brief Why the reclaimers are being run. */
+  enum class Pressure
+  {
+    /** @brief An allocation crossed the soft limit. */
+    Soft,
+    /** @brief An allocation would exceed the hard limit. */
+    Hard,
+    /** @brief A raw allocation failed. */
+    Failed,
+  };
+
+  /** @brief A reclaimer.
+   *
+   *  The second argument is the number of bytes the budget would like
+   *  freed. The return value is the number of bytes the reclaimer
+   *  believes it freed; it is only used for logging.
+   */
+  using Reclaimer = std::function<size_t(Pressure, size_t)>;
+
+  /** @class Reservation
+   *  @brief Bytes admitted by admit() that are not yet registered.
+   *
+   *  These count against the budget until the reservation is
+   *  destroyed, which the allocator does once it has registered the
+   *  memory or given up on it.
+   */
+  class LBANNV2_EXPORT Reservation
+  {
+  public:
+    Reservation() = default;
+    Reservation(Reservation&& other) noexcept;
+    Reservation& operator=(Reservation&& other) noexcept;
+    Reservation(Reservation const&) = delete;
+    Reservation& operator=(Reservation const&) = delete;
+    ~Reservation();
+
+    size_t bytes() const noexcept { return m_bytes; }
+
+  private:
+    friend class MemoryBudget;
+    Reservation(MemoryBudget* budget, size_t nbytes) noexcept
+      : m_budget {budget}, m_bytes {nbytes}
+    {}
+
+    MemoryBudget* m_budget = nullptr;
+    size_t m_bytes = 0UL;
+  };  // class Reservation
+
+  MemoryBudget();
+  ~MemoryBudget() = default;
+  MemoryBudget(MemoryBudget const&) = delete;
+  MemoryBudget(MemoryBudget&&) = delete;
+  MemoryBudget& operator=(MemoryBudget const&) = delete;
+  MemoryBudget& operator=(MemoryBudget&&) = delete;
+
+  size_t soft_limit() const noexcept
+  {
+    return m_soft_limit.load(std::memory_order_relaxed);
+  }
+
+  size_t hard_limit() const noexcept
+  {
+    return m_hard_limit.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Set both limits (0 disables a limit). */
+  void set_limits(size_t soft, size_t hard);
+
+  /** @brief The number of bytes counted against the budget. */
+  size_t usage() const noexcept;
+
+  /** @brief Add a reclaimer.
+   *
+   *  Reclaimers run in the order they were added.
+   *
+   *  @returns A handle for remove_reclaimer().
+   */
+  size_t add_reclaimer(Reclaimer reclaimer);
+
+  /** @brief Remove a reclaimer added by add_reclaimer(). */
+  void remove_reclaimer(size_t handle);
+
+  /** @brief Run the reclaimers.
+   *
+   *  Only one thread reclaims at a time. Calls made while another
+   *  thread is reclaiming do not wait for it (a reclaimer may be
+   *  waiting on something the caller holds, such as the Python GIL);
+   *  they do nothing, as do calls from within a reclaimer.
+   *
+   *  @returns The sum of the reclaimers' return values.
+   */
+  size_t reclaim(Pressure pressure, size_t nbytes);
+
+  /** @brief Check that an allocation of nbytes fits in the budget,
+   *         reclaiming memory as needed.
+   *
+   *  The check and the reservation of the bytes are one atomic step
+   *  with respect to other admissions.
+   *
+   *  @returns The reservation of the bytes; hold it until they are
+   *           registered. It is empty if no limit is set.
+   *  @throws OutOfMemory if the allocation would exceed the hard
+   *          limit even after reclaiming.
+   */
+  [[nodiscard]] Reservation admit(size_t nbytes);
+
+  /** @brief Do a raw allocation, retrying once after reclaiming if
+   *         it fails.
+   *
+   *  This does not call admit().
+   *
+   *  @param[in] alloc The allocator to use.
+   *  @param[in] nbytes The size of the allocation.
+   *  @param[in] zeroed Use raw_alloc_zeroed() rather than raw_alloc().
+   *
+   *  @throws OutOfMemory if the retry also fails.
+   */
+  void* raw_alloc(Allocator& alloc, size_t nbytes, bool zeroed = false);
+
+  /** @brief Describe the memory registered with the PointerRegistry. */
+  std::string diagnostic() const;
+
+private:
+  /** @brief usage(), less the reservations. */
+  size_t held() const noexcept;
+
+  /** @brief Reserve nbytes if they fit under the limit. */
+  bool try_reserve(size_t nbytes, size_t limit) noexcept;
+
+  std::atomic<size_t> m_soft_limit = 0UL;
+  std::atomic<size_t> m_hard_limit = 0UL;
+  std::atomic<bool> m_soft_fired = false;
+  std::atomic<size_t> m_reserved = 0UL;
+
+  mutable std::mutex m_mtx;
+  std::vector<std::pair<size_t, Reclaimer>> m_reclaimers;
+  size_t m_next_handle = 0UL;
+
+  std::mutex m_reclaim_mtx;
+};  // class MemoryBudget
+
+/** @brief Get the memory limit of this process's cgroup.
+ *
+ *  Both cgroup v2 ("memory.max") and v1 ("memory.limit_in_bytes")
+ *  are understood. The limits of ancestor cgroups apply too, so the
+ *  smallest limit on the path to the root is returned.
+ *
+ *  @param[in] proc_cgroup The file listing the process's cgroups.
+ *  @param[in] cgroup_root The mount point of the cgroup filesystem.
+ *
+ *  @returns The limit in bytes, or nothing if there is none.
+ */
+LBANNV2_EXPORT std::optional<size_t>
+cgroup_memory_limit(std::string const& proc_cgroup = "/proc/self/cgroup",
+                    std::string const& cgroup_root = "/sys/fs/cgroup");
+
+/** @brief Get the budget used by LBANNv2 allocators. */
+LBANNV2_EXPORT MemoryBudget& memory_budget();
+
+}  // namespace lbannv2
@@ -25,54 +25,11 @@
 
 namespace
 {
-bool get_use_nonblocking_stream_env_var()
-{
-  char* env = std::getenv("LBANNV2_NONBLOCKING_HOST_ALLOC_STREAM");
-  return env && std::strlen(env) && env[0] != '0';
-}
-
-bool use_nonblocking_stream()
-{
-  static bool const nonblock = get_use_nonblocking_stream_env_var();
-  LBANNV2_DEBUG("Using nonblocking MI300A allocation stream? {}", nonblock);
-  return nonblock;
-}
-
-struct StreamRAII
-{
-  ::lbannv2::TorchGPUStream_t stream;
-
-  StreamRAII()
-    : stream {lbannv2::c10_gpu::getStreamFromExternal(
-        use_nonblocking_stream() ? lbannv2::gpu::make_nonblocking_stream()
-                                 : lbannv2::gpu::make_stream(),
-        lbannv2::gpu::current_device())}
-  {}
-  ~StreamRAII()
-  {
-    try
-    {
-      lbannv2::gpu::destroy_stream(stream.stream());
-    }
-    catch (...)
-    {}
-  }
-};  // struct StreamRAII
-
 // Internal stream for managing "host" allocations through CUB
 ::lbannv2::TorchGPUStream_t host_allocation_stream(c10::DeviceIndex const idx)
 {
-  static std::vector<StreamRAII> stream_raii(lbannv2::gpu::num_devices());
-  LBANNV2_ASSERT_ALWAYS(idx >= 0 && idx < lbannv2::gpu::num_devices());
-  return stream_raii[idx].stream;
-}
-
-c10::Device resolve_device(c10::Device const& d)
-{
-  if (d.is_cuda() && !d.has_index())
-    return {c10::kCUDA, lbannv2::gpu::current_device()};
-
-  return d;
+  return lbannv2::c10_gpu::getStreamFromExternal(
+    lbannv2::gpu::host_allocation_stream(idx), idx);
 }
 
 #if LBANNV2_USE_C10_HIP_NAMESPACE_AND_SYMBOLS
@@ -150,6 +107,23 @@ void* MI300Allocator::raw_alloc(size_t const nbytes)
   return ptr;
 }
 
+void* MI300Allocator::raw_alloc_zeroed(size_t const nbytes)
+{
+  // Zero the memory on the GPU, in order with the allocation, rather
+  // than faulting it into the host's view with a memset.
+  auto const stream = host_allocation_stream(lbannv2::gpu::current_device());
+  auto* const ptr = alloc_->raw_alloc_with_stream(nbytes, stream);
+  if (ptr && nbytes)
+    LBANNV2_CHECK_GPU(hipMemsetAsync(ptr, 0, nbytes, stream));
+
+  LBANNV2_TRACE("MI300Allocator::raw_alloc_zeroed(nbytes={}): ptr={}",
+                nbytes,
+                ptr);
+  lbannv2::gpu::sync(stream);
+
+  return ptr;
+}
+
 void MI300Allocator::raw_dealloc(void* ptr)
 {
   LBANNV2_TRACE("MI300Allocator::raw_deallocate(ptr={})", ptr);
@@ -192,45 +166,109 @@ c10::DeviceIndex lbannv2::get_device_idx(void const* const ptr) noexcept
   }
 }
 
+namespace lbannv2
+{
+
 // Let's aim for a fully robust implementation here. We must consider:
 //   1. Migrating from D(:m) -> D(:m) is a no-op.
 //   2. Migrating from D:m -> D:n is a deep copy
-void lbannv2::migrate_ptr(c10::DataPtr& ptr,
-                          c10::Device to_device,
-                          c10::Stream with_stream)
+// The first is handled by CoherentMemoryDomain::rebrand(); the second
+// is rejected there (see can_migrate()).
+class MI300ACoherentMemory final : public CoherentMemoryDomain
 {
-  auto const real_tgt_device = resolve_device(to_device);
+  class EventFence final : public Fence
+  {
+  public:
+    explicit EventFence(TorchGPUStream_t const& stream)
+      : m_event {gpu::make_event()}
+    {
+      gpu::record_event(m_event, stream.stream());
+    }
+    EventFence(EventFence const&) = delete;
+    EventFence& operator=(EventFence const&) = delete;
 
-  // If no migration actually happens, just short-circuit...
-  if (ptr.device() == real_tgt_device)
-    return;
+    ~EventFence()
+    {
+      try
+      {
+        gpu::destroy_event(m_event);
+      }
+      catch (...)
+      {}
+    }
 
-#if LBANNV2_WITHOUT_MI300A || LBANNV2_UNKNOWN_MI300A
-#if LBANNV2_UNKNOWN_MI300A
-  if (!lbannv2::gpu::is_integrated())
-#endif
+    bool query() const final { return gpu::query_event(m_event); }
+
+    void wait() const final { gpu::sync_event(m_event); }
+
+    void wait_on(c10::Stream const stream) const final
+    {
+      if (stream.device().is_cpu())
+        wait();
+      else
+        gpu::wait_event(TorchGPUStream_t {stream}.stream(), m_event);
+    }
+
+  private:
+    gpu::Event_t m_event;
+  };  // class EventFence
+
+public:
+  std::string name() const final { return "mi300a"; }
+
+  c10::DeviceType device_type() const noexcept final { return c10::kCUDA; }
+
+  c10::DeviceIndex current_device() const final
   {
-    throw std::runtime_error("migrate_ptr is only supported on MI300A");
+    return gpu::current_device();
   }
-#endif
 
-  // Check that the migration is valid
-  auto const ptr_dev_idx = get_device_idx(ptr.get_context());
-  c10::Device const real_src_device = ptr_dev_idx == -1
-                                        ? c10::Device {c10::kCPU}
-                                        : c10::Device {c10::kCUDA, ptr_dev_idx};
-  LBANNV2_ASSERT(real_tgt_device.is_cpu() || real_src_device == real_tgt_device,
-                 std::runtime_error,
-                 "lbannv2::migrate_ptr: invalid src/tgt device combo");
-
-  // Update the stream
-  auto const new_stream = real_tgt_device.is_cpu()
-                            ? host_allocation_stream(ptr_dev_idx)
-                            : TorchGPUStream_t(with_stream);
-
-  // UGH. Oh well.
-  MI300Allocator::instance().alloc_->recordStream(ptr, new_stream);
-
-  // Finally, update the DataPtr itself
-  ptr.unsafe_set_device(real_tgt_device);
+  Allocator& host_allocator() final { return MI300Allocator::instance(); }
+
+  // NOTE: This assumes a binary view of memory: pointers only come
+  // from "CPU" or "CUDA" (i.e., HIP).
+  c10::Device origin(void const* const ptr) const noexcept final
+  {
+    auto const idx = get_device_idx(ptr);
+    return idx == -1 ? c10::Device {c10::kCPU}
+                     : c10::Device {c10::kCUDA, idx};
+  }
+
+  c10::Stream current_stream(c10::Device const device) const final
+  {
+    return getDeviceCurrentStream(resolve(device).index());
+  }
+
+  void synchronize(c10::Device const device) final
+  {
+    getDeviceCurrentStream(resolve(device).index()).synchronize();
+  }
+
+  std::shared_ptr<Fence> record(c10::Device const device) final
+  {
+    return std::make_shared<EventFence>(
+      getDeviceCurrentStream(resolve(device).index()));
+  }
+
+private:
+  void associate(c10::DataPtr& ptr,
+                 c10::Device const& to,
+                 c10::Stream const stream) final
+  {
+    auto const ptr_dev_idx = get_device_idx(ptr.get_context());
+    auto const new_stream = to.is_cpu() ? host_allocation_stream(ptr_dev_idx)
+                                        : TorchGPUStream_t(stream);
+
+    // UGH. Oh well.
+    MI300Allocator::instance().alloc_->recordStream(ptr, new_stream);
+  }
+};  // class MI300ACoherentMemory
+
+CoherentMemoryDomain& mi300a_coherent_memory()
+{
+  // Never destroyed: tensors may well outlive static destruction.
+  static MI300ACoherentMemory* const domain = new MI300ACoherentMemory;
+  return *domain;
 }
+
+}  // namespace lbannv2
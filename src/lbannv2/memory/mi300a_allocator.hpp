@@ -7,6 +7,7 @@
 #pragma once
 
 #include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/coherent_memory.hpp>
 #include <lbannv2/utils/gpu_utils.hpp>
 
 #include <c10/core/Stream.h>
@@ -20,10 +21,7 @@
 namespace lbannv2
 {
 
-// Call when moving pointer to a different device
-void migrate_ptr(c10::DataPtr& ptr,
-                 c10::Device to_device,
-                 c10::Stream with_stream);
+class MI300ACoherentMemory;
 
 class MI300Allocator final : public Allocator
 {
@@ -32,12 +30,18 @@ public:
 
   void* raw_alloc(size_t nbytes) final;
 
+  void* raw_alloc_zeroed(size_t nbytes) final;
+
   void raw_dealloc(void* ptr) final;
 
   c10::DeleterFnPtr raw_deleter() const final;
 
   c10::Device get_device() const noexcept final;
 
+  /** @brief The memory is the APU's HBM, so the host budget (e.g., a
+   *         cgroup limit) does not gate it. */
+  bool uses_host_budget() const noexcept final { return false; }
+
   static MI300Allocator& instance();
 
 private:
@@ -55,10 +59,18 @@ private:
 #endif
   DeviceAlloc_t* alloc_;
 
-  friend void migrate_ptr(c10::DataPtr&, c10::Device, c10::Stream);
-
+  friend class MI300ACoherentMemory;
 };
 
+/** @brief The MI300A coherent-memory domain.
+ *
+ *  Its host allocator is the MI300Allocator, whose memory comes from
+ *  the (HIP) device caching allocator and is tied to the device that
+ *  was current when it was allocated. Streams are associated with
+ *  recordStream; on the host, with an internal allocation stream.
+ */
+LBANNV2_EXPORT CoherentMemoryDomain& mi300a_coherent_memory();
+
 /** @brief Get the device with which the allocation is associated.
  *
  * @note From what I can tell, this is any valid pointer -- it doesn't
@@ -0,0 +1,234 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/mmap_file_allocator.hpp"
+
+#include "lbannv2/memory/deferred_free.hpp"
+#include "lbannv2/memory/registry.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+
+using MFA = lbannv2::MmapFileAllocator;
+
+size_t page_size() noexcept
+{
+  static size_t const size = sysconf(_SC_PAGESIZE);
+  return size;
+}
+
+std::string get_env_directory()
+{
+  for (char const* const var : {"LBANNV2_MMAP_DIR", "TMPDIR"})
+  {
+    char const* const env = std::getenv(var);
+    if (env && std::strlen(env))
+      return env;
+  }
+  return "/tmp";
+}
+
+int to_madvise(MFA::Advice const advice)
+{
+  switch (advice)
+  {
+  case MFA::Advice::Normal:
+    return MADV_NORMAL;
+  case MFA::Advice::Random:
+    return MADV_RANDOM;
+  case MFA::Advice::Sequential:
+    return MADV_SEQUENTIAL;
+  case MFA::Advice::WillNeed:
+    return MADV_WILLNEED;
+  case MFA::Advice::DontNeed:
+    return MADV_DONTNEED;
+  }
+  throw std::runtime_error("Unknown madvise advice");
+}
+
+// Make an anonymous (already unlinked) file in dir.
+int make_file(std::string const& dir)
+{
+  std::string const path = dir + "/lbannv2-mmap-XXXXXX";
+  std::vector<char> buf(path.cbegin(), path.cend());
+  buf.push_back('\0');
+
+  int const fd = mkostemp(buf.data(), O_CLOEXEC);
+  LBANNV2_ASSERT(fd >= 0,
+                 std::runtime_error,
+                 "MmapFileAllocator: cannot create file in \"" + dir
+                   + "\": " + std::strerror(errno));
+  unlink(buf.data());
+  return fd;
+}
+
+void delete_mmap_file_ptr(void* const ptr)
+{
+  auto const nbytes = lbannv2::pointer_registry().remove(ptr);
+  lbannv2::release_or_defer(MFA::instance(), ptr, nbytes);
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+MmapFileAllocator::MmapFileAllocator() : m_directory {get_env_directory()} {}
+
+void MmapFileAllocator::copy_data(void* const dst,
+                                  void const* const src,
+                                  size_t const bytes) const
+{
+  std::memcpy(dst, src, bytes);
+}
+
+void* MmapFileAllocator::raw_alloc(size_t const nbytes)
+{
+  if (nbytes == 0)
+    return nullptr;
+
+  size_t const len = (nbytes + page_size() - 1) / page_size() * page_size();
+  int const fd = make_file(directory());
+
+  // Extending the file leaves a hole, so no blocks are used yet.
+  if (ftruncate(fd, static_cast<off_t>(len)) != 0)
+  {
+    auto const err = errno;
+    close(fd);
+    throw std::runtime_error(std::string("MmapFileAllocator: ftruncate: ")
+                             + std::strerror(err));
+  }
+
+  void* const ptr =
+    mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  auto const err = errno;
+  // The mapping keeps the file alive.
+  close(fd);
+  LBANNV2_ASSERT(ptr != MAP_FAILED,
+                 std::runtime_error,
+                 std::string("MmapFileAllocator: mmap: ") + std::strerror(err));
+
+  LBANNV2_TRACE(
+    "MmapFileAllocator::raw_alloc(nbytes={}): ptr={}", nbytes, ptr);
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  m_sizes.emplace(ptr, len);
+  m_stats.mapped_bytes += len;
+  ++m_stats.num_files;
+  return ptr;
+}
+
+void* MmapFileAllocator::raw_alloc_zeroed(size_t const nbytes)
+{
+  // Every allocation maps a new, empty file, which reads as zeros.
+  return raw_alloc(nbytes);
+}
+
+void MmapFileAllocator::raw_dealloc(void* const ptr)
+{
+  if (!ptr)
+    return;
+
+  size_t len;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto const it = m_sizes.find(ptr);
+    LBANNV2_ASSERT(it != m_sizes.end(),
+                   std::runtime_error,
+                   "MmapFileAllocator: pointer not allocated here");
+    len = it->second;
+    m_sizes.erase(it);
+    m_stats.mapped_bytes -= len;
+    --m_stats.num_files;
+  }
+
+  LBANNV2_TRACE("MmapFileAllocator::raw_dealloc(ptr={})", ptr);
+  munmap(ptr, len);
+}
+
+c10::DeleterFnPtr MmapFileAllocator::raw_deleter() const
+{
+  return &delete_mmap_file_ptr;
+}
+
+c10::Device MmapFileAllocator::get_device() const noexcept
+{
+  return c10::Device {c10::kCPU};
+}
+
+std::string MmapFileAllocator::directory() const
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_directory;
+}
+
+void MmapFileAllocator::set_directory(std::string dir)
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  m_directory = std::move(dir);
+}
+
+void MmapFileAllocator::advise(void const* const ptr,
+                               size_t const nbytes,
+                               Advice const advice) const
+{
+  void const* const base = pointer_registry().get_context(ptr);
+  size_t len;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto const it = m_sizes.find(base);
+    LBANNV2_ASSERT(it != m_sizes.end(),
+                   std::runtime_error,
+                   "MmapFileAllocator: pointer not allocated here");
+    len = it->second;
+  }
+
+  // Widen to pages, but never beyond this mapping; advice like
+  // DONTNEED would be destructive to anonymous neighbors.
+  auto const base_addr = reinterpret_cast<std::uintptr_t>(base);
+  auto const addr = reinterpret_cast<std::uintptr_t>(ptr);
+  auto const begin = addr / page_size() * page_size();
+  auto const end = std::min(
+    (addr + nbytes + page_size() - 1) / page_size() * page_size(),
+    base_addr + len);
+  if (begin >= end)
+    return;
+
+  if (madvise(reinterpret_cast<void*>(begin), end - begin, to_madvise(advice))
+      != 0)
+  {
+    throw std::runtime_error(std::string("MmapFileAllocator: madvise: ")
+                             + std::strerror(errno));
+  }
+}
+
+auto MmapFileAllocator::stats() const -> Stats
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_stats;
+}
+
+MmapFileAllocator& MmapFileAllocator::instance()
+{
+  // Never destroyed: tensors may well outlive static destruction.
+  static MmapFileAllocator* const alloc = new MmapFileAllocator;
+  return *alloc;
+}
+
+}  // namespace lbannv2
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace lbannv2
+{
+
+/** @class MmapFileAllocator
+ *  @brief A CPU allocator backed by memory-mapped files.
+ *
+ *  Each allocation is a shared mapping of its own (sparse) temporary
+ *  file. The file is unlinked as soon as it is mapped, so nothing is
+ *  left behind, and disk blocks are only used for pages that are
+ *  written. Since the kernel can write pages back to the file and
+ *  drop them at any time, the working set of these allocations is
+ *  not limited by DRAM.
+ *
+ *  The files are created in directory(), which defaults to
+ *  LBANNV2_MMAP_DIR, then TMPDIR, then /tmp. For out-of-core use,
+ *  this should be on fast local storage.
+ */
+class LBANNV2_EXPORT MmapFileAllocator final : public Allocator
+{
+public:
+  /** @brief Access pattern hints; see madvise(2). */
+  enum class Advice
+  {
+    Normal,
+    Random,
+    Sequential,
+    WillNeed,
+    DontNeed,
+  };
+
+  struct Stats
+  {
+    /** @brief Bytes currently mapped. */
+    size_t mapped_bytes = 0UL;
+    /** @brief Number of files currently mapped. */
+    size_t num_files = 0UL;
+  };
+
+  void copy_data(void* dst, void const* src, size_t bytes) const final;
+
+  void* raw_alloc(size_t nbytes) final;
+
+  void* raw_alloc_zeroed(size_t nbytes) final;
+
+  void raw_dealloc(void* ptr) final;
+
+  c10::DeleterFnPtr raw_deleter() const final;
+
+  c10::Device get_device() const noexcept final;
+
+  /** @brief The directory in which new files are created. */
+  std::string directory() const;
+
+  /** @brief Set the directory in which new files are created. */
+  void set_directory(std::string dir);
+
+  /** @brief Give the kernel a hint about part of an allocation.
+   *
+   *  The range is widened to page boundaries, but is clipped to the
+   *  allocation containing ptr.
+   *
+   *  @param[in] ptr The beginning of the range.
+   *  @param[in] nbytes The length of the range.
+   *  @param[in] advice The hint.
+   *
+   *  @throws UnknownAddress if ptr is not in registered memory.
+   *  @throws std::runtime_error if ptr is in memory from another
+   *          allocator.
+   */
+  void advise(void const* ptr, size_t nbytes, Advice advice) const;
+
+  Stats stats() const;
+
+  static MmapFileAllocator& instance();
+
+private:
+  MmapFileAllocator();
+  ~MmapFileAllocator() = default;
+  MmapFileAllocator(MmapFileAllocator const&) = delete;
+  MmapFileAllocator(MmapFileAllocator&&) = delete;
+  MmapFileAllocator& operator=(MmapFileAllocator const&) = delete;
+  MmapFileAllocator& operator=(MmapFileAllocator&&) = delete;
+
+  mutable std::mutex m_mtx;
+  std::string m_directory;
+  std::unordered_map<void const*, size_t> m_sizes;
+  Stats m_stats;
+};  // class MmapFileAllocator
+
+}  // namespace lbannv2
@@ -0,0 +1,301 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/numa_allocator.hpp"
+
+#include "lbannv2/memory/deferred_free.hpp"
+#include "lbannv2/memory/registry.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// We use the system calls directly rather than depend on libnuma.
+namespace
+{
+
+using NA = lbannv2::NumaAllocator;
+
+// From <linux/mempolicy.h>
+constexpr int mpol_preferred = 1;
+constexpr int mpol_bind = 2;
+constexpr int mpol_interleave = 3;
+constexpr int mpol_f_node = 1 << 0;
+constexpr int mpol_f_addr = 1 << 1;
+
+constexpr size_t bits_per_ulong = sizeof(unsigned long) * CHAR_BIT;
+
+size_t page_size() noexcept
+{
+  static size_t const size = sysconf(_SC_PAGESIZE);
+  return size;
+}
+
+std::vector<int> get_online_nodes()
+{
+  std::vector<int> nodes;
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string list;
+  if (online && std::getline(online, list))
+  {
+    // A list of ranges, e.g., "0-3,8".
+    std::istringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+      int lo, hi;
+      auto const n = std::sscanf(item.c_str(), "%d-%d", &lo, &hi);
+      if (n == 1)
+        hi = lo;
+      for (int i = lo; n >= 1 && i <= hi; ++i)
+        nodes.push_back(i);
+    }
+  }
+
+  if (nodes.empty())
+    nodes.push_back(0);
+  return nodes;
+}
+
+// The node of the CPU the calling thread is running on.
+int current_node(int const fallback) noexcept
+{
+  unsigned cpu, node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+    return fallback;
+  return static_cast<int>(node);
+}
+
+void set_policy(void* const ptr,
+                size_t const len,
+                int const mode,
+                std::vector<int> const& nodes)
+{
+  auto const max_node = *std::max_element(nodes.cbegin(), nodes.cend());
+  std::vector<unsigned long> mask(max_node / bits_per_ulong + 1, 0UL);
+  for (auto const n : nodes)
+    mask[n / bits_per_ulong] |= 1UL << (n % bits_per_ulong);
+
+  // The kernel treats maxnode as one past the last bit.
+  if (syscall(SYS_mbind,
+              ptr,
+              len,
+              mode,
+              mask.data(),
+              mask.size() * bits_per_ulong + 1,
+              0)
+      != 0)
+  {
+    LBANNV2_DEBUG("NumaAllocator: mbind(ptr={}, mode={}) failed ({})",
+                  ptr,
+                  mode,
+                  std::strerror(errno));
+  }
+}
+
+void delete_numa_ptr(void* const ptr)
+{
+  auto const nbytes = lbannv2::pointer_registry().remove(ptr);
+  lbannv2::release_or_defer(NA::instance(), ptr, nbytes);
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+NumaAllocator::NumaAllocator()
+  : m_nodes {get_online_nodes()},
+    m_node_bytes(*std::max_element(m_nodes.cbegin(), m_nodes.cend()) + 1, 0UL)
+{
+  LBANNV2_DEBUG("NumaAllocator: {} online node(s)", m_nodes.size());
+}
+
+void NumaAllocator::copy_data(void* const dst,
+                              void const* const src,
+                              size_t const bytes) const
+{
+  std::memcpy(dst, src, bytes);
+}
+
+void* NumaAllocator::raw_alloc(size_t const nbytes)
+{
+  if (nbytes == 0)
+    return nullptr;
+
+  size_t const len = (nbytes + page_size() - 1) / page_size() * page_size();
+  void* const ptr = mmap(
+    nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  LBANNV2_ASSERT(
+    ptr != MAP_FAILED, std::runtime_error, "NumaAllocator: mmap failed");
+
+  auto const placement = this->placement();
+  Record record {len, nbytes, m_nodes.front()};
+  if (m_nodes.size() > 1)
+  {
+    switch (placement.policy)
+    {
+    case NumaPlacement::Policy::Local:
+      // "Preferred" rather than "bind" so that a full node spills
+      // over instead of failing.
+      record.node = current_node(m_nodes.front());
+      set_policy(ptr, len, mpol_preferred, {record.node});
+      break;
+    case NumaPlacement::Policy::Interleave:
+      record.node = -1;
+      set_policy(ptr, len, mpol_interleave, m_nodes);
+      break;
+    case NumaPlacement::Policy::Bind:
+      record.node = placement.node;
+      set_policy(ptr, len, mpol_bind, {record.node});
+      break;
+    }
+  }
+
+  LBANNV2_TRACE("NumaAllocator::raw_alloc(nbytes={}): ptr={}, node={}",
+                nbytes,
+                ptr,
+                record.node);
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  m_records.emplace(ptr, record);
+  account(record, /*add=*/true);
+  return ptr;
+}
+
+void* NumaAllocator::raw_alloc_zeroed(size_t const nbytes)
+{
+  // Fresh anonymous mappings are zero-filled by the kernel.
+  return raw_alloc(nbytes);
+}
+
+void NumaAllocator::raw_dealloc(void* const ptr)
+{
+  if (!ptr)
+    return;
+
+  size_t len;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto const it = m_records.find(ptr);
+    LBANNV2_ASSERT(it != m_records.end(),
+                   std::runtime_error,
+                   "NumaAllocator: pointer not allocated here");
+    len = it->second.size;
+    account(it->second, /*add=*/false);
+    m_records.erase(it);
+  }
+
+  LBANNV2_TRACE("NumaAllocator::raw_dealloc(ptr={})", ptr);
+  munmap(ptr, len);
+}
+
+c10::DeleterFnPtr NumaAllocator::raw_deleter() const
+{
+  return &delete_numa_ptr;
+}
+
+c10::Device NumaAllocator::get_device() const noexcept
+{
+  return c10::Device {c10::kCPU};
+}
+
+NumaPlacement NumaAllocator::placement() const
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_placement;
+}
+
+NumaPlacement NumaAllocator::set_placement(NumaPlacement const placement)
+{
+  auto const is_online = [this](int const node) {
+    return std::find(m_nodes.cbegin(), m_nodes.cend(), node) != m_nodes.cend();
+  };
+  LBANNV2_ASSERT(placement.policy != NumaPlacement::Policy::Bind
+                   || is_online(placement.node),
+                 std::runtime_error,
+                 "NumaAllocator: cannot bind to a node that is not online");
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return std::exchange(m_placement, placement);
+}
+
+std::vector<size_t> NumaAllocator::bytes_by_node() const
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_node_bytes;
+}
+
+int NumaAllocator::intended_node(void const* const ptr) const
+{
+  void const* const base = pointer_registry().get_context(ptr);
+  std::lock_guard<std::mutex> lock(m_mtx);
+  auto const it = m_records.find(base);
+  LBANNV2_ASSERT(it != m_records.end(),
+                 std::runtime_error,
+                 "NumaAllocator: pointer not allocated here");
+  return it->second.node;
+}
+
+void NumaAllocator::account(Record const& record, bool const add)
+{
+  auto const update = [&](int const node, size_t const bytes) {
+    if (add)
+      m_node_bytes[node] += bytes;
+    else
+      m_node_bytes[node] -= bytes;
+  };
+
+  if (record.node >= 0)
+  {
+    update(record.node, record.nbytes);
+    return;
+  }
+
+  // Interleaved: split evenly, any remainder going to the first node.
+  auto const share = record.nbytes / m_nodes.size();
+  for (auto const n : m_nodes)
+    update(n, share);
+  update(m_nodes.front(), record.nbytes - share * m_nodes.size());
+}
+
+int NumaAllocator::node_of(void const* const ptr) noexcept
+{
+  auto const addr = reinterpret_cast<std::uintptr_t>(ptr);
+  void* const page = reinterpret_cast<void*>(addr - addr % page_size());
+  int node = -1;
+  if (syscall(SYS_get_mempolicy,
+              &node,
+              nullptr,
+              0UL,
+              page,
+              mpol_f_node | mpol_f_addr)
+      != 0)
+    return -1;
+  return node;
+}
+
+NumaAllocator& NumaAllocator::instance()
+{
+  // Never destroyed: tensors may well outlive static destruction.
+  static NumaAllocator* const alloc = new NumaAllocator;
+  return *alloc;
+}
+
+}  // namespace lbannv2
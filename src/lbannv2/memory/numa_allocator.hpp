@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace lbannv2
+{
+
+/** @brief Where a NumaAllocator puts new allocations. */
+struct NumaPlacement
+{
+  enum class Policy
+  {
+    /** @brief Prefer the node of the allocating thread.
+     *
+     *  This is MPOL_PREFERRED: pages go to other nodes once the
+     *  preferred node is full, rather than failing.
+     */
+    Local,
+    /** @brief Interleave pages across all online nodes. */
+    Interleave,
+    /** @brief Bind to an explicit node. */
+    Bind,
+  };
+
+  Policy policy = Policy::Local;
+  /** @brief The node to bind to; only used by Policy::Bind. */
+  int node = -1;
+};
+
+/** @class NumaAllocator
+ *  @brief A CPU allocator with control over NUMA placement.
+ *
+ *  Every allocation is its own page-aligned anonymous mapping with a
+ *  memory policy (mbind(2)) set according to the current
+ *  placement(). Pages are still only placed on first touch, but the
+ *  kernel will put them where the policy says rather than wherever
+ *  the touching thread happens to run.
+ *
+ *  On single-node machines, or where the mbind system call is not
+ *  permitted, the policy is skipped and this behaves like a plain
+ *  mmap-based allocator.
+ *
+ *  Since each allocation is at least a page and costs a system call,
+ *  this is meant for large buffers.
+ */
+class LBANNV2_EXPORT NumaAllocator final : public Allocator
+{
+public:
+  void copy_data(void* dst, void const* src, size_t bytes) const final;
+
+  void* raw_alloc(size_t nbytes) final;
+
+  void* raw_alloc_zeroed(size_t nbytes) final;
+
+  void raw_dealloc(void* ptr) final;
+
+  c10::DeleterFnPtr raw_deleter() const final;
+
+  c10::Device get_device() const noexcept final;
+
+  /** @brief The placement used for new allocations. */
+  NumaPlacement placement() const;
+
+  /** @brief Set the placement used for new allocations.
+   *
+   *  This is process-wide.
+   *
+   *  @returns The previous placement.
+   *  @throws std::runtime_error if binding to a node that is not
+   *          online.
+   */
+  NumaPlacement set_placement(NumaPlacement placement);
+
+  /** @brief The online NUMA nodes. Always has at least one entry. */
+  std::vector<int> const& nodes() const noexcept { return m_nodes; }
+
+  /** @brief Bytes currently allocated, by intended node.
+   *
+   *  Indexed by node id. Interleaved allocations are split evenly
+   *  across the online nodes. These are the requested sizes, as
+   *  counted by the PointerRegistry, so they sum to this allocator's
+   *  current_bytes there.
+   */
+  std::vector<size_t> bytes_by_node() const;
+
+  /** @brief The node the allocation containing ptr was placed on.
+   *
+   *  Any address in a live allocation from this allocator may be
+   *  given; it is resolved through the PointerRegistry.
+   *
+   *  @returns The node id, or -1 for interleaved allocations.
+   *  @throws UnknownAddress if ptr is not in a registered allocation.
+   *  @throws std::runtime_error if it is not from this allocator.
+   */
+  int intended_node(void const* ptr) const;
+
+  /** @brief The node actually backing the page containing ptr.
+   *
+   *  This faults the page in if it has not yet been touched.
+   *
+   *  @returns The node id, or -1 if it cannot be determined.
+   */
+  static int node_of(void const* ptr) noexcept;
+
+  static NumaAllocator& instance();
+
+private:
+  NumaAllocator();
+  ~NumaAllocator() = default;
+  NumaAllocator(NumaAllocator const&) = delete;
+  NumaAllocator(NumaAllocator&&) = delete;
+  NumaAllocator& operator=(NumaAllocator const&) = delete;
+  NumaAllocator& operator=(NumaAllocator&&) = delete;
+
+  struct Record
+  {
+    /** @brief The length of the mapping. */
+    size_t size;
+    /** @brief The size requested. */
+    size_t nbytes;
+    /** @brief -1 for interleaved allocations. */
+    int node;
+  };
+
+  void account(Record const& record, bool add);
+
+  std::vector<int> m_nodes;
+
+  mutable std::mutex m_mtx;
+  NumaPlacement m_placement;
+  std::unordered_map<void const*, Record> m_records;
+  std::vector<size_t> m_node_bytes;
+};  // class NumaAllocator
+
+}  // namespace lbannv2
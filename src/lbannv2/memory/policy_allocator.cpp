@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/policy_allocator.hpp"
+
+#include "lbannv2/memory/huge_page_allocator.hpp"
+#include "lbannv2/memory/mmap_file_allocator.hpp"
+#include "lbannv2/memory/numa_allocator.hpp"
+#include "lbannv2/memory/registry.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using lbannv2::DynamicLayer;
+using lbannv2::DynamicNext;
+using lbannv2::ErasedLayer;
+
+[[noreturn]] void bad_spec(std::string_view const spec,
+                           std::string const& why)
+{
+  throw std::runtime_error("Bad host allocator spec \"" + std::string(spec)
+                           + "\": " + why);
+}
+
+std::string_view trim(std::string_view s) noexcept
+{
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front())))
+    s.remove_prefix(1);
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back())))
+    s.remove_suffix(1);
+  return s;
+}
+
+std::vector<std::string_view> split(std::string_view s)
+{
+  std::vector<std::string_view> out;
+  while (!s.empty())
+  {
+    auto const comma = s.find(',');
+    out.push_back(trim(s.substr(0, comma)));
+    if (comma == std::string_view::npos)
+      break;
+    s.remove_prefix(comma + 1);
+  }
+  return out;
+}
+
+// "<digits>[KMGT]"
+size_t parse_size(std::string_view const spec, std::string_view const str)
+{
+  constexpr std::string_view suffixes = "KMGT";
+  constexpr size_t max_size = std::numeric_limits<size_t>::max();
+  auto const too_big = [&] {
+    bad_spec(spec, "size \"" + std::string(str) + "\" is too large");
+  };
+
+  size_t value = 0UL;
+  size_t i = 0UL;
+  for (; i < str.size() && std::isdigit(static_cast<unsigned char>(str[i]));
+       ++i)
+  {
+    size_t const digit = str[i] - '0';
+    if (value > (max_size - digit) / 10)
+      too_big();
+    value = value * 10 + digit;
+  }
+
+  if (i == 0)
+    bad_spec(spec, "expected a size, got \"" + std::string(str) + "\"");
+
+  if (i < str.size())
+  {
+    auto const suffix = suffixes.find(static_cast<char>(
+      std::toupper(static_cast<unsigned char>(str[i]))));
+    if (suffix == std::string_view::npos || i + 1 != str.size())
+      bad_spec(spec, "bad size suffix in \"" + std::string(str) + "\"");
+    auto const shift = 10 * (suffix + 1);
+    if (value > (max_size >> shift))
+      too_big();
+    value <<= shift;
+  }
+  return value;
+}
+
+std::unique_ptr<DynamicLayer> make_backing(std::string_view const name)
+{
+  using lbannv2::AllocatorBacking;
+  if (name == "malloc")
+    return std::make_unique<ErasedLayer<lbannv2::MallocBacking>>();
+  if (name == "hugepage")
+    return std::make_unique<ErasedLayer<AllocatorBacking>>(
+      lbannv2::HugePageAllocator::instance());
+  if (name == "numa")
+    return std::make_unique<ErasedLayer<AllocatorBacking>>(
+      lbannv2::NumaAllocator::instance());
+  if (name == "mmap")
+    return std::make_unique<ErasedLayer<AllocatorBacking>>(
+      lbannv2::MmapFileAllocator::instance());
+  return nullptr;
+}
+
+std::atomic<lbannv2::PolicyAllocatorBase*> current_policy_alloc = nullptr;
+
+}  // namespace
+
+namespace lbannv2
+{
+
+void PolicyAllocatorBase::copy_data(void* const dst,
+                                    void const* const src,
+                                    size_t const bytes) const
+{
+  std::memcpy(dst, src, bytes);
+}
+
+void PolicyAllocatorBase::raw_dealloc(void* const ptr)
+{
+  raw_sized_dealloc(ptr, pointer_registry().bytes_registered(ptr));
+}
+
+c10::DeleterFnPtr PolicyAllocatorBase::raw_deleter() const
+{
+  return &Allocator::delete_registered;
+}
+
+c10::Device PolicyAllocatorBase::get_device() const noexcept
+{
+  return c10::Device {c10::kCPU};
+}
+
+std::unique_ptr<PolicyAllocatorBase>
+make_policy_allocator(std::string_view const spec)
+{
+  auto layers = split(spec);
+  bool const headers = !layers.empty() && layers.front() == "headers";
+  if (headers)
+  {
+    layers.erase(layers.begin());
+    if (layers.empty())
+      layers.push_back("malloc");
+  }
+  if (layers.empty() || layers.back().empty())
+    bad_spec(spec, "empty");
+
+  // Build bottom-up.
+  auto stack = make_backing(layers.back());
+  if (stack)
+    layers.pop_back();
+  else
+    stack = make_backing("malloc");
+
+  while (!layers.empty())
+  {
+    auto const layer = layers.back();
+    layers.pop_back();
+    if (layer == "tracking")
+    {
+      stack = std::make_unique<ErasedLayer<TrackingLayer<DynamicNext>>>(
+        std::move(stack));
+    }
+    else if (layer == "caching")
+    {
+      stack = std::make_unique<ErasedLayer<CachingLayer<DynamicNext>>>(
+        std::move(stack));
+    }
+    else if (layer.starts_with("limit="))
+    {
+      auto const limit = parse_size(spec, layer.substr(6));
+      stack = std::make_unique<ErasedLayer<LimitingLayer<DynamicNext>>>(
+        limit, std::move(stack));
+    }
+    else if (make_backing(layer))
+    {
+      bad_spec(spec, "backing \"" + std::string(layer) + "\" is not last");
+    }
+    else
+    {
+      bad_spec(spec, "unknown layer \"" + std::string(layer) + "\"");
+    }
+  }
+
+  LBANNV2_DEBUG("Assembled host allocator \"{}\"", std::string(spec));
+  auto alloc = std::make_unique<PolicyAllocator<DynamicNext>>(std::move(stack));
+  alloc->set_header_layout(headers);
+  return alloc;
+}
+
+PolicyAllocatorBase& use_host_allocator_spec(std::string_view const spec)
+{
+  // Tensors may well outlive static destruction, so these are never
+  // destroyed. One per spec, so switching back and forth does not
+  // leak.
+  static std::mutex mtx;
+  static auto* const cache =
+    new std::map<std::string, PolicyAllocatorBase*, std::less<>>;
+
+  PolicyAllocatorBase* alloc = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = cache->find(spec);
+    if (it == cache->end())
+      it = cache->emplace(spec, make_policy_allocator(spec).release()).first;
+    alloc = it->second;
+  }
+  use_cpu_allocator(*alloc);
+  current_policy_alloc.store(alloc);
+  return *alloc;
+}
+
+PolicyAllocatorBase* current_policy_allocator() noexcept
+{
+  return current_policy_alloc.load();
+}
+
+}  // namespace lbannv2
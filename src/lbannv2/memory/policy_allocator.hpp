@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/deferred_free.hpp>
+#include <lbannv2/memory/policy_layers.hpp>
+
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace lbannv2
+{
+
+/** @class PolicyAllocatorBase
+ *  @brief The non-template part of PolicyAllocator.
+ */
+class LBANNV2_EXPORT PolicyAllocatorBase : public Allocator
+{
+public:
+  void copy_data(void* dst, void const* src, size_t bytes) const final;
+
+  /** @brief Deallocate, finding the size in the PointerRegistry. */
+  void raw_dealloc(void* ptr) final;
+
+  c10::DeleterFnPtr raw_deleter() const final;
+
+  c10::Device get_device() const noexcept final;
+
+  // Allocations are registered one by one, so the layout may change
+  // at any time.
+  using Allocator::set_header_layout;
+
+  /** @brief Return memory held in reserve by the stack. */
+  virtual void release_cached() = 0;
+
+  /** @brief Collect the statistics of the stack's layers. */
+  virtual PolicyStats stats() const = 0;
+};  // class PolicyAllocatorBase
+
+/** @class PolicyAllocator
+ *  @brief A CPU allocator made from a stack of layers.
+ *
+ *  See policy_layers.hpp. Allocations are registered with the
+ *  PointerRegistry at this level, so layers need not deal with it.
+ *
+ *  @tparam Stack The top layer of the stack.
+ */
+template <typename Stack>
+class PolicyAllocator final : public PolicyAllocatorBase
+{
+public:
+  /** @brief Constructor
+   *
+   *  The arguments are forwarded to the stack.
+   */
+  template <typename... Args>
+  explicit PolicyAllocator(Args&&... args)
+    : m_stack(std::forward<Args>(args)...)
+  {}
+
+  ~PolicyAllocator() { DeferredFree::instance().drain(this); }
+
+  void* raw_alloc(size_t const nbytes) final
+  {
+    return nbytes ? m_stack.allocate(nbytes) : nullptr;
+  }
+
+  void raw_sized_dealloc(void* const ptr, size_t const nbytes) final
+  {
+    if (ptr)
+      m_stack.deallocate(ptr, nbytes);
+  }
+
+  void release_cached() final { m_stack.release(); }
+
+  PolicyStats stats() const final
+  {
+    PolicyStats out;
+    m_stack.stats(out);
+    return out;
+  }
+
+private:
+  Stack m_stack;
+};  // class PolicyAllocator
+
+/** @brief Assemble an allocator from a spec string.
+ *
+ *  The spec is a comma-separated list of layers, top to bottom,
+ *  ending with a backing:
+ *
+ *    - "tracking": a TrackingLayer.
+ *    - "limit=<bytes>": a LimitingLayer. The size may have a K, M, G
+ *      or T (binary) suffix.
+ *    - "caching": a CachingLayer.
+ *    - "malloc": aligned heap memory (MallocBacking).
+ *    - "hugepage", "numa", "mmap": the raw allocations of
+ *      HugePageAllocator, NumaAllocator or MmapFileAllocator.
+ *
+ *  If the spec does not end with a backing, "malloc" is assumed. For
+ *  example, "tracking,limit=64G,caching,hugepage".
+ *
+ *  The spec may start with "headers", which is not a layer but puts
+ *  the allocator in the header layout (see
+ *  Allocator::set_header_layout()).
+ *
+ *  @throws std::runtime_error if the spec is malformed.
+ */
+LBANNV2_EXPORT std::unique_ptr<PolicyAllocatorBase>
+make_policy_allocator(std::string_view spec);
+
+/** @brief Assemble an allocator from a spec string and use it for
+ *         CPU allocations.
+ *
+ *  Allocators installed this way live until the program exits. There
+ *  is one per spec string: using a spec again reuses its allocator.
+ *
+ *  @returns The allocator for the spec.
+ */
+LBANNV2_EXPORT PolicyAllocatorBase&
+use_host_allocator_spec(std::string_view spec);
+
+/** @brief The allocator most recently installed by
+ *         use_host_allocator_spec(), or nullptr.
+ */
+LBANNV2_EXPORT PolicyAllocatorBase* current_policy_allocator() noexcept;
+
+}  // namespace lbannv2
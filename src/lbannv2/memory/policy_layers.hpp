@@ -0,0 +1,381 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/caching_host_allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+#include <lbannv2/utils/errors.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** @file
+ *
+ *  Building blocks for host allocators.
+ *
+ *  A layer is any class providing
+ *
+ *  @code
+ *    void* allocate(size_t nbytes);
+ *    void deallocate(void* ptr, size_t nbytes);
+ *    void release();
+ *    void stats(PolicyStats& out) const;
+ *  @endcode
+ *
+ *  where deallocate() is given the same size that was passed to
+ *  allocate() and release() returns any memory held in reserve.
+ *  Layers other than "backings" take the type of the layer below as a
+ *  template parameter, hold it by value and forward to it, so a stack
+ *  like
+ *
+ *  @code
+ *    TrackingLayer<LimitingLayer<CachingLayer<MallocBacking>>>
+ *  @endcode
+ *
+ *  is resolved entirely at compile time. Constructor arguments not
+ *  consumed by a layer are passed down the stack.
+ *
+ *  Stacks assembled at runtime (see make_policy_allocator()) instead
+ *  use DynamicNext as the template parameter, at the cost of one
+ *  virtual call per layer.
+ */
+
+namespace lbannv2
+{
+
+/** @brief What the layers of a stack know about themselves. */
+struct PolicyStats
+{
+  /** @brief Counters from a TrackingLayer, if there is one. */
+  std::optional<MemoryStats> tracked;
+  /** @brief Bytes held in reserve by CachingLayers. */
+  size_t cached_bytes = 0UL;
+  /** @brief The tightest LimitingLayer limit (0 if none). */
+  size_t limit = 0UL;
+};
+
+/** @class TrackingLayer
+ *  @brief Counts the bytes and allocations passing through.
+ */
+template <typename Next>
+class TrackingLayer
+{
+public:
+  template <typename... Args>
+  explicit TrackingLayer(Args&&... args) : m_next(std::forward<Args>(args)...)
+  {}
+
+  void* allocate(size_t const nbytes)
+  {
+    void* const ptr = m_next.allocate(nbytes);
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_stats.current_bytes += nbytes;
+    m_stats.peak_bytes = std::max(m_stats.peak_bytes, m_stats.current_bytes);
+    ++m_stats.current_allocations;
+    ++m_stats.total_allocations;
+    return ptr;
+  }
+
+  void deallocate(void* const ptr, size_t const nbytes)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      m_stats.current_bytes -= nbytes;
+      --m_stats.current_allocations;
+      ++m_stats.total_frees;
+    }
+    m_next.deallocate(ptr, nbytes);
+  }
+
+  void release() { m_next.release(); }
+
+  void stats(PolicyStats& out) const
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      out.tracked = m_stats;
+    }
+    m_next.stats(out);
+  }
+
+private:
+  Next m_next;
+  mutable std::mutex m_mtx;
+  MemoryStats m_stats;
+};  // class TrackingLayer
+
+/** @class LimitingLayer
+ *  @brief Fails allocations that would put more than a given number
+ *         of bytes through this layer at once.
+ */
+template <typename Next>
+class LimitingLayer
+{
+public:
+  template <typename... Args>
+  explicit LimitingLayer(size_t const limit, Args&&... args)
+    : m_next(std::forward<Args>(args)...), m_limit {limit}
+  {}
+
+  void* allocate(size_t const nbytes)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      LBANNV2_ASSERT(m_bytes + nbytes <= m_limit,
+                     std::runtime_error,
+                     "Host allocation of " + std::to_string(nbytes)
+                       + " bytes would exceed the limit of "
+                       + std::to_string(m_limit) + " bytes");
+      m_bytes += nbytes;
+    }
+
+    try
+    {
+      return m_next.allocate(nbytes);
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      m_bytes -= nbytes;
+      throw;
+    }
+  }
+
+  void deallocate(void* const ptr, size_t const nbytes)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      m_bytes -= nbytes;
+    }
+    m_next.deallocate(ptr, nbytes);
+  }
+
+  void release() { m_next.release(); }
+
+  void stats(PolicyStats& out) const
+  {
+    out.limit = out.limit ? std::min(out.limit, m_limit) : m_limit;
+    m_next.stats(out);
+  }
+
+private:
+  Next m_next;
+  size_t const m_limit;
+  std::mutex m_mtx;
+  size_t m_bytes = 0UL;
+};  // class LimitingLayer
+
+/** @class CachingLayer
+ *  @brief Keeps freed blocks for reuse by requests of the same size
+ *         class (see CachingHostAllocator::round_size()).
+ *
+ *  Cached blocks are returned to the layer below by release(), or if
+ *  an allocation from the layer below fails (after which it is
+ *  retried once).
+ */
+template <typename Next>
+class CachingLayer
+{
+public:
+  template <typename... Args>
+  explicit CachingLayer(Args&&... args) : m_next(std::forward<Args>(args)...)
+  {}
+
+  ~CachingLayer()
+  {
+    try
+    {
+      release();
+    }
+    catch (...)
+    {}
+  }
+
+  void* allocate(size_t const nbytes)
+  {
+    auto const size = CachingHostAllocator::round_size(nbytes);
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      auto const it = m_free.find(size);
+      if (it != m_free.end() && !it->second.empty())
+      {
+        void* const ptr = it->second.back();
+        it->second.pop_back();
+        m_cached_bytes -= size;
+        return ptr;
+      }
+    }
+
+    try
+    {
+      return m_next.allocate(size);
+    }
+    catch (...)
+    {
+      release();
+      return m_next.allocate(size);
+    }
+  }
+
+  void deallocate(void* const ptr, size_t const nbytes)
+  {
+    auto const size = CachingHostAllocator::round_size(nbytes);
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_free[size].push_back(ptr);
+    m_cached_bytes += size;
+  }
+
+  void release()
+  {
+    decltype(m_free) free;
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      free.swap(m_free);
+      m_cached_bytes = 0UL;
+    }
+    for (auto const& [size, ptrs] : free)
+      for (void* const ptr : ptrs)
+        m_next.deallocate(ptr, size);
+    m_next.release();
+  }
+
+  void stats(PolicyStats& out) const
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      out.cached_bytes += m_cached_bytes;
+    }
+    m_next.stats(out);
+  }
+
+private:
+  Next m_next;
+  mutable std::mutex m_mtx;
+  std::unordered_map<size_t, std::vector<void*>> m_free;
+  size_t m_cached_bytes = 0UL;
+};  // class CachingLayer
+
+/** @class MallocBacking
+ *  @brief Aligned heap memory.
+ */
+class MallocBacking
+{
+public:
+  static constexpr size_t kAlignment = 64;
+
+  void* allocate(size_t const nbytes)
+  {
+    void* ptr = nullptr;
+    LBANNV2_ASSERT(posix_memalign(&ptr, kAlignment, nbytes) == 0,
+                   std::runtime_error,
+                   "MallocBacking: out of memory");
+    return ptr;
+  }
+
+  void deallocate(void* const ptr, size_t) { std::free(ptr); }
+
+  void release() {}
+
+  void stats(PolicyStats&) const {}
+};  // class MallocBacking
+
+/** @class AllocatorBacking
+ *  @brief The raw allocations of another LBANNv2 allocator.
+ *
+ *  This is how the specialized allocators (e.g., HugePageAllocator,
+ *  NumaAllocator) sit at the bottom of a stack. Nothing is registered
+ *  with the PointerRegistry at this level.
+ */
+class AllocatorBacking
+{
+public:
+  explicit AllocatorBacking(Allocator& alloc) : m_alloc {&alloc} {}
+
+  void* allocate(size_t const nbytes) { return m_alloc->raw_alloc(nbytes); }
+
+  void deallocate(void* const ptr, size_t const nbytes)
+  {
+    m_alloc->raw_sized_dealloc(ptr, nbytes);
+  }
+
+  void release() {}
+
+  void stats(PolicyStats&) const {}
+
+private:
+  Allocator* m_alloc;
+};  // class AllocatorBacking
+
+/** @class DynamicLayer
+ *  @brief Type-erased layer interface for runtime-assembled stacks.
+ */
+class DynamicLayer
+{
+public:
+  virtual ~DynamicLayer() = default;
+  virtual void* allocate(size_t nbytes) = 0;
+  virtual void deallocate(void* ptr, size_t nbytes) = 0;
+  virtual void release() = 0;
+  virtual void stats(PolicyStats& out) const = 0;
+};  // class DynamicLayer
+
+/** @class ErasedLayer
+ *  @brief Adapts a layer to the DynamicLayer interface.
+ */
+template <typename Layer>
+class ErasedLayer final : public DynamicLayer
+{
+public:
+  template <typename... Args>
+  explicit ErasedLayer(Args&&... args) : m_layer(std::forward<Args>(args)...)
+  {}
+
+  void* allocate(size_t const nbytes) final { return m_layer.allocate(nbytes); }
+  void deallocate(void* const ptr, size_t const nbytes) final
+  {
+    m_layer.deallocate(ptr, nbytes);
+  }
+  void release() final { m_layer.release(); }
+  void stats(PolicyStats& out) const final { m_layer.stats(out); }
+
+private:
+  Layer m_layer;
+};  // class ErasedLayer
+
+/** @class DynamicNext
+ *  @brief A layer that forwards to a type-erased layer it owns.
+ */
+class DynamicNext
+{
+public:
+  explicit DynamicNext(std::unique_ptr<DynamicLayer> layer)
+    : m_layer {std::move(layer)}
+  {}
+
+  void* allocate(size_t const nbytes) { return m_layer->allocate(nbytes); }
+  void deallocate(void* const ptr, size_t const nbytes)
+  {
+    m_layer->deallocate(ptr, nbytes);
+  }
+  void release() { m_layer->release(); }
+  void stats(PolicyStats& out) const { m_layer->stats(out); }
+
+private:
+  std::unique_ptr<DynamicLayer> m_layer;
+};  // class DynamicNext
+
+}  // namespace lbannv2
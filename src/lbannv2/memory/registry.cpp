@@ -6,26 +6,71 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "registry.hpp"
 
+#include "lbannv2/memory/allocation_trace.hpp"
+#include "lbannv2/memory/registry_index.hpp"
 #include "lbannv2/utils/errors.hpp"
 #include "lbannv2/utils/logging.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include <vector>
+
 namespace
 {
 
-// Syntactic sugar. Iterators kinda suck for readability.
-auto const& get_ptr_range(std::input_iterator auto const& map_iter) noexcept
+std::size_t range_bytes(std::pair<void*, void*> const& r) noexcept
 {
-  return map_iter->first;
+  return std::distance((std::byte*) r.first, (std::byte*) r.second);
 }
 
-auto const& get_allocator_ptr(std::input_iterator auto const& map_iter) noexcept
+// The last range found by this thread. Entries are only valid while
+// the registry's epoch matches the one recorded here.
+struct LastHit
+{
+  std::uint64_t registry_id = 0;
+  std::uint64_t epoch = 0;
+  std::pair<void*, void*> range = {nullptr, nullptr};
+  c10::Allocator* alloc = nullptr;
+  lbannv2::NestedRanges const* nested = nullptr;
+};
+
+thread_local LastHit last_hit;
+
+std::uint64_t next_registry_id() noexcept
 {
-  return map_iter->second;
+  // Start at 1 so a default LastHit never matches.
+  static std::atomic<std::uint64_t> id = 1;
+  return id.fetch_add(1, std::memory_order_relaxed);
 }
 
-std::size_t range_bytes(std::pair<void*, void*> const& r) noexcept
+lbannv2::PointerRegistry::Mode get_env_registry_mode()
 {
-  return std::distance((std::byte*) r.first, (std::byte*) r.second);
+  char const* const env = std::getenv("LBANNV2_REGISTRY_MODE");
+  if (env && std::strcmp(env, "read_mostly") == 0)
+    return lbannv2::PointerRegistry::Mode::ReadMostly;
+  return lbannv2::PointerRegistry::Mode::Locked;
+}
+
+lbannv2::PointerRegistry::Index
+get_env_registry_index(lbannv2::PointerRegistry::Mode const mode)
+{
+  using Index = lbannv2::PointerRegistry::Index;
+  char const* const env = std::getenv("LBANNV2_REGISTRY_INDEX");
+  if (mode == lbannv2::PointerRegistry::Mode::ReadMostly)
+  {
+    if (env && std::strcmp(env, "page_map") == 0)
+      LBANNV2_WARN("LBANNV2_REGISTRY_INDEX=page_map is not supported in "
+                   "read-mostly mode; using the range map");
+    return Index::RangeMap;
+  }
+  if (env && std::strcmp(env, "page_map") == 0)
+    return Index::PageMap;
+  if (env && std::strcmp(env, "range_map") == 0)
+    return Index::RangeMap;
+  return lbannv2::PointerRegistry::default_index();
 }
 
 }  // namespace
@@ -33,102 +78,472 @@ std::size_t range_bytes(std::pair<void*, void*> const& r) noexcept
 namespace lbannv2
 {
 
+PointerRegistry::PointerRegistry(Mode const mode, Index const index)
+  : m_registry {make_registry_index(index)},
+    m_snapshot {mode == Mode::ReadMostly ? make_registry_index(index)
+                                         : nullptr},
+    m_id {next_registry_id()},
+    m_mode {mode},
+    m_index_kind {index}
+{
+  // Every write would rebuild the page map's tables.
+  LBANNV2_ASSERT(mode != Mode::ReadMostly || index != Index::PageMap,
+                 std::runtime_error,
+                 "PointerRegistry: read-mostly mode needs the range map");
+}
+
+PointerRegistry::~PointerRegistry() = default;
+
+template <typename F>
+decltype(auto) PointerRegistry::read(F&& f) const
+{
+  if (m_mode == Mode::ReadMostly)
+  {
+    SnapshotType const snapshot = m_snapshot.load(std::memory_order_acquire);
+    return f(*snapshot);
+  }
+
+  std::lock_guard<std::mutex> lock(m_registry_mtx);
+  return f(std::as_const(*m_registry));
+}
+
+template <typename F>
+void PointerRegistry::write(F&& f, bool const invalidate)
+{
+  std::lock_guard<std::mutex> lock(m_registry_mtx);
+
+  // Writers validate before modifying anything, so if f throws there
+  // is nothing to publish.
+  f(*m_registry);
+
+  if (m_mode == Mode::ReadMostly)
+    m_snapshot.store(m_registry->clone(), std::memory_order_release);
+
+  // Only bump the epoch once the change is visible to readers.
+  if (invalidate)
+    m_epoch.fetch_add(1, std::memory_order_release);
+}
+
+bool PointerRegistry::lookup(void const* const ptr,
+                             KeyT& range,
+                             c10::Allocator*& alloc) const
+{
+  // The epoch must be read before the lookup so that a concurrent
+  // removal always invalidates what we cache.
+  auto const epoch = m_epoch.load(std::memory_order_acquire);
+  RangeLessAndDisjoint const less;
+  NestedRanges const* nested = nullptr;
+  if (last_hit.registry_id == m_id && last_hit.epoch == epoch
+      && !less(last_hit.range, ptr) && !less(ptr, last_hit.range))
+  {
+    range = last_hit.range;
+    alloc = last_hit.alloc;
+    nested = last_hit.nested;
+  }
+  else
+  {
+    auto const entry = read(
+      [&](RegistryIndex const& registry) { return registry.find(ptr); });
+    if (!entry)
+      return false;
+
+    range = entry->range;
+    alloc = entry->alloc;
+    nested = entry->nested;
+    last_hit = {m_id, epoch, range, alloc, nested};
+  }
+
+  // Resolved outside the lock; see NestedRanges.
+  if (nested)
+  {
+    void* begin = nullptr;
+    size_t size = 0UL;
+    if (!nested->find_nested(range.first, ptr, begin, size))
+      return false;
+    range = {begin, static_cast<std::byte*>(begin) + size};
+  }
+  return true;
+}
+
+void PointerRegistry::account_add(size_t const bytes,
+                                  c10::Allocator* const alloc,
+                                  c10::Device const device)
+{
+  for (MemoryStats* const s : {&m_stats.total,
+                               &m_stats.by_allocator[alloc],
+                               &m_stats.by_device[device]})
+  {
+    s->current_bytes += bytes;
+    s->peak_bytes = std::max(s->peak_bytes, s->current_bytes);
+    ++s->current_allocations;
+    ++s->total_allocations;
+  }
+  if (device.is_cpu())
+    m_host_bytes_registered.fetch_add(bytes, std::memory_order_relaxed);
+  m_num_registered.store(m_stats.total.current_allocations,
+                         std::memory_order_relaxed);
+  m_bytes_registered.store(m_stats.total.current_bytes,
+                           std::memory_order_relaxed);
+  m_peak_bytes_registered.store(m_stats.total.peak_bytes,
+                                std::memory_order_relaxed);
+}
+
+void PointerRegistry::account_remove(size_t const bytes,
+                                     c10::Allocator* const alloc,
+                                     c10::Device const device)
+{
+  for (MemoryStats* const s : {&m_stats.total,
+                               &m_stats.by_allocator[alloc],
+                               &m_stats.by_device[device]})
+  {
+    s->current_bytes -= bytes;
+    --s->current_allocations;
+    ++s->total_frees;
+  }
+  prune_allocator_stats(alloc);
+  if (device.is_cpu())
+    m_host_bytes_registered.fetch_sub(bytes, std::memory_order_relaxed);
+  m_num_registered.store(m_stats.total.current_allocations,
+                         std::memory_order_relaxed);
+  m_bytes_registered.store(m_stats.total.current_bytes,
+                           std::memory_order_relaxed);
+}
+
+void PointerRegistry::prune_allocator_stats(c10::Allocator* const alloc)
+{
+  // Allocators come and go (e.g., one per spec or per shared segment)
+  // and their addresses are reused, so a key must not outlive the
+  // allocations made through it.
+  auto const it = m_stats.by_allocator.find(alloc);
+  if (it != m_stats.by_allocator.end() && it->second.current_allocations == 0)
+    m_stats.by_allocator.erase(it);
+}
+
+void PointerRegistry::account_resize(size_t const old_bytes,
+                                     size_t const new_bytes,
+                                     c10::Allocator* const alloc,
+                                     c10::Device const device)
+{
+  for (MemoryStats* const s : {&m_stats.total,
+                               &m_stats.by_allocator[alloc],
+                               &m_stats.by_device[device]})
+  {
+    s->current_bytes = s->current_bytes - old_bytes + new_bytes;
+    s->peak_bytes = std::max(s->peak_bytes, s->current_bytes);
+  }
+  if (device.is_cpu())
+  {
+    m_host_bytes_registered.fetch_add(new_bytes, std::memory_order_relaxed);
+    m_host_bytes_registered.fetch_sub(old_bytes, std::memory_order_relaxed);
+  }
+  m_bytes_registered.store(m_stats.total.current_bytes,
+                           std::memory_order_relaxed);
+  m_peak_bytes_registered.store(m_stats.total.peak_bytes,
+                                std::memory_order_relaxed);
+}
+
 void PointerRegistry::add(void* const ptr,
                           size_t const size,
-                          c10::Allocator* const allocator)
+                          c10::Allocator* const allocator,
+                          c10::Device const device,
+                          NestedRanges const* const nested)
 {
   if (!ptr)
     return;
 
-  std::lock_guard<std::mutex> lock(m_registry_mtx);
-  auto const [it, added] = m_registry.emplace(
-    KeyT {ptr, static_cast<std::byte*>(ptr) + size}, allocator);
-  LBANNV2_ASSERT(
-    added, std::runtime_error, "Address range overlaps existing range");
+  write(
+    [&](RegistryIndex& registry) {
+      bool const added =
+        registry.insert({KeyT {ptr, static_cast<std::byte*>(ptr) + size},
+                         allocator,
+                         device,
+                         nested});
+      LBANNV2_ASSERT(
+        added, std::runtime_error, "Address range overlaps existing range");
+      account_add(size, allocator, device);
+    },
+    /*invalidate=*/false);
 
   LBANNV2_TRACE("Registered pointer range start={}, size={}, allocator={}",
                 ptr,
                 size,
                 (void*) allocator);
+  trace_allocation_event(TraceEvent::Alloc, ptr, size, device);
 }
 
-void PointerRegistry::remove(void* const ptr)
+size_t PointerRegistry::remove(void* const ptr)
 {
   if (!ptr)
+    return 0UL;
+
+  size_t bytes = 0UL;
+  c10::Device device {c10::kCPU};
+  write(
+    [&](RegistryIndex& registry) {
+      auto const entry = registry.find(ptr);
+      if (!entry)
+        throw UnknownAddress {};
+      else if (entry->range.first != ptr)
+        throw std::runtime_error("Cannot remove ptr; not beginning of range.");
+
+      LBANNV2_TRACE(
+        "Deregistered pointer range start={}, size={}, allocator={}",
+        entry->range.first,
+        range_bytes(entry->range),
+        (void*) entry->alloc);
+
+      bytes = range_bytes(entry->range);
+      device = entry->device;
+      registry.erase(ptr);
+      account_remove(bytes, entry->alloc, device);
+    },
+    /*invalidate=*/true);
+
+  trace_allocation_event(TraceEvent::Free, ptr, bytes, device);
+  return bytes;
+}
+
+void PointerRegistry::resize(void* const ptr, size_t const new_size)
+{
+  move(ptr, ptr, new_size);
+}
+
+void PointerRegistry::move(void* const ptr,
+                           void* const new_ptr,
+                           size_t const new_size)
+{
+  LBANNV2_ASSERT(ptr && new_ptr,
+                 std::runtime_error,
+                 "Cannot move a range to or from nullptr");
+
+  size_t old_bytes = 0UL;
+  c10::Device device {c10::kCPU};
+  write(
+    [&](RegistryIndex& registry) {
+      auto const entry = registry.find(ptr);
+      if (!entry)
+        throw UnknownAddress {};
+      else if (entry->range.first != ptr)
+        throw std::runtime_error("Cannot move ptr; not beginning of range.");
+
+      // The new range may overlap the old one, so take the old one
+      // out to check, and put it back if the check fails.
+      KeyT const new_range {new_ptr,
+                            static_cast<std::byte*>(new_ptr) + new_size};
+      registry.erase(ptr);
+      if (registry.overlaps(new_range))
+      {
+        registry.insert(*entry);
+        throw std::runtime_error("Address range overlaps existing range");
+      }
+      registry.insert({new_range, entry->alloc, entry->device, entry->nested});
+      old_bytes = range_bytes(entry->range);
+      device = entry->device;
+      account_resize(old_bytes, new_size, entry->alloc, device);
+    },
+    /*invalidate=*/true);
+
+  LBANNV2_TRACE("Moved pointer range start={}, size={} to start={}, size={}",
+                ptr,
+                old_bytes,
+                new_ptr,
+                new_size);
+  // Replays see a free and a fresh allocation.
+  trace_allocation_event(TraceEvent::Free, ptr, old_bytes, device);
+  trace_allocation_event(TraceEvent::Alloc, new_ptr, new_size, device);
+}
+
+void PointerRegistry::add_many(std::span<Registration const> const regs)
+{
+  std::vector<RegistryIndex::Entry> entries;
+  entries.reserve(regs.size());
+  for (auto const& r : regs)
+    if (r.ptr)
+      entries.push_back(
+        {KeyT {r.ptr, static_cast<std::byte*>(r.ptr) + r.size},
+         r.allocator,
+         r.device});
+  if (entries.empty())
     return;
 
-  std::lock_guard<std::mutex> lock(m_registry_mtx);
-  auto const it = m_registry.find(ptr);
-  if (it == m_registry.cend())
-    throw UnknownAddress {};
-  else if (get_ptr_range(it).first != ptr)
-    throw std::runtime_error("Cannot remove ptr; not beginning of range.");
+  // Sorted by start address, a batch is free of overlaps if and only
+  // if every pair of neighbors is disjoint.
+  std::sort(entries.begin(), entries.end(), [](auto const& a, auto const& b) {
+    return a.range.first < b.range.first;
+  });
+  RangeLessAndDisjoint const less;
+  for (size_t i = 1; i < entries.size(); ++i)
+    LBANNV2_ASSERT(less(entries[i - 1].range, entries[i].range),
+                   std::runtime_error,
+                   "Address range overlaps existing range");
 
-  {
-    [[maybe_unused]] auto const& [ptr_range, alloc_ptr] = *it;
-    LBANNV2_TRACE("Deregistered pointer range start={}, size={}, allocator={}",
-                  ptr_range.first,
-                  range_bytes(ptr_range),
-                  (void*) alloc_ptr);
-  }
+  write(
+    [&](RegistryIndex& registry) {
+      for (auto const& e : entries)
+        LBANNV2_ASSERT(!registry.overlaps(e.range),
+                       std::runtime_error,
+                       "Address range overlaps existing range");
 
-  m_registry.erase(it);
+      for (auto const& e : entries)
+      {
+        registry.insert(e);
+        account_add(range_bytes(e.range), e.alloc, e.device);
+      }
+    },
+    /*invalidate=*/false);
+
+  LBANNV2_TRACE("Registered {} pointer ranges", entries.size());
+  if (AllocationTracer::enabled())
+    for (auto const& e : entries)
+      trace_allocation_event(
+        TraceEvent::Alloc, e.range.first, range_bytes(e.range), e.device);
+}
+
+void PointerRegistry::remove_many(std::span<void* const> const ptrs)
+{
+  std::vector<void*> to_remove;
+  to_remove.reserve(ptrs.size());
+  std::copy_if(ptrs.begin(),
+               ptrs.end(),
+               std::back_inserter(to_remove),
+               [](void* const p) { return p != nullptr; });
+  if (to_remove.empty())
+    return;
+
+  std::sort(to_remove.begin(), to_remove.end());
+  LBANNV2_ASSERT(
+    std::adjacent_find(to_remove.begin(), to_remove.end()) == to_remove.end(),
+    std::runtime_error,
+    "Cannot remove ptr; listed more than once.");
+
+  std::vector<RegistryIndex::Entry> entries;
+  entries.reserve(to_remove.size());
+  write(
+    [&](RegistryIndex& registry) {
+      for (void* const ptr : to_remove)
+      {
+        auto const entry = registry.find(ptr);
+        if (!entry)
+          throw UnknownAddress {};
+        else if (entry->range.first != ptr)
+          throw std::runtime_error(
+            "Cannot remove ptr; not beginning of range.");
+        entries.push_back(*entry);
+      }
+
+      for (auto const& e : entries)
+      {
+        registry.erase(e.range.first);
+        account_remove(range_bytes(e.range), e.alloc, e.device);
+      }
+    },
+    /*invalidate=*/true);
+
+  LBANNV2_TRACE("Deregistered {} pointer ranges", to_remove.size());
+  if (AllocationTracer::enabled())
+    for (auto const& e : entries)
+      trace_allocation_event(
+        TraceEvent::Free, e.range.first, range_bytes(e.range), e.device);
 }
 
 bool PointerRegistry::known(void const* const ptr) const noexcept
 {
-  std::lock_guard<std::mutex> lock(m_registry_mtx);
-  return m_registry.contains(ptr);
+  KeyT range;
+  c10::Allocator* alloc;
+  return lookup(ptr, range, alloc);
 }
 
 c10::Allocator* PointerRegistry::get_allocator(void const* const ptr) const
 {
-  std::lock_guard<std::mutex> lock(m_registry_mtx);
-  auto const it = m_registry.find(ptr);
-  if (it == m_registry.cend())
+  KeyT range;
+  c10::Allocator* alloc;
+  if (!lookup(ptr, range, alloc))
     throw UnknownAddress {};
-  return get_allocator_ptr(it);
+  return alloc;
 }
 
 void PointerRegistry::unsafe_reset_allocator(void const* const ptr,
                                              c10::Allocator* const new_alloc)
 {
-  std::lock_guard<std::mutex> lock(m_registry_mtx);
-  auto const it = m_registry.find(ptr);
-  if (it == m_registry.cend())
-    throw UnknownAddress {};
-  it->second = new_alloc;
+  write(
+    [&](RegistryIndex& registry) {
+      auto const entry = registry.find(ptr);
+      if (!entry)
+        throw UnknownAddress {};
+      LBANNV2_ASSERT(!entry->nested,
+                     std::runtime_error,
+                     "Cannot reset a range with nested allocations");
+      registry.reset_allocator(ptr, new_alloc);
+
+      // Move the range between allocators without counting it as a
+      // new allocation or a free.
+      auto const bytes = range_bytes(entry->range);
+      auto& old_stats = m_stats.by_allocator[entry->alloc];
+      old_stats.current_bytes -= bytes;
+      --old_stats.current_allocations;
+      auto& new_stats = m_stats.by_allocator[new_alloc];
+      new_stats.current_bytes += bytes;
+      new_stats.peak_bytes =
+        std::max(new_stats.peak_bytes, new_stats.current_bytes);
+      ++new_stats.current_allocations;
+      prune_allocator_stats(entry->alloc);
+    },
+    /*invalidate=*/true);
+}
+
+void PointerRegistry::unsafe_reset_device(void const* const ptr,
+                                          c10::Device const new_device)
+{
+  write(
+    [&](RegistryIndex& registry) {
+      auto const entry = registry.find(ptr);
+      if (!entry)
+        throw UnknownAddress {};
+      LBANNV2_ASSERT(!entry->nested,
+                     std::runtime_error,
+                     "Cannot reset a range with nested allocations");
+      registry.reset_device(ptr, new_device);
+
+      auto const bytes = range_bytes(entry->range);
+      auto& old_stats = m_stats.by_device[entry->device];
+      old_stats.current_bytes -= bytes;
+      --old_stats.current_allocations;
+      auto& new_stats = m_stats.by_device[new_device];
+      new_stats.current_bytes += bytes;
+      new_stats.peak_bytes =
+        std::max(new_stats.peak_bytes, new_stats.current_bytes);
+      ++new_stats.current_allocations;
+
+      if (new_device.is_cpu() && !entry->device.is_cpu())
+        m_host_bytes_registered.fetch_add(bytes, std::memory_order_relaxed);
+      else if (!new_device.is_cpu() && entry->device.is_cpu())
+        m_host_bytes_registered.fetch_sub(bytes, std::memory_order_relaxed);
+    },
+    /*invalidate=*/false);
 }
 
 void* PointerRegistry::get_context(void const* const ptr) const
 {
-  std::lock_guard<std::mutex> lock(m_registry_mtx);
-  auto const it = m_registry.find(ptr);
-  if (it == m_registry.cend())
+  KeyT range;
+  c10::Allocator* alloc;
+  if (!lookup(ptr, range, alloc))
     throw UnknownAddress {};
-  return get_ptr_range(it).first;
+  return range.first;
 }
 
-std::size_t PointerRegistry::bytes_registered() const noexcept
+RegistryStats PointerRegistry::stats() const
 {
   std::lock_guard<std::mutex> lock(m_registry_mtx);
-  size_t bytes = 0UL;
-  for (auto const& kvp : m_registry)
-  {
-    bytes += range_bytes(kvp.first);
-  }
-  return bytes;
+  return m_stats;
 }
 
 std::size_t
 PointerRegistry::bytes_registered(void const* const ptr) const noexcept
 {
-  std::lock_guard<std::mutex> lock(m_registry_mtx);
-  auto const it = m_registry.find(ptr);
-  if (it != m_registry.cend())
-  {
-    return range_bytes(it->first);
-  }
+  KeyT range;
+  c10::Allocator* alloc;
+  if (lookup(ptr, range, alloc))
+    return range_bytes(range);
   return 0;
 }
 
@@ -136,6 +551,7 @@ PointerRegistry::bytes_registered(void const* const ptr) const noexcept
 
 auto lbannv2::pointer_registry() -> PointerRegistry&
 {
-  static PointerRegistry registry;
+  static auto const mode = get_env_registry_mode();
+  static PointerRegistry registry {mode, get_env_registry_index(mode)};
   return registry;
 }
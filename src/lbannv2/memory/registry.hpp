@@ -10,20 +10,89 @@
 
 #include <lbannv2/memory/allocator.hpp>
 
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <span>
 #include <stdexcept>
+#include <unordered_map>
 
+#include <c10/core/Device.h>
 #include <c10/core/DeviceType.h>
 
 namespace lbannv2
 {
 
+class RegistryIndex;
+
 struct LBANNV2_EXPORT UnknownAddress : std::runtime_error
 {
   UnknownAddress() : std::runtime_error {"Unknown address"} {}
 };
 
+/** @brief Allocation counters for some subset of registered memory.
+ *
+ *  "Current" values describe live registrations; "total" values are
+ *  cumulative over the life of the registry.
+ */
+struct MemoryStats
+{
+  size_t current_bytes = 0UL;
+  size_t peak_bytes = 0UL;
+  size_t current_allocations = 0UL;
+  size_t total_allocations = 0UL;
+  size_t total_frees = 0UL;
+};
+
+/** @brief A point-in-time copy of the registry's counters.
+ *
+ *  An allocator appears in @c by_allocator only while it has live
+ *  registrations; its counters restart if it registers memory again.
+ *  Allocator addresses may be reused once they are gone, so they are
+ *  not stable keys beyond that.
+ */
+struct RegistryStats
+{
+  MemoryStats total;
+  std::unordered_map<c10::Allocator*, MemoryStats> by_allocator;
+  std::unordered_map<c10::Device, MemoryStats> by_device;
+};
+
+/** @class NestedRanges
+ *  @brief Resolves addresses to the allocations nested in a
+ *         registered range.
+ *
+ *  Allocators that carve one registered range (e.g., a slab) into
+ *  many small allocations can attach one of these to the range when
+ *  they add() it. Lookups that land in the range are then narrowed to
+ *  the nested allocation containing the address; addresses that are
+ *  not in a live nested allocation are treated as unregistered.
+ *
+ *  The registry calls find_nested() without holding its lock, so the
+ *  implementation must tolerate the range having just been removed.
+ */
+class LBANNV2_EXPORT NestedRanges
+{
+public:
+  /** @brief Find the live nested allocation containing ptr.
+   *
+   *  @param[in] base The beginning of the registered range.
+   *  @param[in] ptr An address in the registered range.
+   *  @param[out] begin The beginning of the nested allocation.
+   *  @param[out] size The size in bytes of the nested allocation.
+   *
+   *  @returns @c false if ptr is not in a live nested allocation.
+   */
+  virtual bool find_nested(void const* base,
+                           void const* ptr,
+                           void*& begin,
+                           size_t& size) const noexcept = 0;
+
+protected:
+  ~NestedRanges() = default;
+};
+
 // We should consider the issue of registering nullptr or equivalent
 // zero-size allocations. Note that if ISO C++ is the only source of
 // memory, this should be an error. But I'm not sure how all of the
@@ -34,32 +103,179 @@ struct LBANNV2_EXPORT UnknownAddress : std::runtime_error
 
 /** @class PointerRegistry
  *  @brief Tracks known memory regions
+ *
+ *  The registry supports two concurrency modes. In "locked" mode, all
+ *  readers and writers serialize on a single mutex. In "read-mostly"
+ *  mode, writers still serialize on the mutex but publish an immutable
+ *  snapshot of the registry after each modification; readers load the
+ *  current snapshot atomically and never touch the mutex. The latter
+ *  trades O(n) writes for contention-free lookups, so it is only a
+ *  win when lookups dominate.
+ *
+ *  Independently of the mode, the registry can be backed by one of
+ *  two index structures: an ordered map of ranges (O(log n) lookups)
+ *  or a radix page map keyed on address bits (O(1) lookups, at the
+ *  cost of insertion/removal time proportional to the size of small
+ *  ranges). The page map is expensive to copy, so it cannot be used
+ *  in read-mostly mode.
+ *
+ *  In either mode, lookups first consult a per-thread cache of the
+ *  last range that thread found. Since registered ranges can never
+ *  overlap, adding ranges cannot invalidate a cached hit; removing (or
+ *  modifying) ranges bumps an epoch counter that invalidates all
+ *  cached hits. For ranges with NestedRanges, the registered range is
+ *  cached and the nested allocation is resolved on every lookup.
  */
 class LBANNV2_EXPORT PointerRegistry
 {
 public:
+  /** @brief The synchronization strategy used by the registry. */
+  enum class Mode
+  {
+    /** @brief All access is serialized on a mutex. */
+    Locked,
+    /** @brief Lookups read lock-free from copy-on-write snapshots. */
+    ReadMostly,
+  };
+
+  /** @brief The data structure used to look up ranges. */
+  enum class Index
+  {
+    /** @brief An ordered map keyed on ranges. */
+    RangeMap,
+    /** @brief A two-level radix table keyed on address bits. */
+    PageMap,
+  };
+
+  /** @brief The index used when none is specified.
+   *
+   *  This is set at configure time with the CMake option
+   *  `LBANNV2_REGISTRY_USE_PAGE_MAP`.
+   */
+  static constexpr Index default_index() noexcept
+  {
+#if LBANNV2_REGISTRY_USE_PAGE_MAP
+    return Index::PageMap;
+#else
+    return Index::RangeMap;
+#endif
+  }
+
+  /** @brief Construct an empty registry.
+   *
+   *  @param[in] mode The synchronization strategy to use.
+   *  @param[in] index The lookup structure to use.
+   *
+   *  @throws std::runtime_error if the mode is read-mostly and the
+   *          index is the page map.
+   */
+  explicit PointerRegistry(Mode mode = Mode::Locked,
+                           Index index = default_index());
+  ~PointerRegistry();
+  PointerRegistry(PointerRegistry const&) = delete;
+  PointerRegistry(PointerRegistry&&) = delete;
+  PointerRegistry& operator=(PointerRegistry const&) = delete;
+  PointerRegistry& operator=(PointerRegistry&&) = delete;
+
+  /** @brief Get the synchronization strategy of this registry. */
+  Mode mode() const noexcept { return m_mode; }
+
+  /** @brief Get the lookup structure of this registry. */
+  Index index() const noexcept { return m_index_kind; }
+
   /** @brief Register an allocation.
    *
    *  @param[in] ptr The beginning of the allocated range.
    *  @param[in] size The size in bytes of the allocated range.
    *  @param[in] allocator The allocator responsible for deleting the range.
+   *  @param[in] device The device with which the range is associated.
+   *                    This is only used for statistics.
+   *  @param[in] nested If not null, resolves lookups in the range to
+   *                    the allocations nested in it. It must outlive
+   *                    the registration.
    */
-  void add(void* ptr, size_t size, c10::Allocator* allocator);
+  void add(void* ptr,
+           size_t size,
+           c10::Allocator* allocator,
+           c10::Device device = c10::Device {c10::kCPU},
+           NestedRanges const* nested = nullptr);
 
   /** @brief Deregister an allocation.
    *
    *  The pointer passed must match a pointer registered with add().
    *
    *  @param[in] ptr The (context) pointer to deregister.
+   *
+   *  @returns The size of the allocation.
+   */
+  size_t remove(void* ptr);
+
+  /** @brief Change the size of a registered allocation.
+   *
+   *  Readers see either the old range or the new one, never neither.
+   *  The change is not counted as an allocation or a free.
+   *
+   *  @param[in] ptr The (context) pointer of the allocation.
+   *  @param[in] new_size The new size in bytes.
+   *
+   *  @throws UnknownAddress if ptr is not registered.
+   *  @throws std::runtime_error if ptr is not the beginning of its
+   *          range or the new range overlaps another range. The
+   *          registry is then unchanged.
    */
-  void remove(void* ptr);
+  void resize(void* ptr, size_t new_size);
+
+  /** @brief Move a registered allocation to a new address, possibly
+   *         changing its size.
+   *
+   *  This is resize() for allocations that were moved (e.g., by
+   *  mremap(2)); the allocator and device are kept.
+   *
+   *  @param[in] ptr The old (context) pointer of the allocation.
+   *  @param[in] new_ptr The new (context) pointer.
+   *  @param[in] new_size The new size in bytes.
+   */
+  void move(void* ptr, void* new_ptr, size_t new_size);
+
+  /** @brief The arguments to a single add(). */
+  struct Registration
+  {
+    void* ptr;
+    size_t size;
+    c10::Allocator* allocator;
+    c10::Device device = c10::Device {c10::kCPU};
+  };
+
+  /** @brief Register a batch of allocations.
+   *
+   *  The whole batch is checked for overlaps, both with existing
+   *  ranges and among its own members, before anything is added. If
+   *  any check fails, nothing is registered. The batch is committed
+   *  in one critical section (and, in read-mostly mode, publishes one
+   *  snapshot).
+   *
+   *  Null pointers are ignored, as in add().
+   *
+   *  @param[in] regs The allocations to register.
+   */
+  void add_many(std::span<Registration const> regs);
+
+  /** @brief Deregister a batch of allocations.
+   *
+   *  Every non-null pointer must be the context pointer of a distinct
+   *  registered range. If any is not, nothing is removed.
+   *
+   *  @param[in] ptrs The (context) pointers to deregister.
+   */
+  void remove_many(std::span<void* const> ptrs);
 
   /** @brief Query whether this address is part of a registered
    *         allocation.
    *
    *  Returns @c true for any address that is included in a registered
    *  allocation, that is, in the range [ptr, ptr + size) for any
-   *  (ptr, size) passed to add().
+   *  (ptr, size) passed to add(). In ranges with NestedRanges, only
+   *  addresses in live nested allocations are included.
    *
    *  @param[in] ptr The pointer in question.
    */
@@ -76,9 +292,9 @@ public:
 
   /** @brief Reset the allocator associated with a pointer.
    *
-   *  In cases of MI300A pointer migration, this allows us to keep our
-   *  internal bookkeeping consistent. It should not be used outside
-   *  of this context.
+   *  In cases of coherent-memory pointer migration, this allows us to
+   *  keep our internal bookkeeping consistent. It should not be used
+   *  outside of this context. Ranges with NestedRanges cannot be reset.
    */
   void unsafe_reset_allocator(void const* ptr, c10::Allocator* new_alloc);
   // FIXME (trb): An alternative would be to make this similar to
@@ -89,11 +305,19 @@ public:
   // "registry.get_allocator(ptr)" in that argument, so what would the
   // point really be?
 
+  /** @brief Reset the device associated with a pointer.
+   *
+   *  Like unsafe_reset_allocator(), this exists to keep statistics
+   *  consistent across coherent-memory pointer migration.
+   */
+  void unsafe_reset_device(void const* ptr, c10::Device new_device);
+
   /** @brief Get the context of the given pointer.
    *
    *  The context is the address returned by the raw allocator when
    *  the allocation is requested. It is the pointer that must be
-   *  passed to @c delete.
+   *  passed to @c delete. For nested allocations, it is the beginning
+   *  of the nested allocation.
    *
    *  @param[in] ptr The pointer whose context is needed.
    *
@@ -105,19 +329,44 @@ public:
   /** @brief Get the current number of registered ranges */
   size_t num_registered() const noexcept
   {
-    std::lock_guard<std::mutex> lock(m_registry_mtx);
-    return m_registry.size();
+    return m_num_registered.load(std::memory_order_relaxed);
   }
 
   /** @brief Get the current number of registered bytes */
-  size_t bytes_registered() const noexcept;
+  size_t bytes_registered() const noexcept
+  {
+    return m_bytes_registered.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Get the current number of registered bytes on the host
+   *         (that is, in ranges whose device is the CPU). */
+  size_t host_bytes_registered() const noexcept
+  {
+    return m_host_bytes_registered.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Get the largest number of bytes ever registered at once */
+  size_t peak_bytes_registered() const noexcept
+  {
+    return m_peak_bytes_registered.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Get a snapshot of the registry's counters.
+   *
+   *  The totals are maintained incrementally as ranges are added and
+   *  removed, so this does not walk the registry; it only briefly
+   *  holds the writer lock to copy the per-allocator and per-device
+   *  breakdowns.
+   */
+  RegistryStats stats() const;
 
   /** @brief Get the number of bytes associated with the given
    *         pointer.
    *
    *  Unregistered pointers return 0. Since zero-sized ranges are
    *  allowed in the registry, this function cannot serve as a proxy
-   *  for known().
+   *  for known(). For nested allocations, this is the size of the
+   *  nested allocation.
    *
    *  @param[in] ptr Any valid address.
    *
@@ -177,11 +426,75 @@ public:
   };
 
 private:
-  using MapType = std::map<KeyT, c10::Allocator*, RangeLessAndDisjoint>;
-  MapType m_registry;
+  using SnapshotType = std::shared_ptr<RegistryIndex const>;
+
+  /** @brief Apply a read-only function to the current registry state. */
+  template <typename F>
+  decltype(auto) read(F&& f) const;
+
+  /** @brief Apply a modifying function to the registry state.
+   *
+   *  In read-mostly mode, a new snapshot is published after f
+   *  returns. If @c invalidate is true, cached lookups are
+   *  invalidated, too.
+   */
+  template <typename F>
+  void write(F&& f, bool invalidate);
+
+  /** @brief Find the range containing ptr, if any.
+   *
+   *  If the registered range has NestedRanges, @c range is narrowed
+   *  to the nested allocation containing ptr.
+   *
+   *  @returns @c true if a range was found, in which case @c range
+   *           and @c alloc are set accordingly.
+   */
+  bool lookup(void const* ptr, KeyT& range, c10::Allocator*& alloc) const;
+
+  /** @name Statistics bookkeeping; m_registry_mtx must be held. */
+  ///@{
+  void account_add(size_t bytes, c10::Allocator* alloc, c10::Device device);
+  void
+  account_remove(size_t bytes, c10::Allocator* alloc, c10::Device device);
+  void account_resize(size_t old_bytes,
+                      size_t new_bytes,
+                      c10::Allocator* alloc,
+                      c10::Device device);
+  /** @brief Drop an allocator's counters once it has no live
+   *         registrations. */
+  void prune_allocator_stats(c10::Allocator* alloc);
+  ///@}
+
+  /** @brief The authoritative state; guarded by m_registry_mtx. */
+  std::unique_ptr<RegistryIndex> m_registry;
+  /** @brief The most recently published state (read-mostly mode). */
+  std::atomic<SnapshotType> m_snapshot;
+  /** @brief Bumped whenever a range is removed or modified. */
+  std::atomic<std::uint64_t> m_epoch = 0;
+  /** @brief Breakdown of counters; guarded by m_registry_mtx. */
+  RegistryStats m_stats;
+  /** @brief Lock-free copies of the headline counters. */
+  std::atomic<size_t> m_num_registered = 0UL;
+  std::atomic<size_t> m_bytes_registered = 0UL;
+  std::atomic<size_t> m_host_bytes_registered = 0UL;
+  std::atomic<size_t> m_peak_bytes_registered = 0UL;
+  /** @brief Distinguishes registries in the per-thread lookup cache. */
+  std::uint64_t const m_id;
+  Mode const m_mode;
+  Index const m_index_kind;
   mutable std::mutex m_registry_mtx;
 };  // struct PointerRegistry
 
+/** @brief Get the process-wide pointer registry.
+ *
+ *  The synchronization mode is set on first use from the environment
+ *  variable `LBANNV2_REGISTRY_MODE`. Valid values are "locked" (the
+ *  default) and "read_mostly". Likewise, the index may be selected
+ *  with `LBANNV2_REGISTRY_INDEX`. Valid values are "range_map" and
+ *  "page_map"; the default is PointerRegistry::default_index(). A
+ *  read-mostly registry always uses the range map.
+ */
+
 LBANNV2_EXPORT PointerRegistry& pointer_registry();
 
 }  // namespace lbannv2
@@ -0,0 +1,285 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "registry_index.hpp"
+
+#include "lbannv2/utils/errors.hpp"
+
+#include <algorithm>
+
+namespace
+{
+
+using KeyT = lbannv2::RegistryIndex::KeyT;
+
+bool contains(KeyT const& r, void const* const ptr) noexcept
+{
+  lbannv2::PointerRegistry::RangeLessAndDisjoint const less;
+  return !less(r, ptr) && !less(ptr, r);
+}
+
+std::uintptr_t to_addr(void const* const ptr) noexcept
+{
+  return reinterpret_cast<std::uintptr_t>(ptr);
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+// RangeMapIndex
+
+std::unique_ptr<RegistryIndex> RangeMapIndex::clone() const
+{
+  return std::make_unique<RangeMapIndex>(*this);
+}
+
+bool RangeMapIndex::insert(Entry const& entry)
+{
+  return m_map
+    .emplace(entry.range, Value {entry.alloc, entry.device, entry.nested})
+    .second;
+}
+
+bool RangeMapIndex::overlaps(KeyT const& range) const
+{
+  // Overlapping ranges are "equivalent" keys.
+  return m_map.contains(range);
+}
+
+void RangeMapIndex::erase(void const* const ptr)
+{
+  m_map.erase(m_map.find(ptr));
+}
+
+auto RangeMapIndex::find(void const* const ptr) const -> std::optional<Entry>
+{
+  auto const it = m_map.find(ptr);
+  if (it == m_map.cend())
+    return std::nullopt;
+  return Entry {
+    it->first, it->second.alloc, it->second.device, it->second.nested};
+}
+
+bool RangeMapIndex::reset_allocator(void const* const ptr,
+                                    c10::Allocator* const alloc)
+{
+  auto const it = m_map.find(ptr);
+  if (it == m_map.end())
+    return false;
+  it->second.alloc = alloc;
+  return true;
+}
+
+bool RangeMapIndex::reset_device(void const* const ptr,
+                                 c10::Device const device)
+{
+  auto const it = m_map.find(ptr);
+  if (it == m_map.end())
+    return false;
+  it->second.device = device;
+  return true;
+}
+
+void RangeMapIndex::for_each(std::function<void(Entry const&)> const& f) const
+{
+  for (auto const& [range, value] : m_map)
+    f(Entry {range, value.alloc, value.device, value.nested});
+}
+
+// PageMapIndex
+
+namespace
+{
+
+constexpr std::uintptr_t kLeafMask =
+  (std::uintptr_t {1} << PageMapIndex::kLeafBits) - 1;
+
+std::uintptr_t granule_of(void const* const ptr) noexcept
+{
+  return to_addr(ptr) >> PageMapIndex::kGranuleBits;
+}
+
+// The inclusive range of granules touched by a range. Zero-size
+// ranges touch the granule containing their address.
+std::pair<std::uintptr_t, std::uintptr_t> granules_of(KeyT const& r) noexcept
+{
+  auto const first = granule_of(r.first);
+  auto const last = r.first == r.second
+                      ? first
+                      : granule_of(static_cast<std::byte*>(r.second) - 1);
+  return {first, last};
+}
+
+bool is_large(KeyT const& r) noexcept
+{
+  auto const [first, last] = granules_of(r);
+  return last - first >= PageMapIndex::kMaxSlotGranules;
+}
+
+bool in_address_space(void const* const ptr) noexcept
+{
+  return (to_addr(ptr) >> PageMapIndex::kAddressBits) == 0;
+}
+
+}  // namespace
+
+PageMapIndex::PageMapIndex()
+  : m_root {
+      std::make_unique<std::unique_ptr<Leaf>[]>(size_t {1} << kRootBits)}
+{}
+
+PageMapIndex::~PageMapIndex() = default;
+
+std::unique_ptr<RegistryIndex> PageMapIndex::clone() const
+{
+  auto out = std::make_unique<PageMapIndex>();
+  for (auto const& [ptr, entry] : m_entries)
+    out->insert(*entry);
+  return out;
+}
+
+auto PageMapIndex::bucket(std::uintptr_t const granule) const noexcept
+  -> Bucket const*
+{
+  auto const& leaf = m_root[granule >> kLeafBits];
+  return leaf ? leaf->slots[granule & kLeafMask].get() : nullptr;
+}
+
+auto PageMapIndex::bucket_or_create(std::uintptr_t const granule) -> Bucket&
+{
+  auto& leaf = m_root[granule >> kLeafBits];
+  if (!leaf)
+    leaf = std::make_unique<Leaf>();
+  auto& slot = leaf->slots[granule & kLeafMask];
+  if (!slot)
+    slot = std::make_unique<Bucket>();
+  return *slot;
+}
+
+void PageMapIndex::release_bucket(std::uintptr_t const granule) noexcept
+{
+  // Leaves are kept around once allocated; the heap tends to reuse
+  // the same address ranges, so they would likely come right back.
+  m_root[granule >> kLeafBits]->slots[granule & kLeafMask].reset();
+}
+
+bool PageMapIndex::overlaps(KeyT const& range) const
+{
+  LBANNV2_ASSERT(in_address_space(range.second),
+                 std::runtime_error,
+                 "Address range outside of page map address space");
+
+  // Overlapping ranges are "equivalent" keys.
+  return m_entries.contains(range);
+}
+
+bool PageMapIndex::insert(Entry const& entry)
+{
+  if (overlaps(entry.range))
+    return false;
+
+  auto owned = std::make_unique<Entry>(entry);
+  Entry* const e = owned.get();
+  m_entries.emplace(entry.range, std::move(owned));
+  if (is_large(entry.range))
+  {
+    m_large.emplace(entry.range, e);
+    return true;
+  }
+  auto const [first, last] = granules_of(entry.range);
+  for (auto g = first; g <= last; ++g)
+    bucket_or_create(g).push_back(e);
+  return true;
+}
+
+void PageMapIndex::erase(void const* const ptr)
+{
+  auto const it = m_entries.find(ptr);
+  Entry* const e = it->second.get();
+  if (is_large(e->range))
+  {
+    m_large.erase(e->range);
+    m_entries.erase(it);
+    return;
+  }
+  auto const [first, last] = granules_of(e->range);
+  for (auto g = first; g <= last; ++g)
+  {
+    auto& b = bucket_or_create(g);
+    b.erase(std::find(b.begin(), b.end(), e));
+    if (b.empty())
+      release_bucket(g);
+  }
+  m_entries.erase(it);
+}
+
+auto PageMapIndex::find_entry(void const* const ptr) const noexcept -> Entry*
+{
+  if (!in_address_space(ptr))
+    return nullptr;
+  if (auto const* const b = bucket(granule_of(ptr)))
+  {
+    for (auto* const e : *b)
+      if (contains(e->range, ptr))
+        return e;
+  }
+  if (m_large.empty())
+    return nullptr;
+  auto const it = m_large.find(ptr);
+  return it == m_large.cend() ? nullptr : it->second;
+}
+
+auto PageMapIndex::find(void const* const ptr) const -> std::optional<Entry>
+{
+  if (auto const* const e = find_entry(ptr))
+    return *e;
+  return std::nullopt;
+}
+
+bool PageMapIndex::reset_allocator(void const* const ptr,
+                                   c10::Allocator* const alloc)
+{
+  if (auto* const e = find_entry(ptr))
+  {
+    e->alloc = alloc;
+    return true;
+  }
+  return false;
+}
+
+bool PageMapIndex::reset_device(void const* const ptr,
+                                c10::Device const device)
+{
+  if (auto* const e = find_entry(ptr))
+  {
+    e->device = device;
+    return true;
+  }
+  return false;
+}
+
+void PageMapIndex::for_each(std::function<void(Entry const&)> const& f) const
+{
+  for (auto const& [ptr, entry] : m_entries)
+    f(*entry);
+}
+
+std::unique_ptr<RegistryIndex>
+make_registry_index(PointerRegistry::Index const kind)
+{
+  switch (kind)
+  {
+  case PointerRegistry::Index::RangeMap:
+    return std::make_unique<RangeMapIndex>();
+  case PointerRegistry::Index::PageMap:
+    return std::make_unique<PageMapIndex>();
+  }
+  throw std::runtime_error("Unknown registry index kind");
+}
+
+}  // namespace lbannv2
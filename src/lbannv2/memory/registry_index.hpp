@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/registry.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <c10/core/Allocator.h>
+
+/** @file
+ *
+ *  Index structures backing the PointerRegistry. These are not
+ *  thread-safe; synchronization is the registry's job.
+ */
+
+namespace lbannv2
+{
+
+/** @class RegistryIndex
+ *  @brief Maps addresses to the registered range containing them.
+ */
+class RegistryIndex
+{
+public:
+  using KeyT = PointerRegistry::KeyT;
+
+  struct Entry
+  {
+    KeyT range;
+    c10::Allocator* alloc;
+    c10::Device device;
+    NestedRanges const* nested = nullptr;
+  };
+
+  virtual ~RegistryIndex() = default;
+
+  /** @brief Deep-copy this index. */
+  virtual std::unique_ptr<RegistryIndex> clone() const = 0;
+
+  /** @brief Add an entry.
+   *
+   *  @returns @c false (and leaves the index unchanged) if the
+   *           entry's range overlaps a range already in the index.
+   */
+  virtual bool insert(Entry const& entry) = 0;
+
+  /** @brief Check whether a range overlaps any range in the index. */
+  virtual bool overlaps(KeyT const& range) const = 0;
+
+  /** @brief Remove the entry whose range begins at ptr.
+   *
+   *  @pre An entry beginning at ptr exists.
+   */
+  virtual void erase(void const* ptr) = 0;
+
+  /** @brief Find the entry whose range contains ptr. */
+  virtual std::optional<Entry> find(void const* ptr) const = 0;
+
+  /** @brief Replace the allocator of the entry containing ptr.
+   *
+   *  @returns @c false if no range contains ptr.
+   */
+  virtual bool reset_allocator(void const* ptr, c10::Allocator* alloc) = 0;
+
+  /** @brief Replace the device of the entry containing ptr.
+   *
+   *  @returns @c false if no range contains ptr.
+   */
+  virtual bool reset_device(void const* ptr, c10::Device device) = 0;
+
+  /** @brief The number of entries in the index. */
+  virtual size_t size() const noexcept = 0;
+
+  /** @brief Visit every entry in the index. */
+  virtual void for_each(std::function<void(Entry const&)> const& f) const = 0;
+};  // class RegistryIndex
+
+/** @class RangeMapIndex
+ *  @brief Ordered-map index with O(log n) lookups.
+ *
+ *  See PointerRegistry::RangeLessAndDisjoint for the ordering that
+ *  makes this work.
+ */
+class RangeMapIndex final : public RegistryIndex
+{
+public:
+  std::unique_ptr<RegistryIndex> clone() const final;
+  bool insert(Entry const& entry) final;
+  bool overlaps(KeyT const& range) const final;
+  void erase(void const* ptr) final;
+  std::optional<Entry> find(void const* ptr) const final;
+  bool reset_allocator(void const* ptr, c10::Allocator* alloc) final;
+  bool reset_device(void const* ptr, c10::Device device) final;
+  size_t size() const noexcept final { return m_map.size(); }
+  void for_each(std::function<void(Entry const&)> const& f) const final;
+
+private:
+  struct Value
+  {
+    c10::Allocator* alloc;
+    c10::Device device;
+    NestedRanges const* nested;
+  };
+  using MapType = std::map<KeyT, Value, PointerRegistry::RangeLessAndDisjoint>;
+  MapType m_map;
+};  // class RangeMapIndex
+
+/** @class PageMapIndex
+ *  @brief Two-level radix "page map" index with O(1) lookups.
+ *
+ *  This is in the spirit of tcmalloc's page map. The address space
+ *  (assumed to be 48 bits, as on x86-64 and most aarch64 systems) is
+ *  divided into granules of 2^kGranuleBits bytes. A root table
+ *  indexed by the high address bits points to lazily-allocated leaf
+ *  tables indexed by the middle bits, and each leaf slot holds the
+ *  (usually very short) list of entries overlapping that granule.
+ *
+ *  Finding the entry for an address is thus two table lookups plus a
+ *  scan of one granule's list. The price is paid at insertion and
+ *  erasure, which touch one slot per granule spanned by the range.
+ *  Ranges spanning more than kMaxSlotGranules granules (e.g., large
+ *  mappings) would make that price proportional to their size, so
+ *  they are kept once, in an ordered map that lookups fall back to
+ *  when no slot entry contains the address. Overlap checks use the
+ *  ordered map of all entries.
+ *
+ *  Copies rebuild every table, so this index is not suitable for
+ *  read-mostly registries, which copy the index on every write.
+ */
+class PageMapIndex final : public RegistryIndex
+{
+public:
+  static constexpr unsigned kAddressBits = 48;
+  static constexpr unsigned kGranuleBits = 16;
+  static constexpr unsigned kLeafBits = 16;
+  static constexpr unsigned kRootBits = kAddressBits - kGranuleBits - kLeafBits;
+  static constexpr size_t kMaxSlotGranules = 64;
+
+  PageMapIndex();
+  ~PageMapIndex();
+
+  std::unique_ptr<RegistryIndex> clone() const final;
+  bool insert(Entry const& entry) final;
+  bool overlaps(KeyT const& range) const final;
+  void erase(void const* ptr) final;
+  std::optional<Entry> find(void const* ptr) const final;
+  bool reset_allocator(void const* ptr, c10::Allocator* alloc) final;
+  bool reset_device(void const* ptr, c10::Device device) final;
+  size_t size() const noexcept final { return m_entries.size(); }
+  void for_each(std::function<void(Entry const&)> const& f) const final;
+
+private:
+  template <typename T>
+  using RangeMap = std::map<KeyT, T, PointerRegistry::RangeLessAndDisjoint>;
+  using Bucket = std::vector<Entry*>;
+  struct Leaf
+  {
+    std::unique_ptr<Bucket> slots[size_t {1} << kLeafBits];
+  };
+
+  /** @brief Get the bucket for a granule, or nullptr if empty. */
+  Bucket const* bucket(std::uintptr_t granule) const noexcept;
+
+  /** @brief Get the bucket for a granule, allocating if needed. */
+  Bucket& bucket_or_create(std::uintptr_t granule);
+
+  /** @brief Drop a (now-empty) bucket. */
+  void release_bucket(std::uintptr_t granule) noexcept;
+
+  /** @brief Find the entry (owned by this index) containing ptr. */
+  Entry* find_entry(void const* ptr) const noexcept;
+
+  std::unique_ptr<std::unique_ptr<Leaf>[]> m_root;
+  /** @brief Every entry. */
+  RangeMap<std::unique_ptr<Entry>> m_entries;
+  /** @brief The entries that are too large for slots. */
+  RangeMap<Entry*> m_large;
+};  // class PageMapIndex
+
+/** @brief Create an empty index of the given kind. */
+std::unique_ptr<RegistryIndex> make_registry_index(PointerRegistry::Index kind);
+
+}  // namespace lbannv2
@@ -0,0 +1,439 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/shm_allocator.hpp"
+
+#include "lbannv2/memory/deferred_free.hpp"
+#include "lbannv2/memory/registry.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+using SA = lbannv2::ShmAllocator;
+
+template <typename T>
+T* at_offset(void* const base, size_t const offset) noexcept
+{
+  return reinterpret_cast<T*>(static_cast<std::byte*>(base) + offset);
+}
+
+constexpr std::uint64_t kSegmentMagic = 0x4c42563253484d2eULL;
+constexpr std::uint64_t kBlockMagic = 0x4c425632424c4b2eULL;
+
+// Blocks are carved in multiples of this, and free lists refer to
+// them by offset / kGranule, so segments are limited to 1 TiB.
+constexpr size_t kGranule = 256;
+constexpr size_t kMaxSegmentSize = kGranule << 32;
+// The first page holds the Segment.
+constexpr size_t kFirstBlock = 4096;
+// Block sizes are kGranule << c for size classes c < kNumClasses.
+constexpr size_t kNumClasses = 33;
+
+size_t get_env_segment_size()
+{
+  char const* const env = std::getenv("LBANNV2_SHM_SIZE");
+  if (env && std::strlen(env))
+    return std::strtoull(env, nullptr, 0);
+  return size_t {1} << 30;
+}
+
+std::runtime_error shm_error(std::string const& what)
+{
+  return std::runtime_error("ShmAllocator: " + what + ": "
+                            + std::strerror(errno));
+}
+
+void delete_shm_ptr(void* const ptr)
+{
+  auto const nbytes = lbannv2::pointer_registry().remove(ptr);
+  lbannv2::release_or_defer(SA::instance(), ptr, nbytes);
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+/** @brief The start of every segment.
+ *
+ *  Everything here is shared by all processes mapping the segment,
+ *  so it is only modified with atomics.
+ */
+struct ShmAllocator::Segment
+{
+  std::uint64_t magic;
+  std::uint64_t size;
+  /** @brief The offset of the first byte not yet carved. */
+  std::atomic<std::uint64_t> carved;
+  /** @brief Free blocks of each size class, as a stack.
+   *
+   *  The low 32 bits are the offset of the top block in granules (0
+   *  if empty), the high 32 bits a tag that is bumped by every
+   *  change, so that a block popped and pushed again in between
+   *  cannot fool a compare-and-swap.
+   */
+  std::array<std::atomic<std::uint64_t>, kNumClasses> free_lists;
+};
+
+/** @brief The start of every block. */
+struct alignas(64) ShmAllocator::Block
+{
+  std::uint64_t magic;
+  /** @brief The offset of the block in its segment. */
+  std::uint64_t offset;
+  /** @brief The size requested, excluding the header. */
+  std::uint64_t size;
+  std::uint32_t size_class;
+  /** @brief References held by processes and unopened handles. */
+  std::atomic<std::uint32_t> refs;
+  /** @brief The next free block, in granules; only used when free. */
+  std::atomic<std::uint32_t> next;
+};
+
+// The free lists must work across processes.
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+ShmAllocator::ShmAllocator() : m_segment_size {get_env_segment_size()} {}
+
+void ShmAllocator::copy_data(void* const dst,
+                             void const* const src,
+                             size_t const bytes) const
+{
+  std::memcpy(dst, src, bytes);
+}
+
+void* ShmAllocator::raw_alloc(size_t const nbytes)
+{
+  if (nbytes == 0)
+    return nullptr;
+
+  // Also keeps nbytes + sizeof(Block) and its bit_ceil from
+  // overflowing.
+  if (nbytes > kMaxSegmentSize)
+    return nullptr;
+
+  Segment* const segment = own_segment();
+  size_t const block_size =
+    std::bit_ceil(std::max(nbytes + sizeof(Block), kGranule));
+  size_t const size_class = std::countr_zero(block_size / kGranule);
+  if (size_class >= kNumClasses)
+    return nullptr;
+
+  // Pop a free block, or carve a new one.
+  auto& list = segment->free_lists[size_class];
+  Block* block = nullptr;
+  auto head = list.load(std::memory_order_acquire);
+  while (auto const index = static_cast<std::uint32_t>(head))
+  {
+    // The block may be popped (even reused) by someone else in the
+    // meantime, so its next is only trusted if the tag is unchanged.
+    auto* const top = at_offset<Block>(segment, index * kGranule);
+    std::uint64_t const next = top->next.load(std::memory_order_relaxed);
+    std::uint64_t const tag = (head >> 32) + 1;
+    if (list.compare_exchange_weak(
+          head, (tag << 32) | next, std::memory_order_acquire))
+    {
+      block = top;
+      break;
+    }
+  }
+  if (!block)
+  {
+    // Only advance past blocks that fit, so that carved never passes
+    // the end of the segment.
+    auto offset = segment->carved.load(std::memory_order_relaxed);
+    do
+    {
+      if (block_size > segment->size - offset)
+        return nullptr;
+    } while (!segment->carved.compare_exchange_weak(
+      offset, offset + block_size, std::memory_order_relaxed));
+    block = new (at_offset<void>(segment, offset)) Block;
+    block->offset = offset;
+    block->size_class = size_class;
+  }
+
+  block->size = nbytes;
+  block->refs.store(1, std::memory_order_relaxed);
+  block->magic = kBlockMagic;
+  m_live_blocks.fetch_add(1, std::memory_order_relaxed);
+
+  LBANNV2_TRACE("ShmAllocator::raw_alloc(nbytes={}): block={}",
+                nbytes,
+                static_cast<void*>(block));
+  return block + 1;
+}
+
+void ShmAllocator::raw_dealloc(void* const ptr)
+{
+  if (!ptr)
+    return;
+
+  auto* const block = static_cast<Block*>(ptr) - 1;
+  LBANNV2_ASSERT(block->magic == kBlockMagic,
+                 std::runtime_error,
+                 "ShmAllocator: pointer not allocated here");
+  m_live_blocks.fetch_sub(1, std::memory_order_relaxed);
+  release_block(block);
+}
+
+void ShmAllocator::release_block(Block* const block) noexcept
+{
+  if (block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+
+  // Push the block onto its free list, in whichever segment it is.
+  block->magic = 0;
+  auto* const segment = segment_of(block);
+  auto& list = segment->free_lists[block->size_class];
+  auto const index = static_cast<std::uint32_t>(block->offset / kGranule);
+  auto head = list.load(std::memory_order_relaxed);
+  do
+  {
+    block->next.store(static_cast<std::uint32_t>(head),
+                      std::memory_order_relaxed);
+  } while (!list.compare_exchange_weak(head,
+                                       (((head >> 32) + 1) << 32) | index,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed));
+
+  LBANNV2_TRACE("ShmAllocator::release_block(block={})",
+                static_cast<void*>(block));
+}
+
+c10::DeleterFnPtr ShmAllocator::raw_deleter() const
+{
+  return &delete_shm_ptr;
+}
+
+c10::Device ShmAllocator::get_device() const noexcept
+{
+  return c10::Device {c10::kCPU};
+}
+
+void ShmAllocator::set_segment_size(size_t const nbytes)
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  LBANNV2_ASSERT(!m_segment.load(std::memory_order_relaxed),
+                 std::runtime_error,
+                 "ShmAllocator: the segment has already been created");
+  m_segment_size = nbytes;
+}
+
+std::string ShmAllocator::segment_name() const
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_segment_name;
+}
+
+ShmHandle ShmAllocator::share(void const* const ptr)
+{
+  auto& registry = pointer_registry();
+  LBANNV2_ASSERT(registry.known(ptr) && registry.get_allocator(ptr) == this,
+                 std::runtime_error,
+                 "ShmAllocator::share: pointer not allocated here");
+  auto* const block = static_cast<Block*>(registry.get_context(ptr)) - 1;
+  auto const* const segment = segment_of(block);
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  auto const it = m_names.find(segment);
+  LBANNV2_ASSERT(it != m_names.end(),
+                 std::runtime_error,
+                 "ShmAllocator::share: unknown segment");
+  block->refs.fetch_add(1, std::memory_order_relaxed);
+  return {it->second, block->offset + sizeof(Block), block->size};
+}
+
+c10::DataPtr ShmAllocator::open(ShmHandle const& handle)
+{
+  Block* block;
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto const it = m_by_name.find(handle.segment);
+    Segment* const segment =
+      it != m_by_name.end() ? it->second : map_segment(handle.segment);
+    LBANNV2_ASSERT(handle.offset >= kFirstBlock + sizeof(Block)
+                     && handle.offset <= segment->size
+                     && handle.size <= segment->size - handle.offset,
+                   std::runtime_error,
+                   "ShmAllocator::open: handle out of range");
+    block = at_offset<Block>(segment, handle.offset) - 1;
+  }
+  LBANNV2_ASSERT(block->magic == kBlockMagic && block->size == handle.size
+                   && block->refs.load(std::memory_order_relaxed) > 0,
+                 std::runtime_error,
+                 "ShmAllocator::open: handle does not name a live block");
+
+  void* const ptr = block + 1;
+  if (pointer_registry().known(ptr))
+  {
+    // The handle is used up all the same.
+    release_block(block);
+    throw std::runtime_error(
+      "ShmAllocator::open: block is already mapped by this process");
+  }
+  // The DataPtr takes over the handle's reference.
+  pointer_registry().add(ptr, handle.size, this, get_device());
+  m_live_blocks.fetch_add(1, std::memory_order_relaxed);
+  return {ptr, ptr, &delete_shm_ptr, get_device()};
+}
+
+auto ShmAllocator::stats() const -> Stats
+{
+  Stats out;
+  out.live_blocks = m_live_blocks.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(m_mtx);
+  if (auto const* const segment = m_segment.load(std::memory_order_relaxed))
+  {
+    out.segment_size = segment->size;
+    out.carved_bytes =
+      segment->carved.load(std::memory_order_relaxed) - kFirstBlock;
+  }
+  out.foreign_segments =
+    m_by_name.size() - (m_segment.load(std::memory_order_relaxed) ? 1 : 0);
+  return out;
+}
+
+auto ShmAllocator::own_segment() -> Segment*
+{
+  if (auto* const segment = m_segment.load(std::memory_order_acquire))
+    return segment;
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  if (auto* const segment = m_segment.load(std::memory_order_relaxed))
+    return segment;
+  auto* const segment = create_segment();
+  m_segment.store(segment, std::memory_order_release);
+  return segment;
+}
+
+auto ShmAllocator::create_segment() -> Segment*
+{
+  static_assert(sizeof(Segment) <= kFirstBlock);
+  LBANNV2_ASSERT(m_segment_size > kFirstBlock
+                   && m_segment_size <= kMaxSegmentSize,
+                 std::runtime_error,
+                 "ShmAllocator: bad segment size");
+
+  auto const pid = getpid();
+  std::string const name = "/lbannv2-shm-" + std::to_string(pid);
+  int const fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+    throw shm_error("shm_open(" + name + ")");
+  if (ftruncate(fd, m_segment_size) != 0)
+  {
+    auto const err = shm_error("ftruncate(" + name + ")");
+    close(fd);
+    shm_unlink(name.c_str());
+    throw err;
+  }
+  void* const base = mmap(
+    nullptr, m_segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+  {
+    auto const err = shm_error("mmap(" + name + ")");
+    shm_unlink(name.c_str());
+    throw err;
+  }
+
+  auto* const segment = new (base) Segment;
+  segment->size = m_segment_size;
+  segment->carved.store(kFirstBlock, std::memory_order_relaxed);
+  for (auto& list : segment->free_lists)
+    list.store(0, std::memory_order_relaxed);
+  segment->magic = kSegmentMagic;
+
+  m_segment_name = name;
+  m_creator = pid;
+  m_names.emplace(segment, name);
+  m_by_name.emplace(name, segment);
+
+  static bool const registered = (std::atexit(&unlink_own_segment), true);
+  (void) registered;
+
+  LBANNV2_DEBUG("ShmAllocator: created segment {} ({} bytes)",
+                name,
+                m_segment_size);
+  return segment;
+}
+
+auto ShmAllocator::map_segment(std::string const& name) -> Segment*
+{
+  int const fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0)
+    throw shm_error("shm_open(" + name + ")");
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    auto const err = shm_error("fstat(" + name + ")");
+    close(fd);
+    throw err;
+  }
+  size_t const size = st.st_size;
+  void* const base =
+    size < kFirstBlock
+      ? MAP_FAILED
+      : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+    throw shm_error("mmap(" + name + ")");
+
+  auto* const segment = static_cast<Segment*>(base);
+  if (segment->magic != kSegmentMagic || segment->size != size)
+  {
+    munmap(base, size);
+    throw std::runtime_error("ShmAllocator: " + name
+                             + " is not an LBANNv2 segment");
+  }
+
+  // Mappings are kept for the life of the process, since blocks may
+  // be opened from them at any time.
+  m_names.emplace(segment, name);
+  m_by_name.emplace(name, segment);
+  LBANNV2_DEBUG("ShmAllocator: mapped segment {} ({} bytes)", name, size);
+  return segment;
+}
+
+auto ShmAllocator::segment_of(Block* const block) noexcept -> Segment*
+{
+  return reinterpret_cast<Segment*>(reinterpret_cast<std::byte*>(block)
+                                    - block->offset);
+}
+
+void ShmAllocator::unlink_own_segment()
+{
+  // Forked children inherit this handler along with the segment.
+  auto& alloc = instance();
+  std::lock_guard<std::mutex> lock(alloc.m_mtx);
+  if (alloc.m_creator == getpid() && !alloc.m_segment_name.empty())
+    shm_unlink(alloc.m_segment_name.c_str());
+}
+
+ShmAllocator& ShmAllocator::instance()
+{
+  // Never destroyed: tensors may well outlive static destruction.
+  static ShmAllocator* const alloc = new ShmAllocator;
+  return *alloc;
+}
+
+}  // namespace lbannv2
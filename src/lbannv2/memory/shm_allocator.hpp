@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+namespace lbannv2
+{
+
+/** @brief Names a ShmAllocator allocation in any process. */
+struct ShmHandle
+{
+  /** @brief The name of the shared-memory segment. */
+  std::string segment;
+  /** @brief The offset of the allocation in the segment. */
+  size_t offset;
+  /** @brief The size in bytes of the allocation. */
+  size_t size;
+};
+
+/** @class ShmAllocator
+ *  @brief A CPU allocator whose memory can be shared between
+ *         processes without copying.
+ *
+ *  Allocations are carved from a named POSIX shared-memory segment
+ *  (see shm_overview(7)) that is created on first use. The segment
+ *  holds its own bookkeeping: power-of-two blocks are carved off the
+ *  end of the used part, and freed blocks go to a lock-free free list
+ *  per block size. Since these lists live in the segment, any
+ *  process that maps it may allocate from it or free to it. Processes
+ *  forked after the segment was created keep allocating from it.
+ *
+ *  share() makes a ShmHandle for an allocation, which another process
+ *  turns back into a DataPtr to the same memory with open(). Each
+ *  block is reference counted: share() adds a reference, which the
+ *  DataPtr returned by open() takes over, so the block is only reused
+ *  once every process is done with it. A handle that is never opened
+ *  leaks its block.
+ *
+ *  Allocations and opened blocks are registered with the
+ *  PointerRegistry in each process.
+ *
+ *  The segment size is fixed when the segment is created; it is set
+ *  by LBANNV2_SHM_SIZE (in bytes, 1 GiB by default) or by
+ *  set_segment_size() before the first allocation. The segment is
+ *  sparse, so only pages that are touched use memory. Its name is
+ *  removed when the creating process exits, after which it cannot be
+ *  opened by new processes; mappings of it stay valid.
+ */
+class LBANNV2_EXPORT ShmAllocator final : public Allocator
+{
+public:
+  struct Stats
+  {
+    /** @brief The size of this process's segment (0 if not yet
+     *         created). */
+    size_t segment_size = 0UL;
+    /** @brief Bytes of the segment carved into blocks so far, by any
+     *         process. */
+    size_t carved_bytes = 0UL;
+    /** @brief Blocks allocated or opened by this process and not yet
+     *         freed by it. */
+    size_t live_blocks = 0UL;
+    /** @brief Segments of other processes mapped by this one. */
+    size_t foreign_segments = 0UL;
+  };
+
+  void copy_data(void* dst, void const* src, size_t bytes) const final;
+
+  void* raw_alloc(size_t nbytes) final;
+
+  /** @brief Drop this process's reference to a block. */
+  void raw_dealloc(void* ptr) final;
+
+  c10::DeleterFnPtr raw_deleter() const final;
+
+  c10::Device get_device() const noexcept final;
+
+  /** @brief Set the size of the segment, if it is not yet created. */
+  void set_segment_size(size_t nbytes);
+
+  /** @brief The name of this process's segment ("" if not yet
+   *         created). */
+  std::string segment_name() const;
+
+  /** @brief Make a handle to the allocation containing ptr.
+   *
+   *  Each handle must be passed to open() exactly once, in this or
+   *  any other process.
+   *
+   *  @throws std::runtime_error if ptr is not in a live allocation of
+   *          a ShmAllocator.
+   */
+  ShmHandle share(void const* ptr);
+
+  /** @brief Map the allocation named by a handle from share().
+   *
+   *  A process cannot open a block that it holds already, such as one
+   *  it shared and has not freed: the block is registered once per
+   *  process. Such an open() throws, and the handle's reference is
+   *  dropped, as if the handle had been opened and freed.
+   *
+   *  @throws std::runtime_error if the segment cannot be opened, the
+   *          handle does not name a live block in it, or this
+   *          process holds the block already.
+   */
+  c10::DataPtr open(ShmHandle const& handle);
+
+  Stats stats() const;
+
+  static ShmAllocator& instance();
+
+private:
+  ShmAllocator();
+  ~ShmAllocator() = default;
+  ShmAllocator(ShmAllocator const&) = delete;
+  ShmAllocator(ShmAllocator&&) = delete;
+  ShmAllocator& operator=(ShmAllocator const&) = delete;
+  ShmAllocator& operator=(ShmAllocator&&) = delete;
+
+  struct Segment;
+  struct Block;
+
+  Segment* own_segment();
+  static Segment* segment_of(Block* block) noexcept;
+  /** @brief Drop a reference to a block, freeing it if it was the
+   *         last. */
+  static void release_block(Block* block) noexcept;
+  static void unlink_own_segment();
+
+  // These require m_mtx to be held.
+  Segment* create_segment();
+  Segment* map_segment(std::string const& name);
+
+  mutable std::mutex m_mtx;
+  size_t m_segment_size;
+  /** @brief This process's segment; set once, under m_mtx. */
+  std::atomic<Segment*> m_segment = nullptr;
+  std::string m_segment_name;
+  /** @brief The process that created m_segment. */
+  pid_t m_creator = 0;
+  /** @brief The names of the segments mapped by this process. */
+  std::unordered_map<Segment const*, std::string> m_names;
+  std::unordered_map<std::string, Segment*> m_by_name;
+  std::atomic<size_t> m_live_blocks = 0UL;
+};  // class ShmAllocator
+
+}  // namespace lbannv2
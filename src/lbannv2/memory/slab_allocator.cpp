@@ -0,0 +1,522 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2/memory/slab_allocator.hpp"
+
+#include "lbannv2/memory/deferred_free.hpp"
+#include "lbannv2/utils/errors.hpp"
+#include "lbannv2/utils/logging.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace
+{
+
+using SA = lbannv2::SlabAllocator;
+
+constexpr size_t round_up(size_t const n, size_t const m) noexcept
+{
+  return (n + m - 1) / m * m;
+}
+
+constexpr size_t size_class_of(size_t const nbytes) noexcept
+{
+  return std::bit_width(std::max(nbytes, SA::kMinSlotSize) - 1)
+         - std::bit_width(SA::kMinSlotSize - 1);
+}
+
+constexpr size_t slot_size_of(size_t const size_class) noexcept
+{
+  return SA::kMinSlotSize << size_class;
+}
+
+static_assert(slot_size_of(SA::kNumClasses - 1) == SA::kMaxSlotSize);
+static_assert(size_class_of(1) == 0 && size_class_of(16) == 0);
+static_assert(size_class_of(17) == 1 && size_class_of(4096) == 8);
+
+size_t get_env_size(char const* const name, size_t const default_value)
+{
+  char const* const env = std::getenv(name);
+  if (env && std::strlen(env))
+    return std::strtoull(env, nullptr, 0);
+  return default_value;
+}
+
+size_t get_env_max_size()
+{
+  auto const max_size = get_env_size("LBANNV2_SLAB_MAX_SIZE", 256);
+  if (max_size == 0)
+    return 0;
+  return slot_size_of(size_class_of(std::min(max_size, SA::kMaxSlotSize)));
+}
+
+size_t get_env_reserve_size()
+{
+  return round_up(get_env_size("LBANNV2_SLAB_RESERVE", size_t {1} << 30),
+                  SA::kSlabSize);
+}
+
+void delete_slab_ptr(void* const ptr)
+{
+  auto& alloc = SA::instance();
+  if (alloc.in_slab(ptr))
+    alloc.raw_dealloc(ptr);
+  else
+    lbannv2::release_or_defer(
+      alloc, ptr, lbannv2::pointer_registry().remove(ptr));
+}
+
+// Set once this thread's cache is gone, so frees during thread exit
+// go straight back to the slabs.
+thread_local bool t_cache_gone = false;
+
+}  // namespace
+
+namespace lbannv2
+{
+
+SlabAllocator::SlabAllocator()
+  : Allocator {/*register_allocations=*/false},
+    m_max_size {get_env_max_size()},
+    m_reserve_size {get_env_reserve_size()}
+{}
+
+SlabAllocator::ThreadCache::ThreadCache()
+{
+  // Frees only push onto these, so they must not need to grow.
+  for (auto& list : slots)
+    list.reserve(kThreadCacheSize + 1);
+}
+
+SlabAllocator::ThreadCache::~ThreadCache()
+{
+  auto& alloc = SlabAllocator::instance();
+  for (auto const& list : slots)
+    alloc.flush(list);
+  t_cache_gone = true;
+}
+
+auto SlabAllocator::thread_cache() -> ThreadCache&
+{
+  thread_local ThreadCache cache;
+  return cache;
+}
+
+void SlabAllocator::copy_data(void* const dst,
+                              void const* const src,
+                              size_t const bytes) const
+{
+  std::memcpy(dst, src, bytes);
+}
+
+void* SlabAllocator::raw_alloc(size_t const nbytes)
+{
+  if (nbytes == 0)
+    return nullptr;
+
+  if (nbytes <= m_max_size)
+    if (void* const ptr = alloc_slot(size_class_of(nbytes)))
+      return ptr;
+  return alloc_large(nbytes);
+}
+
+void SlabAllocator::raw_dealloc(void* const ptr)
+{
+  if (!ptr)
+    return;
+
+  if (in_slab(ptr))
+  {
+    free_slot(ptr);
+    return;
+  }
+
+  LBANNV2_TRACE("SlabAllocator::raw_dealloc(ptr={})", ptr);
+  std::free(ptr);
+  m_large_allocations.fetch_sub(1, std::memory_order_relaxed);
+}
+
+c10::DeleterFnPtr SlabAllocator::raw_deleter() const
+{
+  return &delete_slab_ptr;
+}
+
+c10::Device SlabAllocator::get_device() const noexcept
+{
+  return c10::Device {c10::kCPU};
+}
+
+bool SlabAllocator::in_slab(void const* const ptr) const noexcept
+{
+  auto const* const p = static_cast<std::byte const*>(ptr);
+  return p >= m_begin.load(std::memory_order_acquire)
+         && p < m_end.load(std::memory_order_acquire);
+}
+
+size_t SlabAllocator::release_cached()
+{
+  if (!t_cache_gone)
+    for (auto& list : thread_cache().slots)
+    {
+      flush(list);
+      list.clear();
+    }
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  std::vector<Slab*> empty;
+  std::copy_if(m_slabs.cbegin(),
+               m_slabs.cend(),
+               std::back_inserter(empty),
+               [](Slab const* const s) { return s->num_used == 0; });
+  pointer_registry().remove_many(
+    std::vector<void*>(empty.cbegin(), empty.cend()));
+  for (Slab* const slab : empty)
+    release_slab(slab);
+
+  if (!empty.empty())
+    LBANNV2_DEBUG("SlabAllocator: released {} slab(s)", empty.size());
+  return empty.size() * kSlabSize;
+}
+
+auto SlabAllocator::stats() const -> Stats
+{
+  Stats out;
+  out.large_allocations = m_large_allocations.load(std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  out.num_slabs = m_slabs.size();
+  for (Slab const* const slab : m_slabs)
+  {
+    size_t live = 0UL;
+    for (auto const& word : slab->live)
+      live += std::popcount(word.load(std::memory_order_relaxed));
+    out.live_slots += live;
+    out.live_bytes += live * slab->slot_size.load(std::memory_order_relaxed);
+    out.cached_slots += slab->num_used - live;
+    if (slab->num_used == 0)
+      ++out.empty_slabs;
+  }
+  return out;
+}
+
+SlabAllocator& SlabAllocator::instance()
+{
+  // Never destroyed: tensors may well outlive static destruction.
+  static SlabAllocator* const alloc = new SlabAllocator;
+  return *alloc;
+}
+
+bool SlabAllocator::find_nested(void const* const base,
+                                void const* const ptr,
+                                void*& begin,
+                                size_t& size) const noexcept
+{
+  // The reserved range is never unmapped, so the header can be read
+  // even if the slab was just released (its slot size is then 0).
+  auto const* const slab = static_cast<Slab const*>(base);
+  size_t const slot_size = slab->slot_size.load(std::memory_order_acquire);
+  if (slot_size == 0)
+    return false;
+
+  auto const layout = layout_of(slot_size);
+  size_t const offset = static_cast<std::byte const*>(ptr)
+                        - static_cast<std::byte const*>(base);
+  if (offset < layout.first)
+    return false;
+  size_t const idx = (offset - layout.first) / slot_size;
+  if (idx >= layout.count)
+    return false;
+  auto const word = slab->live[idx / 64].load(std::memory_order_acquire);
+  if (!(word >> (idx % 64) & 1U))
+    return false;
+
+  begin = static_cast<std::byte*>(const_cast<void*>(base)) + layout.first
+          + idx * slot_size;
+  size = slot_size;
+  return true;
+}
+
+auto SlabAllocator::slab_of(void const* const ptr) noexcept -> Slab*
+{
+  auto const addr = reinterpret_cast<std::uintptr_t>(ptr);
+  return reinterpret_cast<Slab*>(addr & ~(kSlabSize - 1));
+}
+
+size_t SlabAllocator::slot_index(Slab const* const slab,
+                                 void const* const ptr) noexcept
+{
+  size_t const slot_size = slab->slot_size.load(std::memory_order_relaxed);
+  size_t const offset = static_cast<std::byte const*>(ptr)
+                        - reinterpret_cast<std::byte const*>(slab);
+  return (offset - layout_of(slot_size).first) / slot_size;
+}
+
+void* SlabAllocator::alloc_slot(size_t const size_class)
+{
+  void* ptr = nullptr;
+  if (t_cache_gone)
+  {
+    std::vector<void*> one;
+    one.reserve(1);
+    refill(size_class, one, 1);
+    if (one.empty())
+      return nullptr;
+    ptr = one.front();
+  }
+  else
+  {
+    auto& list = thread_cache().slots[size_class];
+    if (list.empty())
+    {
+      // Take a few at a time to amortize the lock, but not so many
+      // that big slots pile up in one thread's list.
+      auto const batch = std::min(
+        kThreadCacheSize / 2, layout_of(slot_size_of(size_class)).count / 4);
+      refill(size_class, list, std::max(batch, size_t {1}));
+      if (list.empty())
+        return nullptr;
+    }
+    ptr = list.back();
+    list.pop_back();
+  }
+
+  Slab* const slab = slab_of(ptr);
+  size_t const idx = slot_index(slab, ptr);
+  slab->live[idx / 64].fetch_or(std::uint64_t {1} << (idx % 64),
+                                std::memory_order_release);
+  LBANNV2_TRACE("SlabAllocator::alloc_slot(size_class={}): ptr={}",
+                size_class,
+                ptr);
+  return ptr;
+}
+
+void SlabAllocator::free_slot(void* const ptr) noexcept
+{
+  LBANNV2_TRACE("SlabAllocator::free_slot(ptr={})", ptr);
+
+  Slab* const slab = slab_of(ptr);
+  size_t const idx = slot_index(slab, ptr);
+  slab->live[idx / 64].fetch_and(~(std::uint64_t {1} << (idx % 64)),
+                                 std::memory_order_release);
+
+  if (t_cache_gone)
+  {
+    flush({&ptr, 1});
+    return;
+  }
+
+  auto const size_class =
+    size_class_of(slab->slot_size.load(std::memory_order_relaxed));
+  auto& list = thread_cache().slots[size_class];
+  list.push_back(ptr);
+  if (list.size() > kThreadCacheSize)
+  {
+    // Keep the most recently freed (and likely still cached) half.
+    auto const half = list.begin() + kThreadCacheSize / 2;
+    flush({list.begin(), half});
+    list.erase(list.begin(), half);
+  }
+}
+
+void* SlabAllocator::alloc_large(size_t const nbytes)
+{
+  void* ptr = nullptr;
+  if (posix_memalign(&ptr, 64, nbytes) != 0)
+    return nullptr;
+
+  try
+  {
+    pointer_registry().add(ptr, nbytes, this, get_device());
+  }
+  catch (...)
+  {
+    std::free(ptr);
+    throw;
+  }
+  m_large_allocations.fetch_add(1, std::memory_order_relaxed);
+
+  LBANNV2_TRACE("SlabAllocator::alloc_large(nbytes={}): ptr={}", nbytes, ptr);
+  return ptr;
+}
+
+void SlabAllocator::refill(size_t const size_class,
+                           std::vector<void*>& out,
+                           size_t const count)
+{
+  size_t const slot_size = slot_size_of(size_class);
+  auto const layout = layout_of(slot_size);
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  auto& partial = m_partial[size_class];
+  while (out.size() < count)
+  {
+    if (partial.empty() && !new_slab(size_class))
+      break;
+
+    Slab* const slab = partial.back();
+    auto* const base = reinterpret_cast<std::byte*>(slab);
+    for (size_t w = 0; w < kBitmapWords && out.size() < count; ++w)
+    {
+      auto& used = slab->used[w];
+      while (~used && out.size() < count)
+      {
+        auto const bit = std::countr_one(used);
+        used |= std::uint64_t {1} << bit;
+        ++slab->num_used;
+        out.push_back(base + layout.first + (w * 64 + bit) * slot_size);
+      }
+    }
+    if (slab->num_used == layout.count)
+    {
+      slab->partial = false;
+      partial.pop_back();
+    }
+  }
+}
+
+void SlabAllocator::flush(std::span<void* const> const slots) noexcept
+{
+  if (slots.empty())
+    return;
+
+  std::lock_guard<std::mutex> lock(m_mtx);
+  for (void* const ptr : slots)
+  {
+    Slab* const slab = slab_of(ptr);
+    size_t const idx = slot_index(slab, ptr);
+    slab->used[idx / 64] &= ~(std::uint64_t {1} << (idx % 64));
+    --slab->num_used;
+    if (!slab->partial)
+    {
+      // Room for every slab of the class was reserved in new_slab().
+      auto const size_class =
+        size_class_of(slab->slot_size.load(std::memory_order_relaxed));
+      slab->partial = true;
+      m_partial[size_class].push_back(slab);
+    }
+  }
+}
+
+auto SlabAllocator::new_slab(size_t const size_class) -> Slab*
+{
+  if (!m_reserved)
+  {
+    m_reserved = true;
+    if (m_reserve_size)
+    {
+      // Over-allocate so the range can be aligned to kSlabSize.
+      size_t const size = m_reserve_size + kSlabSize;
+      void* const region = mmap(nullptr,
+                                size,
+                                PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                                -1,
+                                0);
+      if (region == MAP_FAILED)
+      {
+        LBANNV2_WARN("SlabAllocator: could not reserve {} bytes ({})",
+                     m_reserve_size,
+                     std::strerror(errno));
+      }
+      else
+      {
+        auto* const raw = static_cast<std::byte*>(region);
+        auto* const begin = reinterpret_cast<std::byte*>(
+          round_up(reinterpret_cast<std::uintptr_t>(raw), kSlabSize));
+        auto* const end = begin + m_reserve_size;
+        if (begin != raw)
+          munmap(raw, begin - raw);
+        if (end != raw + size)
+          munmap(end, raw + size - end);
+
+        m_next_slab = begin;
+        m_end.store(end, std::memory_order_release);
+        m_begin.store(begin, std::memory_order_release);
+        LBANNV2_DEBUG("SlabAllocator: reserved {} bytes at {}",
+                      m_reserve_size,
+                      (void*) begin);
+      }
+    }
+  }
+
+  std::byte* base = nullptr;
+  if (!m_free_slabs.empty())
+  {
+    base = reinterpret_cast<std::byte*>(m_free_slabs.back());
+    m_free_slabs.pop_back();
+  }
+  else if (m_next_slab && m_next_slab != m_end.load(std::memory_order_relaxed))
+  {
+    base = m_next_slab;
+    m_next_slab += kSlabSize;
+  }
+  else
+  {
+    if (!m_warned_full && m_reserve_size)
+      LBANNV2_WARN("SlabAllocator: all {} bytes of slabs are in use; "
+                   "small allocations will be made individually",
+                   m_reserve_size);
+    m_warned_full = true;
+    return nullptr;
+  }
+
+  size_t const slot_size = slot_size_of(size_class);
+  auto const layout = layout_of(slot_size);
+  auto* const slab = new (base) Slab {};
+  // Slots past the end of the slab are never free.
+  for (size_t idx = layout.count; idx < kBitmapWords * 64; ++idx)
+    slab->used[idx / 64] |= std::uint64_t {1} << (idx % 64);
+  slab->partial = true;
+  slab->slot_size.store(slot_size, std::memory_order_release);
+
+  try
+  {
+    m_slabs.push_back(slab);
+    m_partial[size_class].reserve(m_slabs.size());
+    m_partial[size_class].push_back(slab);
+    pointer_registry().add(base, kSlabSize, this, get_device(), this);
+  }
+  catch (...)
+  {
+    if (!m_slabs.empty() && m_slabs.back() == slab)
+      m_slabs.pop_back();
+    if (!m_partial[size_class].empty()
+        && m_partial[size_class].back() == slab)
+      m_partial[size_class].pop_back();
+    slab->slot_size.store(0, std::memory_order_release);
+    m_free_slabs.push_back(slab);
+    throw;
+  }
+
+  LBANNV2_DEBUG("SlabAllocator: new slab (ptr={}, slot_size={})",
+                (void*) base,
+                slot_size);
+  return slab;
+}
+
+void SlabAllocator::release_slab(Slab* const slab)
+{
+  auto const size_class =
+    size_class_of(slab->slot_size.load(std::memory_order_relaxed));
+  slab->slot_size.store(0, std::memory_order_release);
+
+  if (slab->partial)
+    std::erase(m_partial[size_class], slab);
+  std::erase(m_slabs, slab);
+
+  // The slab stays reserved, but its pages are returned.
+  madvise(slab, kSlabSize, MADV_DONTNEED);
+  m_free_slabs.push_back(slab);
+}
+
+}  // namespace lbannv2
@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace lbannv2
+{
+
+/** @class SlabAllocator
+ *  @brief Packs small CPU allocations into shared slabs.
+ *
+ *  Scalars, step counters, masks and other tiny tensors each cost an
+ *  allocation and a PointerRegistry entry of their own with the other
+ *  allocators. This one rounds requests of at most max_size() bytes
+ *  up to a power-of-two size class and hands out slots of slabs
+ *  (kSlabSize bytes, aligned to their size) that hold one size class
+ *  each.
+ *
+ *  Each slab is registered with the PointerRegistry once, along with
+ *  the allocator as its NestedRanges: a bitmap in the slab records
+ *  which slots are live, so registry lookups still resolve to the
+ *  slot containing an address.
+ *
+ *  Freed slots go to a free list private to the freeing thread, from
+ *  which that thread's next allocations of the same size class are
+ *  served without locking. Lists that grow too long are returned to
+ *  the slabs in batches, and empty slabs are only released (and
+ *  deregistered) by release_cached().
+ *
+ *  Slabs are carved from one virtual address range reserved on first
+ *  use (LBANNV2_SLAB_RESERVE bytes, 1 GiB by default), so that whether
+ *  a pointer is a slot can be decided without a lookup. Larger
+ *  requests, and small ones once the reservation is used up, are
+ *  allocated and registered individually. The largest request served
+ *  from slabs defaults to 256 bytes and can be set with
+ *  LBANNV2_SLAB_MAX_SIZE (in bytes; it is rounded up to a size class).
+ */
+class LBANNV2_EXPORT SlabAllocator final : public Allocator,
+                                           private NestedRanges
+{
+public:
+  static constexpr size_t kSlabSize = size_t {64} << 10;
+  static constexpr size_t kMinSlotSize = 16;
+  static constexpr size_t kMaxSlotSize = 4096;
+  static constexpr size_t kNumClasses = 9;
+  /** @brief The longest per-thread free list of a size class. */
+  static constexpr size_t kThreadCacheSize = 64;
+
+  struct Stats
+  {
+    /** @brief Slabs held, including empty ones. */
+    size_t num_slabs = 0UL;
+    /** @brief Slabs with no slots in use. */
+    size_t empty_slabs = 0UL;
+    /** @brief Slots handed out and not yet freed. */
+    size_t live_slots = 0UL;
+    /** @brief The bytes in live slots. */
+    size_t live_bytes = 0UL;
+    /** @brief Freed slots held in per-thread free lists. */
+    size_t cached_slots = 0UL;
+    /** @brief Allocations made outside of slabs and not yet freed. */
+    size_t large_allocations = 0UL;
+  };
+
+  void copy_data(void* dst, void const* src, size_t bytes) const final;
+
+  void* raw_alloc(size_t nbytes) final;
+
+  void raw_dealloc(void* ptr) final;
+
+  c10::DeleterFnPtr raw_deleter() const final;
+
+  c10::Device get_device() const noexcept final;
+
+  /** @brief The largest request that is served from a slab. */
+  size_t max_size() const noexcept { return m_max_size; }
+
+  /** @brief Whether ptr is in a slab (live or not). */
+  bool in_slab(void const* ptr) const noexcept;
+
+  /** @brief Return the calling thread's free lists to the slabs and
+   *         release the slabs that are then empty.
+   *
+   *  @returns The number of bytes released.
+   */
+  size_t release_cached();
+
+  Stats stats() const;
+
+  static SlabAllocator& instance();
+
+private:
+  SlabAllocator();
+  ~SlabAllocator() = default;
+  SlabAllocator(SlabAllocator const&) = delete;
+  SlabAllocator(SlabAllocator&&) = delete;
+  SlabAllocator& operator=(SlabAllocator const&) = delete;
+  SlabAllocator& operator=(SlabAllocator&&) = delete;
+
+  static constexpr size_t kBitmapWords = kSlabSize / kMinSlotSize / 64;
+
+  /** @brief The start of every slab. */
+  struct Slab
+  {
+    /** @brief 0 while the slab is not in use. */
+    std::atomic<std::uint32_t> slot_size;
+    /** @brief Slots handed out or in free lists; guarded by m_mtx. */
+    std::uint32_t num_used;
+    /** @brief Whether the slab is in m_partial; guarded by m_mtx. */
+    bool partial;
+    /** @brief Slots handed out. */
+    std::array<std::atomic<std::uint64_t>, kBitmapWords> live;
+    /** @brief Slots handed out or in free lists; guarded by m_mtx. */
+    std::array<std::uint64_t, kBitmapWords> used;
+  };
+
+  /** @brief Where the slots of a slab start, and how many there are.
+   *
+   *  Slots follow the Slab header, at a multiple of their size.
+   */
+  struct Layout
+  {
+    size_t first;
+    size_t count;
+  };
+
+  static constexpr Layout layout_of(size_t slot_size) noexcept
+  {
+    size_t const first =
+      (sizeof(Slab) + slot_size - 1) / slot_size * slot_size;
+    return {first, (kSlabSize - first) / slot_size};
+  }
+
+  /** @brief A thread's free lists, one per size class. */
+  struct ThreadCache
+  {
+    std::array<std::vector<void*>, kNumClasses> slots;
+    ThreadCache();
+    ~ThreadCache();
+  };
+
+  static ThreadCache& thread_cache();
+
+  bool find_nested(void const* base,
+                   void const* ptr,
+                   void*& begin,
+                   size_t& size) const noexcept final;
+
+  static Slab* slab_of(void const* ptr) noexcept;
+  static size_t slot_index(Slab const* slab, void const* ptr) noexcept;
+
+  void* alloc_slot(size_t size_class);
+  void free_slot(void* ptr) noexcept;
+  void* alloc_large(size_t nbytes);
+
+  // These take m_mtx.
+  void refill(size_t size_class, std::vector<void*>& out, size_t count);
+  void flush(std::span<void* const> slots) noexcept;
+
+  // These require m_mtx to be held. release_slab() does not
+  // deregister the slab.
+  Slab* new_slab(size_t size_class);
+  void release_slab(Slab* slab);
+
+  size_t const m_max_size;
+  size_t const m_reserve_size;
+
+  /** @brief The reserved range; set once, under m_mtx. */
+  std::atomic<std::byte*> m_begin = nullptr;
+  std::atomic<std::byte*> m_end = nullptr;
+
+  mutable std::mutex m_mtx;
+  bool m_reserved = false;
+  bool m_warned_full = false;
+  /** @brief Slabs never used so far start here. */
+  std::byte* m_next_slab = nullptr;
+  /** @brief Released slabs. */
+  std::vector<Slab*> m_free_slabs;
+  /** @brief Slabs of each size class with unused slots. */
+  std::array<std::vector<Slab*>, kNumClasses> m_partial;
+  /** @brief All slabs in use. */
+  std::vector<Slab*> m_slabs;
+  std::atomic<size_t> m_large_allocations = 0UL;
+};  // class SlabAllocator
+
+}  // namespace lbannv2
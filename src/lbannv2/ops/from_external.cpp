@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2_config.h>
+
+#include <lbannv2/ops/from_external.hpp>
+#include <lbannv2/utils/errors.hpp>
+
+#include <ATen/EmptyTensor.h>
+#include <ATen/ops/empty.h>
+#include <c10/core/Storage.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+template <typename ReleaseT>
+at::Tensor wrap_external(void* const data,
+                         c10::IntArrayRef const sizes,
+                         std::optional<c10::IntArrayRef> const strides,
+                         ReleaseT&& release,
+                         c10::TensorOptions const& options)
+{
+  at::detail::check_size_nonnegative(sizes);
+  std::vector<int64_t> contiguous(sizes.size(), 1);
+  for (size_t i = sizes.size(); i > 1; --i)
+    contiguous[i - 2] = contiguous[i - 1] * std::max<int64_t>(sizes[i - 1], 1);
+  c10::IntArrayRef const real_strides =
+    strides ? *strides : c10::IntArrayRef {contiguous};
+  LBANNV2_ASSERT(real_strides.size() == sizes.size(),
+                 std::runtime_error,
+                 "from_external: strides and sizes differ in length");
+  size_t const nbytes = at::detail::computeStorageNbytes(
+    sizes, real_strides, options.dtype().itemsize());
+
+  auto data_ptr = lbannv2::ExternalAllocator::instance().wrap(
+    data, nbytes, std::forward<ReleaseT>(release), options.device());
+  c10::Storage storage {c10::Storage::use_byte_size_t {},
+                        nbytes,
+                        std::move(data_ptr),
+                        /*allocator=*/nullptr,
+                        /*resizable=*/false};
+  return at::empty({0}, options)
+    .set_(std::move(storage), /*storage_offset=*/0, sizes, real_strides);
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+at::Tensor from_external(void* const data,
+                         c10::IntArrayRef const sizes,
+                         std::optional<c10::IntArrayRef> const strides,
+                         ExternalAllocator::Release release,
+                         c10::TensorOptions const& options)
+{
+  return wrap_external(data, sizes, strides, std::move(release), options);
+}
+
+at::Tensor from_external(void* const data,
+                         c10::IntArrayRef const sizes,
+                         std::optional<c10::IntArrayRef> const strides,
+                         std::shared_ptr<void const> owner,
+                         c10::TensorOptions const& options)
+{
+  return wrap_external(data, sizes, strides, std::move(owner), options);
+}
+
+}  // namespace lbannv2
@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/external_allocator.hpp>
+
+#include <ATen/Tensor.h>
+#include <c10/core/TensorOptions.h>
+#include <c10/util/ArrayRef.h>
+
+#include <memory>
+#include <optional>
+
+namespace lbannv2
+{
+
+/** @brief Wrap externally owned memory in a tensor without copying.
+ *
+ *  Unlike at::from_blob(), the memory is registered with the
+ *  PointerRegistry (see ExternalAllocator::wrap()), so LBANNv2 treats
+ *  the tensor like one it allocated. The storage is not resizable.
+ *
+ *  @param[in] data The beginning of the memory.
+ *  @param[in] sizes The sizes of the tensor.
+ *  @param[in] strides The strides of the tensor; contiguous if not
+ *                     given.
+ *  @param[in] release Called once the storage has been freed.
+ *  @param[in] options The dtype and device of the tensor.
+ *
+ *  @throws std::runtime_error if the memory overlaps registered
+ *          memory, in which case release is not called.
+ */
+LBANNV2_EXPORT at::Tensor
+from_external(void* data,
+              c10::IntArrayRef sizes,
+              std::optional<c10::IntArrayRef> strides,
+              ExternalAllocator::Release release,
+              c10::TensorOptions const& options = {});
+
+/** @brief Wrap externally owned memory that is kept alive by owner. */
+LBANNV2_EXPORT at::Tensor
+from_external(void* data,
+              c10::IntArrayRef sizes,
+              std::optional<c10::IntArrayRef> strides,
+              std::shared_ptr<void const> owner,
+              c10::TensorOptions const& options = {});
+
+}  // namespace lbannv2
@@ -6,55 +6,38 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include <lbannv2_config.h>
 
-#include <lbannv2/memory/mi300a_allocator.hpp>
+#include <lbannv2/memory/allocation_trace.hpp>
+#include <lbannv2/memory/coherent_memory.hpp>
 #include <lbannv2/memory/registry.hpp>
 #include <lbannv2/ops/migrate.hpp>
-#include <lbannv2/utils/gpu_utils.hpp>
 #include <lbannv2/utils/logging.hpp>
 #include <lbannv2/utils/tensor_helpers.hpp>
 
 #include <ATen/Tensor.h>
+#include <ATen/core/grad_mode.h>
 #include <c10/core/Device.h>
-#if LBANNV2_HAS_ROCM
-#include <c10/hip/HIPFunctions.h>
-#endif
+#include <torch/csrc/autograd/custom_function.h>
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
 
-#if LBANNV2_WITH_MI300A || LBANNV2_UNKNOWN_MI300A
 namespace
 {
 
-// NOTE: This function assumes a binary view of memory: pointers only
-// come from "CPU" or "CUDA" (i.e., HIP).
-at::Device get_origin_device(void const* const ptr)
-{
-  // Note to future!me: the HIP runtime can give us both the context
-  // pointer and the buffer size for any pointer allocated by HIP.
-  // HOWEVER, so can the pytorch DataPtr object, which we have in the
-  // context in which this function is used...
-  int device_idx;
-  if (hipPointerGetAttribute(&device_idx,
-                             HIP_POINTER_ATTRIBUTE_DEVICE_ORDINAL,
-                             const_cast<void*>(ptr))
-      == hipSuccess)
-  {
-    return {c10::kCUDA, static_cast<c10::DeviceIndex>(device_idx)};
-  }
-  return c10::kCPU;
-}
-
 // PyTorch still admits the possibility of a single process using
 // multiple GPUs, though this historically has not been LBANN's
 // preferred approach (instead preferring 1 GPU per rank and 1 rank
-// per GPU). On MI300A, we can migrate a pointer from any "GPU" to the
-// CPU freely. HOWEVER, we can only migrate from the CPU to the
-// specific device on which the migrateable memory was allocated.
-bool is_ok_device(c10::Device const& d)
-{
-  return d.is_cpu()
-#if LBANNV2_HAS_GPU
-         || d.is_cuda()
-#endif
-    ;
+// per GPU). With coherent memory, we can migrate a pointer from any
+// "GPU" to the CPU freely. HOWEVER, we can only migrate from the CPU
+// to the specific device on which the migrateable memory was
+// allocated.
+bool is_ok_device(lbannv2::CoherentMemoryDomain const& domain,
+                  c10::Device const& d)
+{
+  return d.is_cpu() || d.type() == domain.device_type();
 }
 
 c10::DispatchKeySet get_default_keyset(c10::Device const& d)
@@ -67,21 +50,16 @@ c10::DispatchKeySet get_default_keyset(c10::Device const& d)
   }
 }
 
-}  // namespace
-#endif
-
-at::Tensor lbannv2::migrate(at::Tensor& t, c10::Device const& d)
+// Throws if the domain cannot migrate the tensor to d. This does not
+// touch the tensor, so a batch can be checked before any of it is
+// migrated.
+void check_migratable(lbannv2::CoherentMemoryDomain const& domain,
+                      at::Tensor const& t,
+                      c10::Device const& d)
 {
-  auto const src_d = t.device();
-  LBANNV2_TRACE(
-    "migrate(ptr={}, from={}, to={})", t.data_ptr(), src_d.str(), d.str());
-
-  // Short-circuit
-  if (src_d == d)
-    return t;
-
-#if LBANNV2_UNKNOWN_MI300A || LBANNV2_WITH_MI300A
-  // NOTE: "LBANNV2_HAS_ROCM" is implied here.
+  // Storage without memory can go anywhere.
+  if (!t.storage().data())
+    return;
 
   // At its heart, this isn't really "migrate", it's "rebrand"... I
   // don't actually care what the device annotations on the Tensor or
@@ -91,73 +69,296 @@ at::Tensor lbannv2::migrate(at::Tensor& t, c10::Device const& d)
   // access is enabled *now*, I haven't discovered a way to tell if it
   // was enabled when a particular buffer was allocated (well, other
   // than trying to read it and letting the segfault happen)).
-  auto const real_src_d = get_origin_device(t.const_data_ptr());
+  auto const real_src_d = domain.origin(t.const_data_ptr());
 
-  // We need to get the "real" "CUDA" target.
-  c10::Device const real_tgt_d =
-    (d.is_cuda() && !d.has_index())
-      ? c10::Device {c10::kCUDA, gpu::current_device()}
-      : d;
+  // We need to get the "real" device target.
+  c10::Device const real_tgt_d = domain.resolve(d);
 
   // If the real_src_d is "cpu", it can be migrated to "cpu".
-  // If the real_src_d is "cuda:N", it can be migrated to "cpu" or "cuda:N".
-  LBANNV2_ASSERT(real_tgt_d.is_cpu() || (real_src_d == real_tgt_d),
+  // If the real_src_d is "cuda:N", it can be migrated to "cpu" or
+  // "cuda:N".
+  LBANNV2_ASSERT(domain.can_migrate(t.const_data_ptr(), real_tgt_d),
                  std::runtime_error,
                  "Migrate: ptr is not migrateable to given device.");
   LBANNV2_ASSERT(
-    is_ok_device(real_src_d),
+    is_ok_device(domain, real_src_d),
     std::runtime_error,
     "Migrate: source tensor's device type not supported by LBANNv2.");
-  LBANNV2_ASSERT(is_ok_device(real_tgt_d),
+  LBANNV2_ASSERT(is_ok_device(domain, real_tgt_d),
                  std::runtime_error,
                  "Migrate: destination device type not supported by LBANNv2.");
+}
+
+// Rebrands the tensor's storage to d. The tensor itself still claims
+// its old device.
+void rebrand_storage(lbannv2::CoherentMemoryDomain& domain,
+                     at::Tensor const& t,
+                     c10::Device const& d)
+{
+  auto& data_ptr = t.storage().mutable_data_ptr();
+  c10::Device const real_tgt_d = domain.resolve(d);
+  if (!data_ptr.get())
+  {
+    data_ptr.unsafe_set_device(real_tgt_d);
+    return;
+  }
 
   // FIXME: If the pointer is not owned by LBANNv2, how do we handle
   // its associated stream?
   //  ---> The PyTorch CUDA caching allocator provides "recordStream" :)
+  c10::Stream stream = real_tgt_d.is_cpu()
+                         ? c10::Stream {c10::Stream::DEFAULT, d}
+                         : domain.current_stream(real_tgt_d);
+
+  domain.rebrand(data_ptr, d, stream);
+  lbannv2::trace_allocation_event(lbannv2::TraceEvent::Migrate,
+                                  t.storage().data(),
+                                  t.storage().nbytes(),
+                                  d,
+                                  stream.id());
+
+  // Report the number of meaningful bytes migrated. This is
+  // inherently based on the tensor shape rather than the allocated
+  // buffer size (think: binned allocations, subtensor "views", etc).
+  LBANNV2_TRACE("migrated {} bytes (ptr={})",
+                std::accumulate(t.sizes().cbegin(),
+                                t.sizes().cend(),
+                                static_cast<int64_t>(1),
+                                std::multiplies<int64_t> {})
+                  * t.dtype().itemsize(),
+                t.const_data_ptr());
+}
 
-#if LBANNV2_UNKNOWN_MI300A
-  if (lbannv2::gpu::is_integrated())
-#endif
+// Makes a tensor on d that aliases t: same storage (which must be
+// rebranded already), storage offset, sizes, strides and names.
+//
+// This is not made with the TensorImpl::VIEW constructor: that one
+// expects the key set of a base tensor, autograd keys included, and
+// with only the backend keys the result is an inference tensor (see
+// TensorImpl::is_inference()). A regular tensor gets the autograd
+// keys. Sharing the version counter of t (which t shares with any
+// other view of its base) makes in-place writes through any alias
+// visible to autograd's checks on saved tensors.
+at::Tensor make_alias(at::Tensor const& t, c10::Device const& d)
+{
+  auto storage = t.storage();
+  auto out = at::detail::make_tensor<at::TensorImpl>(
+    std::move(storage), get_default_keyset(d), t.dtype());
+  sync_metadata(t, out);
+  if (out.is_inference() == t.is_inference())
+    out.unsafeGetTensorImpl()->set_version_counter(
+      t.unsafeGetTensorImpl()->version_counter());
+  return out;
+}
+
+// Gives a migrated tensor a grad_fn that returns gradients to the
+// source device, as Tensor::to() does. Gradients are copied rather
+// than migrated, since their memory may still be in use where they
+// were computed.
+struct MigrateFunction : torch::autograd::Function<MigrateFunction>
+{
+  static at::Tensor forward(torch::autograd::AutogradContext* const ctx,
+                            at::Tensor const& t,
+                            c10::Device const d)
   {
-    c10::Stream stream = real_tgt_d.is_cpu()
-                           ? c10::Stream {c10::Stream::DEFAULT, d}
-                           : getDeviceCurrentStream(real_tgt_d.index());
-
-    lbannv2::migrate_ptr(t.storage().mutable_data_ptr(), d, stream);
-
-    // Report the number of meaningful bytes migrated. This is
-    // inherently based on the tensor shape rather than the allocated
-    // buffer size (think: binned allocations, subtensor "views",
-    // etc).
-    LBANNV2_TRACE("migrated {} bytes (ptr={})",
-                  std::accumulate(t.sizes().cbegin(),
-                                  t.sizes().cend(),
-                                  static_cast<int64_t>(1),
-                                  std::multiplies<int64_t> {})
-                    * t.dtype().itemsize(),
-                  t.const_data_ptr());
-
-    auto storage = t.storage();
-    // FIXME (trb): I initially created this as a 'VIEW', but that
-    // puts it in "inference mode" (i.e., out.is_inference() == true).
-    // This is bad for training workloads. We may need to be a bit
-    // more careful in general here... E.g., migrating views to views,
-    // etc.
-    auto out =
-      at::detail::make_tensor<at::TensorImpl>(  // at::TensorImpl::VIEW,
-        std::move(storage),
-        get_default_keyset(d),
-        t.dtype());
-    sync_metadata(t, out);
-
-    if (src_d.is_cuda())
+    ctx->saved_data["device"] = t.device();
+    return make_alias(t, d);
+  }
+
+  static torch::autograd::variable_list
+  backward(torch::autograd::AutogradContext* const ctx,
+           torch::autograd::variable_list const grads)
+  {
+    auto const src_d = ctx->saved_data["device"].toDevice();
+    auto const& grad = grads.front();
+    return {grad.defined() ? grad.to(src_d) : grad, at::Tensor {}};
+  }
+};  // struct MigrateFunction
+
+// Whether t is a view that autograd tracks through its base: one
+// made from a base that requires grad, without changing the dtype.
+// In-place writes through such a view rewrite the base's history, so
+// it must be migrated as a view of the migrated base, not an alias.
+bool is_tracked_view(at::Tensor const& t)
+{
+  if (!t.is_view() || !at::GradMode::is_enabled())
+    return false;
+  auto const& base = t._base();
+  return base.requires_grad() && base.dtype() == t.dtype();
+}
+
+using MigratedTensors =
+  std::unordered_map<c10::TensorImpl const*, at::Tensor>;
+
+// Makes the tensor on d for t, whose storage has been rebranded. A
+// tensor given more than once (e.g., tied weights), or the base of
+// several views, is migrated once, into done.
+at::Tensor const&
+make_migrated(at::Tensor const& t, c10::Device const& d, MigratedTensors& done)
+{
+  if (auto const it = done.find(t.unsafeGetTensorImpl()); it != done.end())
+    return it->second;
+
+  at::Tensor out;
+  if (is_tracked_view(t))
+  {
+    // The base shares t's storage, so it has been rebranded too.
+    auto const& base = make_migrated(t._base(), d, done);
+    out = base.as_strided(t.sizes(), t.strides(), t.storage_offset());
+  }
+  else if (t.requires_grad() && at::GradMode::is_enabled())
+    out = MigrateFunction::apply(t, d);
+  else
+    out = make_alias(t, d);
+  return done.emplace(t.unsafeGetTensorImpl(), std::move(out)).first->second;
+}
+
+}  // namespace
+
+at::Tensor lbannv2::migrate(at::Tensor& t, c10::Device const& d)
+{
+  auto const src_d = t.device();
+  LBANNV2_TRACE(
+    "migrate(ptr={}, from={}, to={})", t.data_ptr(), src_d.str(), d.str());
+
+  // Short-circuit
+  if (src_d == d)
+    return t;
+
+  if (coherent_memory_domain())
+    return migrate_many({t}, d).front();
+  trace_allocation_event(
+    TraceEvent::Migrate, t.storage().data(), t.storage().nbytes(), d);
+  return t.to(t.options().device(d));
+}
+
+namespace
+{
+
+// Migrates a batch with the domain, leaving the source devices to be
+// synchronized. Returns the devices (of the domain's type) that
+// tensors were migrated away from.
+std::vector<c10::Device>
+migrate_batch(lbannv2::CoherentMemoryDomain& domain,
+              at::TensorList const ts,
+              c10::Device const& d,
+              std::vector<at::Tensor>& out)
+{
+  // Check everything before migrating anything, so that a bad tensor
+  // leaves the whole batch where it was.
+  for (auto const& t : ts)
+  {
+    if (t.device() != d)
+      check_migratable(domain, t, d);
+  }
+
+  // Rebrand each storage once (views and tied weights share one), and
+  // note the devices whose streams must be synchronized.
+  std::unordered_set<c10::StorageImpl const*> rebranded;
+  std::vector<at::Tensor> owners;
+  std::vector<c10::Device> sources;
+  for (auto const& t : ts)
+  {
+    auto const src_d = t.device();
+    if (src_d == d)
+      continue;
+    if (rebranded.insert(t.storage().unsafeGetStorageImpl()).second)
     {
-      getDeviceCurrentStream(src_d.index()).synchronize();
+      rebrand_storage(domain, t, d);
+      owners.push_back(t);
     }
+    if (src_d.type() == domain.device_type()
+        && std::find(sources.cbegin(), sources.cend(), src_d)
+             == sources.cend())
+      sources.push_back(src_d);
+  }
+
+  // Views keep their own offsets and strides over the shared
+  // storage; those autograd tracks become views of their migrated
+  // base. If a tensor cannot be made (e.g., the view kernel is not
+  // available for d), the storage goes back where it was.
+  MigratedTensors migrated;
+  out.reserve(out.size() + ts.size());
+  try
+  {
+    for (auto const& t : ts)
+      out.push_back(t.device() == d ? t : make_migrated(t, d, migrated));
+  }
+  catch (...)
+  {
+    for (auto const& t : owners)
+      rebrand_storage(domain, t, t.device());
+    throw;
+  }
+
+  LBANNV2_TRACE("migrated {} storages from {} devices",
+                rebranded.size(),
+                sources.size());
+  return sources;
+}
+
+}  // namespace
 
+std::vector<at::Tensor> lbannv2::migrate_many(at::TensorList const ts,
+                                              c10::Device const& d)
+{
+  LBANNV2_TRACE("migrate_many(n={}, to={})", ts.size(), d.str());
+
+  std::vector<at::Tensor> out;
+  auto* const domain = coherent_memory_domain();
+  if (!domain)
+  {
+    out.reserve(ts.size());
+    for (auto t : ts)
+      out.push_back(migrate(t, d));
     return out;
   }
-#endif
-  return t.to(t.options().device(d));
+
+  // One synchronization per source stream, rather than per tensor.
+  for (auto const& src_d : migrate_batch(*domain, ts, d, out))
+    domain->synchronize(src_d);
+  return out;
+}
+
+bool lbannv2::MigrationHandle::ready() const
+{
+  return std::all_of(m_fences.cbegin(),
+                     m_fences.cend(),
+                     [](FencePtr const& fence) { return fence->query(); });
+}
+
+void lbannv2::MigrationHandle::wait() const
+{
+  for (auto const& fence : m_fences)
+    fence->wait();
+}
+
+void lbannv2::MigrationHandle::wait_on(c10::Stream const stream) const
+{
+  for (auto const& fence : m_fences)
+    fence->wait_on(stream);
+}
+
+std::pair<at::Tensor, lbannv2::MigrationHandle>
+lbannv2::migrate_async(at::Tensor& t, c10::Device const& d)
+{
+  auto [out, handle] = migrate_many_async({t}, d);
+  return {std::move(out.front()), std::move(handle)};
+}
+
+std::pair<std::vector<at::Tensor>, lbannv2::MigrationHandle>
+lbannv2::migrate_many_async(at::TensorList const ts, c10::Device const& d)
+{
+  LBANNV2_TRACE("migrate_many_async(n={}, to={})", ts.size(), d.str());
+
+  // Without a domain, migration is a (synchronous) copy.
+  auto* const domain = coherent_memory_domain();
+  if (!domain)
+    return {migrate_many(ts, d), MigrationHandle {}};
+
+  std::vector<at::Tensor> out;
+  std::vector<MigrationHandle::FencePtr> fences;
+  for (auto const& src_d : migrate_batch(*domain, ts, d, out))
+    fences.push_back(domain->record(src_d));
+  return {std::move(out), MigrationHandle {std::move(fences)}};
 }
@@ -8,8 +8,15 @@
 
 #include <lbannv2_config.h>
 
+#include <lbannv2/memory/coherent_memory.hpp>
+
 #include <ATen/Tensor.h>
 #include <c10/core/Device.h>
+#include <c10/core/Stream.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
 
 namespace lbannv2
 {
@@ -19,7 +26,9 @@ namespace lbannv2
  *
  *  If we have an APU (e.g., MI300A), we are able to zero-copy migrate
  *  the memory between the "cpu" backend and the "cuda" backend, under
- *  certain circumstances. The semantics differ from the "to" operator
+ *  certain circumstances. This goes through the coherent-memory
+ *  domain in use (see coherent_memory_domain()), which may also be
+ *  one emulated on the host. The semantics differ from the "to" operator
  *  in the sense that the original tensor is considered "invalid"
  *  (implicitly, of course) after the migration.
  *
@@ -37,11 +46,22 @@ namespace lbannv2
  *  of CPU tensors allocated using the LBANNv2 allocator, this will be
  *  whichever CUDA device was selected at the time of its allocation.
  *
- *  If we do not have an APU, this is just a direct call to "to".
+ *  If there is no coherent-memory domain, this is just a direct call
+ *  to "to".
  *
  *  Upon successful migration, the input tensor is invalidated to
  *  prevent foot wounds.
  *
+ *  The migrated tensor aliases the input: it has the same storage,
+ *  storage offset, sizes and strides, so views (strided slices,
+ *  transposes, offsets) migrate as views, without copies. It shares
+ *  the input's version counter, and if the input requires grad, the
+ *  migrated tensor gets a grad_fn that returns gradients to the
+ *  source device, as with "to". A view of a base that requires grad
+ *  becomes a view (as_strided) of the migrated base, so autograd sees
+ *  in-place writes through either; this needs the view kernels of
+ *  the target device.
+ *
  *  Schema: migrate(Tensor(a!), Device) -> Tensor(a!)
  *
  *  @param[in] t The tensor to (possibly) migrate.
@@ -51,4 +71,88 @@ namespace lbannv2
  */
 at::Tensor migrate(at::Tensor& t, c10::Device const& d);
 
+/** @brief Migrate several tensors to a new device at once.
+ *
+ *  This is migrate() for a batch, such as the parameters and buffers
+ *  of a model or an optimizer's state. Every tensor is checked before
+ *  any is migrated, so if one cannot be migrated, none is. Storage
+ *  shared between tensors (e.g., views) is rebranded once, and each
+ *  source device is synchronized once, after everything has been
+ *  rebranded, rather than once per tensor.
+ *
+ *  Tensors already on the target device are returned as they are. A
+ *  tensor given more than once is migrated to one tensor; distinct
+ *  views of one storage stay distinct views of the migrated storage,
+ *  and views of one base that requires grad are migrated as views
+ *  of a single migrated base.
+ *
+ *  @param[in] ts The tensors to (possibly) migrate.
+ *  @param[in] d The target device.
+ *
+ *  @returns The migrated tensors, in the order of ts.
+ *
+ *  @throws std::runtime_error if any tensor cannot be migrated.
+ */
+std::vector<at::Tensor> migrate_many(at::TensorList ts, c10::Device const& d);
+
+/** @class MigrationHandle
+ *  @brief The device work that tensors migrated without blocking must
+ *         wait for.
+ *
+ *  Migrating memory away from a device is only safe once the work
+ *  queued on the device before the migration has completed. The
+ *  asynchronous migrations record a fence on each source device's
+ *  current stream instead of synchronizing it; consumers of the
+ *  migrated tensors then wait for the handle, either on the host
+ *  (wait()) or on the stream that will use them (wait_on()).
+ *
+ *  A default-constructed handle has nothing to wait for.
+ */
+class LBANNV2_EXPORT MigrationHandle
+{
+public:
+  using FencePtr = std::shared_ptr<CoherentMemoryDomain::Fence>;
+
+  MigrationHandle() = default;
+  explicit MigrationHandle(std::vector<FencePtr> fences)
+    : m_fences {std::move(fences)}
+  {}
+
+  /** @brief Whether the work the migration depends on has completed. */
+  bool ready() const;
+
+  /** @brief Block the host until the migrated tensors can be used. */
+  void wait() const;
+
+  /** @brief Make later work on a stream wait until the migrated
+   *         tensors can be used, without blocking the host.
+   */
+  void wait_on(c10::Stream stream) const;
+
+private:
+  std::vector<FencePtr> m_fences;
+};  // class MigrationHandle
+
+/** @brief Migrate a tensor without blocking the host.
+ *
+ *  This is migrate(), except that a source device is not
+ *  synchronized: the returned handle must be waited on before the
+ *  migrated tensor is used.
+ *
+ *  @returns The migrated tensor and the handle to wait for.
+ */
+std::pair<at::Tensor, MigrationHandle> migrate_async(at::Tensor& t,
+                                                     c10::Device const& d);
+
+/** @brief Migrate several tensors without blocking the host.
+ *
+ *  This is migrate_many(), except that each source device gets a
+ *  fence in the returned handle instead of being synchronized.
+ *
+ *  @returns The migrated tensors, in the order of ts, and the handle
+ *           to wait for.
+ */
+std::pair<std::vector<at::Tensor>, MigrationHandle>
+migrate_many_async(at::TensorList ts, c10::Device const& d);
+
 }// namespace lbannv2
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/growable_allocator.hpp>
+#include <lbannv2/ops/resize.hpp>
+#include <lbannv2/utils/logging.hpp>
+
+#include <ATen/EmptyTensor.h>
+#include <c10/core/StorageImpl.h>
+#include <c10/core/TensorImpl.h>
+
+namespace
+{
+
+// Grow the storage's memory and, if it moved, swap in a DataPtr for
+// the new address.
+void grow_storage(c10::StorageImpl& storage, size_t const nbytes)
+{
+  auto& alloc = lbannv2::GrowableAllocator::instance();
+  auto& data_ptr = storage.mutable_data_ptr();
+  void* const old_ptr = data_ptr.get();
+  c10::Device const device = data_ptr.device();
+
+  void* const new_ptr = alloc.grow(old_ptr, nbytes);
+  if (new_ptr != old_ptr)
+  {
+    // The old DataPtr must not free the memory that moved.
+    (void) data_ptr.release_context();
+    storage.set_data_ptr_noswap(
+      c10::DataPtr {new_ptr, new_ptr, alloc.raw_deleter(), device});
+  }
+  storage.set_nbytes(nbytes);
+
+  LBANNV2_TRACE("resize_: grew storage (old={}, new={}, nbytes={})",
+                old_ptr,
+                new_ptr,
+                nbytes);
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+at::Tensor const& resize_(at::Tensor const& self,
+                          at::IntArrayRef const sizes,
+                          std::optional<c10::MemoryFormat> memory_format)
+{
+  auto* const impl = self.unsafeGetTensorImpl();
+  if (impl->has_storage())
+  {
+    auto& storage = *impl->storage().unsafeGetStorageImpl();
+    auto const& data_ptr = storage.data_ptr();
+    if (data_ptr.get() && storage.resizable()
+        && data_ptr.get_deleter()
+             == GrowableAllocator::instance().raw_deleter())
+    {
+      at::detail::check_size_nonnegative(sizes);
+      size_t const nbytes = at::detail::computeStorageNbytesContiguous(
+        sizes, self.dtype().itemsize(), self.storage_offset());
+      if (nbytes > storage.nbytes())
+        grow_storage(storage, nbytes);
+    }
+  }
+  return self.resize_(sizes, memory_format);
+}
+
+}  // namespace lbannv2
@@ -0,0 +1,37 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <ATen/Tensor.h>
+#include <c10/core/MemoryFormat.h>
+#include <c10/util/ArrayRef.h>
+
+#include <optional>
+
+namespace lbannv2
+{
+
+/** @brief Resize a tensor as Tensor::resize_() does, growing storage
+ *         from the GrowableAllocator in place.
+ *
+ *  The native kernel grows a storage by allocating a new one and
+ *  copying. When the storage came from the GrowableAllocator, it is
+ *  instead grown with GrowableAllocator::grow() before resize_()
+ *  runs, which then finds it big enough. Other tensors are resized
+ *  as usual.
+ *
+ *  This is not registered as the aten::resize_ kernel, so only its
+ *  callers (including lbannv2.resize_ in Python) grow in place.
+ */
+LBANNV2_EXPORT at::Tensor const&
+resize_(at::Tensor const& self,
+        at::IntArrayRef size,
+        std::optional<c10::MemoryFormat> memory_format = std::nullopt);
+
+}  // namespace lbannv2
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/ops/zeros.hpp>
+#include <lbannv2/utils/logging.hpp>
+
+#include <ATen/EmptyTensor.h>
+#include <ATen/ops/empty.h>
+#include <c10/core/CPUAllocator.h>
+#include <c10/core/DefaultDtype.h>
+#include <c10/core/Storage.h>
+#include <c10/core/TensorImpl.h>
+#include <torch/library.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+bool get_env_elision()
+{
+  char const* const env = std::getenv("LBANNV2_ZERO_FILL_ELISION");
+  return !env || std::strcmp(env, "0") != 0;
+}
+
+std::atomic<bool>& elision_flag() noexcept
+{
+  static std::atomic<bool> flag {get_env_elision()};
+  return flag;
+}
+
+}  // namespace
+
+namespace lbannv2
+{
+
+at::Tensor zeros_cpu(c10::SymIntArrayRef const size,
+                     std::optional<c10::ScalarType> const dtype,
+                     std::optional<c10::Layout> const layout,
+                     std::optional<c10::Device> const device,
+                     std::optional<bool> const pin_memory)
+{
+  // new_zeros dispatches on self, so a CPU tensor can ask for zeros on
+  // another device.
+  auto* const alloc = dynamic_cast<Allocator*>(c10::GetCPUAllocator());
+  if (!alloc || !zero_fill_elision_enabled()
+      || (device && !device->is_cpu())
+      || layout.value_or(c10::kStrided) != c10::kStrided
+      || pin_memory.value_or(false))
+  {
+    // Not at::zeros; that would come right back here.
+    return at::empty_symint(size, dtype, layout, device, pin_memory, {})
+      .zero_();
+  }
+
+  auto const sizes = c10::asIntArrayRefSlow(size);
+  at::detail::check_size_nonnegative(sizes);
+  auto const dt = c10::scalarTypeToTypeMeta(
+    dtype.value_or(c10::get_default_dtype_as_scalartype()));
+  size_t const nbytes =
+    at::detail::computeStorageNbytesContiguous(sizes, dt.itemsize());
+
+  LBANNV2_TRACE("zeros_cpu(nbytes={})", nbytes);
+
+  // This mirrors at::detail::empty_generic, except for the allocation.
+  c10::Storage storage(c10::Storage::use_byte_size_t {},
+                       nbytes,
+                       alloc->allocate_zeroed(nbytes),
+                       alloc,
+                       /*resizable=*/true);
+  auto out = at::detail::make_tensor<at::TensorImpl>(
+    std::move(storage), c10::DispatchKeySet(c10::DispatchKey::CPU), dt);
+  out.unsafeGetTensorImpl()->set_sizes_contiguous(sizes);
+  return out;
+}
+
+at::Tensor new_zeros_cpu(at::Tensor const& self,
+                         c10::SymIntArrayRef const size,
+                         std::optional<c10::ScalarType> const dtype,
+                         std::optional<c10::Layout> const layout,
+                         std::optional<c10::Device> const device,
+                         std::optional<bool> const pin_memory)
+{
+  return zeros_cpu(size,
+                   dtype.value_or(self.scalar_type()),
+                   layout.value_or(self.layout()),
+                   device.value_or(self.device()),
+                   pin_memory);
+}
+
+void set_zero_fill_elision(bool const enable) noexcept
+{
+  elision_flag().store(enable, std::memory_order_relaxed);
+}
+
+bool zero_fill_elision_enabled() noexcept
+{
+  return elision_flag().load(std::memory_order_relaxed);
+}
+
+void register_zero_fill_ops(torch::Library& m)
+{
+  m.impl("zeros", TORCH_FN(zeros_cpu));
+  m.impl("new_zeros", TORCH_FN(new_zeros_cpu));
+}
+
+}  // namespace lbannv2
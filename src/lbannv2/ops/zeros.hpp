@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <ATen/Tensor.h>
+#include <c10/core/Device.h>
+#include <c10/core/Layout.h>
+#include <c10/core/ScalarType.h>
+#include <c10/core/SymIntArrayRef.h>
+
+#include <optional>
+
+namespace torch
+{
+class Library;
+}  // namespace torch
+
+namespace lbannv2
+{
+
+/** @brief Create a zero-filled CPU tensor, skipping the memset when
+ *         the allocator knows the memory to be zero.
+ *
+ *  If the current CPU allocator is an LBANNv2 Allocator, the storage
+ *  comes from Allocator::allocate_zeroed(), which hands out fresh
+ *  mappings (or scrubbed cache blocks) as they are. Otherwise, or for
+ *  pinned or non-strided requests, this is at::empty() followed by
+ *  zero_().
+ *
+ *  Schema: zeros(SymInt[] size, *, ScalarType? dtype=None,
+ *                Layout? layout=None, Device? device=None,
+ *                bool? pin_memory=None) -> Tensor
+ */
+LBANNV2_EXPORT at::Tensor zeros_cpu(c10::SymIntArrayRef size,
+                                    std::optional<c10::ScalarType> dtype,
+                                    std::optional<c10::Layout> layout,
+                                    std::optional<c10::Device> device,
+                                    std::optional<bool> pin_memory);
+
+/** @brief Like zeros_cpu(), with the options defaulting to self's.
+ *
+ *  Schema: new_zeros(Tensor self, SymInt[] size, *,
+ *                    ScalarType? dtype=None, Layout? layout=None,
+ *                    Device? device=None, bool? pin_memory=None)
+ *            -> Tensor
+ */
+LBANNV2_EXPORT at::Tensor new_zeros_cpu(at::Tensor const& self,
+                                        c10::SymIntArrayRef size,
+                                        std::optional<c10::ScalarType> dtype,
+                                        std::optional<c10::Layout> layout,
+                                        std::optional<c10::Device> device,
+                                        std::optional<bool> pin_memory);
+
+/** @brief Enable or disable zero-fill elision in zeros_cpu().
+ *
+ *  It is enabled by default; set LBANNV2_ZERO_FILL_ELISION=0 to
+ *  disable it at startup.
+ */
+LBANNV2_EXPORT void set_zero_fill_elision(bool enable) noexcept;
+
+LBANNV2_EXPORT bool zero_fill_elision_enabled() noexcept;
+
+/** @brief Register zeros_cpu() and new_zeros_cpu() as the CPU kernels
+ *         of aten::zeros and aten::new_zeros.
+ *
+ *  @param[in] m An implementation library for aten on CPU.
+ */
+LBANNV2_EXPORT void register_zero_fill_ops(torch::Library& m);
+
+}  // namespace lbannv2
@@ -6,6 +6,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include <lbannv2_config.h>
 
+#include <lbannv2/memory/allocation_trace.hpp>
+#include <lbannv2/memory/policy_allocator.hpp>
 #include <lbannv2/utils/gpu_utils.hpp>
 #include <lbannv2/utils/logging.hpp>
 
@@ -36,6 +38,13 @@ void init_lbannv2()
     while (wait) {}
   }
 
+  if (char const* const path = std::getenv("LBANNV2_ALLOC_TRACE"))
+    lbannv2::AllocationTracer::instance().start(path);
+
+  // e.g., LBANNV2_HOST_ALLOCATOR=tracking,limit=64G,caching,hugepage
+  if (char const* const spec = std::getenv("LBANNV2_HOST_ALLOCATOR"))
+    lbannv2::use_host_allocator_spec(spec);
+
 #if LBANNV2_HAS_GPU
   if (!_lbannv2_gpu_initialized)
   {
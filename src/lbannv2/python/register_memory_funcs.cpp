@@ -6,9 +6,26 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include <lbannv2_config.h>
 
+#include <lbannv2/memory/allocation_trace.hpp>
+#include <lbannv2/memory/arena_allocator.hpp>
+#include <lbannv2/memory/caching_host_allocator.hpp>
+#include <lbannv2/memory/coherent_memory.hpp>
+#include <lbannv2/memory/deferred_free.hpp>
+#include <lbannv2/memory/external_allocator.hpp>
+#include <lbannv2/memory/growable_allocator.hpp>
+#include <lbannv2/memory/huge_page_allocator.hpp>
+#include <lbannv2/memory/memory_budget.hpp>
 #include <lbannv2/memory/memory_utils.hpp>
+#include <lbannv2/memory/mmap_file_allocator.hpp>
+#include <lbannv2/memory/numa_allocator.hpp>
+#include <lbannv2/memory/policy_allocator.hpp>
 #include <lbannv2/memory/registry.hpp>
+#include <lbannv2/memory/shm_allocator.hpp>
+#include <lbannv2/memory/slab_allocator.hpp>
+#include <lbannv2/ops/from_external.hpp>
 #include <lbannv2/ops/migrate.hpp>
+#include <lbannv2/ops/resize.hpp>
+#include <lbannv2/ops/zeros.hpp>
 #include <lbannv2/utils/logging.hpp>
 
 #if LBANNV2_HAS_GPU
@@ -18,12 +35,23 @@
 #include <lbannv2/memory/allocator.hpp>
 
 #include <ATen/ops/to_native.h>
+#include <c10/core/CPUAllocator.h>
 #include <c10/core/Device.h>
 #include <pybind11/pybind11.h>
 #include <torch/csrc/utils/pybind.h>
 #include <torch/extension.h>
 #include <torch/library.h>
 
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
 namespace
 {
 
@@ -33,15 +61,34 @@ at::Tensor py_migrate(at::Tensor& t, at::Device const& d)
   return lbannv2::migrate(t, d);
 }
 
+std::vector<at::Tensor> py_migrate_many(std::vector<at::Tensor> const& ts,
+                                        at::Device const& d)
+{
+  return lbannv2::migrate_many(ts, d);
+}
+
+std::tuple<at::Tensor, lbannv2::MigrationHandle>
+py_migrate_async(at::Tensor& t, at::Device const& d)
+{
+  return lbannv2::migrate_async(t, d);
+}
+
+std::tuple<std::vector<at::Tensor>, lbannv2::MigrationHandle>
+py_migrate_many_async(std::vector<at::Tensor> const& ts, at::Device const& d)
+{
+  return lbannv2::migrate_many_async(ts, d);
+}
+
+void py_emulated_device_sleep(at::Device const& d, double const seconds)
+{
+  lbannv2::EmulatedCoherentMemory::instance().stream(d).enqueue([seconds] {
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  });
+}
+
 bool py_supports_migrate() noexcept
 {
-#if LBANNV2_WITH_MI300A
-  return true;
-#elif LBANNV2_HAS_GPU
-  return lbannv2::gpu::is_integrated();
-#else
-  return false;
-#endif
+  return lbannv2::coherent_memory_domain() != nullptr;
 }
 
 void py_use_mi300a_host_allocator()
@@ -49,14 +96,533 @@ void py_use_mi300a_host_allocator()
   lbannv2::use_mi300a_cpu_allocator();
 }
 
+void py_use_coherent_host_allocator()
+{
+  lbannv2::use_coherent_host_allocator();
+}
+
+std::string py_coherent_memory_domain_name()
+{
+  auto const* const domain = lbannv2::coherent_memory_domain();
+  return domain ? domain->name() : "none";
+}
+
+void py_use_emulated_coherent_memory(
+  std::optional<c10::DeviceIndex> const device)
+{
+  auto& domain = lbannv2::EmulatedCoherentMemory::instance();
+  if (device)
+    domain.set_current_device(*device);
+  lbannv2::set_coherent_memory_domain(&domain);
+}
+
+pybind11::dict py_emulated_coherent_memory_stats()
+{
+  auto const stats = lbannv2::EmulatedCoherentMemory::instance().stats();
+  pybind11::dict out;
+  out["num_allocations"] = stats.num_allocations;
+  out["num_to_device"] = stats.num_to_device;
+  out["num_to_host"] = stats.num_to_host;
+  out["num_synchronizations"] = stats.num_synchronizations;
+  out["num_deferred_frees"] = stats.num_deferred_frees;
+  return out;
+}
+
+void py_use_caching_host_allocator()
+{
+  lbannv2::use_caching_host_allocator();
+}
+
+void py_empty_host_cache()
+{
+  lbannv2::CachingHostAllocator::instance().empty_cache();
+}
+
+pybind11::dict py_host_cache_stats()
+{
+  auto const stats = lbannv2::CachingHostAllocator::instance().stats();
+  pybind11::dict out;
+  out["reserved_bytes"] = stats.reserved_bytes;
+  out["allocated_bytes"] = stats.allocated_bytes;
+  out["num_segments"] = stats.num_segments;
+  out["cache_hits"] = stats.cache_hits;
+  out["cache_misses"] = stats.cache_misses;
+  out["zero_filled_bytes"] = stats.zero_filled_bytes;
+  out["zero_fill_elided_bytes"] = stats.zero_fill_elided_bytes;
+  out["scrubbed_bytes"] = stats.scrubbed_bytes;
+  return out;
+}
+
+void py_set_host_cache_scrubbing(bool const enable)
+{
+  lbannv2::CachingHostAllocator::instance().set_scrubbing(enable);
+}
+
+void py_use_huge_page_host_allocator(std::optional<size_t> const threshold)
+{
+  if (threshold)
+    lbannv2::HugePageAllocator::instance().set_threshold(*threshold);
+  lbannv2::use_huge_page_host_allocator();
+}
+
+pybind11::dict py_huge_page_stats()
+{
+  auto const stats = lbannv2::HugePageAllocator::instance().stats();
+  pybind11::dict out;
+  out["threshold"] = lbannv2::HugePageAllocator::instance().threshold();
+  out["small_bytes"] = stats.small_bytes;
+  out["mapped_bytes"] = stats.mapped_bytes;
+  out["hugetlb_bytes"] = stats.hugetlb_bytes;
+  out["huge_backed_bytes"] = stats.huge_backed_bytes;
+  return out;
+}
+
+void py_use_numa_host_allocator()
+{
+  lbannv2::use_numa_host_allocator();
+}
+
+using PyNumaPlacement = std::tuple<std::string, int>;
+
+PyNumaPlacement to_py(lbannv2::NumaPlacement const& p)
+{
+  switch (p.policy)
+  {
+  case lbannv2::NumaPlacement::Policy::Local:
+    return {"local", p.node};
+  case lbannv2::NumaPlacement::Policy::Interleave:
+    return {"interleave", p.node};
+  case lbannv2::NumaPlacement::Policy::Bind:
+    return {"bind", p.node};
+  }
+  throw std::runtime_error("Unknown NUMA policy");
+}
+
+PyNumaPlacement py_get_numa_placement()
+{
+  return to_py(lbannv2::NumaAllocator::instance().placement());
+}
+
+PyNumaPlacement py_set_numa_placement(std::string const& policy,
+                                      int const node)
+{
+  using Policy = lbannv2::NumaPlacement::Policy;
+  lbannv2::NumaPlacement p {Policy::Local, node};
+  if (policy == "interleave")
+    p.policy = Policy::Interleave;
+  else if (policy == "bind")
+    p.policy = Policy::Bind;
+  else if (policy != "local")
+    throw std::runtime_error("Unknown NUMA policy \"" + policy + "\"");
+  return to_py(lbannv2::NumaAllocator::instance().set_placement(p));
+}
+
+pybind11::dict py_numa_stats()
+{
+  auto const& alloc = lbannv2::NumaAllocator::instance();
+  pybind11::dict out;
+  out["nodes"] = alloc.nodes();
+  out["bytes_by_node"] = alloc.bytes_by_node();
+  return out;
+}
+
+void py_use_arena_host_allocator()
+{
+  lbannv2::use_arena_host_allocator();
+}
+
+void py_begin_arena_scope()
+{
+  lbannv2::ArenaAllocator::instance().begin_scope();
+}
+
+size_t py_end_arena_scope()
+{
+  return lbannv2::ArenaAllocator::instance().end_scope();
+}
+
+pybind11::dict py_arena_stats()
+{
+  auto const stats = lbannv2::ArenaAllocator::instance().stats();
+  pybind11::dict out;
+  out["reserved_bytes"] = stats.reserved_bytes;
+  out["num_chunks"] = stats.num_chunks;
+  out["used_bytes"] = stats.used_bytes;
+  out["peak_used_bytes"] = stats.peak_used_bytes;
+  out["live_allocations"] = stats.live_allocations;
+  out["total_outliving"] = stats.total_outliving;
+  return out;
+}
+
+void py_use_slab_host_allocator()
+{
+  lbannv2::use_slab_host_allocator();
+}
+
+size_t py_release_slab_cache()
+{
+  return lbannv2::SlabAllocator::instance().release_cached();
+}
+
+pybind11::dict py_slab_stats()
+{
+  auto& alloc = lbannv2::SlabAllocator::instance();
+  auto const stats = alloc.stats();
+  pybind11::dict out;
+  out["max_size"] = alloc.max_size();
+  out["num_slabs"] = stats.num_slabs;
+  out["empty_slabs"] = stats.empty_slabs;
+  out["live_slots"] = stats.live_slots;
+  out["live_bytes"] = stats.live_bytes;
+  out["cached_slots"] = stats.cached_slots;
+  out["large_allocations"] = stats.large_allocations;
+  return out;
+}
+
+void py_use_growable_host_allocator(std::optional<size_t> const reserve)
+{
+  if (reserve)
+    lbannv2::GrowableAllocator::instance().set_reserve_size(*reserve);
+  lbannv2::use_growable_host_allocator();
+}
+
+at::Tensor py_resize_(at::Tensor const& t, std::vector<int64_t> const& size)
+{
+  return lbannv2::resize_(t, size);
+}
+
+pybind11::dict py_growable_stats()
+{
+  auto const stats = lbannv2::GrowableAllocator::instance().stats();
+  pybind11::dict out;
+  out["reserved_bytes"] = stats.reserved_bytes;
+  out["committed_bytes"] = stats.committed_bytes;
+  out["num_allocations"] = stats.num_allocations;
+  out["num_grown_in_place"] = stats.num_grown_in_place;
+  out["num_remapped"] = stats.num_remapped;
+  return out;
+}
+
+// External memory
+
+// Tensors may be freed on threads that do not hold the GIL (e.g., by
+// the DeferredFree worker or a DataLoader thread).
+template <typename T>
+std::shared_ptr<void const> keep_alive(T&& obj)
+{
+  return std::shared_ptr<void const>(
+    new std::decay_t<T>(std::forward<T>(obj)), [](void const* p) {
+      pybind11::gil_scoped_acquire gil;
+      delete static_cast<std::decay_t<T> const*>(p);
+    });
+}
+
+at::Tensor py_wrap_external(std::uintptr_t const ptr,
+                            int64_t const nbytes,
+                            pybind11::object owner,
+                            at::Device const& device)
+{
+  return lbannv2::from_external(reinterpret_cast<void*>(ptr),
+                                {nbytes},
+                                std::nullopt,
+                                keep_alive(std::move(owner)),
+                                at::TensorOptions {}
+                                  .dtype(at::kByte)
+                                  .device(device));
+}
+
+at::Tensor py_wrap_buffer(pybind11::buffer const& buf)
+{
+  // The tensor is writable, so the buffer must be, too; read-only
+  // exporters (e.g., bytes) raise BufferError here.
+  auto info = buf.request(/*writable=*/true);
+  // Nothing to wrap (and the pointer may well be null).
+  if (info.size == 0)
+    return at::empty({0}, at::TensorOptions {}.dtype(at::kByte));
+  // Only C-contiguous buffers are flattened to bytes.
+  auto expected = info.itemsize;
+  for (auto i = info.ndim; i > 0; --i)
+  {
+    if (info.shape[i - 1] > 1 && info.strides[i - 1] != expected)
+      throw std::runtime_error("wrap_buffer: buffer is not contiguous");
+    expected *= info.shape[i - 1];
+  }
+  void* const ptr = info.ptr;
+  int64_t const nbytes = info.size * info.itemsize;
+  // The buffer_info holds the exporter's buffer (and the exporter).
+  return lbannv2::from_external(ptr,
+                                {nbytes},
+                                std::nullopt,
+                                keep_alive(std::move(info)),
+                                at::TensorOptions {}.dtype(at::kByte));
+}
+
+pybind11::dict py_external_stats()
+{
+  auto const stats = lbannv2::ExternalAllocator::instance().stats();
+  pybind11::dict out;
+  out["registered_bytes"] = stats.registered_bytes;
+  out["num_ranges"] = stats.num_ranges;
+  return out;
+}
+
+// Shared memory
+void py_use_shm_host_allocator(std::optional<size_t> const segment_size)
+{
+  if (segment_size)
+    lbannv2::ShmAllocator::instance().set_segment_size(*segment_size);
+  lbannv2::use_shm_host_allocator();
+}
+
+std::tuple<std::string, size_t, size_t> py_shm_share(torch::Tensor const& t)
+{
+  auto const handle =
+    lbannv2::ShmAllocator::instance().share(t.storage().data());
+  return {handle.segment, handle.offset, handle.size};
+}
+
+at::Tensor py_shm_open(std::string segment, size_t offset, size_t size)
+{
+  auto data_ptr = lbannv2::ShmAllocator::instance().open(
+    {std::move(segment), offset, size});
+  c10::Storage storage {c10::Storage::use_byte_size_t {},
+                        size,
+                        std::move(data_ptr),
+                        /*allocator=*/nullptr,
+                        /*resizable=*/false};
+  return at::empty({0}, at::TensorOptions {}.dtype(at::kByte))
+    .set_(std::move(storage));
+}
+
+pybind11::dict py_shm_stats()
+{
+  auto& alloc = lbannv2::ShmAllocator::instance();
+  auto const stats = alloc.stats();
+  pybind11::dict out;
+  out["segment"] = alloc.segment_name();
+  out["segment_size"] = stats.segment_size;
+  out["carved_bytes"] = stats.carved_bytes;
+  out["live_blocks"] = stats.live_blocks;
+  out["foreign_segments"] = stats.foreign_segments;
+  return out;
+}
+
+void py_use_mmap_file_host_allocator(
+  std::optional<std::string> const& directory)
+{
+  if (directory)
+    lbannv2::MmapFileAllocator::instance().set_directory(*directory);
+  lbannv2::use_mmap_file_host_allocator();
+}
+
+void py_mmap_advise(torch::Tensor const& t, std::string const& advice)
+{
+  using Advice = lbannv2::MmapFileAllocator::Advice;
+  Advice a;
+  if (advice == "normal")
+    a = Advice::Normal;
+  else if (advice == "random")
+    a = Advice::Random;
+  else if (advice == "sequential")
+    a = Advice::Sequential;
+  else if (advice == "willneed")
+    a = Advice::WillNeed;
+  else if (advice == "dontneed")
+    a = Advice::DontNeed;
+  else
+    throw std::runtime_error("Unknown madvise advice \"" + advice + "\"");
+  lbannv2::MmapFileAllocator::instance().advise(
+    t.const_data_ptr(), t.nbytes(), a);
+}
+
 void py_use_torch_host_allocator()
 {
   lbannv2::use_torch_cpu_allocator();
 }
 
+// The CPU allocator in use, as an opaque handle for
+// py_restore_host_allocator(), so that context managers nest.
+constexpr char const* host_allocator_handle = "lbannv2.HostAllocator";
+
+pybind11::capsule py_current_host_allocator()
+{
+  return pybind11::capsule(c10::GetCPUAllocator(), host_allocator_handle);
+}
+
+void py_restore_host_allocator(pybind11::capsule const& handle)
+{
+  char const* const name = handle.name();
+  if (!name || std::strcmp(name, host_allocator_handle) != 0)
+    throw std::runtime_error("Not a handle from current_host_allocator");
+  lbannv2::use_cpu_allocator(*handle.get_pointer<c10::Allocator>());
+}
+
 bool py_using_lbannv2_memory(torch::Tensor const& t)
 {
-  return lbannv2::pointer_registry().known(t.const_data_ptr());
+  return lbannv2::allocation_header(t.storage().data_ptr())
+         || lbannv2::pointer_registry().known(t.const_data_ptr());
+}
+
+pybind11::dict to_dict(lbannv2::MemoryStats const& stats)
+{
+  pybind11::dict out;
+  out["current_bytes"] = stats.current_bytes;
+  out["peak_bytes"] = stats.peak_bytes;
+  out["current_allocations"] = stats.current_allocations;
+  out["total_allocations"] = stats.total_allocations;
+  out["total_frees"] = stats.total_frees;
+  return out;
+}
+
+// Allocators are keyed by address since c10::Allocator has no name.
+pybind11::dict py_memory_stats()
+{
+  auto const stats = lbannv2::pointer_registry().stats();
+
+  pybind11::dict by_allocator;
+  for (auto const& [alloc, alloc_stats] : stats.by_allocator)
+    by_allocator[pybind11::int_(reinterpret_cast<std::uintptr_t>(alloc))] =
+      to_dict(alloc_stats);
+
+  pybind11::dict by_device;
+  for (auto const& [device, device_stats] : stats.by_device)
+    by_device[pybind11::str(device.str())] = to_dict(device_stats);
+
+  auto out = to_dict(stats.total);
+  out["by_allocator"] = by_allocator;
+  out["by_device"] = by_device;
+  return out;
+}
+
+void py_use_host_allocator_spec(std::string const& spec)
+{
+  lbannv2::use_host_allocator_spec(spec);
+}
+
+lbannv2::PolicyAllocatorBase& get_policy_allocator()
+{
+  auto* const alloc = lbannv2::current_policy_allocator();
+  if (!alloc)
+    throw std::runtime_error("No host allocator spec is in use");
+  return *alloc;
+}
+
+pybind11::dict py_host_allocator_stats()
+{
+  auto const stats = get_policy_allocator().stats();
+  pybind11::dict out;
+  if (stats.tracked)
+    out = to_dict(*stats.tracked);
+  out["cached_bytes"] = stats.cached_bytes;
+  out["limit"] = stats.limit;
+  return out;
+}
+
+void py_release_host_allocator_cache()
+{
+  get_policy_allocator().release_cached();
+}
+
+void py_set_memory_limits(size_t const soft, size_t const hard)
+{
+  lbannv2::memory_budget().set_limits(soft, hard);
+}
+
+std::tuple<size_t, size_t> py_memory_limits()
+{
+  auto const& budget = lbannv2::memory_budget();
+  return {budget.soft_limit(), budget.hard_limit()};
+}
+
+std::optional<size_t> py_cgroup_memory_limit()
+{
+  return lbannv2::cgroup_memory_limit();
+}
+
+// Reclaimers may run on threads that do not hold the GIL, and are
+// copied when they run, so the Python callable is shared rather than
+// copied.
+size_t py_add_memory_reclaimer(pybind11::function const& fn)
+{
+  using Pressure = lbannv2::MemoryBudget::Pressure;
+  std::shared_ptr<pybind11::function> const callable(
+    new pybind11::function(fn), [](pybind11::function* f) {
+      pybind11::gil_scoped_acquire gil;
+      delete f;
+    });
+
+  return lbannv2::memory_budget().add_reclaimer(
+    [callable](Pressure const pressure, size_t const nbytes) -> size_t {
+      char const* const name = pressure == Pressure::Soft   ? "soft"
+                               : pressure == Pressure::Hard ? "hard"
+                                                            : "failed";
+      pybind11::gil_scoped_acquire gil;
+      auto const freed = (*callable)(name, nbytes);
+      return freed.is_none() ? 0UL : freed.cast<size_t>();
+    });
+}
+
+void py_remove_memory_reclaimer(size_t const handle)
+{
+  lbannv2::memory_budget().remove_reclaimer(handle);
+}
+
+void py_start_allocation_trace(std::string const& path)
+{
+  lbannv2::AllocationTracer::instance().start(path);
+}
+
+void py_stop_allocation_trace()
+{
+  lbannv2::AllocationTracer::instance().stop();
+}
+
+void py_flush_allocation_trace()
+{
+  lbannv2::AllocationTracer::instance().flush();
+}
+
+void py_set_deferred_free_threshold(size_t const nbytes)
+{
+  lbannv2::DeferredFree::instance().set_threshold(nbytes);
+}
+
+size_t py_drain_deferred_frees()
+{
+  return lbannv2::DeferredFree::instance().drain();
+}
+
+pybind11::dict py_deferred_free_stats()
+{
+  auto& queue = lbannv2::DeferredFree::instance();
+  auto const stats = queue.stats();
+  pybind11::dict out;
+  out["threshold"] = queue.threshold();
+  out["queue_depth"] = stats.queue_depth;
+  out["max_queue_depth"] = stats.max_queue_depth;
+  out["pending_bytes"] = stats.pending_bytes;
+  out["num_deferred"] = stats.num_deferred;
+  out["num_released"] = stats.num_released;
+  out["num_drains"] = stats.num_drains;
+  out["total_latency_ns"] = stats.total_latency_ns;
+  out["max_latency_ns"] = stats.max_latency_ns;
+  return out;
+}
+
+void py_set_zero_fill_elision(bool const enable)
+{
+  lbannv2::set_zero_fill_elision(enable);
+}
+
+bool py_zero_fill_elision_enabled()
+{
+  return lbannv2::zero_fill_elision_enabled();
+}
+
+size_t py_reclaim_memory(size_t const nbytes)
+{
+  return lbannv2::memory_budget().reclaim(
+    lbannv2::MemoryBudget::Pressure::Soft, nbytes);
 }
 
 }  // namespace
@@ -75,18 +641,333 @@ void add_memory_funcs(pybind11::module_& m)
         &py_migrate,
         "Try to migrate an LBANNv2-owned pointer to a new device.");
 
+  m.def("migrate_many",
+        &py_migrate_many,
+        "Migrate a list of tensors to a new device, synchronizing each "
+        "source device once.");
+
+  pybind11::class_<lbannv2::MigrationHandle>(
+    m,
+    "MigrationHandle",
+    "The device work that tensors migrated without blocking must wait for")
+    .def("ready",
+         &lbannv2::MigrationHandle::ready,
+         "Whether the migrated tensors can be used")
+    .def("wait",
+         &lbannv2::MigrationHandle::wait,
+         pybind11::call_guard<pybind11::gil_scoped_release>(),
+         "Block until the migrated tensors can be used")
+    .def("wait_on",
+         &lbannv2::MigrationHandle::wait_on,
+         pybind11::arg("stream"),
+         "Make later work on the stream wait until the migrated tensors "
+         "can be used");
+
+  m.def("migrate_async",
+        &py_migrate_async,
+        "Migrate a tensor without blocking; returns the tensor and a "
+        "MigrationHandle to wait on before using it.");
+
+  m.def("migrate_many_async",
+        &py_migrate_many_async,
+        "Migrate a list of tensors without blocking; returns the tensors "
+        "and a MigrationHandle to wait on before using them.");
+
   m.def("use_mi300a_host_allocator",
         &py_use_mi300a_host_allocator,
         "Use the LBANNv2 MI300A allocator for CPU allocations");
 
+  m.def("use_coherent_host_allocator",
+        &py_use_coherent_host_allocator,
+        "Use the coherent-memory domain's allocator for CPU allocations");
+
+  m.def("coherent_memory_domain",
+        &py_coherent_memory_domain_name,
+        "Get the name of the coherent-memory domain in use");
+
+  m.def("use_emulated_coherent_memory",
+        &py_use_emulated_coherent_memory,
+        pybind11::arg("device") = pybind11::none(),
+        "Migrate through a coherent-memory domain emulated on the host, "
+        "optionally setting its current device");
+
+  m.def("emulated_device_sleep",
+        &py_emulated_device_sleep,
+        pybind11::arg("device"),
+        pybind11::arg("seconds"),
+        "Queue work that sleeps on an emulated device's stream, standing "
+        "in for a kernel");
+
+  m.def("emulated_coherent_memory_stats",
+        &py_emulated_coherent_memory_stats,
+        "Get the emulated coherent-memory domain's statistics");
+
+  m.def("use_caching_host_allocator",
+        &py_use_caching_host_allocator,
+        "Use the LBANNv2 caching allocator for CPU allocations");
+
+  m.def("empty_host_cache",
+        &py_empty_host_cache,
+        "Release unused memory held by the LBANNv2 caching host allocator");
+
+  m.def("host_cache_stats",
+        &py_host_cache_stats,
+        "Get the LBANNv2 caching host allocator's statistics");
+
+  m.def("set_host_cache_scrubbing",
+        &py_set_host_cache_scrubbing,
+        "Start or stop zeroing free blocks of the LBANNv2 caching host "
+        "allocator in the background");
+
+  m.def("use_huge_page_host_allocator",
+        &py_use_huge_page_host_allocator,
+        pybind11::arg("threshold") = pybind11::none(),
+        "Use the LBANNv2 huge page allocator for CPU allocations, "
+        "optionally setting the size (in bytes) above which huge pages "
+        "are used");
+
+  m.def("huge_page_stats",
+        &py_huge_page_stats,
+        "Get the LBANNv2 huge page allocator's statistics");
+
+  m.def("use_numa_host_allocator",
+        &py_use_numa_host_allocator,
+        "Use the LBANNv2 NUMA-aware allocator for CPU allocations");
+
+  m.def("get_numa_placement",
+        &py_get_numa_placement,
+        "Get the NUMA placement (policy, node) for new allocations");
+
+  m.def("set_numa_placement",
+        &py_set_numa_placement,
+        pybind11::arg("policy"),
+        pybind11::arg("node") = -1,
+        "Set the NUMA placement for new allocations: \"local\", "
+        "\"interleave\" or \"bind\" (to the given node). Returns the "
+        "previous placement.");
+
+  m.def("numa_stats",
+        &py_numa_stats,
+        "Get the online NUMA nodes and the bytes allocated on each");
+
+  m.def("use_arena_host_allocator",
+        &py_use_arena_host_allocator,
+        "Use the LBANNv2 arena allocator for CPU allocations");
+
+  m.def("begin_arena_scope",
+        &py_begin_arena_scope,
+        "Open a (possibly nested) LBANNv2 arena scope");
+
+  m.def("end_arena_scope",
+        &py_end_arena_scope,
+        "Close an LBANNv2 arena scope, resetting the arena if it is the "
+        "outermost one. Returns the number of allocations that outlived "
+        "the reset.");
+
+  m.def("arena_stats",
+        &py_arena_stats,
+        "Get the LBANNv2 arena allocator's statistics");
+
+  m.def("use_slab_host_allocator",
+        &py_use_slab_host_allocator,
+        "Use the LBANNv2 slab allocator for CPU allocations");
+
+  m.def("release_slab_cache",
+        &py_release_slab_cache,
+        "Release empty slabs of the LBANNv2 slab allocator. Returns the "
+        "number of bytes released.");
+
+  m.def("slab_stats",
+        &py_slab_stats,
+        "Get the LBANNv2 slab allocator's statistics");
+
+  m.def("use_growable_host_allocator",
+        &py_use_growable_host_allocator,
+        pybind11::arg("reserve") = pybind11::none(),
+        "Use the LBANNv2 growable allocator for CPU allocations, so that "
+        "lbannv2.resize_ grows storage without copying. Optionally sets "
+        "the address space (in bytes) reserved for each allocation.");
+
+  m.def("resize_",
+        &py_resize_,
+        pybind11::arg("tensor"),
+        pybind11::arg("size"),
+        "Resize a tensor in place as Tensor.resize_ does, growing storage "
+        "from the LBANNv2 growable allocator without copying.");
+
+  m.def("growable_stats",
+        &py_growable_stats,
+        "Get the LBANNv2 growable allocator's statistics");
+
+  m.def("wrap_external",
+        &py_wrap_external,
+        pybind11::arg("ptr"),
+        pybind11::arg("nbytes"),
+        pybind11::arg("owner") = pybind11::none(),
+        pybind11::arg("device") = at::Device {at::kCPU},
+        "Wrap externally owned memory in a byte tensor without copying, "
+        "registering it with LBANNv2. A reference to owner is held until "
+        "the tensor's storage is freed.");
+
+  m.def("wrap_buffer",
+        &py_wrap_buffer,
+        "Wrap the memory of an object supporting the writable buffer "
+        "protocol in a byte tensor without copying, registering it with "
+        "LBANNv2. Empty buffers give an empty, unregistered tensor.");
+
+  m.def("external_stats",
+        &py_external_stats,
+        "Get the number and size of external ranges registered with "
+        "LBANNv2");
+
+  m.def("use_shm_host_allocator",
+        &py_use_shm_host_allocator,
+        pybind11::arg("segment_size") = pybind11::none(),
+        "Use the LBANNv2 shared-memory allocator for CPU allocations. "
+        "Optionally sets the size (in bytes) of the segment, if it has "
+        "not been created yet.");
+
+  m.def("shm_share",
+        &py_shm_share,
+        "Get a (segment, offset, size) handle to the shared-memory storage "
+        "of a tensor. Each handle must be opened exactly once.");
+
+  m.def("shm_open",
+        &py_shm_open,
+        "Open a handle from shm_share as a byte tensor, in any process, "
+        "without copying");
+
+  m.def("shm_stats",
+        &py_shm_stats,
+        "Get the LBANNv2 shared-memory allocator's statistics");
+
+  m.def("use_mmap_file_host_allocator",
+        &py_use_mmap_file_host_allocator,
+        pybind11::arg("directory") = pybind11::none(),
+        "Use the LBANNv2 file-backed allocator for CPU allocations, "
+        "optionally changing the directory that holds the files");
+
+  m.def("mmap_advise",
+        &py_mmap_advise,
+        "Give the kernel a hint (\"normal\", \"random\", \"sequential\", "
+        "\"willneed\" or \"dontneed\") about the memory of a tensor from "
+        "the file-backed allocator");
+
+  m.def("use_host_allocator_spec",
+        &py_use_host_allocator_spec,
+        "Assemble a CPU allocator from a spec string (e.g., "
+        "\"tracking,limit=64G,caching,hugepage\") and use it for CPU "
+        "allocations");
+
+  m.def("host_allocator_stats",
+        &py_host_allocator_stats,
+        "Get the statistics of the allocator installed by "
+        "use_host_allocator_spec");
+
+  m.def("release_host_allocator_cache",
+        &py_release_host_allocator_cache,
+        "Return the memory cached by the allocator installed by "
+        "use_host_allocator_spec");
+
+  // Memory budget
+  m.def("set_memory_limits",
+        &py_set_memory_limits,
+        pybind11::arg("soft"),
+        pybind11::arg("hard"),
+        "Set the soft and hard limits, in bytes, on memory held by LBANNv2 "
+        "allocators (0 disables a limit)");
+
+  m.def("memory_limits",
+        &py_memory_limits,
+        "Get the soft and hard limits on memory held by LBANNv2 allocators");
+
+  m.def("cgroup_memory_limit",
+        &py_cgroup_memory_limit,
+        "Get the memory limit of this process's cgroup, in bytes, or None. "
+        "This covers all of the process's memory, not just LBANNv2's, and "
+        "is not used as a default memory limit");
+
+  m.def("add_memory_reclaimer",
+        &py_add_memory_reclaimer,
+        "Add a callable(pressure, nbytes) that frees memory when the "
+        "memory budget is under pressure (\"soft\", \"hard\" or "
+        "\"failed\"); it may return the number of bytes it freed. "
+        "Returns a handle for remove_memory_reclaimer");
+
+  m.def("remove_memory_reclaimer",
+        &py_remove_memory_reclaimer,
+        "Remove a callable added by add_memory_reclaimer");
+
+  // Python reclaimers take the GIL themselves.
+  m.def("reclaim_memory",
+        &py_reclaim_memory,
+        pybind11::arg("nbytes") = 0,
+        pybind11::call_guard<pybind11::gil_scoped_release>(),
+        "Run the memory reclaimers");
+
+  // Allocation tracing
+  m.def("start_allocation_trace",
+        &py_start_allocation_trace,
+        "Start recording allocation, free and migration events to a file "
+        "(see lbannv2-trace-replay)");
+
+  m.def("stop_allocation_trace",
+        &py_stop_allocation_trace,
+        "Stop recording allocation events, writing out all events");
+
+  m.def("flush_allocation_trace",
+        &py_flush_allocation_trace,
+        "Write out all allocation events recorded so far");
+
+  // Deferred frees
+  m.def("set_deferred_free_threshold",
+        &py_set_deferred_free_threshold,
+        "Release LBANNv2 host buffers of at least this many bytes on a "
+        "background thread (0 disables)");
+
+  m.def("drain_deferred_frees",
+        &py_drain_deferred_frees,
+        "Release all deferred host buffers now. Returns the number of "
+        "bytes released.");
+
+  m.def("deferred_free_stats",
+        &py_deferred_free_stats,
+        "Get the deferred free queue's depth, latency and totals");
+
+  // Zero-fill elision
+  m.def("set_zero_fill_elision",
+        &py_set_zero_fill_elision,
+        "Let torch.zeros skip the memset when an LBANNv2 CPU allocator "
+        "knows the memory to be zero already");
+
+  m.def("zero_fill_elision_enabled",
+        &py_zero_fill_elision_enabled,
+        "Determine whether torch.zeros may skip the memset");
+
   m.def("use_pytorch_host_allocator",
         &py_use_torch_host_allocator,
         "Use the default pytorch CPU allocator for CPU allocations");
 
+  m.def("current_host_allocator",
+        &py_current_host_allocator,
+        "Get a handle to the CPU allocator in use, for "
+        "restore_host_allocator");
+
+  m.def("restore_host_allocator",
+        &py_restore_host_allocator,
+        pybind11::arg("handle"),
+        "Use the CPU allocator of a handle from current_host_allocator "
+        "again");
+
   m.def(
     "using_lbannv2_memory",
     &py_using_lbannv2_memory,
     "Determine whether LBANNv2 allocated the memory backing a given tensor");
+
+  m.def("memory_stats",
+        &py_memory_stats,
+        "Get a snapshot of the LBANNv2 pointer registry's allocation "
+        "counters, broken down by allocator and by device");
 }
 
 }  // namespace _lbannv2
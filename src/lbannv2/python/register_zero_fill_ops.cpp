@@ -0,0 +1,20 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "lbannv2_config.h"
+
+#include <lbannv2/ops/zeros.hpp>
+
+#include <torch/extension.h>
+#include <torch/library.h>
+
+// These take precedence over the CompositeExplicitAutograd kernels
+// for CPU tensors. They fall back to empty+zero_ when the CPU
+// allocator is not an LBANNv2 allocator.
+TORCH_LIBRARY_IMPL(aten, CPU, m)
+{
+  lbannv2::register_zero_fill_ops(m);
+}
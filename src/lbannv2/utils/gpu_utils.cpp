@@ -3,6 +3,11 @@
 #include "errors.hpp"
 #include "logging.hpp"
 
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
 bool lbannv2::gpu::is_integrated() noexcept
 {
 #if LBANNV2_WITH_MI300A
@@ -53,12 +58,32 @@ void lbannv2::gpu::set_device(c10::DeviceIndex const d)
 #define lbannv2StreamNonBlocking cudaStreamNonBlocking
 #define lbannv2StreamSync cudaStreamSynchronize
 #define lbannv2StreamDestroy cudaStreamDestroy
+#define lbannv2EventCreateWithFlags cudaEventCreateWithFlags
+#define lbannv2EventDisableTiming cudaEventDisableTiming
+#define lbannv2EventRecord cudaEventRecord
+#define lbannv2StreamWaitEvent cudaStreamWaitEvent
+#define lbannv2EventQuery cudaEventQuery
+#define lbannv2Success cudaSuccess
+#define lbannv2ErrorNotReady cudaErrorNotReady
+#define lbannv2EventSync cudaEventSynchronize
+#define lbannv2EventDestroy cudaEventDestroy
+#define lbannv2LaunchHostFunc cudaLaunchHostFunc
 #elif LBANNV2_HAS_ROCM
 #define lbannv2StreamCreate hipStreamCreate
 #define lbannv2StreamCreateWithFlags hipStreamCreateWithFlags
 #define lbannv2StreamNonBlocking hipStreamNonBlocking
 #define lbannv2StreamSync hipStreamSynchronize
 #define lbannv2StreamDestroy hipStreamDestroy
+#define lbannv2EventCreateWithFlags hipEventCreateWithFlags
+#define lbannv2EventDisableTiming hipEventDisableTiming
+#define lbannv2EventRecord hipEventRecord
+#define lbannv2StreamWaitEvent hipStreamWaitEvent
+#define lbannv2EventQuery hipEventQuery
+#define lbannv2Success hipSuccess
+#define lbannv2ErrorNotReady hipErrorNotReady
+#define lbannv2EventSync hipEventSynchronize
+#define lbannv2EventDestroy hipEventDestroy
+#define lbannv2LaunchHostFunc hipLaunchHostFunc
 #endif
 
 auto lbannv2::gpu::make_stream() -> Stream_t
@@ -92,4 +117,181 @@ void lbannv2::gpu::destroy_stream(Stream_t const stream)
   LBANNV2_TRACE("lbannv2::gpu::destroy_stream(stream={})", (void*) stream);
 }
 
+auto lbannv2::gpu::make_event() -> Event_t
+{
+  Event_t event;
+  LBANNV2_CHECK_GPU(
+    lbannv2EventCreateWithFlags(&event, lbannv2EventDisableTiming));
+  LBANNV2_TRACE("lbannv2::gpu::make_event(): created event {}",
+                (void*) event);
+  return event;
+}
+
+void lbannv2::gpu::record_event(Event_t const event, Stream_t const stream)
+{
+  LBANNV2_CHECK_GPU(lbannv2EventRecord(event, stream));
+}
+
+void lbannv2::gpu::wait_event(Stream_t const stream, Event_t const event)
+{
+  LBANNV2_CHECK_GPU(lbannv2StreamWaitEvent(stream, event, 0));
+}
+
+bool lbannv2::gpu::query_event(Event_t const event)
+{
+  auto const status = lbannv2EventQuery(event);
+  if (status == lbannv2ErrorNotReady)
+    return false;
+  LBANNV2_CHECK_GPU(status);
+  return true;
+}
+
+void lbannv2::gpu::sync_event(Event_t const event)
+{
+  LBANNV2_CHECK_GPU(lbannv2EventSync(event));
+}
+
+void lbannv2::gpu::destroy_event(Event_t const event)
+{
+  LBANNV2_CHECK_GPU(lbannv2EventDestroy(event));
+  LBANNV2_TRACE("lbannv2::gpu::destroy_event(event={})", (void*) event);
+}
+
+void lbannv2::gpu::launch_host_func(Stream_t const stream,
+                                    std::function<void()> f)
+{
+  using F = std::function<void()>;
+  auto fn = std::make_unique<F>(std::move(f));
+  LBANNV2_CHECK_GPU(lbannv2LaunchHostFunc(
+    stream,
+    [](void* const data) {
+      std::unique_ptr<F> const fn {static_cast<F*>(data)};
+      (*fn)();
+    },
+    fn.get()));
+  fn.release();
+}
+
+#elif LBANNV2_HAS_HOST_STREAMS
+
+// The runtime's handles are pointers to the emulated objects.
+
+auto lbannv2::gpu::make_stream() -> Stream_t
+{
+  auto* const stream = new HostStream;
+  LBANNV2_TRACE("lbannv2::gpu::make_stream(): created host stream {}",
+                (void*) stream);
+  return stream;
+}
+
+auto lbannv2::gpu::make_nonblocking_stream() -> Stream_t
+{
+  auto* const stream = new HostStream {/*nonblocking=*/true};
+  LBANNV2_TRACE(
+    "lbannv2::gpu::make_nonblocking_stream(): created host stream {}",
+    (void*) stream);
+  return stream;
+}
+
+void lbannv2::gpu::sync(Stream_t const stream)
+{
+  stream->synchronize();
+  LBANNV2_TRACE("lbannv2::gpu::sync(stream={})", (void const*) stream);
+}
+
+void lbannv2::gpu::destroy_stream(Stream_t const stream)
+{
+  LBANNV2_TRACE("lbannv2::gpu::destroy_stream(stream={})", (void*) stream);
+  delete stream;
+}
+
+auto lbannv2::gpu::make_event() -> Event_t
+{
+  auto* const event = new HostEvent;
+  LBANNV2_TRACE("lbannv2::gpu::make_event(): created host event {}",
+                (void*) event);
+  return event;
+}
+
+void lbannv2::gpu::record_event(Event_t const event, Stream_t const stream)
+{
+  event->record(*stream);
+}
+
+void lbannv2::gpu::wait_event(Stream_t const stream, Event_t const event)
+{
+  stream->wait(*event);
+}
+
+bool lbannv2::gpu::query_event(Event_t const event)
+{
+  return event->query();
+}
+
+void lbannv2::gpu::sync_event(Event_t const event)
+{
+  event->synchronize();
+}
+
+void lbannv2::gpu::destroy_event(Event_t const event)
+{
+  LBANNV2_TRACE("lbannv2::gpu::destroy_event(event={})", (void*) event);
+  delete event;
+}
+
+void lbannv2::gpu::launch_host_func(Stream_t const stream,
+                                    std::function<void()> f)
+{
+  stream->enqueue(std::move(f));
+}
+
+#endif
+
+#if LBANNV2_HAS_STREAMS
+
+namespace
+{
+
+bool get_use_nonblocking_stream_env_var()
+{
+  char* env = std::getenv("LBANNV2_NONBLOCKING_HOST_ALLOC_STREAM");
+  return env && std::strlen(env) && env[0] != '0';
+}
+
+lbannv2::gpu::Stream_t make_host_allocation_stream()
+{
+  static bool const nonblock = get_use_nonblocking_stream_env_var();
+  LBANNV2_DEBUG("Using nonblocking host allocation stream? {}", nonblock);
+  return nonblock ? lbannv2::gpu::make_nonblocking_stream()
+                  : lbannv2::gpu::make_stream();
+}
+
+}  // namespace
+
+auto lbannv2::gpu::host_allocation_stream(c10::DeviceIndex const d)
+  -> Stream_t
+{
+#if LBANNV2_HAS_GPU
+  // Never destroyed: memory may be released on them at any time.
+  static std::vector<Stream_t> const* const streams = [] {
+    auto* const out = new std::vector<Stream_t>;
+    auto const current = current_device();
+    for (c10::DeviceIndex i = 0; i < num_devices(); ++i)
+    {
+      set_device(i);
+      out->push_back(make_host_allocation_stream());
+    }
+    set_device(current);
+    return out;
+  }();
+  LBANNV2_ASSERT_ALWAYS(d >= 0 && d < num_devices());
+  return (*streams)[d];
+#else
+  (void) d;
+  // Never destroyed: memory may be released on it at any time.
+  static Stream_t const stream = make_host_allocation_stream();
+  return stream;
+#endif
+}
+
 #endif
@@ -47,8 +47,15 @@
       throw std::runtime_error("HIP command \"" #cmd "\" failed.");            \
     }                                                                          \
   } while (0)
+
+#elif LBANNV2_HAS_HOST_STREAMS
+
+#include <lbannv2/utils/host_stream.hpp>
+
 #endif
 
+#include <functional>
+
 namespace lbannv2
 {
 #if LBANNV2_USE_C10_HIP_NAMESPACE_AND_SYMBOLS
@@ -76,13 +83,25 @@ inline constexpr bool has_gpu() noexcept
   return LBANNV2_HAS_GPU;
 }
 
+// Whether the gpu:: stream and event functions are emulated on the
+// host (see HostStream).
+inline constexpr bool has_host_streams() noexcept
+{
+  return LBANNV2_HAS_HOST_STREAMS;
+}
+
 namespace gpu
 {
 
 #if LBANNV2_HAS_CUDA
 using Stream_t = cudaStream_t;
+using Event_t = cudaEvent_t;
 #elif LBANNV2_HAS_ROCM
 using Stream_t = hipStream_t;
+using Event_t = hipEvent_t;
+#elif LBANNV2_HAS_HOST_STREAMS
+using Stream_t = HostStream*;
+using Event_t = HostEvent*;
 #endif
 
 // Returns 'false' if no GPU support
@@ -97,11 +116,31 @@ c10::DeviceIndex current_device();
 // Throws if d >= num_devices() or d < 0.
 void set_device(c10::DeviceIndex d);
 
-#if LBANNV2_HAS_GPU
+#if LBANNV2_HAS_STREAMS
 Stream_t make_stream();
 Stream_t make_nonblocking_stream();
 void sync(Stream_t);
 void destroy_stream(Stream_t);
+
+// Events are created without timing.
+Event_t make_event();
+void record_event(Event_t, Stream_t);
+// Later work on the stream waits for the event's current record.
+void wait_event(Stream_t, Event_t);
+// Returns 'true' if the event's current record has completed.
+bool query_event(Event_t);
+void sync_event(Event_t);
+void destroy_event(Event_t);
+
+// Runs f on a host thread once the work before it on the stream has
+// completed. f must not use the GPU runtime.
+void launch_host_func(Stream_t, std::function<void()> f);
+
+// LBANNv2's own stream on device d, which orders the allocation and
+// release of host memory. It is non-blocking if
+// LBANNV2_NONBLOCKING_HOST_ALLOC_STREAM is set, and never destroyed.
+// With host streams, there is a single one and d is ignored.
+Stream_t host_allocation_stream(c10::DeviceIndex d);
 #endif
 
 }  // namespace gpu
@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include "host_stream.hpp"
+
+#include "errors.hpp"
+#include "logging.hpp"
+
+#include <stdexcept>
+
+namespace lbannv2
+{
+
+// HostStream
+
+HostStream::HostStream(bool const nonblocking)
+  : m_nonblocking {nonblocking}, m_worker {[this] { work(); }}
+{}
+
+HostStream::~HostStream()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_stop = true;
+  }
+  m_work_cv.notify_one();
+  m_worker.join();
+}
+
+void HostStream::enqueue(Work work)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_queue.push_back(std::move(work));
+    ++m_num_enqueued;
+  }
+  m_work_cv.notify_one();
+}
+
+void HostStream::wait(HostEvent const& event)
+{
+  if (auto mark = event.current())
+    enqueue([mark = std::move(mark)] { mark->wait(); });
+}
+
+bool HostStream::query() const
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_num_completed == m_num_enqueued;
+}
+
+void HostStream::synchronize()
+{
+  LBANNV2_ASSERT(std::this_thread::get_id() != m_worker.get_id(),
+                 std::runtime_error,
+                 "HostStream: cannot synchronize from the stream's work");
+
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    auto const target = m_num_enqueued;
+    m_done_cv.wait(lock, [&] { return m_num_completed >= target; });
+    std::swap(error, m_error);
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+void HostStream::work()
+{
+  std::unique_lock<std::mutex> lock(m_mtx);
+  for (;;)
+  {
+    m_work_cv.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+    // Pending work is finished before stopping.
+    if (m_queue.empty())
+      return;
+
+    std::exception_ptr error;
+    {
+      auto work = std::move(m_queue.front());
+      m_queue.pop_front();
+      lock.unlock();
+      try
+      {
+        work();
+      }
+      catch (...)
+      {
+        error = std::current_exception();
+      }
+    }
+    lock.lock();
+    if (error)
+    {
+      LBANNV2_DEBUG("HostStream {}: enqueued work threw", (void*) this);
+      if (!m_error)
+        m_error = std::move(error);
+    }
+    ++m_num_completed;
+    m_done_cv.notify_all();
+  }
+}
+
+// HostEvent
+
+void HostEvent::Mark::complete() noexcept
+{
+  when = Clock::now();
+  done.store(true, std::memory_order_release);
+  done.notify_all();
+}
+
+void HostEvent::Mark::wait() const noexcept
+{
+  while (!done.load(std::memory_order_acquire))
+    done.wait(false, std::memory_order_acquire);
+}
+
+void HostEvent::record(HostStream& stream)
+{
+  auto mark = std::make_shared<Mark>();
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_mark = mark;
+  }
+  stream.enqueue([mark = std::move(mark)] { mark->complete(); });
+}
+
+bool HostEvent::query() const
+{
+  auto const mark = current();
+  return !mark || mark->done.load(std::memory_order_acquire);
+}
+
+void HostEvent::synchronize() const
+{
+  if (auto const mark = current())
+    mark->wait();
+}
+
+float HostEvent::elapsed_ms(HostEvent const& start, HostEvent const& end)
+{
+  auto const first = start.current();
+  auto const last = end.current();
+  LBANNV2_ASSERT(first && last && first->done.load(std::memory_order_acquire)
+                   && last->done.load(std::memory_order_acquire),
+                 std::runtime_error,
+                 "HostEvent: elapsed time of incomplete events");
+  return std::chrono::duration<float, std::milli>(last->when - first->when)
+    .count();
+}
+
+auto HostEvent::current() const -> std::shared_ptr<Mark>
+{
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_mark;
+}
+
+}  // namespace lbannv2
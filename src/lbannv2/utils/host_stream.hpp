@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <lbannv2_config.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace lbannv2
+{
+
+class HostEvent;
+
+/** @class HostStream
+ *  @brief An ordered work queue that emulates a GPU stream on the
+ *         host.
+ *
+ *  Work enqueued on a stream runs in order on the stream's own worker
+ *  thread, asynchronously with respect to the enqueuing thread.
+ *  Together with HostEvent, this gives CPU-only builds the stream
+ *  semantics that stream-ordered allocation relies on: record an
+ *  event after some work, make another stream wait on it, and query
+ *  or synchronize on either. With LBANNV2_HAS_HOST_STREAMS, the
+ *  lbannv2::gpu stream and event functions are implemented with it.
+ *
+ *  Errors are reported asynchronously, as on a GPU stream: the first
+ *  exception thrown by enqueued work is kept and rethrown by the next
+ *  synchronize(). Later work still runs, so that events recorded
+ *  after it complete. There is no legacy default stream, so
+ *  blocking and non-blocking streams behave the same; the flag is
+ *  kept for reference.
+ *
+ *  Destroying a stream waits for its pending work.
+ */
+class LBANNV2_EXPORT HostStream
+{
+public:
+  using Work = std::function<void()>;
+
+  explicit HostStream(bool nonblocking = false);
+  ~HostStream();
+  HostStream(HostStream const&) = delete;
+  HostStream(HostStream&&) = delete;
+  HostStream& operator=(HostStream const&) = delete;
+  HostStream& operator=(HostStream&&) = delete;
+
+  bool nonblocking() const noexcept { return m_nonblocking; }
+
+  /** @brief Run work after all the work enqueued before it. */
+  void enqueue(Work work);
+
+  /** @brief Make later work wait until the event's current record has
+   *         completed.
+   *
+   *  This does not block the calling thread. Waiting on an event that
+   *  has never been recorded is a no-op.
+   */
+  void wait(HostEvent const& event);
+
+  /** @brief Whether all enqueued work has completed. */
+  bool query() const;
+
+  /** @brief Wait for all enqueued work.
+   *
+   *  This must not be called from work on the same stream.
+   *
+   *  @throws The first exception thrown by enqueued work since the
+   *          last synchronize(), if any.
+   */
+  void synchronize();
+
+private:
+  void work();
+
+  bool const m_nonblocking;
+
+  mutable std::mutex m_mtx;
+  std::condition_variable m_work_cv;
+  std::condition_variable m_done_cv;
+  std::deque<Work> m_queue;
+  std::uint64_t m_num_enqueued = 0UL;
+  std::uint64_t m_num_completed = 0UL;
+  std::exception_ptr m_error;
+  bool m_stop = false;
+  std::thread m_worker;
+};  // class HostStream
+
+/** @class HostEvent
+ *  @brief A marker in a HostStream's work, as a GPU event is in a
+ *         GPU stream.
+ *
+ *  An event is complete once the work enqueued on the stream before
+ *  its most recent record() has completed. Each record() supersedes
+ *  the previous one; waits and synchronizations already issued still
+ *  refer to the record that was current when they were issued. An
+ *  event that has never been recorded is complete.
+ *
+ *  An event may be destroyed while a record is pending.
+ */
+class LBANNV2_EXPORT HostEvent
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  HostEvent() = default;
+  HostEvent(HostEvent const&) = delete;
+  HostEvent(HostEvent&&) = delete;
+  HostEvent& operator=(HostEvent const&) = delete;
+  HostEvent& operator=(HostEvent&&) = delete;
+
+  /** @brief Mark the current end of a stream's work. */
+  void record(HostStream& stream);
+
+  /** @brief Whether the most recent record has completed. */
+  bool query() const;
+
+  /** @brief Wait for the most recent record to complete. */
+  void synchronize() const;
+
+  /** @brief The time between the completion of two records, in
+   *         milliseconds.
+   *
+   *  @throws std::runtime_error if either event has not completed.
+   */
+  static float elapsed_ms(HostEvent const& start, HostEvent const& end);
+
+private:
+  friend class HostStream;
+
+  /** @brief The state of one record(). */
+  struct Mark
+  {
+    std::atomic<bool> done = false;
+    Clock::time_point when;
+
+    void complete() noexcept;
+    void wait() const noexcept;
+  };
+
+  std::shared_ptr<Mark> current() const;
+
+  mutable std::mutex m_mtx;
+  std::shared_ptr<Mark> m_mark;
+};  // class HostEvent
+
+}  // namespace lbannv2
@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/memory_budget.hpp>
+#include <lbannv2/memory/policy_allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+TEST_CASE("Header layout allocations", "[memory][header]")
+{
+  auto alloc = lbannv2::make_policy_allocator("headers,tracking");
+  REQUIRE(alloc->header_layout());
+  auto& registry = lbannv2::pointer_registry();
+  auto const base_usage = lbannv2::memory_budget().usage();
+
+  {
+    auto ptr = alloc->allocate(100);
+    REQUIRE(ptr.get());
+    CHECK(reinterpret_cast<std::uintptr_t>(ptr.get()) % 64 == 0);
+
+    auto const* const header = lbannv2::allocation_header(ptr);
+    REQUIRE(header);
+    CHECK(header->allocator == alloc.get());
+    CHECK(header->size == 100UL);
+    CHECK(header->tags == 0U);
+    CHECK(static_cast<void const*>(header + 1) == ptr.get());
+    CHECK(lbannv2::allocator_of(ptr) == alloc.get());
+
+    // The whole block is registered, with the header as context.
+    CHECK(registry.known(ptr.get()));
+    CHECK(registry.known(static_cast<char*>(ptr.get()) + 99));
+    CHECK(registry.get_context(ptr.get()) == header);
+    CHECK(registry.get_context(ptr.get()) == ptr.get_context());
+    CHECK(lbannv2::is_managed_ptr(ptr));
+    CHECK(lbannv2::memory_budget().usage()
+          == base_usage + 100 + sizeof(lbannv2::AllocationHeader));
+    CHECK(alloc->stats().tracked->current_bytes
+          == 100 + sizeof(lbannv2::AllocationHeader));
+  }
+
+  CHECK(lbannv2::memory_budget().usage() == base_usage);
+  CHECK(alloc->stats().tracked->current_allocations == 0UL);
+
+  SECTION("Zeroed")
+  {
+    auto ptr = alloc->allocate_zeroed(1000);
+    auto const* const bytes = static_cast<unsigned char const*>(ptr.get());
+    CHECK(std::all_of(bytes, bytes + 1000, [](auto b) { return b == 0; }));
+    CHECK(lbannv2::allocation_header(ptr)->size == 1000UL);
+  }
+
+  SECTION("Changing the layout")
+  {
+    auto headered = alloc->allocate(100);
+    alloc->set_header_layout(false);
+    auto registered = alloc->allocate(100);
+    CHECK_FALSE(lbannv2::allocation_header(registered));
+    CHECK(registry.known(registered.get()));
+    CHECK(lbannv2::allocator_of(registered) == alloc.get());
+
+    headered.clear();
+    CHECK_FALSE(registry.known(headered.get()));
+    registered.clear();
+    CHECK(alloc->stats().tracked->current_allocations == 0UL);
+  }
+}
+
+TEST_CASE("Header layout specs", "[memory][header]")
+{
+  CHECK(lbannv2::make_policy_allocator("headers")->header_layout());
+  CHECK_FALSE(lbannv2::make_policy_allocator("caching")->header_layout());
+  CHECK_THROWS_AS(lbannv2::make_policy_allocator("tracking,headers"),
+                  std::runtime_error);
+}
@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/allocation_trace.hpp>
+#include <lbannv2/memory/policy_allocator.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using lbannv2::TraceEvent;
+
+namespace
+{
+
+fs::path trace_path(std::string const& name)
+{
+  return fs::temp_directory_path()
+         / ("lbannv2-" + name + "-" + std::to_string(getpid()) + ".trace");
+}
+
+}  // namespace
+
+TEST_CASE("Allocation traces round trip", "[memory][trace]")
+{
+  auto const path = trace_path("round-trip");
+  auto& tracer = lbannv2::AllocationTracer::instance();
+  auto alloc = lbannv2::make_policy_allocator("tracking");
+
+  // More than a ring's worth, from two threads.
+  constexpr size_t num_allocs = 5000;
+  auto const work = [&] {
+    for (size_t i = 0; i < num_allocs; ++i)
+      alloc->allocate(64 + i % 7);
+  };
+
+  CHECK_FALSE(lbannv2::AllocationTracer::enabled());
+  tracer.start(path);
+  CHECK(lbannv2::AllocationTracer::enabled());
+  CHECK_THROWS_AS(tracer.start(path), std::runtime_error);
+
+  std::thread other(work);
+  work();
+  other.join();
+  tracer.stop();
+  CHECK_FALSE(lbannv2::AllocationTracer::enabled());
+
+  // Not recorded.
+  alloc->allocate(64);
+
+  auto const events = lbannv2::read_allocation_trace(path);
+  REQUIRE(events.size() == 4 * num_allocs);
+  CHECK(std::is_sorted(
+    events.cbegin(), events.cend(), [](auto const& a, auto const& b) {
+      return a.time_ns < b.time_ns;
+    }));
+
+  auto const count = [&](auto pred) {
+    return std::count_if(events.cbegin(), events.cend(), pred);
+  };
+  CHECK(count([](auto const& e) { return e.kind == TraceEvent::Alloc; })
+        == 2 * num_allocs);
+  CHECK(count([](auto const& e) { return e.kind == TraceEvent::Free; })
+        == 2 * num_allocs);
+  CHECK(count([](auto const& e) {
+          return e.device_type == static_cast<std::int8_t>(c10::kCPU);
+        })
+        == 4 * num_allocs);
+
+  std::vector<std::uint32_t> threads;
+  for (auto const& e : events)
+    threads.push_back(e.thread);
+  std::sort(threads.begin(), threads.end());
+  CHECK(std::unique(threads.begin(), threads.end()) - threads.begin() == 2);
+
+  SECTION("Replay")
+  {
+    auto replay_alloc = lbannv2::make_policy_allocator("tracking");
+    auto const stats =
+      lbannv2::replay_allocation_trace(events, *replay_alloc);
+    CHECK(stats.num_allocs == 2 * num_allocs);
+    CHECK(stats.num_frees == 2 * num_allocs);
+    CHECK(stats.num_unmatched_frees == 0UL);
+    CHECK(stats.peak_requested_bytes >= 64UL);
+    CHECK(stats.peak_requested_bytes <= 2 * 70UL);
+    CHECK(replay_alloc->stats().tracked->current_allocations == 0UL);
+  }
+
+  fs::remove(path);
+}
+
+TEST_CASE("Replaying a handmade trace", "[memory][trace]")
+{
+  auto const event = [](TraceEvent::Kind kind, std::uint64_t ptr, size_t n) {
+    TraceEvent e {};
+    e.kind = kind;
+    e.ptr = ptr;
+    e.size = n;
+    return e;
+  };
+  std::vector<TraceEvent> const events {
+    event(TraceEvent::Alloc, 0x1000, 100),
+    event(TraceEvent::Alloc, 0x2000, 200),
+    event(TraceEvent::Migrate, 0x1000, 100),
+    event(TraceEvent::Free, 0x1000, 100),
+    event(TraceEvent::Free, 0x3000, 300),
+    event(TraceEvent::Alloc, 0x1000, 50),
+  };
+
+  auto alloc = lbannv2::make_policy_allocator("tracking");
+  auto const stats = lbannv2::replay_allocation_trace(events, *alloc);
+  CHECK(stats.num_allocs == 3UL);
+  CHECK(stats.num_frees == 1UL);
+  CHECK(stats.num_migrates == 1UL);
+  CHECK(stats.num_unmatched_frees == 1UL);
+  CHECK(stats.peak_requested_bytes == 300UL);
+  // Live allocations are freed at the end.
+  CHECK(alloc->stats().tracked->current_allocations == 0UL);
+}
+
+TEST_CASE("Reading a bad trace throws", "[memory][trace]")
+{
+  auto const path = trace_path("bad");
+  CHECK_THROWS_AS(lbannv2::read_allocation_trace(path), std::runtime_error);
+  std::ofstream(path) << "not a trace";
+  CHECK_THROWS_AS(lbannv2::read_allocation_trace(path), std::runtime_error);
+  fs::remove(path);
+}
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/arena_allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+using AA = lbannv2::ArenaAllocator;
+
+TEST_CASE("ArenaAllocator", "[memory][arena]")
+{
+  auto& alloc = AA::instance();
+  auto& registry = lbannv2::pointer_registry();
+  alloc.release_cached();
+  auto const base = alloc.stats();
+  auto const base_registered = registry.num_registered();
+
+  alloc.begin_scope();
+  void* first = nullptr;
+  {
+    auto a = alloc.allocate(100);
+    auto b = alloc.allocate(200);
+    first = a.get();
+
+    CHECK(reinterpret_cast<std::uintptr_t>(a.get()) % AA::kAlignment == 0);
+    CHECK(reinterpret_cast<std::uintptr_t>(b.get()) % AA::kAlignment == 0);
+    CHECK(a.get() < b.get());
+
+    // One registry entry for the chunk, not one per allocation, but
+    // lookups resolve to the allocation.
+    CHECK(registry.known(a.get()));
+    CHECK(registry.known(b.get()));
+    CHECK(registry.num_registered() == base_registered + 1);
+    auto* const inside = static_cast<std::byte*>(b.get()) + 199;
+    CHECK(registry.get_context(inside) == b.get());
+    CHECK_FALSE(registry.known(inside + 1));
+    CHECK_FALSE(registry.known(static_cast<std::byte*>(b.get()) - 1));
+    CHECK(alloc.stats().num_chunks == base.num_chunks + 1);
+    CHECK(alloc.stats().live_allocations == base.live_allocations + 2);
+  }
+
+  SECTION("Resetting rewinds the arena")
+  {
+    CHECK(alloc.end_scope() == 0UL);
+    CHECK(alloc.stats().used_bytes == 0UL);
+
+    alloc.begin_scope();
+    {
+      auto c = alloc.allocate(64);
+      CHECK(c.get() == first);
+    }
+    CHECK(alloc.end_scope() == 0UL);
+  }
+
+  SECTION("Nested scopes reset only at the outermost level")
+  {
+    alloc.begin_scope();
+    auto c = alloc.allocate(64);
+    CHECK(alloc.end_scope() == 0UL);
+    CHECK(alloc.stats().used_bytes > 0UL);
+    c = c10::DataPtr {};
+    CHECK(alloc.end_scope() == 0UL);
+  }
+
+  SECTION("Allocations that outlive the scope are reported")
+  {
+    auto c = alloc.allocate(64);
+    CHECK(alloc.end_scope() == 1UL);
+    CHECK(alloc.stats().total_outliving == base.total_outliving + 1);
+
+    // The chunk is held, so new allocations come from elsewhere.
+    alloc.begin_scope();
+    {
+      auto d = alloc.allocate(64);
+      CHECK(d.get() != first);
+    }
+    CHECK(alloc.end_scope() == 0UL);
+    CHECK(alloc.stats().num_chunks == base.num_chunks + 2);
+
+    // Once freed, the held chunk is reusable.
+    c = c10::DataPtr {};
+    alloc.release_cached();
+    CHECK(alloc.stats().num_chunks == base.num_chunks);
+  }
+
+  SECTION("Freed allocations are unknown before the reset")
+  {
+    auto c = alloc.allocate(64);
+    void* const raw = c.get();
+    CHECK(registry.known(raw));
+    c = c10::DataPtr {};
+    CHECK_FALSE(registry.known(raw));
+    CHECK(alloc.end_scope() == 0UL);
+  }
+
+  SECTION("Large allocations get their own chunk")
+  {
+    auto c = alloc.allocate(alloc.chunk_size() + 1);
+    CHECK(alloc.stats().num_chunks == base.num_chunks + 2);
+    c = c10::DataPtr {};
+    CHECK(alloc.end_scope() == 0UL);
+  }
+
+  alloc.release_cached();
+  CHECK(registry.num_registered() == base_registered);
+}
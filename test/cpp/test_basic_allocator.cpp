@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/basic_allocator.hpp>
+#include <lbannv2/memory/policy_allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using lbannv2::BasicAllocator;
+using lbannv2::MallocBacking;
+
+TEST_CASE("BasicAllocator without registration", "[memory][basic]")
+{
+  BasicAllocator<lbannv2::TrackingLayer<MallocBacking>,
+                 lbannv2::NoRegistration>
+    alloc;
+
+  {
+    auto ptr = alloc.allocate(100);
+    REQUIRE(ptr.get());
+    CHECK(ptr.device() == c10::Device {c10::kCPU});
+    CHECK(reinterpret_cast<std::uintptr_t>(ptr.get())
+            % MallocBacking::kAlignment
+          == 0);
+    CHECK_FALSE(lbannv2::pointer_registry().known(ptr.get()));
+    CHECK(alloc.stats().tracked->current_bytes
+          == 100 + sizeof(lbannv2::AllocationHeader));
+  }
+  CHECK(alloc.stats().tracked->current_allocations == 0UL);
+
+  auto empty = alloc.allocate(0);
+  CHECK_FALSE(empty.get());
+}
+
+TEST_CASE("BasicAllocator with eager registration", "[memory][basic]")
+{
+  BasicAllocator<MallocBacking, lbannv2::EagerRegistration> alloc;
+  auto& registry = lbannv2::pointer_registry();
+  void* raw_ptr = nullptr;
+  {
+    auto ptr = alloc.allocate(100);
+    raw_ptr = ptr.get();
+    auto const* const header =
+      static_cast<lbannv2::AllocationHeader const*>(ptr.get_context());
+    CHECK(header->allocator == &alloc);
+    CHECK(header->size == 100UL);
+    CHECK(registry.known(raw_ptr));
+    CHECK(registry.get_allocator(raw_ptr) == &alloc);
+    CHECK(registry.get_context(raw_ptr) == ptr.get_context());
+    CHECK(registry.get_context(static_cast<char*>(raw_ptr) + 99)
+          == ptr.get_context());
+    CHECK(registry.bytes_registered(ptr.get_context())
+          == 100 + sizeof(lbannv2::AllocationHeader));
+  }
+  CHECK_FALSE(registry.known(raw_ptr));
+}
+
+TEST_CASE("BasicAllocator with lazy registration", "[memory][basic]")
+{
+  BasicAllocator<MallocBacking, lbannv2::LazyRegistration> alloc;
+  auto& registry = lbannv2::pointer_registry();
+  auto const base = registry.bytes_registered();
+
+  // Freed before its batch is registered.
+  alloc.allocate(100);
+  CHECK(registry.bytes_registered() == base);
+
+  auto ptr = alloc.allocate(100);
+  CHECK_FALSE(registry.known(ptr.get()));
+  alloc.flush_registrations();
+  CHECK(registry.known(ptr.get()));
+  CHECK(registry.get_context(ptr.get()) == ptr.get_context());
+
+  // A full batch is registered on its own.
+  std::vector<c10::DataPtr> ptrs;
+  for (size_t i = 0; i < lbannv2::LazyRegistration::kBatchSize; ++i)
+    ptrs.push_back(alloc.allocate(10));
+  CHECK(registry.known(ptrs.front().get()));
+
+  ptrs.clear();
+  ptr.clear();
+  CHECK(registry.bytes_registered() == base);
+
+  SECTION("A batch that fails to register is dropped")
+  {
+    auto dropped = alloc.allocate(100);
+    // Conflicts with the pending registration.
+    registry.add(dropped.get(), 1, nullptr);
+    CHECK_THROWS(alloc.flush_registrations());
+    registry.remove(dropped.get());
+
+    CHECK_NOTHROW(alloc.flush_registrations());
+    CHECK_FALSE(registry.known(dropped.get()));
+    CHECK_NOTHROW(dropped.clear());
+    CHECK(registry.bytes_registered() == base);
+  }
+
+  SECTION("Unknown frees are still errors")
+  {
+    lbannv2::LazyRegistration lazy;
+    int x = 0;
+    CHECK_THROWS_AS(lazy.on_free(&x, sizeof(x)), lbannv2::UnknownAddress);
+
+    // Dropped allocations are forgiven once.
+    registry.add(&x, sizeof(x), nullptr);
+    lazy.on_alloc(&x, sizeof(x), nullptr);
+    CHECK_THROWS(lazy.flush());
+    registry.remove(&x);
+    CHECK_NOTHROW(lazy.on_free(&x, sizeof(x)));
+    CHECK_THROWS_AS(lazy.on_free(&x, sizeof(x)), lbannv2::UnknownAddress);
+  }
+}
+
+TEST_CASE("Allocator benchmarks", "[memory][basic][!benchmark]")
+{
+  constexpr size_t nbytes = 256;
+
+  lbannv2::PolicyAllocator<MallocBacking> current;
+  BENCHMARK("lbannv2::Allocator")
+  {
+    return current.allocate(nbytes);
+  };
+
+  BasicAllocator<MallocBacking, lbannv2::EagerRegistration> eager;
+  BENCHMARK("BasicAllocator, eager registration")
+  {
+    return eager.allocate(nbytes);
+  };
+
+  BasicAllocator<MallocBacking, lbannv2::LazyRegistration> lazy;
+  BENCHMARK("BasicAllocator, lazy registration")
+  {
+    return lazy.allocate(nbytes);
+  };
+
+  BasicAllocator<MallocBacking, lbannv2::NoRegistration> none;
+  BENCHMARK("BasicAllocator, no registration")
+  {
+    return none.allocate(nbytes);
+  };
+
+  BasicAllocator<lbannv2::CachingLayer<MallocBacking>,
+                 lbannv2::NoRegistration>
+    cached;
+  BENCHMARK("BasicAllocator, cached, no registration")
+  {
+    return cached.allocate(nbytes);
+  };
+}
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/caching_host_allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+
+using CHA = lbannv2::CachingHostAllocator;
+
+TEST_CASE("CachingHostAllocator::round_size()", "[memory][caching]")
+{
+  CHECK(CHA::round_size(0) == 0UL);
+  CHECK(CHA::round_size(1) == CHA::kMinBlockSize);
+  CHECK(CHA::round_size(512) == 512UL);
+  CHECK(CHA::round_size(513) == 640UL);
+  CHECK(CHA::round_size(1000) == 1024UL);
+  CHECK(CHA::round_size(1025) == 1280UL);
+  CHECK(CHA::round_size(CHA::kSmallSize) == CHA::kSmallSize);
+  CHECK(CHA::round_size(CHA::kSmallSize + 1)
+        == CHA::kSmallSize + CHA::kMinBlockSize);
+}
+
+TEST_CASE("CachingHostAllocator::allocate", "[memory][caching]")
+{
+  auto& alloc = CHA::instance();
+  alloc.empty_cache();
+  auto const base = alloc.stats();
+
+  void* raw_ptr = nullptr;
+  {
+    auto ptr = alloc.allocate(100);
+    raw_ptr = ptr.get();
+    CHECK(ptr.device() == c10::Device {c10::kCPU});
+    CHECK(reinterpret_cast<std::uintptr_t>(raw_ptr) % CHA::kAlignment == 0);
+    CHECK(lbannv2::pointer_registry().known(raw_ptr));
+    CHECK(alloc.stats().allocated_bytes
+          == base.allocated_bytes + CHA::kMinBlockSize);
+  }
+
+  // Deregistered, but still cached.
+  CHECK_FALSE(lbannv2::pointer_registry().known(raw_ptr));
+  CHECK(alloc.stats().allocated_bytes == base.allocated_bytes);
+  CHECK(alloc.stats().reserved_bytes
+        == base.reserved_bytes + CHA::kMinBlockSize);
+
+  SECTION("Same size class reuses the block")
+  {
+    auto ptr = alloc.allocate(CHA::kMinBlockSize);
+    CHECK(ptr.get() == raw_ptr);
+    CHECK(alloc.stats().cache_hits == base.cache_hits + 1);
+  }
+
+  SECTION("empty_cache() returns the memory")
+  {
+    alloc.empty_cache();
+    CHECK(alloc.stats().reserved_bytes == base.reserved_bytes);
+  }
+
+  SECTION("Zero-size allocations are null")
+  {
+    auto ptr = alloc.allocate(0);
+    CHECK(ptr.get() == nullptr);
+  }
+}
+
+TEST_CASE("CachingHostAllocator large blocks", "[memory][caching]")
+{
+  auto& alloc = CHA::instance();
+  alloc.empty_cache();
+  auto const base = alloc.stats();
+
+  // Both fit in one segment.
+  size_t const size = 3 * CHA::kSmallSize;
+  void* a = alloc.raw_alloc(size);
+  void* b = alloc.raw_alloc(size);
+  auto const after_alloc = alloc.stats();
+  CHECK(after_alloc.num_segments == base.num_segments + 1);
+  CHECK(after_alloc.cache_hits == base.cache_hits + 1);
+  CHECK(static_cast<std::byte*>(b) == static_cast<std::byte*>(a) + size);
+
+  SECTION("Freed neighbors coalesce")
+  {
+    alloc.raw_dealloc(a);
+    alloc.raw_dealloc(b);
+
+    // Only possible if a and b (and the tail) coalesced.
+    void* c = alloc.raw_alloc(2 * size);
+    CHECK(c == a);
+    CHECK(alloc.stats().num_segments == base.num_segments + 1);
+    alloc.raw_dealloc(c);
+  }
+
+  SECTION("Segments in use are not released")
+  {
+    alloc.raw_dealloc(a);
+    alloc.empty_cache();
+    CHECK(alloc.stats().num_segments == base.num_segments + 1);
+    alloc.raw_dealloc(b);
+  }
+
+  alloc.empty_cache();
+  CHECK(alloc.stats().reserved_bytes == base.reserved_bytes);
+}
+
+TEST_CASE("CachingHostAllocator rejects foreign pointers", "[memory][caching]")
+{
+  auto& alloc = CHA::instance();
+  int x;
+  CHECK_THROWS(alloc.raw_dealloc(&x));
+}
@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/coherent_memory.hpp>
+#include <lbannv2/memory/deferred_free.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <c10/core/Allocator.h>
+#include <c10/core/CPUAllocator.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+using ECM = lbannv2::EmulatedCoherentMemory;
+
+namespace
+{
+
+// Installs a domain for the duration of a test.
+struct DomainGuard
+{
+  lbannv2::CoherentMemoryDomain* const prev;
+  explicit DomainGuard(lbannv2::CoherentMemoryDomain* const domain)
+    : prev {lbannv2::coherent_memory_domain()}
+  {
+    lbannv2::set_coherent_memory_domain(domain);
+  }
+  ~DomainGuard() { lbannv2::set_coherent_memory_domain(prev); }
+};
+
+}  // namespace
+
+TEST_CASE("EmulatedCoherentMemory", "[memory][coherent]")
+{
+  ECM domain {2};
+  DomainGuard guard {&domain};
+
+  auto& registry = lbannv2::pointer_registry();
+  c10::Device const cpu {c10::kCPU};
+  c10::Device const dev {c10::kCUDA, 0};
+
+  auto const base = domain.stats();
+  auto ptr = domain.host_allocator().allocate(64);
+  void* const raw = ptr.get();
+
+  REQUIRE(registry.known(raw));
+  CHECK(ptr.device() == cpu);
+  CHECK(domain.stats().num_allocations == base.num_allocations + 1);
+
+  SECTION("Allocations are tied to the current device")
+  {
+    CHECK(domain.origin(raw) == dev);
+    CHECK(domain.origin(static_cast<char*>(raw) + 63) == dev);
+    CHECK(domain.can_migrate(raw, cpu));
+    CHECK(domain.can_migrate(raw, dev));
+    CHECK(domain.can_migrate(raw, c10::Device {c10::kCUDA}));
+  }
+
+  SECTION("Rebranding is zero-copy and keeps the registry consistent")
+  {
+    auto const stats = registry.stats();
+    auto const on_cpu = stats.by_device.at(cpu).current_bytes;
+
+    lbannv2::migrate_ptr(
+      ptr, c10::Device {c10::kCUDA}, domain.current_stream(dev));
+    CHECK(ptr.get() == raw);
+    CHECK(ptr.device() == dev);
+    CHECK(domain.stats().num_to_device == base.num_to_device + 1);
+    CHECK(registry.stats().by_device.at(dev).current_bytes >= 64UL);
+    CHECK(registry.stats().by_device.at(cpu).current_bytes == on_cpu - 64UL);
+
+    lbannv2::migrate_ptr(ptr, cpu, c10::Stream {c10::Stream::DEFAULT, cpu});
+    CHECK(ptr.get() == raw);
+    CHECK(ptr.device() == cpu);
+    CHECK(domain.stats().num_to_host == base.num_to_host + 1);
+    CHECK(registry.stats().by_device.at(cpu).current_bytes == on_cpu);
+    CHECK(domain.associated_stream(raw) == 0);
+  }
+
+  SECTION("Memory cannot move to another device")
+  {
+    c10::Device const other {c10::kCUDA, 1};
+    CHECK_FALSE(domain.can_migrate(raw, other));
+    CHECK_THROWS_AS(lbannv2::migrate_ptr(
+                      ptr, other, c10::Stream {c10::Stream::DEFAULT, other}),
+                    std::runtime_error);
+    CHECK(ptr.device() == cpu);
+  }
+
+  SECTION("Allocations follow the current device")
+  {
+    domain.set_current_device(1);
+    auto ptr1 = domain.host_allocator().allocate(64);
+    CHECK(domain.origin(ptr1.get()) == c10::Device {c10::kCUDA, 1});
+    CHECK_FALSE(domain.can_migrate(ptr1.get(), dev));
+    CHECK(domain.can_migrate(ptr1.get(), c10::Device {c10::kCUDA}));
+  }
+
+  SECTION("Frees wait for work on the device")
+  {
+    std::promise<void> go;
+    auto kernel = go.get_future().share();
+    lbannv2::migrate_ptr(ptr, dev, domain.current_stream(dev));
+    domain.stream(dev).enqueue([kernel] { kernel.wait(); });
+
+    ptr.clear();
+    CHECK(domain.stats().num_deferred_frees == base.num_deferred_frees + 1);
+    CHECK_FALSE(registry.known(raw));
+    CHECK(domain.stats().num_allocations == base.num_allocations + 1);
+
+    go.set_value();
+    domain.synchronize(dev);
+    lbannv2::DeferredFree::instance().drain(&domain.host_allocator());
+  }
+
+  SECTION("Frees are immediate on an idle device")
+  {
+    lbannv2::migrate_ptr(ptr, dev, domain.current_stream(dev));
+    domain.synchronize(dev);
+    ptr.clear();
+    CHECK(domain.stats().num_deferred_frees == base.num_deferred_frees);
+  }
+
+  SECTION("Other host memory is tied to the host")
+  {
+    auto other = c10::GetCPUAllocator()->allocate(64);
+    CHECK(domain.origin(other.get()) == cpu);
+    CHECK(domain.can_migrate(other.get(), cpu));
+    CHECK_FALSE(domain.can_migrate(other.get(), dev));
+    CHECK_THROWS_AS(
+      lbannv2::migrate_ptr(other, dev, domain.current_stream(dev)),
+      std::runtime_error);
+  }
+
+  ptr.clear();
+  CHECK(domain.stats().num_allocations == base.num_allocations);
+  CHECK(domain.origin(raw) == cpu);
+}
+
+TEST_CASE("EmulatedCoherentMemory streams and fences", "[memory][coherent]")
+{
+  using namespace std::chrono_literals;
+
+  ECM domain {2};
+  c10::Device const cpu {c10::kCPU};
+  c10::Device const dev {c10::kCUDA, 0};
+  auto& stream = domain.stream(dev);
+
+  CHECK(&domain.stream(c10::Device {c10::kCUDA}) == &stream);
+  CHECK_THROWS_AS(domain.stream(cpu), std::runtime_error);
+
+  std::promise<void> go;
+  auto kernel = go.get_future().share();
+  int value = 0;
+  stream.enqueue([&, kernel] {
+    kernel.wait();
+    value = 42;
+  });
+
+  // A fence does not block; it completes with the work before it.
+  auto const fence = domain.record(dev);
+  CHECK_FALSE(fence->query());
+
+  SECTION("Waiting on the host")
+  {
+    go.set_value();
+    fence->wait();
+    CHECK(fence->query());
+    CHECK(value == 42);
+  }
+
+  SECTION("Waiting on a CPU stream is waiting on the host")
+  {
+    go.set_value();
+    fence->wait_on(c10::Stream {c10::Stream::DEFAULT, cpu});
+    CHECK(value == 42);
+  }
+
+  SECTION("Waiting on a device stream does not block the host")
+  {
+    c10::Device const other {c10::kCUDA, 1};
+    int seen = -1;
+    fence->wait_on(c10::Stream {c10::Stream::DEFAULT, other});
+    domain.stream(other).enqueue([&] { seen = value; });
+    std::this_thread::sleep_for(5ms);
+    CHECK_FALSE(domain.stream(other).query());
+    go.set_value();
+    domain.synchronize(other);
+    CHECK(seen == 42);
+  }
+
+  domain.synchronize(dev);
+  CHECK(stream.query());
+}
+
+TEST_CASE("migrate_ptr without a coherent memory domain",
+          "[memory][coherent]")
+{
+  DomainGuard guard {nullptr};
+  c10::Device const dev {c10::kCUDA, 0};
+
+  auto ptr = ECM::instance().host_allocator().allocate(8);
+  CHECK_THROWS_AS(
+    lbannv2::migrate_ptr(ptr, dev, c10::Stream {c10::Stream::DEFAULT, dev}),
+    std::runtime_error);
+  CHECK(ptr.device() == c10::Device {c10::kCPU});
+}
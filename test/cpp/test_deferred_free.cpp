@@ -0,0 +1,170 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/deferred_free.hpp>
+#include <lbannv2/memory/huge_page_allocator.hpp>
+#include <lbannv2/memory/memory_budget.hpp>
+#include <lbannv2/memory/policy_allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+#include <lbannv2/utils/gpu_utils.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+using lbannv2::DeferredFree;
+
+namespace
+{
+
+// Restores the threshold on scope exit.
+struct ThresholdGuard
+{
+  size_t const old = DeferredFree::instance().threshold();
+  ThresholdGuard(size_t const nbytes)
+  {
+    DeferredFree::instance().set_threshold(nbytes);
+  }
+  ~ThresholdGuard()
+  {
+    DeferredFree::instance().drain();
+    DeferredFree::instance().set_threshold(old);
+  }
+};
+
+void wait_for_empty_queue()
+{
+  auto& queue = DeferredFree::instance();
+  for (int i = 0; i < 500 && queue.pending_bytes(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+}  // namespace
+
+TEST_CASE("Large frees are deferred", "[memory][deferred]")
+{
+  ThresholdGuard guard(size_t {1} << 20);
+  auto& queue = DeferredFree::instance();
+  auto& alloc = lbannv2::HugePageAllocator::instance();
+  auto const base = queue.stats();
+  auto const base_mapped = alloc.stats().mapped_bytes;
+
+  // Small frees are not deferred.
+  alloc.allocate(100);
+  CHECK(queue.stats().num_deferred == base.num_deferred);
+
+  size_t const nbytes = size_t {4} << 20;
+  void* raw_ptr = nullptr;
+  {
+    auto ptr = alloc.allocate(nbytes);
+    raw_ptr = ptr.get();
+  }
+  // Deregistered right away, whether or not it has been released.
+  CHECK_FALSE(lbannv2::pointer_registry().known(raw_ptr));
+  CHECK(queue.stats().num_deferred == base.num_deferred + 1);
+
+  wait_for_empty_queue();
+  auto const stats = queue.stats();
+  CHECK(stats.queue_depth == 0UL);
+  CHECK(stats.pending_bytes == 0UL);
+  CHECK(stats.num_released == base.num_released + 1);
+  CHECK(stats.max_queue_depth >= 1UL);
+  CHECK(stats.total_latency_ns > base.total_latency_ns);
+  CHECK(alloc.stats().mapped_bytes == base_mapped);
+}
+
+TEST_CASE("Deferred frees count against the budget", "[memory][deferred]")
+{
+  ThresholdGuard guard(1);
+  auto& queue = DeferredFree::instance();
+  auto& budget = lbannv2::memory_budget();
+  auto policy = lbannv2::make_policy_allocator("tracking");
+  auto const base_usage = budget.usage();
+
+  // The worker may or may not have caught up, but whatever it has
+  // not released yet is still counted.
+  size_t const nbytes = size_t {1} << 16;
+  std::vector<c10::DataPtr> ptrs;
+  for (int i = 0; i < 64; ++i)
+    ptrs.push_back(policy->allocate(nbytes));
+  ptrs.clear();
+
+  auto const pending = queue.pending_bytes();
+  auto const usage = budget.usage();
+  CHECK(usage <= base_usage + pending);
+  CHECK(usage <= base_usage + 64 * nbytes);
+
+  SECTION("Memory pressure drains the queue")
+  {
+    budget.reclaim(lbannv2::MemoryBudget::Pressure::Hard, 0);
+    CHECK(queue.pending_bytes() == 0UL);
+    CHECK(budget.usage() == base_usage);
+  }
+
+  SECTION("Destroying an allocator drains its frees")
+  {
+    policy.reset();
+    CHECK(queue.pending_bytes() == 0UL);
+  }
+
+  CHECK(queue.stats().num_released >= 64UL);
+}
+
+TEST_CASE("Frees deferred until work completes", "[memory][deferred]")
+{
+  auto& queue = DeferredFree::instance();
+  auto policy = lbannv2::make_policy_allocator("tracking");
+  auto const base = queue.stats();
+
+  // Not subject to the threshold.
+  REQUIRE(queue.threshold() == 0UL);
+  size_t const nbytes = 100;
+  void* const ptr = policy->raw_alloc(nbytes);
+  REQUIRE(policy->stats().tracked->current_allocations == 1UL);
+
+  std::promise<void> done;
+  auto work = done.get_future().share();
+  queue.defer_after(*policy, ptr, nbytes, [work] { work.wait(); });
+  CHECK(queue.stats().num_deferred == base.num_deferred + 1);
+  CHECK(queue.pending_bytes() >= nbytes);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  CHECK(policy->stats().tracked->current_allocations == 1UL);
+
+  done.set_value();
+  wait_for_empty_queue();
+  CHECK(policy->stats().tracked->current_allocations == 0UL);
+  CHECK(queue.stats().num_released == base.num_released + 1);
+}
+
+#if LBANNV2_HAS_HOST_STREAMS
+TEST_CASE("Frees deferred on an emulated stream", "[memory][deferred]")
+{
+  namespace gpu = lbannv2::gpu;
+  auto& queue = DeferredFree::instance();
+  auto policy = lbannv2::make_policy_allocator("tracking");
+
+  auto* const stream = gpu::host_allocation_stream(0);
+  CHECK(gpu::host_allocation_stream(0) == stream);
+
+  std::promise<void> go;
+  auto started = go.get_future().share();
+  gpu::launch_host_func(stream, [started] { started.wait(); });
+
+  size_t const nbytes = 100;
+  queue.defer_on_stream(*policy, policy->raw_alloc(nbytes), nbytes, stream);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  CHECK(policy->stats().tracked->current_allocations == 1UL);
+
+  go.set_value();
+  gpu::sync(stream);
+  wait_for_empty_queue();
+  CHECK(policy->stats().tracked->current_allocations == 0UL);
+}
+#endif
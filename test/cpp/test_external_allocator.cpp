@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/external_allocator.hpp>
+#include <lbannv2/memory/memory_budget.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <vector>
+
+using EA = lbannv2::ExternalAllocator;
+
+TEST_CASE("ExternalAllocator", "[memory][external]")
+{
+  auto& alloc = EA::instance();
+  auto& registry = lbannv2::pointer_registry();
+  auto const base = alloc.stats();
+  auto const base_usage = lbannv2::memory_budget().usage();
+
+  std::vector<unsigned char> buffer(1000);
+  void* const raw = buffer.data();
+
+  SECTION("Wrapped ranges look like LBANNv2 memory")
+  {
+    int released = 0;
+    {
+      auto ptr = alloc.wrap(raw, buffer.size(), [&] { ++released; });
+      CHECK(ptr.get() == raw);
+      CHECK(lbannv2::is_managed_ptr(buffer.data() + 999));
+      CHECK(registry.get_context(buffer.data() + 500) == raw);
+      CHECK(lbannv2::allocator_of(ptr) == &alloc);
+      CHECK(alloc.stats().num_ranges == base.num_ranges + 1);
+      CHECK(alloc.registered_bytes()
+            == base.registered_bytes + buffer.size());
+      // Not counted against the budget.
+      CHECK(lbannv2::memory_budget().usage() == base_usage);
+      CHECK(released == 0);
+    }
+    CHECK(released == 1);
+    CHECK_FALSE(lbannv2::is_managed_ptr(raw));
+    CHECK(alloc.stats().num_ranges == base.num_ranges);
+  }
+
+  SECTION("The owner is kept alive")
+  {
+    auto owner = std::make_shared<int>(42);
+    std::weak_ptr<int> weak = owner;
+    {
+      auto ptr = alloc.wrap(raw, buffer.size(), std::move(owner));
+      CHECK_FALSE(weak.expired());
+    }
+    CHECK(weak.expired());
+  }
+
+  SECTION("Overlapping ranges are rejected")
+  {
+    int released = 0;
+    auto ptr = alloc.wrap(raw, 100, [&] { ++released; });
+    CHECK_THROWS(alloc.wrap(buffer.data() + 50, 100, [&] { ++released; }));
+    CHECK_THROWS(alloc.wrap(raw, 10, [&] { ++released; }));
+    CHECK(alloc.stats().num_ranges == base.num_ranges + 1);
+    ptr.clear();
+    CHECK(released == 1);
+  }
+
+  SECTION("Allocation is refused")
+  {
+    CHECK_THROWS(alloc.allocate(64));
+  }
+
+  CHECK(alloc.stats().registered_bytes == base.registered_bytes);
+}
@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/growable_allocator.hpp>
+#include <lbannv2/memory/memory_budget.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+
+using GA = lbannv2::GrowableAllocator;
+
+namespace
+{
+
+bool all_equal(void const* const ptr, size_t const n, unsigned char const v)
+{
+  auto const* const bytes = static_cast<unsigned char const*>(ptr);
+  for (size_t i = 0; i < n; ++i)
+    if (bytes[i] != v)
+      return false;
+  return true;
+}
+
+// Release a DataPtr whose memory grow() moved, and return a DataPtr
+// for the new address.
+c10::DataPtr rebind(c10::DataPtr& old, void* const ptr)
+{
+  if (ptr == old.get())
+    return std::move(old);
+  (void) old.release_context();
+  return {ptr, ptr, GA::instance().raw_deleter(), old.device()};
+}
+
+}  // namespace
+
+TEST_CASE("GrowableAllocator", "[memory][growable]")
+{
+  auto& alloc = GA::instance();
+  auto& registry = lbannv2::pointer_registry();
+  auto const orig_reserve = alloc.reserve_size();
+  auto const base = alloc.stats();
+  auto const base_registered = registry.num_registered();
+
+  SECTION("Growth within the reservation is in place")
+  {
+    alloc.set_reserve_size(size_t {4} << 20);
+    auto ptr = alloc.allocate(100);
+    CHECK(alloc.capacity(ptr.get()) == size_t {4} << 20);
+    std::memset(ptr.get(), 0x5a, 100);
+
+    void* const grown = alloc.grow(ptr.get(), size_t {1} << 20);
+    CHECK(grown == ptr.get());
+    CHECK(all_equal(grown, 100, 0x5a));
+    CHECK(all_equal(static_cast<char*>(grown) + 100, 4096 - 100, 0));
+    std::memset(grown, 0x11, size_t {1} << 20);
+
+    CHECK(registry.bytes_registered(grown) == size_t {1} << 20);
+    CHECK(registry.known(static_cast<char*>(grown) + (size_t {1} << 20) - 1));
+    CHECK(registry.num_registered() == base_registered + 1);
+    CHECK(alloc.stats().num_grown_in_place == base.num_grown_in_place + 1);
+    CHECK(alloc.stats().committed_bytes
+          == base.committed_bytes + (size_t {1} << 20));
+
+    // Shrinking only updates the registered size.
+    CHECK(alloc.grow(grown, 10) == grown);
+    CHECK(registry.bytes_registered(grown) == 10UL);
+    CHECK(alloc.grow(grown, 4096) == grown);
+    CHECK(all_equal(grown, 4096, 0x11));
+  }
+
+  SECTION("Growth past the reservation remaps")
+  {
+    alloc.set_reserve_size(size_t {64} << 10);
+    auto ptr = alloc.allocate(size_t {48} << 10);
+    void* const old = ptr.get();
+    std::memset(old, 0x7e, size_t {48} << 10);
+
+    void* const grown = alloc.grow(old, size_t {200} << 10);
+    auto moved = rebind(ptr, grown);
+    CHECK(all_equal(grown, size_t {48} << 10, 0x7e));
+    std::memset(grown, 0x01, size_t {200} << 10);
+
+    CHECK(alloc.capacity(grown) >= size_t {200} << 10);
+    CHECK(registry.bytes_registered(grown) == size_t {200} << 10);
+    CHECK(registry.num_registered() == base_registered + 1);
+    CHECK(alloc.stats().num_remapped == base.num_remapped + 1);
+    if (grown != old)
+      CHECK_FALSE(registry.known(old));
+
+    // The new reservation leaves room to grow in place again.
+    auto const in_place = alloc.stats().num_grown_in_place;
+    CHECK(alloc.grow(grown, alloc.capacity(grown)) == grown);
+    CHECK(alloc.stats().num_grown_in_place == in_place + 1);
+  }
+
+  SECTION("Growth is checked against the memory budget")
+  {
+    auto& budget = lbannv2::memory_budget();
+    auto const soft = budget.soft_limit();
+    auto const hard = budget.hard_limit();
+
+    auto ptr = alloc.allocate(4096);
+    budget.set_limits(0, budget.usage() + (size_t {1} << 20));
+    CHECK_THROWS_AS(alloc.grow(ptr.get(), size_t {64} << 20),
+                    lbannv2::OutOfMemory);
+    CHECK(registry.bytes_registered(ptr.get()) == 4096UL);
+    budget.set_limits(soft, hard);
+  }
+
+  alloc.set_reserve_size(orig_reserve);
+  auto const after = alloc.stats();
+  CHECK(after.num_allocations == base.num_allocations);
+  CHECK(after.reserved_bytes == base.reserved_bytes);
+  CHECK(registry.num_registered() == base_registered);
+}
+
+TEST_CASE("PointerRegistry::resize() and move()", "[memory][registry]")
+{
+  lbannv2::PointerRegistry registry;
+  std::vector<unsigned char> buffer(64);
+  c10::Allocator* const fake_alloc =
+    reinterpret_cast<c10::Allocator*>(&buffer[0]);
+
+  registry.add(&buffer[0], 8, fake_alloc);
+  registry.add(&buffer[32], 8, fake_alloc);
+  CHECK(registry.known(&buffer[4]));
+
+  registry.resize(&buffer[0], 16);
+  CHECK(registry.bytes_registered(&buffer[12]) == 16UL);
+  CHECK(registry.bytes_registered() == 24UL);
+  CHECK(registry.num_registered() == 2UL);
+
+  // Growing into a neighbor fails and changes nothing.
+  CHECK_THROWS_AS(registry.resize(&buffer[0], 40), std::runtime_error);
+  CHECK(registry.bytes_registered(&buffer[0]) == 16UL);
+  CHECK_THROWS_AS(registry.resize(&buffer[4], 20), std::runtime_error);
+  CHECK_THROWS_AS(registry.resize(&buffer[20], 4), lbannv2::UnknownAddress);
+
+  registry.move(&buffer[0], &buffer[48], 12);
+  CHECK_FALSE(registry.known(&buffer[4]));
+  CHECK(registry.get_context(&buffer[50]) == &buffer[48]);
+  CHECK(registry.get_allocator(&buffer[50]) == fake_alloc);
+  CHECK(registry.bytes_registered() == 20UL);
+  CHECK(registry.stats().total.total_allocations == 2UL);
+  CHECK(registry.stats().total.total_frees == 0UL);
+
+  registry.remove(&buffer[48]);
+  registry.remove(&buffer[32]);
+}
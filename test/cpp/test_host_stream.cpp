@@ -0,0 +1,194 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/utils/gpu_utils.hpp>
+#include <lbannv2/utils/host_stream.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("HostStream", "[utils][stream]")
+{
+  lbannv2::HostStream stream;
+
+  SECTION("Work runs in order, off the calling thread")
+  {
+    std::vector<int> order;
+    std::thread::id worker;
+    for (int i = 0; i < 100; ++i)
+      stream.enqueue([&, i] {
+        order.push_back(i);
+        worker = std::this_thread::get_id();
+      });
+    stream.synchronize();
+
+    REQUIRE(order.size() == 100UL);
+    for (int i = 0; i < 100; ++i)
+      CHECK(order[i] == i);
+    CHECK(worker != std::this_thread::get_id());
+    CHECK(stream.query());
+  }
+
+  SECTION("Work is asynchronous")
+  {
+    std::promise<void> go;
+    auto started = go.get_future().share();
+    stream.enqueue([started] { started.wait(); });
+    CHECK_FALSE(stream.query());
+    go.set_value();
+    stream.synchronize();
+    CHECK(stream.query());
+  }
+
+  SECTION("Errors are reported by synchronize()")
+  {
+    bool ran = false;
+    stream.enqueue([] { throw std::logic_error("first"); });
+    stream.enqueue([] { throw std::runtime_error("second"); });
+    stream.enqueue([&] { ran = true; });
+    CHECK_THROWS_AS(stream.synchronize(), std::logic_error);
+    CHECK(ran);
+    CHECK_NOTHROW(stream.synchronize());
+  }
+
+  SECTION("Destruction waits for pending work")
+  {
+    std::atomic<int> count = 0;
+    {
+      lbannv2::HostStream other;
+      for (int i = 0; i < 10; ++i)
+        other.enqueue([&] {
+          std::this_thread::sleep_for(1ms);
+          ++count;
+        });
+    }
+    CHECK(count == 10);
+  }
+}
+
+TEST_CASE("HostEvent", "[utils][stream]")
+{
+  lbannv2::HostStream producer, consumer;
+  lbannv2::HostEvent event;
+
+  SECTION("Events that were never recorded are complete")
+  {
+    CHECK(event.query());
+    event.synchronize();
+    consumer.wait(event);
+    consumer.synchronize();
+  }
+
+  SECTION("Events complete after the work before them")
+  {
+    std::promise<void> go;
+    auto started = go.get_future().share();
+    producer.enqueue([started] { started.wait(); });
+    event.record(producer);
+    CHECK_FALSE(event.query());
+    go.set_value();
+    event.synchronize();
+    CHECK(event.query());
+  }
+
+  SECTION("Streams wait for events on other streams")
+  {
+    std::promise<void> go;
+    auto started = go.get_future().share();
+    int value = 0;
+    int seen = -1;
+
+    producer.enqueue([&, started] {
+      started.wait();
+      value = 42;
+    });
+    event.record(producer);
+    consumer.wait(event);
+    consumer.enqueue([&] { seen = value; });
+
+    std::this_thread::sleep_for(5ms);
+    CHECK_FALSE(consumer.query());
+    go.set_value();
+    consumer.synchronize();
+    CHECK(seen == 42);
+  }
+
+  SECTION("Waits refer to the record current when they were issued")
+  {
+    std::promise<void> go;
+    auto started = go.get_future().share();
+    producer.enqueue([started] { started.wait(); });
+    event.record(producer);
+    consumer.wait(event);
+
+    // Re-recording on an idle stream does not release the wait.
+    lbannv2::HostStream idle;
+    event.record(idle);
+    event.synchronize();
+    std::this_thread::sleep_for(5ms);
+    CHECK_FALSE(consumer.query());
+
+    go.set_value();
+    consumer.synchronize();
+  }
+
+  SECTION("Elapsed time")
+  {
+    lbannv2::HostEvent end;
+    event.record(producer);
+    producer.enqueue([] { std::this_thread::sleep_for(2ms); });
+    end.record(producer);
+    end.synchronize();
+    CHECK(lbannv2::HostEvent::elapsed_ms(event, end) >= 2.f);
+    lbannv2::HostEvent const never;
+    CHECK_THROWS_AS(lbannv2::HostEvent::elapsed_ms(event, never),
+                    std::runtime_error);
+  }
+}
+
+#if LBANNV2_HAS_HOST_STREAMS
+TEST_CASE("gpu:: streams on the host", "[utils][stream]")
+{
+  namespace gpu = lbannv2::gpu;
+  STATIC_REQUIRE(lbannv2::has_host_streams());
+
+  auto* const a = gpu::make_stream();
+  auto* const b = gpu::make_nonblocking_stream();
+  auto* const event = gpu::make_event();
+  CHECK(b->nonblocking());
+
+  std::promise<void> go;
+  auto started = go.get_future().share();
+  int value = 0;
+  int seen = -1;
+  gpu::launch_host_func(a, [&, started] {
+    started.wait();
+    value = 7;
+  });
+  gpu::record_event(event, a);
+  gpu::wait_event(b, event);
+  gpu::launch_host_func(b, [&] { seen = value; });
+
+  CHECK_FALSE(gpu::query_event(event));
+  go.set_value();
+  gpu::sync_event(event);
+  CHECK(gpu::query_event(event));
+  gpu::sync(b);
+  CHECK(seen == 7);
+
+  gpu::destroy_event(event);
+  gpu::destroy_stream(b);
+  gpu::destroy_stream(a);
+}
+#endif
@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/huge_page_allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+using HPA = lbannv2::HugePageAllocator;
+
+TEST_CASE("HugePageAllocator::allocate", "[memory][hugepage]")
+{
+  auto& alloc = HPA::instance();
+  alloc.set_threshold(HPA::kHugePageSize);
+  auto const base = alloc.stats();
+
+  SECTION("Small allocations fall through to the heap")
+  {
+    auto ptr = alloc.allocate(100);
+    CHECK(lbannv2::pointer_registry().known(ptr.get()));
+    auto const stats = alloc.stats();
+    CHECK(stats.small_bytes == base.small_bytes + 100);
+    CHECK(stats.mapped_bytes == base.mapped_bytes);
+  }
+
+  SECTION("Large allocations are huge-page aligned")
+  {
+    size_t const size = HPA::kHugePageSize + 1;
+    void* raw_ptr = nullptr;
+    {
+      auto ptr = alloc.allocate(size);
+      raw_ptr = ptr.get();
+      CHECK(reinterpret_cast<std::uintptr_t>(raw_ptr) % HPA::kHugePageSize
+            == 0);
+      CHECK(lbannv2::pointer_registry().known(raw_ptr));
+
+      // Fault it in; it should be usable.
+      std::memset(raw_ptr, 1, size);
+
+      auto const stats = alloc.stats();
+      CHECK(stats.mapped_bytes
+            == base.mapped_bytes + 2 * HPA::kHugePageSize);
+      CHECK(stats.huge_backed_bytes <= stats.mapped_bytes);
+    }
+    CHECK_FALSE(lbannv2::pointer_registry().known(raw_ptr));
+    CHECK(alloc.stats().mapped_bytes == base.mapped_bytes);
+  }
+
+  SECTION("The threshold is adjustable")
+  {
+    alloc.set_threshold(4096);
+    auto ptr = alloc.allocate(8192);
+    CHECK(reinterpret_cast<std::uintptr_t>(ptr.get()) % HPA::kHugePageSize
+          == 0);
+    CHECK(alloc.stats().mapped_bytes
+          == base.mapped_bytes + HPA::kHugePageSize);
+    alloc.set_threshold(HPA::kHugePageSize);
+  }
+}
@@ -0,0 +1,277 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/memory_budget.hpp>
+#include <lbannv2/memory/policy_allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using Pressure = lbannv2::MemoryBudget::Pressure;
+
+namespace
+{
+
+void write_file(fs::path const& path, std::string const& contents)
+{
+  fs::create_directories(path.parent_path());
+  std::ofstream(path) << contents;
+}
+
+// Restores the global budget's limits on scope exit.
+struct LimitsGuard
+{
+  size_t soft = lbannv2::memory_budget().soft_limit();
+  size_t hard = lbannv2::memory_budget().hard_limit();
+  ~LimitsGuard() { lbannv2::memory_budget().set_limits(soft, hard); }
+};
+
+// Fails the first "failures" allocations.
+class FlakyBacking : public lbannv2::MallocBacking
+{
+public:
+  explicit FlakyBacking(int& failures) : m_failures {&failures} {}
+
+  void* allocate(size_t const nbytes)
+  {
+    if (*m_failures > 0)
+    {
+      --*m_failures;
+      throw std::bad_alloc();
+    }
+    return MallocBacking::allocate(nbytes);
+  }
+
+private:
+  int* m_failures;
+};
+
+}  // namespace
+
+TEST_CASE("cgroup_memory_limit", "[memory][budget]")
+{
+  auto const root = fs::temp_directory_path()
+                    / ("lbannv2-cgroup-" + std::to_string(getpid()));
+  auto const proc = root / "cgroup";
+  auto const sys = root / "sys";
+
+  SECTION("No cgroup file")
+  {
+    CHECK_FALSE(lbannv2::cgroup_memory_limit(proc, sys));
+  }
+
+  SECTION("v2, unlimited")
+  {
+    write_file(proc, "0::/job\n");
+    write_file(sys / "job/memory.max", "max\n");
+    CHECK_FALSE(lbannv2::cgroup_memory_limit(proc, sys));
+  }
+
+  SECTION("v2, limited by an ancestor")
+  {
+    write_file(proc, "0::/job/step\n");
+    write_file(sys / "job/step/memory.max", "max\n");
+    write_file(sys / "job/memory.max", "1073741824\n");
+    CHECK(lbannv2::cgroup_memory_limit(proc, sys) == 1073741824UL);
+  }
+
+  SECTION("v1")
+  {
+    write_file(proc, "12:cpu,cpuacct:/job\n4:memory:/job\n");
+    write_file(sys / "memory/job/memory.limit_in_bytes", "536870912\n");
+    write_file(sys / "memory/memory.limit_in_bytes", "9223372036854771712\n");
+    CHECK(lbannv2::cgroup_memory_limit(proc, sys) == 536870912UL);
+  }
+
+  fs::remove_all(root);
+}
+
+TEST_CASE("MemoryBudget reclaimers", "[memory][budget]")
+{
+  lbannv2::MemoryBudget budget;
+  std::vector<Pressure> calls;
+  auto const handle = budget.add_reclaimer([&](Pressure p, size_t) {
+    calls.push_back(p);
+    return size_t {10};
+  });
+  budget.add_reclaimer([](Pressure, size_t) -> size_t {
+    throw std::runtime_error("ignored");
+  });
+
+  CHECK(budget.reclaim(Pressure::Hard, 100) == 10UL);
+  REQUIRE(calls.size() == 1UL);
+  CHECK(calls.front() == Pressure::Hard);
+
+  budget.remove_reclaimer(handle);
+  CHECK(budget.reclaim(Pressure::Hard, 100) == 0UL);
+  CHECK(calls.size() == 1UL);
+}
+
+TEST_CASE("MemoryBudget reclaim does not wait for another thread",
+          "[memory][budget]")
+{
+  lbannv2::MemoryBudget budget;
+  std::promise<void> entered, go;
+  auto release = go.get_future().share();
+  budget.add_reclaimer([&, release](Pressure, size_t) {
+    entered.set_value();
+    release.wait();
+    return size_t {10};
+  });
+
+  auto first = std::async(std::launch::async, [&] {
+    return budget.reclaim(Pressure::Hard, 100);
+  });
+  entered.get_future().wait();
+  CHECK(budget.reclaim(Pressure::Hard, 100) == 0UL);
+  go.set_value();
+  CHECK(first.get() == 10UL);
+}
+
+TEST_CASE("MemoryBudget reservations", "[memory][budget]")
+{
+  lbannv2::MemoryBudget budget;
+  auto const base = budget.usage();
+
+  SECTION("Without limits, nothing is reserved")
+  {
+    auto const r = budget.admit(100);
+    CHECK(r.bytes() == 0UL);
+    CHECK(budget.usage() == base);
+  }
+
+  SECTION("Admitted bytes count until they are released")
+  {
+    budget.set_limits(0, base + 100);
+    {
+      auto const r = budget.admit(60);
+      CHECK(r.bytes() == 60UL);
+      CHECK(budget.usage() == base + 60);
+      CHECK_THROWS_AS(budget.admit(60), lbannv2::OutOfMemory);
+
+      auto moved = budget.admit(40);
+      lbannv2::MemoryBudget::Reservation other = std::move(moved);
+      CHECK(moved.bytes() == 0UL);
+      CHECK(budget.usage() == base + 100);
+    }
+    CHECK(budget.usage() == base);
+    CHECK_NOTHROW(budget.admit(100));
+  }
+
+  SECTION("Only host memory counts")
+  {
+    budget.set_limits(0, base + 100);
+    std::vector<std::byte> buffer(1000);
+    auto& registry = lbannv2::pointer_registry();
+    registry.add(
+      buffer.data(), buffer.size(), nullptr, c10::Device {c10::kCUDA, 0});
+    CHECK(budget.usage() == base);
+    CHECK_NOTHROW(budget.admit(100));
+    registry.remove(buffer.data());
+  }
+}
+
+TEST_CASE("MemoryBudget limits", "[memory][budget]")
+{
+  auto& registry = lbannv2::pointer_registry();
+  lbannv2::MemoryBudget budget;
+
+  auto const base = budget.usage();
+  budget.set_limits(base + 1000, base + 2000);
+
+  // Stands in for a tensor a reclaimer could spill.
+  std::vector<std::byte> spillable(1500);
+  registry.add(spillable.data(), spillable.size(), nullptr);
+  bool spilled = false;
+
+  std::vector<Pressure> calls;
+  budget.add_reclaimer([&](Pressure p, size_t) {
+    calls.push_back(p);
+    if (p == Pressure::Hard && !spilled)
+    {
+      registry.remove(spillable.data());
+      spilled = true;
+      return size_t {1500};
+    }
+    return size_t {0};
+  });
+
+  // Over the soft limit: reclaims once, but admits.
+  CHECK_NOTHROW(budget.admit(0));
+  CHECK(calls == std::vector<Pressure> {Pressure::Soft});
+  CHECK_NOTHROW(budget.admit(100));
+  CHECK(calls.size() == 1UL);
+
+  // Over the hard limit: the reclaimer spills enough.
+  CHECK_NOTHROW(budget.admit(1000));
+  CHECK(spilled);
+  CHECK(calls.back() == Pressure::Hard);
+
+  // Back under the soft limit re-arms it.
+  CHECK_NOTHROW(budget.admit(0));
+  calls.clear();
+  CHECK_NOTHROW(budget.admit(1500));
+  CHECK(calls == std::vector<Pressure> {Pressure::Soft});
+
+  // Nothing left to spill.
+  CHECK_THROWS_AS(budget.admit(2500), lbannv2::OutOfMemory);
+
+  if (!spilled)
+    registry.remove(spillable.data());
+}
+
+TEST_CASE("Allocations retry after reclaiming", "[memory][budget]")
+{
+  LimitsGuard guard;
+  auto& budget = lbannv2::memory_budget();
+  budget.set_limits(0, 0);
+
+  int failures = 0;
+  int reclaims = 0;
+  auto const handle = budget.add_reclaimer([&](Pressure p, size_t) {
+    if (p == Pressure::Failed)
+      ++reclaims;
+    return size_t {0};
+  });
+
+  lbannv2::PolicyAllocator<FlakyBacking> alloc(failures);
+
+  SECTION("One failure is retried")
+  {
+    failures = 1;
+    auto ptr = alloc.allocate(64);
+    CHECK(ptr.get() != nullptr);
+    CHECK(lbannv2::pointer_registry().known(ptr.get()));
+    CHECK(reclaims == 1);
+  }
+
+  SECTION("Two failures throw")
+  {
+    failures = 2;
+    CHECK_THROWS_AS(alloc.allocate(64), lbannv2::OutOfMemory);
+    CHECK(reclaims == 1);
+  }
+
+  SECTION("The hard limit applies to allocate()")
+  {
+    budget.set_limits(0, budget.usage() + 100);
+    CHECK_THROWS_AS(alloc.allocate(101), lbannv2::OutOfMemory);
+    CHECK_NOTHROW(alloc.allocate(100));
+  }
+
+  budget.remove_reclaimer(handle);
+}
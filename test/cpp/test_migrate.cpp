@@ -0,0 +1,322 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2_config.h>
+
+#include <lbannv2/memory/coherent_memory.hpp>
+#include <lbannv2/ops/migrate.hpp>
+
+#include <ATen/ATen.h>
+#include <ATen/EmptyTensor.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+using ECM = lbannv2::EmulatedCoherentMemory;
+
+namespace
+{
+
+// Installs an emulated domain for the duration of a test.
+struct DomainGuard
+{
+  lbannv2::CoherentMemoryDomain* const prev;
+  explicit DomainGuard(ECM& domain) : prev {lbannv2::coherent_memory_domain()}
+  {
+    domain.set_current_device(0);
+    lbannv2::set_coherent_memory_domain(&domain);
+  }
+  ~DomainGuard() { lbannv2::set_coherent_memory_domain(prev); }
+};
+
+// A CPU tensor in memory of an emulated domain.
+at::Tensor coherent_empty(ECM& domain, at::IntArrayRef const sizes)
+{
+  return at::detail::empty_generic(sizes,
+                                   &domain.host_allocator(),
+                                   c10::DispatchKeySet {c10::DispatchKey::CPU},
+                                   at::kFloat,
+                                   std::nullopt);
+}
+
+// Blocks a device stream until released, like a long kernel.
+struct Kernel
+{
+  std::promise<void> go;
+  Kernel(ECM& domain, c10::Device const& device)
+  {
+    domain.stream(device).enqueue(
+      [done = go.get_future().share()] { done.wait(); });
+  }
+  void finish() { go.set_value(); }
+};
+
+}  // namespace
+
+TEST_CASE("migrate_many on the emulated domain", "[ops][migrate]")
+{
+  ECM domain {1};
+  DomainGuard guard {domain};
+  c10::Device const cpu {c10::kCPU};
+  c10::Device const dev {c10::kCUDA, 0};
+
+  auto base = coherent_empty(domain, {64});
+  auto other = coherent_empty(domain, {16});
+  auto const before = domain.stats();
+
+  SECTION("A bad tensor leaves the whole batch unmigrated")
+  {
+    // Memory from another allocator is tied to the host.
+    auto bad = at::empty({16});
+    CHECK_THROWS_AS(lbannv2::migrate_many({base, other, bad}, dev),
+                    std::runtime_error);
+    CHECK(base.storage().device() == cpu);
+    CHECK(other.storage().device() == cpu);
+    CHECK(domain.stats().num_to_device == before.num_to_device);
+  }
+
+  SECTION("Shared storage is rebranded once")
+  {
+    std::vector<at::Tensor> const ts {base,
+                                      base.narrow(0, 8, 16),
+                                      base.view({8, 8}).t(),
+                                      base.slice(0, 1, 64, 2),
+                                      other};
+    auto const out = lbannv2::migrate_many(ts, dev);
+    REQUIRE(out.size() == ts.size());
+    CHECK(domain.stats().num_to_device == before.num_to_device + 2);
+    for (size_t i = 0; i < ts.size(); ++i)
+    {
+      CHECK(out[i].device() == dev);
+      CHECK(out[i].const_data_ptr() == ts[i].const_data_ptr());
+    }
+    for (size_t i = 1; i < 4; ++i)
+      CHECK(out[i].storage().unsafeGetStorageImpl()
+            == out[0].storage().unsafeGetStorageImpl());
+
+    auto const back = lbannv2::migrate_many(out, cpu);
+    CHECK(domain.stats().num_to_host == before.num_to_host + 2);
+    CHECK(back[0].device() == cpu);
+  }
+
+  SECTION("Each source device is synchronized once")
+  {
+    std::vector<at::Tensor> const ts {base, base.narrow(0, 0, 8), other};
+    auto const out = lbannv2::migrate_many(ts, dev);
+    // Nothing was on a device before.
+    CHECK(domain.stats().num_synchronizations
+          == before.num_synchronizations);
+
+    (void) lbannv2::migrate_many(out, cpu);
+    CHECK(domain.stats().num_synchronizations
+          == before.num_synchronizations + 1);
+  }
+
+  SECTION("Tied weights map to a single output")
+  {
+    auto const out = lbannv2::migrate_many({base, other, base}, dev);
+    REQUIRE(out.size() == 3UL);
+    CHECK(out[0].unsafeGetTensorImpl() == out[2].unsafeGetTensorImpl());
+    CHECK(out[0].unsafeGetTensorImpl() != out[1].unsafeGetTensorImpl());
+    CHECK(domain.stats().num_to_device == before.num_to_device + 2);
+    (void) lbannv2::migrate_many(out, cpu);
+  }
+
+  SECTION("Tensors on the target device are returned as they are")
+  {
+    auto const out = lbannv2::migrate_many({base, other}, cpu);
+    CHECK(out[0].unsafeGetTensorImpl() == base.unsafeGetTensorImpl());
+    CHECK(out[1].unsafeGetTensorImpl() == other.unsafeGetTensorImpl());
+    CHECK(domain.stats().num_to_host == before.num_to_host);
+  }
+}
+
+TEST_CASE("Migrated views on the emulated domain", "[ops][migrate]")
+{
+  ECM domain {1};
+  DomainGuard guard {domain};
+  c10::Device const cpu {c10::kCPU};
+  c10::Device const dev {c10::kCUDA, 0};
+
+  auto base = coherent_empty(domain, {8, 8});
+  auto* const storage = base.storage().unsafeGetStorageImpl();
+
+  // The tensor in out aliases t on the storage of base.
+  auto const check_alias = [&](at::Tensor const& out, at::Tensor const& t) {
+    CHECK(out.device() == dev);
+    CHECK(out.storage().unsafeGetStorageImpl() == storage);
+    CHECK(out.storage_offset() == t.storage_offset());
+    CHECK(out.sizes() == t.sizes());
+    CHECK(out.strides() == t.strides());
+    CHECK(out.const_data_ptr() == t.const_data_ptr());
+    CHECK_FALSE(out.is_inference());
+  };
+
+  SECTION("Strided slices, offsets and transposes")
+  {
+    for (auto const& t : {base.slice(1, 1, 8, 3),
+                          base.narrow(0, 2, 4),
+                          base.t(),
+                          base.view({64}).slice(0, 5, 64, 7)})
+    {
+      auto v = t;
+      check_alias(lbannv2::migrate(v, dev), t);
+    }
+  }
+
+  SECTION("Two views of one storage")
+  {
+    auto const a = base.narrow(0, 4, 2);
+    auto const b = base.t().narrow(1, 1, 3);
+    auto const out = lbannv2::migrate_many({a, b}, dev);
+    REQUIRE(out.size() == 2UL);
+    check_alias(out[0], a);
+    check_alias(out[1], b);
+    CHECK(out[0].unsafeGetTensorImpl() != out[1].unsafeGetTensorImpl());
+    CHECK(domain.stats().num_to_device == 1UL);
+
+    // Writes through one alias are seen by the other's version.
+    auto const version = out[1]._version();
+    out[0].unsafeGetTensorImpl()->bump_version();
+    CHECK(out[1]._version() == version + 1);
+  }
+
+  SECTION("Back to the CPU")
+  {
+    auto const t = base.narrow(1, 2, 5);
+    auto const out = lbannv2::migrate_many({t}, dev);
+    auto const back = lbannv2::migrate_many(out, cpu);
+    CHECK(back[0].device() == cpu);
+    CHECK(back[0].storage_offset() == t.storage_offset());
+    CHECK(back[0].strides() == t.strides());
+    CHECK_FALSE(back[0].is_inference());
+  }
+}
+
+#if LBANNV2_HAS_GPU
+// Gradients return through device kernels.
+TEST_CASE("Migrated tensors and autograd", "[ops][migrate]")
+{
+  ECM domain {1};
+  DomainGuard guard {domain};
+  c10::Device const cpu {c10::kCPU};
+  c10::Device const dev {c10::kCUDA, 0};
+
+  auto x = coherent_empty(domain, {32});
+  x.fill_(1.f);
+  x.requires_grad_(true);
+
+  SECTION("Backward through a migrated tensor")
+  {
+    auto const on_dev = lbannv2::migrate_many({x}, dev)[0];
+    REQUIRE(on_dev.requires_grad());
+    auto const back = lbannv2::migrate_many({on_dev}, cpu)[0];
+    (back * 3.f).sum().backward();
+    REQUIRE(x.grad().defined());
+    CHECK(x.grad().device() == cpu);
+    CHECK(x.grad().equal(at::full({32}, 3.f)));
+  }
+
+  SECTION("Views of a tensor that requires grad stay views")
+  {
+    auto const v = x.narrow(0, 8, 16);
+    auto const w = x.slice(0, 0, 32, 4);
+    auto const out = lbannv2::migrate_many({v, w}, dev);
+    for (auto const& o : out)
+    {
+      REQUIRE(o.is_view());
+      CHECK(o.requires_grad());
+      CHECK(o._base().unsafeGetTensorImpl()
+            == out[0]._base().unsafeGetTensorImpl());
+    }
+    CHECK(out[0].storage_offset() == 8);
+    CHECK(out[1].strides() == w.strides());
+
+    auto const back = lbannv2::migrate_many(out, cpu);
+    (back[0].sum() + back[1].sum()).backward();
+    auto expected = at::zeros({32});
+    expected.narrow(0, 8, 16).add_(1.f);
+    expected.slice(0, 0, 32, 4).add_(1.f);
+    CHECK(x.grad().equal(expected));
+  }
+}
+#endif
+
+TEST_CASE("migrate_async on the emulated domain", "[ops][migrate]")
+{
+  ECM domain {2};
+  DomainGuard guard {domain};
+  c10::Device const cpu {c10::kCPU};
+  c10::Device const dev0 {c10::kCUDA, 0};
+  c10::Device const dev1 {c10::kCUDA, 1};
+
+  auto t = coherent_empty(domain, {64});
+  auto const before = domain.stats();
+
+  SECTION("Nothing to wait for when coming from the CPU")
+  {
+    auto [out, handle] = lbannv2::migrate_async(t, dev0);
+    CHECK(out.device() == dev0);
+    CHECK(handle.ready());
+  }
+
+  SECTION("Leaving a busy device waits for its work")
+  {
+    auto on_dev = lbannv2::migrate_many({t}, dev0)[0];
+    Kernel kernel {domain, dev0};
+
+    auto [out, handle] = lbannv2::migrate_async(on_dev, cpu);
+    CHECK(out.device() == cpu);
+    CHECK(out.const_data_ptr() == t.const_data_ptr());
+    CHECK_FALSE(handle.ready());
+
+    kernel.finish();
+    handle.wait();
+    CHECK(handle.ready());
+  }
+
+  SECTION("Another device's stream waits without blocking the host")
+  {
+    auto on_dev = lbannv2::migrate_many({t}, dev0)[0];
+    Kernel kernel {domain, dev0};
+    auto [out, handle] = lbannv2::migrate_async(on_dev, cpu);
+
+    bool ran = false;
+    handle.wait_on(domain.current_stream(dev1));
+    domain.stream(dev1).enqueue([&] { ran = true; });
+    CHECK_FALSE(domain.stream(dev1).query());
+
+    kernel.finish();
+    domain.synchronize(dev1);
+    CHECK(ran);
+    CHECK(handle.ready());
+  }
+
+  SECTION("Each source device gets a fence")
+  {
+    domain.set_current_device(1);
+    auto u = coherent_empty(domain, {16});
+    auto const on_dev0 = lbannv2::migrate_many({t}, dev0)[0];
+    auto const on_dev1 = lbannv2::migrate_many({u}, dev1)[0];
+
+    // Device 0 is idle; the handle still waits for device 1.
+    Kernel kernel {domain, dev1};
+    auto [out, handle] = lbannv2::migrate_many_async({on_dev0, on_dev1}, cpu);
+    CHECK(out[0].device() == cpu);
+    CHECK(out[1].device() == cpu);
+    CHECK_FALSE(handle.ready());
+
+    kernel.finish();
+    handle.wait();
+    CHECK(handle.ready());
+  }
+
+  // The asynchronous migrations never synchronize a device.
+  CHECK(domain.stats().num_synchronizations == before.num_synchronizations);
+}
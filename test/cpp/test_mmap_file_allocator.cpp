@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/mmap_file_allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+
+using MFA = lbannv2::MmapFileAllocator;
+
+TEST_CASE("MmapFileAllocator", "[memory][mmap]")
+{
+  auto& alloc = MFA::instance();
+  auto const base = alloc.stats();
+
+  size_t const size = 3 << 20;
+  void* raw_ptr = nullptr;
+  {
+    auto ptr = alloc.allocate(size);
+    raw_ptr = ptr.get();
+    REQUIRE(raw_ptr != nullptr);
+    CHECK(lbannv2::is_managed_ptr(raw_ptr));
+    CHECK(alloc.stats().num_files == base.num_files + 1);
+
+    auto* const bytes = static_cast<unsigned char*>(raw_ptr);
+    std::memset(bytes, 0x5a, size);
+
+    SECTION("Advice is accepted")
+    {
+      CHECK_NOTHROW(alloc.advise(bytes, size, MFA::Advice::Sequential));
+      CHECK_NOTHROW(alloc.advise(bytes + 100, 10, MFA::Advice::WillNeed));
+      CHECK_NOTHROW(alloc.advise(bytes, size, MFA::Advice::Normal));
+    }
+
+    SECTION("Dropped pages come back from the file")
+    {
+      REQUIRE_NOTHROW(alloc.advise(bytes, size, MFA::Advice::DontNeed));
+      CHECK(bytes[0] == 0x5a);
+      CHECK(bytes[size - 1] == 0x5a);
+    }
+
+    SECTION("Advice on foreign memory is rejected")
+    {
+      int x;
+      CHECK_THROWS_AS(alloc.advise(&x, sizeof(x), MFA::Advice::DontNeed),
+                      lbannv2::UnknownAddress);
+    }
+  }
+  CHECK_FALSE(lbannv2::is_managed_ptr(raw_ptr));
+  CHECK(alloc.stats().mapped_bytes == base.mapped_bytes);
+}
+
+TEST_CASE("MmapFileAllocator with a bad directory", "[memory][mmap]")
+{
+  auto& alloc = MFA::instance();
+  auto const dir = alloc.directory();
+  alloc.set_directory("/this/directory/does/not/exist");
+  CHECK_THROWS(alloc.allocate(64));
+  alloc.set_directory(dir);
+}
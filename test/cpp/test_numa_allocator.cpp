@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/numa_allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+
+size_t total_bytes(lbannv2::NumaAllocator const& alloc)
+{
+  auto const bytes = alloc.bytes_by_node();
+  return std::accumulate(bytes.cbegin(), bytes.cend(), size_t {0});
+}
+
+}  // namespace
+
+TEST_CASE("NumaAllocator", "[memory][numa]")
+{
+  using Policy = lbannv2::NumaPlacement::Policy;
+
+  auto& alloc = lbannv2::NumaAllocator::instance();
+  REQUIRE_FALSE(alloc.nodes().empty());
+
+  auto const node = alloc.nodes().back();
+  auto const placement = GENERATE_COPY(
+    lbannv2::NumaPlacement {Policy::Local},
+    lbannv2::NumaPlacement {Policy::Interleave},
+    lbannv2::NumaPlacement {Policy::Bind, node});
+
+  auto const orig = alloc.set_placement(placement);
+  auto const base = total_bytes(alloc);
+
+  size_t const size = (1 << 20) + 100;
+  void* raw_ptr = nullptr;
+  {
+    auto ptr = alloc.allocate(size);
+    raw_ptr = ptr.get();
+    CHECK(lbannv2::pointer_registry().known(raw_ptr));
+    CHECK(total_bytes(alloc) == base + size);
+    CHECK(total_bytes(alloc)
+          == lbannv2::pointer_registry()
+               .stats()
+               .by_allocator.at(&alloc)
+               .current_bytes);
+
+    auto const intended = alloc.intended_node(static_cast<char*>(raw_ptr) + 9);
+    if (placement.policy == Policy::Interleave && alloc.nodes().size() > 1)
+      CHECK(intended == -1);
+    else if (placement.policy == Policy::Bind && alloc.nodes().size() > 1)
+      CHECK(intended == node);
+    else
+      CHECK(intended >= 0);
+
+    std::memset(raw_ptr, 0, size);
+    auto const actual = lbannv2::NumaAllocator::node_of(raw_ptr);
+    if (placement.policy == Policy::Bind && actual >= 0)
+      CHECK(actual == node);
+  }
+  CHECK_FALSE(lbannv2::pointer_registry().known(raw_ptr));
+  CHECK(total_bytes(alloc) == base);
+
+  alloc.set_placement(orig);
+}
+
+TEST_CASE("NumaAllocator rejects offline nodes", "[memory][numa]")
+{
+  using Policy = lbannv2::NumaPlacement::Policy;
+
+  auto& alloc = lbannv2::NumaAllocator::instance();
+  auto const& nodes = alloc.nodes();
+  auto const bad = *std::max_element(nodes.cbegin(), nodes.cend()) + 1;
+  CHECK_THROWS(alloc.set_placement({Policy::Bind, bad}));
+  CHECK_THROWS(alloc.set_placement({Policy::Bind, -1}));
+}
@@ -5,10 +5,20 @@
 // SPDX-License-Identifier: Apache-2.0
 ////////////////////////////////////////////////////////////////////////////////
 #include <lbannv2/memory/registry.hpp>
+#include <lbannv2/memory/registry_index.hpp>
 
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <catch2/generators/catch_generators_range.hpp>
 #include <catch2/matchers/catch_matchers_string.hpp>
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
 TEST_CASE("RangeLessAndDisjoint", "[memory][registry]")
 {
   std::vector<unsigned char> buffer(8);
@@ -67,6 +77,26 @@ TEST_CASE("RangeLessAndDisjoint", "[memory][registry]")
 
 namespace
 {
+using Mode = lbannv2::PointerRegistry::Mode;
+using Index = lbannv2::PointerRegistry::Index;
+
+struct RegistryConfig
+{
+  Mode mode;
+  Index index;
+};
+
+// Every registry configuration should behave identically.
+std::vector<RegistryConfig> const& all_configs()
+{
+  static std::vector<RegistryConfig> const configs = {
+    {Mode::Locked, Index::RangeMap},
+    {Mode::Locked, Index::PageMap},
+    {Mode::ReadMostly, Index::RangeMap},
+  };
+  return configs;
+}
+
 size_t rng_bytes(std::pair<void*, void*> const& r)
 {
   return std::distance((std::byte*) r.first, (std::byte*) r.second);
@@ -77,7 +107,8 @@ TEST_CASE("PointerRegistry::add()", "[memory][registry]")
 {
   using RangeT = std::pair<void*, void*>;
 
-  lbannv2::PointerRegistry registry;
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
   std::vector<unsigned char> buffer(32);
 
   // Establish preconditions
@@ -170,7 +201,8 @@ TEST_CASE("PointerRegistry::remove()", "[memory][registry]")
 {
   using RangeT = std::pair<void*, void*>;
 
-  lbannv2::PointerRegistry registry;
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
   std::vector<unsigned char> buffer(32);
 
   // Establish preconditions
@@ -235,7 +267,8 @@ TEST_CASE("PointerRegistry::known()", "[memory][registry]")
 {
   using RangeT = std::pair<void*, void*>;
 
-  lbannv2::PointerRegistry registry;
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
   std::vector<unsigned char> buffer(32);
 
   // Establish preconditions
@@ -287,7 +320,8 @@ TEST_CASE("PointerRegistry::get_context()", "[memory][registry]")
 {
   using RangeT = std::pair<void*, void*>;
 
-  lbannv2::PointerRegistry registry;
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
   std::vector<unsigned char> buffer(32);
 
   // Establish preconditions
@@ -363,7 +397,8 @@ TEST_CASE("PointerRegistry::unsafe_reset_allocator()", "[memory][registry]")
 {
   using RangeT = std::pair<void*, void*>;
 
-  lbannv2::PointerRegistry registry;
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
   std::vector<unsigned char> buffer(32);
 
   // Establish preconditions
@@ -413,7 +448,8 @@ TEST_CASE("PointerRegistry::bytes_registered()", "[memory][registry]")
 {
   using RangeT = std::pair<void*, void*>;
 
-  lbannv2::PointerRegistry registry;
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
   std::vector<unsigned char> buffer(16);
 
   // Establish preconditions
@@ -436,3 +472,425 @@ TEST_CASE("PointerRegistry::bytes_registered()", "[memory][registry]")
   CHECK(registry.bytes_registered(extern_ptr_1) == 0UL);
   CHECK(registry.bytes_registered(extern_ptr_2) == 0UL);
 }
+
+TEST_CASE("PointerRegistry lookup cache", "[memory][registry]")
+{
+  using RangeT = std::pair<void*, void*>;
+
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
+  std::vector<unsigned char> buffer(32);
+
+  RangeT const rng = {&buffer[4], &buffer[8]};
+  void const* const mid_ptr = &buffer[6];
+
+  REQUIRE_NOTHROW(registry.add(rng.first, rng_bytes(rng), nullptr));
+  REQUIRE(registry.known(mid_ptr));
+
+  SECTION("Removed ranges are not found through the cache")
+  {
+    REQUIRE_NOTHROW(registry.remove(rng.first));
+    CHECK_FALSE(registry.known(mid_ptr));
+    CHECK(registry.bytes_registered(mid_ptr) == 0UL);
+  }
+
+  SECTION("Reset allocators are seen through the cache")
+  {
+    c10::Allocator* const fake_alloc =
+      reinterpret_cast<c10::Allocator*>(&buffer[0]);
+    REQUIRE_NOTHROW(registry.unsafe_reset_allocator(mid_ptr, fake_alloc));
+    CHECK(registry.get_allocator(mid_ptr) == fake_alloc);
+  }
+
+  SECTION("Adding ranges does not disturb cached lookups")
+  {
+    RangeT const other = {&buffer[8], &buffer[12]};
+    REQUIRE_NOTHROW(registry.add(other.first, rng_bytes(other), nullptr));
+    CHECK(registry.get_context(mid_ptr) == rng.first);
+    CHECK(registry.get_context(&buffer[10]) == other.first);
+  }
+
+  SECTION("Registries do not share cached lookups")
+  {
+    lbannv2::PointerRegistry other_registry {cfg.mode, cfg.index};
+    CHECK_FALSE(other_registry.known(mid_ptr));
+  }
+}
+
+TEST_CASE("PointerRegistry concurrent lookups", "[memory][registry]")
+{
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
+
+  constexpr size_t num_ranges = 64;
+  constexpr size_t range_size = 16;
+  std::vector<unsigned char> stable(range_size);
+  std::vector<unsigned char> churn(num_ranges * range_size);
+
+  REQUIRE_NOTHROW(registry.add(stable.data(), range_size, nullptr));
+
+  std::atomic<bool> done = false;
+  std::atomic<size_t> misses = 0;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i)
+  {
+    readers.emplace_back([&] {
+      while (!done.load())
+      {
+        if (!registry.known(&stable[range_size / 2])
+            || registry.get_context(&stable[1]) != stable.data())
+          ++misses;
+        // Churned ranges may or may not be present; this just needs
+        // to not crash.
+        (void) registry.known(&churn[range_size / 2]);
+      }
+    });
+  }
+
+  for (int iter = 0; iter < 100; ++iter)
+  {
+    for (size_t r = 0; r < num_ranges; ++r)
+      registry.add(&churn[r * range_size], range_size, nullptr);
+    for (size_t r = 0; r < num_ranges; ++r)
+      registry.remove(&churn[r * range_size]);
+  }
+  done = true;
+  for (auto& t : readers)
+    t.join();
+
+  CHECK(misses == 0UL);
+  CHECK(registry.num_registered() == 1UL);
+}
+
+TEST_CASE("PointerRegistry with large ranges", "[memory][registry]")
+{
+  using RangeT = std::pair<void*, void*>;
+
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
+
+  // Several page map granules' worth of (never dereferenced) address
+  // space. Ranges deliberately straddle granule boundaries.
+  constexpr size_t granule = size_t {1}
+                             << lbannv2::PageMapIndex::kGranuleBits;
+  std::vector<unsigned char> buffer(6 * granule);
+  auto* const base = buffer.data();
+
+  RangeT const big = {base + granule / 2, base + 7 * granule / 2};
+  RangeT const small = {base + 7 * granule / 2, base + 7 * granule / 2 + 8};
+  RangeT const zero = {base + 4 * granule, base + 4 * granule};
+
+  REQUIRE_NOTHROW(registry.add(big.first, rng_bytes(big), nullptr));
+  REQUIRE_NOTHROW(registry.add(small.first, rng_bytes(small), nullptr));
+  REQUIRE_NOTHROW(registry.add(zero.first, rng_bytes(zero), nullptr));
+  REQUIRE(registry.num_registered() == 3UL);
+  REQUIRE(registry.bytes_registered() == rng_bytes(big) + rng_bytes(small));
+
+  SECTION("Interior pointers in every spanned granule are found")
+  {
+    for (size_t offset = 0; offset < rng_bytes(big); offset += granule / 4)
+      CHECK(registry.get_context(base + granule / 2 + offset) == big.first);
+    CHECK(registry.get_context(small.first) == small.first);
+    CHECK(registry.get_context(zero.first) == zero.first);
+    CHECK_FALSE(registry.known(base));
+    CHECK_FALSE(registry.known(base + 4 * granule + 1));
+  }
+
+  SECTION("Overlaps are detected across granules")
+  {
+    REQUIRE_THROWS_WITH(registry.add(base, granule, nullptr),
+                        "Address range overlaps existing range");
+    REQUIRE_THROWS_WITH(registry.add(base + 3 * granule, 1, nullptr),
+                        "Address range overlaps existing range");
+    REQUIRE_THROWS_WITH(registry.add(base + 2 * granule, 0, nullptr),
+                        "Address range overlaps existing range");
+    REQUIRE(registry.num_registered() == 3UL);
+  }
+
+  SECTION("Removal clears every spanned granule")
+  {
+    REQUIRE_NOTHROW(registry.remove(big.first));
+    for (size_t offset = 0; offset < rng_bytes(big); offset += granule / 4)
+      CHECK_FALSE(registry.known(base + granule / 2 + offset));
+    CHECK(registry.known(small.first));
+    REQUIRE_NOTHROW(registry.add(base, 3 * granule, nullptr));
+    CHECK(registry.get_context(base + granule) == base);
+  }
+}
+
+TEST_CASE("PointerRegistry with ranges too large for slots",
+          "[memory][registry]")
+{
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
+
+  // Never dereferenced: a 64 GiB mapping, and small ranges sharing
+  // its first and last granules.
+  constexpr size_t huge = size_t {64} << 30;
+  auto* const base = reinterpret_cast<std::byte*>(std::uintptr_t {1} << 44);
+  auto* const first = base + 100;
+  auto* const end = first + huge;
+
+  REQUIRE_NOTHROW(registry.add(first, huge, nullptr));
+  REQUIRE_NOTHROW(registry.add(base, 100, nullptr));
+  REQUIRE_NOTHROW(registry.add(end, 8, nullptr));
+  REQUIRE(registry.num_registered() == 3UL);
+
+  CHECK(registry.get_context(first) == first);
+  CHECK(registry.get_context(first + huge / 2) == first);
+  CHECK(registry.get_context(end - 1) == first);
+  CHECK(registry.get_context(base + 99) == base);
+  CHECK(registry.get_context(end) == end);
+
+  REQUIRE_THROWS_WITH(registry.add(first + huge / 2, 8, nullptr),
+                      "Address range overlaps existing range");
+
+  REQUIRE_NOTHROW(registry.remove(first));
+  CHECK_FALSE(registry.known(first + huge / 2));
+  CHECK(registry.known(base));
+  CHECK(registry.known(end));
+  REQUIRE_NOTHROW(registry.add(first + huge / 2, 8, nullptr));
+}
+
+TEST_CASE("PointerRegistry rejects a read-mostly page map",
+          "[memory][registry]")
+{
+  CHECK_THROWS_AS(
+    lbannv2::PointerRegistry(Mode::ReadMostly, Index::PageMap),
+    std::runtime_error);
+}
+
+TEST_CASE("PointerRegistry::stats()", "[memory][registry]")
+{
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
+  std::vector<unsigned char> buffer(64);
+
+  // FAKE -- DO NOT DEREFERENCE!
+  auto* const alloc_a = reinterpret_cast<c10::Allocator*>(&buffer[0]);
+  auto* const alloc_b = reinterpret_cast<c10::Allocator*>(&buffer[1]);
+  c10::Device const cpu {c10::kCPU};
+  c10::Device const gpu {c10::kCUDA, 0};
+
+  REQUIRE_NOTHROW(registry.add(&buffer[0], 8, alloc_a, cpu));
+  REQUIRE_NOTHROW(registry.add(&buffer[8], 16, alloc_a, gpu));
+  REQUIRE_NOTHROW(registry.add(&buffer[32], 4, alloc_b, cpu));
+
+  SECTION("Counters track additions")
+  {
+    auto const stats = registry.stats();
+    CHECK(stats.total.current_bytes == 28UL);
+    CHECK(stats.total.peak_bytes == 28UL);
+    CHECK(stats.total.current_allocations == 3UL);
+    CHECK(stats.total.total_allocations == 3UL);
+    CHECK(stats.total.total_frees == 0UL);
+
+    CHECK(stats.by_allocator.at(alloc_a).current_bytes == 24UL);
+    CHECK(stats.by_allocator.at(alloc_b).current_bytes == 4UL);
+    CHECK(stats.by_device.at(cpu).current_bytes == 12UL);
+    CHECK(stats.by_device.at(gpu).current_bytes == 16UL);
+  }
+
+  SECTION("Counters track removals and keep peaks")
+  {
+    REQUIRE_NOTHROW(registry.remove(&buffer[8]));
+    REQUIRE_NOTHROW(registry.add(&buffer[40], 2, alloc_b, cpu));
+
+    CHECK(registry.bytes_registered() == 14UL);
+    CHECK(registry.peak_bytes_registered() == 28UL);
+    CHECK(registry.num_registered() == 3UL);
+
+    auto const stats = registry.stats();
+    CHECK(stats.total.total_allocations == 4UL);
+    CHECK(stats.total.total_frees == 1UL);
+    CHECK(stats.by_allocator.at(alloc_a).current_bytes == 8UL);
+    CHECK(stats.by_allocator.at(alloc_a).peak_bytes == 24UL);
+    CHECK(stats.by_device.at(gpu).current_bytes == 0UL);
+    CHECK(stats.by_device.at(gpu).total_frees == 1UL);
+  }
+
+  SECTION("Allocators without live registrations are dropped")
+  {
+    REQUIRE_NOTHROW(registry.remove(&buffer[32]));
+    CHECK_FALSE(registry.stats().by_allocator.contains(alloc_b));
+
+    REQUIRE_NOTHROW(registry.unsafe_reset_allocator(&buffer[0], alloc_b));
+    REQUIRE_NOTHROW(registry.unsafe_reset_allocator(&buffer[8], alloc_b));
+    auto const stats = registry.stats();
+    CHECK_FALSE(stats.by_allocator.contains(alloc_a));
+    CHECK(stats.by_allocator.at(alloc_b).current_bytes == 24UL);
+    CHECK(stats.by_allocator.at(alloc_b).current_allocations == 2UL);
+  }
+
+  SECTION("Resets move bytes between breakdowns")
+  {
+    REQUIRE_NOTHROW(registry.unsafe_reset_allocator(&buffer[8], alloc_b));
+    REQUIRE_NOTHROW(registry.unsafe_reset_device(&buffer[8], cpu));
+
+    auto const stats = registry.stats();
+    CHECK(stats.total.current_bytes == 28UL);
+    CHECK(stats.total.total_frees == 0UL);
+    CHECK(stats.by_allocator.at(alloc_a).current_bytes == 8UL);
+    CHECK(stats.by_allocator.at(alloc_b).current_bytes == 20UL);
+    CHECK(stats.by_device.at(cpu).current_bytes == 28UL);
+    CHECK(stats.by_device.at(gpu).current_allocations == 0UL);
+  }
+}
+
+TEST_CASE("PointerRegistry::add_many()", "[memory][registry]")
+{
+  using Reg = lbannv2::PointerRegistry::Registration;
+
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
+  std::vector<unsigned char> buffer(64);
+
+  // FAKE -- DO NOT DEREFERENCE!
+  auto* const alloc = reinterpret_cast<c10::Allocator*>(buffer.data());
+
+  SECTION("Adding a batch registers every range")
+  {
+    std::vector<Reg> const regs {{&buffer[32], 8, alloc},
+                                 {&buffer[0], 16, alloc},
+                                 {nullptr, 4, alloc},
+                                 {&buffer[16], 0, alloc}};
+    REQUIRE_NOTHROW(registry.add_many(regs));
+    CHECK(registry.num_registered() == 3UL);
+    CHECK(registry.bytes_registered() == 24UL);
+    CHECK(registry.known(&buffer[4]));
+    CHECK(registry.known(&buffer[16]));
+    CHECK(registry.known(&buffer[39]));
+    CHECK_FALSE(registry.known(&buffer[40]));
+  }
+
+  SECTION("Overlap within a batch adds nothing")
+  {
+    std::vector<Reg> const regs {{&buffer[0], 8, alloc},
+                                 {&buffer[32], 8, alloc},
+                                 {&buffer[4], 8, alloc}};
+    CHECK_THROWS(registry.add_many(regs));
+    CHECK(registry.num_registered() == 0UL);
+    CHECK(registry.bytes_registered() == 0UL);
+  }
+
+  SECTION("Overlap with a registered range adds nothing")
+  {
+    REQUIRE_NOTHROW(registry.add(&buffer[20], 4, alloc));
+
+    std::vector<Reg> const regs {{&buffer[0], 8, alloc},
+                                 {&buffer[16], 8, alloc}};
+    CHECK_THROWS(registry.add_many(regs));
+    CHECK(registry.num_registered() == 1UL);
+    CHECK_FALSE(registry.known(&buffer[0]));
+  }
+}
+
+TEST_CASE("PointerRegistry::remove_many()", "[memory][registry]")
+{
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
+  std::vector<unsigned char> buffer(64);
+
+  // FAKE -- DO NOT DEREFERENCE!
+  auto* const alloc = reinterpret_cast<c10::Allocator*>(buffer.data());
+
+  REQUIRE_NOTHROW(registry.add(&buffer[0], 8, alloc));
+  REQUIRE_NOTHROW(registry.add(&buffer[8], 8, alloc));
+  REQUIRE_NOTHROW(registry.add(&buffer[32], 16, alloc));
+
+  SECTION("Removing a batch unregisters every range")
+  {
+    std::vector<void*> const ptrs {&buffer[32], nullptr, &buffer[0]};
+    REQUIRE_NOTHROW(registry.remove_many(ptrs));
+    CHECK(registry.num_registered() == 1UL);
+    CHECK(registry.bytes_registered() == 8UL);
+    CHECK_FALSE(registry.known(&buffer[0]));
+    CHECK(registry.known(&buffer[8]));
+    CHECK_FALSE(registry.known(&buffer[32]));
+    CHECK(registry.stats().total.total_frees == 2UL);
+  }
+
+  SECTION("Unknown pointers remove nothing")
+  {
+    std::vector<void*> const ptrs {&buffer[0], &buffer[60]};
+    CHECK_THROWS_AS(registry.remove_many(ptrs), lbannv2::UnknownAddress);
+    CHECK(registry.num_registered() == 3UL);
+    CHECK(registry.known(&buffer[0]));
+  }
+
+  SECTION("Interior pointers remove nothing")
+  {
+    std::vector<void*> const ptrs {&buffer[0], &buffer[36]};
+    CHECK_THROWS(registry.remove_many(ptrs));
+    CHECK(registry.num_registered() == 3UL);
+  }
+
+  SECTION("Duplicate pointers remove nothing")
+  {
+    std::vector<void*> const ptrs {&buffer[8], &buffer[0], &buffer[8]};
+    CHECK_THROWS(registry.remove_many(ptrs));
+    CHECK(registry.num_registered() == 3UL);
+  }
+}
+
+namespace
+{
+
+// Splits a range into 4-byte slots, the odd ones of which are live.
+struct OddSlots final : lbannv2::NestedRanges
+{
+  bool find_nested(void const* base,
+                   void const* ptr,
+                   void*& begin,
+                   size_t& size) const noexcept final
+  {
+    auto const offset = (std::byte const*) ptr - (std::byte const*) base;
+    if ((offset / 4) % 2 == 0)
+      return false;
+    begin = (std::byte*) base + offset / 4 * 4;
+    size = 4;
+    return true;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("PointerRegistry nested ranges", "[memory][registry]")
+{
+  auto const cfg = GENERATE(from_range(all_configs()));
+  lbannv2::PointerRegistry registry {cfg.mode, cfg.index};
+  std::vector<unsigned char> buffer(32);
+  OddSlots const slots;
+  c10::Allocator* const fake_alloc =
+    reinterpret_cast<c10::Allocator*>(&buffer[0]);
+
+  REQUIRE_NOTHROW(registry.add(
+    &buffer[0], 16, fake_alloc, c10::Device {c10::kCPU}, &slots));
+  CHECK(registry.num_registered() == 1UL);
+  CHECK(registry.bytes_registered() == 16UL);
+
+  // Lookups resolve to the live slot containing the address.
+  CHECK_FALSE(registry.known(&buffer[2]));
+  CHECK(registry.known(&buffer[5]));
+  CHECK(registry.get_context(&buffer[6]) == &buffer[4]);
+  CHECK(registry.get_context(&buffer[13]) == &buffer[12]);
+  CHECK(registry.bytes_registered(&buffer[7]) == 4UL);
+  CHECK(registry.bytes_registered(&buffer[9]) == 0UL);
+  CHECK(registry.get_allocator(&buffer[4]) == fake_alloc);
+  CHECK_THROWS_AS(registry.get_context(&buffer[0]), lbannv2::UnknownAddress);
+
+  // Cached hits are resolved again.
+  CHECK(registry.known(&buffer[4]));
+  CHECK_FALSE(registry.known(&buffer[8]));
+
+  CHECK_THROWS_AS(registry.unsafe_reset_allocator(&buffer[4], nullptr),
+                  std::runtime_error);
+  CHECK_THROWS_AS(
+    registry.unsafe_reset_device(&buffer[4], c10::Device {c10::kCPU}),
+    std::runtime_error);
+
+  // The registered range is removed as a whole.
+  REQUIRE_NOTHROW(registry.remove(&buffer[0]));
+  CHECK_FALSE(registry.known(&buffer[5]));
+  CHECK(registry.num_registered() == 0UL);
+}
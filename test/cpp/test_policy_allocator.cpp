@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/policy_allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+using Stack = lbannv2::TrackingLayer<
+  lbannv2::LimitingLayer<lbannv2::CachingLayer<lbannv2::MallocBacking>>>;
+
+TEST_CASE("Compile-time policy stack", "[memory][policy]")
+{
+  constexpr size_t limit = 1 << 20;
+  lbannv2::PolicyAllocator<Stack> alloc(limit);
+
+  CHECK(alloc.stats().limit == limit);
+  REQUIRE(alloc.stats().tracked);
+
+  void* raw_ptr = nullptr;
+  {
+    auto ptr = alloc.allocate(1000);
+    raw_ptr = ptr.get();
+    CHECK(ptr.device() == c10::Device {c10::kCPU});
+    CHECK(reinterpret_cast<std::uintptr_t>(raw_ptr)
+            % lbannv2::MallocBacking::kAlignment
+          == 0);
+    CHECK(lbannv2::pointer_registry().known(raw_ptr));
+
+    auto const stats = alloc.stats();
+    CHECK(stats.tracked->current_bytes == 1000UL);
+    CHECK(stats.tracked->current_allocations == 1UL);
+    CHECK(stats.cached_bytes == 0UL);
+  }
+
+  // Deregistered, but still cached.
+  CHECK_FALSE(lbannv2::pointer_registry().known(raw_ptr));
+  {
+    auto const stats = alloc.stats();
+    CHECK(stats.tracked->current_bytes == 0UL);
+    CHECK(stats.tracked->peak_bytes == 1000UL);
+    CHECK(stats.tracked->total_frees == 1UL);
+    CHECK(stats.cached_bytes
+          == lbannv2::CachingHostAllocator::round_size(1000));
+  }
+
+  SECTION("Same size class reuses the block")
+  {
+    auto ptr = alloc.allocate(1024);
+    CHECK(ptr.get() == raw_ptr);
+    CHECK(alloc.stats().cached_bytes == 0UL);
+  }
+
+  SECTION("Allocations past the limit throw")
+  {
+    auto ptr = alloc.allocate(limit / 2);
+    CHECK_THROWS_AS(alloc.allocate(limit / 2 + 1), std::runtime_error);
+    // The failed allocation is not counted.
+    CHECK(alloc.stats().tracked->current_allocations == 1UL);
+  }
+
+  SECTION("release_cached() empties the cache")
+  {
+    alloc.release_cached();
+    CHECK(alloc.stats().cached_bytes == 0UL);
+  }
+}
+
+TEST_CASE("make_policy_allocator", "[memory][policy]")
+{
+  SECTION("Full spec")
+  {
+    auto alloc =
+      lbannv2::make_policy_allocator("tracking, limit=4M, caching, malloc");
+    auto const stats = alloc->stats();
+    CHECK(stats.tracked);
+    CHECK(stats.limit == 4UL << 20);
+
+    {
+      auto ptr = alloc->allocate(100);
+      CHECK(lbannv2::pointer_registry().known(ptr.get()));
+      CHECK(alloc->stats().tracked->current_bytes == 100UL);
+    }
+    CHECK(alloc->stats().cached_bytes > 0UL);
+    alloc->release_cached();
+    CHECK(alloc->stats().cached_bytes == 0UL);
+  }
+
+  SECTION("The backing defaults to malloc")
+  {
+    auto alloc = lbannv2::make_policy_allocator("limit=1K");
+    CHECK_FALSE(alloc->stats().tracked);
+    CHECK(alloc->stats().limit == 1024UL);
+    CHECK_NOTHROW(alloc->allocate(1024));
+    CHECK_THROWS_AS(alloc->allocate(1025), std::runtime_error);
+  }
+
+  SECTION("Size suffixes are binary and case-insensitive")
+  {
+    CHECK(lbannv2::make_policy_allocator("limit=3m")->stats().limit
+          == 3UL << 20);
+    CHECK(lbannv2::make_policy_allocator("limit=16777215T")->stats().limit
+          == 16777215UL << 40);
+  }
+
+  SECTION("Zero-byte allocations")
+  {
+    auto alloc = lbannv2::make_policy_allocator("tracking");
+    auto ptr = alloc->allocate(0);
+    CHECK(ptr.get() == nullptr);
+    CHECK(alloc->stats().tracked->total_allocations == 0UL);
+  }
+
+  SECTION("Malformed specs throw")
+  {
+    for (std::string const spec : {"",
+                                   "bogus",
+                                   "malloc,tracking",
+                                   "limit=",
+                                   "limit=12X",
+                                   "limit=1KB",
+                                   "limit=-1",
+                                   "limit=99999999999999999999",
+                                   "limit=16777216T",
+                                   "tracking,,malloc"})
+    {
+      INFO("spec: \"" << spec << "\"");
+      CHECK_THROWS_AS(lbannv2::make_policy_allocator(spec),
+                      std::runtime_error);
+    }
+  }
+}
+
+TEST_CASE("use_host_allocator_spec", "[memory][policy]")
+{
+  auto& first = lbannv2::use_host_allocator_spec("tracking,malloc");
+  CHECK(lbannv2::current_policy_allocator() == &first);
+
+  auto& other = lbannv2::use_host_allocator_spec("limit=1M");
+  CHECK(&other != &first);
+  CHECK(lbannv2::current_policy_allocator() == &other);
+
+  // Each spec has one allocator.
+  CHECK(&lbannv2::use_host_allocator_spec("tracking,malloc") == &first);
+  CHECK(lbannv2::current_policy_allocator() == &first);
+
+  lbannv2::use_torch_cpu_allocator();
+}
@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/growable_allocator.hpp>
+#include <lbannv2/ops/resize.hpp>
+
+#include <ATen/ATen.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+
+using GA = lbannv2::GrowableAllocator;
+
+TEST_CASE("lbannv2::resize_", "[ops][resize]")
+{
+  constexpr int64_t kNumel = int64_t {1} << 16;
+
+  auto& alloc = GA::instance();
+  auto const orig_reserve = alloc.reserve_size();
+  alloc.set_reserve_size(size_t {4} << 20);
+  lbannv2::use_growable_host_allocator();
+  auto t = at::full({16}, 3.f);
+  lbannv2::use_torch_cpu_allocator();
+  REQUIRE(t.storage().allocator() == &alloc);
+
+  void* const data = t.data_ptr();
+  auto const base = alloc.stats();
+
+  SECTION("Storage from the GrowableAllocator grows in place")
+  {
+    CHECK(&lbannv2::resize_(t, {kNumel}) == &t);
+    CHECK(t.numel() == kNumel);
+    CHECK(t.data_ptr() == data);
+    CHECK(alloc.stats().num_grown_in_place == base.num_grown_in_place + 1);
+    CHECK(alloc.stats().num_allocations == base.num_allocations);
+    CHECK(t.narrow(0, 0, 16).eq(3.f).all().item<bool>());
+  }
+
+  SECTION("Tensor::resize_ is left alone")
+  {
+    t.resize_({kNumel});
+    CHECK(t.numel() == kNumel);
+    CHECK(t.data_ptr() != data);
+    CHECK(alloc.stats().num_grown_in_place == base.num_grown_in_place);
+    CHECK(t.narrow(0, 0, 16).eq(3.f).all().item<bool>());
+  }
+
+  SECTION("Other tensors are resized as usual")
+  {
+    auto other = at::full({4}, 1.f);
+    lbannv2::resize_(other, {kNumel});
+    CHECK(other.numel() == kNumel);
+    CHECK(other.storage().allocator() != &alloc);
+    CHECK(other.narrow(0, 0, 4).eq(1.f).all().item<bool>());
+    CHECK(alloc.stats().num_grown_in_place == base.num_grown_in_place);
+  }
+
+  t.reset();
+  alloc.set_reserve_size(orig_reserve);
+}
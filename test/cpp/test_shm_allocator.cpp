@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/registry.hpp>
+#include <lbannv2/memory/shm_allocator.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using SA = lbannv2::ShmAllocator;
+
+namespace
+{
+
+SA& shm_alloc()
+{
+  auto& alloc = SA::instance();
+  if (alloc.segment_name().empty())
+    alloc.set_segment_size(size_t {64} << 20);
+  return alloc;
+}
+
+}  // namespace
+
+TEST_CASE("ShmAllocator", "[memory][shm]")
+{
+  auto& alloc = shm_alloc();
+  auto const base = alloc.stats();
+
+  SECTION("Allocations are registered and reused")
+  {
+    void* raw = nullptr;
+    {
+      auto ptr = alloc.allocate(1000);
+      raw = ptr.get();
+      REQUIRE(raw);
+      CHECK(reinterpret_cast<std::uintptr_t>(raw) % 64 == 0);
+      CHECK(lbannv2::is_managed_ptr(static_cast<char*>(raw) + 999));
+      CHECK(alloc.stats().live_blocks == base.live_blocks + 1);
+      CHECK_FALSE(alloc.segment_name().empty());
+    }
+    CHECK_FALSE(lbannv2::is_managed_ptr(raw));
+    CHECK(alloc.stats().live_blocks == base.live_blocks);
+
+    auto ptr = alloc.allocate(1500);
+    CHECK(ptr.get() == raw);
+  }
+
+  SECTION("Handles reopen the same memory")
+  {
+    lbannv2::ShmHandle handle;
+    void* raw = nullptr;
+    {
+      auto ptr = alloc.allocate(4000);
+      raw = ptr.get();
+      std::memset(raw, 0x5a, 4000);
+      // Opening a block this process holds uses up the handle.
+      CHECK_THROWS(alloc.open(alloc.share(raw)));
+      handle = alloc.share(static_cast<char*>(raw) + 10);
+      CHECK(handle.segment == alloc.segment_name());
+      CHECK(handle.size == 4000);
+    }
+    // The handle's reference keeps the block alive.
+    CHECK_FALSE(lbannv2::is_managed_ptr(raw));
+    {
+      auto other = alloc.allocate(4000);
+      CHECK(other.get() != raw);
+    }
+
+    auto ptr = alloc.open(handle);
+    CHECK(ptr.get() == raw);
+    CHECK(lbannv2::is_managed_ptr(raw));
+    CHECK(static_cast<unsigned char*>(raw)[3999] == 0x5a);
+
+    // No reference is left behind, so the block is reused.
+    ptr.clear();
+    auto again = alloc.allocate(4000);
+    CHECK(again.get() == raw);
+  }
+
+  SECTION("Bad handles are rejected")
+  {
+    CHECK_THROWS(alloc.open({"/lbannv2-no-such-segment", 4160, 16}));
+    CHECK_THROWS(alloc.open({alloc.segment_name(), 0, 16}));
+    CHECK_THROWS(alloc.open({alloc.segment_name(), 4160, size_t {1} << 40}));
+  }
+
+  SECTION("Requests larger than the segment fail")
+  {
+    auto const carved = alloc.stats().carved_bytes;
+    CHECK_FALSE(alloc.raw_alloc(size_t {128} << 20));
+    CHECK_FALSE(alloc.raw_alloc(~size_t {0} - 16));
+    CHECK(alloc.stats().carved_bytes == carved);
+  }
+
+  SECTION("Foreign memory cannot be shared")
+  {
+    int x;
+    CHECK_THROWS(alloc.share(&x));
+  }
+
+  CHECK(alloc.stats().live_blocks == base.live_blocks);
+}
+
+TEST_CASE("ShmAllocator across processes", "[memory][shm]")
+{
+  auto& alloc = shm_alloc();
+  // Make sure the segment exists before forking.
+  (void) alloc.allocate(1);
+
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  pid_t const pid = fork();
+  REQUIRE(pid >= 0);
+  if (pid == 0)
+  {
+    // The child allocates from the inherited segment and hands the
+    // block to the parent.
+    size_t offset = 0;
+    {
+      auto ptr = alloc.allocate(10000);
+      std::memset(ptr.get(), 0x33, 10000);
+      offset = alloc.share(ptr.get()).offset;
+    }
+    bool const ok = write(fds[1], &offset, sizeof(offset)) == sizeof(offset);
+    _exit(ok ? 0 : 1);
+  }
+
+  close(fds[1]);
+  size_t offset = 0;
+  CHECK(read(fds[0], &offset, sizeof(offset)) == sizeof(offset));
+  close(fds[0]);
+  int status = 0;
+  REQUIRE(waitpid(pid, &status, 0) == pid);
+  REQUIRE(WIFEXITED(status));
+  REQUIRE(WEXITSTATUS(status) == 0);
+
+  auto ptr = alloc.open({alloc.segment_name(), offset, 10000});
+  auto const* const bytes = static_cast<unsigned char const*>(ptr.get());
+  CHECK(bytes[0] == 0x33);
+  CHECK(bytes[9999] == 0x33);
+}
+
+TEST_CASE("ShmAllocator free lists under contention", "[memory][shm]")
+{
+  auto& alloc = shm_alloc();
+  auto const base = alloc.stats();
+
+  constexpr int num_threads = 4;
+  std::vector<std::thread> threads;
+  std::vector<int> errors(num_threads, 0);
+  for (int t = 0; t < num_threads; ++t)
+    threads.emplace_back([&alloc, &errors, t] {
+      for (int i = 0; i < 500; ++i)
+      {
+        size_t const n = 100 + (i % 7) * 300;
+        void* const p = alloc.raw_alloc(n);
+        std::memset(p, t, n);
+        std::this_thread::yield();
+        auto const* const bytes = static_cast<unsigned char const*>(p);
+        if (bytes[0] != t || bytes[n - 1] != t)
+          ++errors[t];
+        alloc.raw_dealloc(p);
+      }
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  for (int t = 0; t < num_threads; ++t)
+    CHECK(errors[t] == 0);
+  CHECK(alloc.stats().live_blocks == base.live_blocks);
+}
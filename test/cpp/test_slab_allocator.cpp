@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/registry.hpp>
+#include <lbannv2/memory/slab_allocator.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+using SA = lbannv2::SlabAllocator;
+
+TEST_CASE("SlabAllocator", "[memory][slab]")
+{
+  auto& alloc = SA::instance();
+  auto& registry = lbannv2::pointer_registry();
+  REQUIRE(alloc.max_size() >= 64UL);
+  alloc.release_cached();
+  auto const base = alloc.stats();
+  auto const base_registered = registry.num_registered();
+
+  SECTION("Small allocations share a slab")
+  {
+    std::vector<c10::DataPtr> ptrs;
+    for (size_t i = 0; i < 100; ++i)
+      ptrs.push_back(alloc.allocate(4 + i % 8));
+
+    std::set<void*> distinct;
+    for (auto const& p : ptrs)
+    {
+      CHECK(alloc.in_slab(p.get()));
+      CHECK(reinterpret_cast<std::uintptr_t>(p.get()) % 16 == 0);
+      distinct.insert(p.get());
+    }
+    CHECK(distinct.size() == ptrs.size());
+    std::memset(ptrs.front().get(), 0xff, 16);
+
+    // One registry entry for the slab, not one per allocation, but
+    // lookups still find each slot.
+    CHECK(registry.num_registered() == base_registered + 1);
+    CHECK(alloc.stats().num_slabs == base.num_slabs + 1);
+    CHECK(alloc.stats().live_slots == base.live_slots + 100);
+    CHECK(alloc.stats().live_bytes == base.live_bytes + 100 * 16);
+    for (auto const& p : ptrs)
+    {
+      CHECK(registry.known(p.get()));
+      CHECK(registry.get_context(static_cast<char*>(p.get()) + 3) == p.get());
+      CHECK(registry.bytes_registered(p.get()) == 16UL);
+      CHECK(registry.get_allocator(p.get()) == &alloc);
+    }
+
+    // Freed slots are no longer known, and are reused by this thread.
+    void* const freed = ptrs.back().get();
+    ptrs.pop_back();
+    CHECK_FALSE(registry.known(freed));
+    CHECK(alloc.stats().cached_slots >= 1UL);
+    auto again = alloc.allocate(10);
+    CHECK(again.get() == freed);
+    CHECK(registry.known(freed));
+  }
+
+  SECTION("Size classes use separate slabs")
+  {
+    auto a = alloc.allocate(8);
+    auto b = alloc.allocate(100);
+    CHECK(alloc.in_slab(b.get()));
+    CHECK(reinterpret_cast<std::uintptr_t>(b.get()) % 128 == 0);
+    CHECK(registry.get_context(b.get()) == b.get());
+    CHECK(registry.bytes_registered(b.get()) == 128UL);
+    CHECK(alloc.stats().num_slabs == base.num_slabs + 2);
+  }
+
+  SECTION("Large allocations are registered individually")
+  {
+    auto big = alloc.allocate(alloc.max_size() + 1);
+    CHECK_FALSE(alloc.in_slab(big.get()));
+    CHECK(registry.num_registered() == base_registered + 1);
+    CHECK(registry.bytes_registered(big.get()) == alloc.max_size() + 1);
+    CHECK(alloc.stats().large_allocations == base.large_allocations + 1);
+    big.clear();
+    CHECK_FALSE(registry.known(big.get()));
+    CHECK(alloc.stats().large_allocations == base.large_allocations);
+  }
+
+  SECTION("Slots freed on another thread go to that thread's lists")
+  {
+    std::vector<c10::DataPtr> ptrs;
+    for (size_t i = 0; i < 3 * SA::kThreadCacheSize; ++i)
+      ptrs.push_back(alloc.allocate(32));
+    std::thread([&] { ptrs.clear(); }).join();
+
+    // The thread's lists went back to the slabs when it exited.
+    auto const stats = alloc.stats();
+    CHECK(stats.live_slots == base.live_slots);
+  }
+
+  // Everything is freed, so the new slabs can go.
+  auto const new_slabs = alloc.stats().num_slabs - base.num_slabs;
+  CHECK(alloc.release_cached() == new_slabs * SA::kSlabSize);
+  auto const after = alloc.stats();
+  CHECK(after.num_slabs == base.num_slabs);
+  CHECK(after.live_slots == base.live_slots);
+  CHECK(registry.num_registered() == base_registered);
+}
+
+TEST_CASE("SlabAllocator under contention", "[memory][slab]")
+{
+  auto& alloc = SA::instance();
+  auto& registry = lbannv2::pointer_registry();
+  auto const base = alloc.stats();
+
+  auto const work = [&] {
+    std::vector<c10::DataPtr> ptrs;
+    for (size_t round = 0; round < 20; ++round)
+    {
+      for (size_t i = 0; i < 200; ++i)
+      {
+        ptrs.push_back(alloc.allocate(1 + (i * 7) % 200));
+        *static_cast<unsigned char*>(ptrs.back().get()) = 1;
+      }
+      for (auto const& p : ptrs)
+        CHECK(registry.known(p.get()));
+      // Free half here and hand the rest to the next round.
+      ptrs.erase(ptrs.begin(), ptrs.begin() + ptrs.size() / 2);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+    threads.emplace_back(work);
+  for (auto& t : threads)
+    t.join();
+
+  alloc.release_cached();
+  auto const after = alloc.stats();
+  CHECK(after.live_slots == base.live_slots);
+  CHECK(after.cached_slots == base.cached_slots);
+}
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/arena_allocator.hpp>
+#include <lbannv2/memory/caching_host_allocator.hpp>
+#include <lbannv2/memory/huge_page_allocator.hpp>
+#include <lbannv2/memory/mmap_file_allocator.hpp>
+#include <lbannv2/memory/numa_allocator.hpp>
+#include <lbannv2/memory/policy_allocator.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using CHA = lbannv2::CachingHostAllocator;
+
+namespace
+{
+
+bool all_zero(void const* const ptr, size_t const nbytes)
+{
+  auto const* const bytes = static_cast<unsigned char const*>(ptr);
+  return std::all_of(
+    bytes, bytes + nbytes, [](unsigned char const b) { return b == 0; });
+}
+
+// Dirty some memory from the allocator so that a zeroed allocation
+// that reuses it has to be cleared.
+void dirty(lbannv2::Allocator& alloc, size_t const nbytes)
+{
+  auto ptr = alloc.allocate(nbytes);
+  std::memset(ptr.get(), 0xff, nbytes);
+}
+
+}  // namespace
+
+TEST_CASE("allocate_zeroed gives zeroed memory", "[memory][zero]")
+{
+  auto policy = lbannv2::make_policy_allocator("caching");
+  lbannv2::Allocator* const allocs[] = {&CHA::instance(),
+                                        &lbannv2::HugePageAllocator::instance(),
+                                        &lbannv2::NumaAllocator::instance(),
+                                        &lbannv2::ArenaAllocator::instance(),
+                                        &lbannv2::MmapFileAllocator::instance(),
+                                        policy.get()};
+  for (auto* const alloc : allocs)
+  {
+    for (size_t const nbytes : {size_t {100}, size_t {3} << 20})
+    {
+      dirty(*alloc, nbytes);
+      auto ptr = alloc->allocate_zeroed(nbytes);
+      REQUIRE(ptr.get());
+      CHECK(all_zero(ptr.get(), nbytes));
+    }
+    CHECK_FALSE(alloc->allocate_zeroed(0).get());
+  }
+}
+
+TEST_CASE("CachingHostAllocator elides zero fills", "[memory][zero]")
+{
+  auto& alloc = CHA::instance();
+  alloc.empty_cache();
+  auto const base = alloc.stats();
+  size_t const nbytes = CHA::kMinLargeAlloc;
+
+  void* raw_ptr = nullptr;
+  {
+    // A fresh segment is already zero.
+    auto ptr = alloc.allocate_zeroed(nbytes);
+    raw_ptr = ptr.get();
+    CHECK(all_zero(raw_ptr, nbytes));
+    CHECK(alloc.stats().zero_fill_elided_bytes
+          == base.zero_fill_elided_bytes + nbytes);
+    CHECK(alloc.stats().zero_filled_bytes == base.zero_filled_bytes);
+    std::memset(raw_ptr, 0xff, nbytes);
+  }
+
+  SECTION("Reusing a dirty block clears it")
+  {
+    auto ptr = alloc.allocate_zeroed(nbytes);
+    CHECK(ptr.get() == raw_ptr);
+    CHECK(all_zero(ptr.get(), nbytes));
+    CHECK(alloc.stats().zero_filled_bytes
+          == base.zero_filled_bytes + nbytes);
+  }
+
+  SECTION("Small blocks are cleared")
+  {
+    auto ptr = alloc.allocate_zeroed(100);
+    CHECK(all_zero(ptr.get(), 100));
+    CHECK(alloc.stats().zero_filled_bytes == base.zero_filled_bytes + 100);
+  }
+
+  SECTION("Scrubbed blocks are not cleared again")
+  {
+    alloc.set_scrubbing(true);
+    CHECK(alloc.scrubbing());
+    for (int i = 0; i < 500 && alloc.stats().scrubbed_bytes
+                                 == base.scrubbed_bytes;
+         ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    alloc.set_scrubbing(false);
+    CHECK_FALSE(alloc.scrubbing());
+    CHECK(alloc.stats().scrubbed_bytes >= base.scrubbed_bytes + nbytes);
+
+    auto const before = alloc.stats();
+    auto ptr = alloc.allocate_zeroed(nbytes);
+    CHECK(ptr.get() == raw_ptr);
+    CHECK(all_zero(ptr.get(), nbytes));
+    CHECK(alloc.stats().zero_filled_bytes == before.zero_filled_bytes);
+    CHECK(alloc.stats().zero_fill_elided_bytes
+          == before.zero_fill_elided_bytes + nbytes);
+  }
+
+  alloc.empty_cache();
+  CHECK(alloc.stats().reserved_bytes == base.reserved_bytes);
+}
@@ -0,0 +1,175 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/caching_host_allocator.hpp>
+#include <lbannv2/ops/zeros.hpp>
+
+#include <ATen/ATen.h>
+#include <c10/core/SymIntArrayRef.h>
+#include <torch/library.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+
+using CHA = lbannv2::CachingHostAllocator;
+
+namespace
+{
+
+// Makes the caching host allocator the CPU allocator, with elision
+// on, for the duration of a test.
+struct ZerosGuard
+{
+  bool const elision = lbannv2::zero_fill_elision_enabled();
+  ZerosGuard()
+  {
+    lbannv2::use_cpu_allocator(CHA::instance());
+    lbannv2::set_zero_fill_elision(true);
+    CHA::instance().empty_cache();
+  }
+  ~ZerosGuard()
+  {
+    lbannv2::set_zero_fill_elision(elision);
+    lbannv2::use_torch_cpu_allocator();
+  }
+};
+
+bool all_zero(at::Tensor const& t)
+{
+  return t.eq(0).all().item<bool>();
+}
+
+// Enough floats for a fresh, already-zero segment.
+constexpr int64_t kNumel = CHA::kMinLargeAlloc / sizeof(float);
+constexpr size_t kNbytes = kNumel * sizeof(float);
+
+}  // namespace
+
+TEST_CASE("zeros_cpu", "[ops][zero]")
+{
+  ZerosGuard guard;
+  auto& alloc = CHA::instance();
+  auto const base = alloc.stats();
+  auto const zeros = [] {
+    return lbannv2::zeros_cpu(c10::fromIntArrayRefSlow({kNumel}),
+                              at::kFloat,
+                              std::nullopt,
+                              std::nullopt,
+                              std::nullopt);
+  };
+
+  SECTION("Fresh memory is not filled again")
+  {
+    auto const t = zeros();
+    CHECK(t.sizes() == at::IntArrayRef {kNumel});
+    CHECK(t.scalar_type() == at::kFloat);
+    CHECK(t.is_contiguous());
+    CHECK(t.storage().allocator() == &alloc);
+    CHECK(all_zero(t));
+    CHECK(alloc.stats().zero_fill_elided_bytes
+          == base.zero_fill_elided_bytes + kNbytes);
+  }
+
+  SECTION("Reused memory is zero")
+  {
+    zeros().fill_(1.f);
+    auto const t = zeros();
+    CHECK(all_zero(t));
+  }
+
+  SECTION("Elision can be disabled")
+  {
+    lbannv2::set_zero_fill_elision(false);
+    auto const t = zeros();
+    CHECK(t.storage().allocator() == &alloc);
+    CHECK(all_zero(t));
+    CHECK(alloc.stats().zero_fill_elided_bytes
+          == base.zero_fill_elided_bytes);
+  }
+
+  SECTION("Other CPU allocators fall back to a fill")
+  {
+    lbannv2::use_torch_cpu_allocator();
+    auto const t = zeros();
+    CHECK(t.storage().allocator() != &alloc);
+    CHECK(all_zero(t));
+    CHECK(alloc.stats().zero_fill_elided_bytes
+          == base.zero_fill_elided_bytes);
+  }
+}
+
+TEST_CASE("new_zeros_cpu", "[ops][zero]")
+{
+  ZerosGuard guard;
+  auto const self = at::ones({2}, at::kDouble);
+
+  auto const t =
+    lbannv2::new_zeros_cpu(self,
+                           c10::fromIntArrayRefSlow({3, kNumel / 3}),
+                           std::nullopt,
+                           std::nullopt,
+                           std::nullopt,
+                           std::nullopt);
+  CHECK(t.sizes() == at::IntArrayRef {3, kNumel / 3});
+  CHECK(t.scalar_type() == at::kDouble);
+  CHECK(t.storage().allocator() == &CHA::instance());
+  CHECK(all_zero(t));
+}
+
+TEST_CASE("The zeros override", "[ops][zero]")
+{
+  ZerosGuard guard;
+  auto& alloc = CHA::instance();
+
+  // Registered for this test only, as the Python module does.
+  torch::Library lib(torch::Library::IMPL,
+                     "aten",
+                     c10::DispatchKey::CPU,
+                     __FILE__,
+                     __LINE__);
+  lbannv2::register_zero_fill_ops(lib);
+
+  SECTION("at::zeros")
+  {
+    auto const base = alloc.stats();
+    auto const t = at::zeros({kNumel});
+    CHECK(all_zero(t));
+    CHECK(alloc.stats().zero_fill_elided_bytes
+          == base.zero_fill_elided_bytes + kNbytes);
+  }
+
+  SECTION("Tensor::new_zeros")
+  {
+    auto const base = alloc.stats();
+    auto const t = at::ones({2}).new_zeros({kNumel});
+    CHECK(all_zero(t));
+    CHECK(alloc.stats().zero_fill_elided_bytes
+          == base.zero_fill_elided_bytes + kNbytes);
+  }
+
+  SECTION("Tensor::new_zeros on another device")
+  {
+    auto const base = alloc.stats();
+    auto const t = at::ones({2}).new_zeros(
+      {kNumel}, at::TensorOptions().device(c10::kMeta));
+    CHECK(t.device() == c10::Device {c10::kMeta});
+    CHECK(t.numel() == kNumel);
+    CHECK(alloc.stats().zero_fill_elided_bytes
+          == base.zero_fill_elided_bytes);
+  }
+
+  SECTION("Without elision")
+  {
+    lbannv2::set_zero_fill_elision(false);
+    auto const base = alloc.stats();
+    auto const t = at::zeros({kNumel});
+    CHECK(all_zero(t));
+    CHECK(alloc.stats().zero_fill_elided_bytes
+          == base.zero_fill_elided_bytes);
+  }
+}
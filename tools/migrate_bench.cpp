@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+
+// Migrate a view-heavy set of tensors to a device and back with
+// migrate_many() and report what it cost: the allocations and bytes
+// registered with LBANNv2 while migrating (both of which should be
+// zero, since migration rebrands memory in place), and the time per
+// round trip, next to the time a deep copy of the same storage takes. Without a
+// coherent-memory domain (LBANNV2_COHERENT_MEMORY), the emulated one
+// is used.
+
+#include <lbannv2/memory/allocator.hpp>
+#include <lbannv2/memory/coherent_memory.hpp>
+#include <lbannv2/memory/registry.hpp>
+#include <lbannv2/ops/migrate.hpp>
+
+#include <ATen/ATen.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+void usage(char const* const argv0)
+{
+  std::cerr
+    << "Usage: " << argv0 << " [options]\n"
+    << "\n"
+    << "Options:\n"
+    << "  --storages=<n>  Number of parameter storages (default 64)\n"
+    << "  --views=<n>     Views of each storage (default 16)\n"
+    << "  --elems=<n>     Floats in each storage (default 1048576)\n"
+    << "  --iters=<n>     Round trips to time (default 20)\n";
+}
+
+size_t parse(char const* const arg, std::string_view const opt)
+{
+  return std::strtoull(arg + opt.size(), nullptr, 0);
+}
+
+// Views of every kind migrate must preserve: offsets, strided
+// slices, non-contiguous reshapes and dtype reinterpretation.
+void add_views(at::Tensor const& base,
+               size_t const num_views,
+               std::vector<at::Tensor>& out)
+{
+  auto const n = base.numel();
+  for (size_t v = 0; v < num_views; ++v)
+  {
+    auto const off = static_cast<int64_t>(v % 8) * (n / 16);
+    switch (v % 4)
+    {
+    case 0: out.push_back(base.narrow(0, off, n / 2)); break;
+    case 1: out.push_back(base.slice(0, off, n, 2 + v % 3)); break;
+    case 2: out.push_back(base.view({16, n / 16}).t()); break;
+    case 3: out.push_back(base.view(at::kInt).narrow(0, off, n / 4)); break;
+    }
+  }
+}
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point const start)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+    .count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  size_t num_storages = 64;
+  size_t num_views = 16;
+  size_t num_elems = 1UL << 20;
+  size_t iters = 20;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string_view const arg = argv[i];
+    if (arg.starts_with("--storages="))
+      num_storages = parse(argv[i], "--storages=");
+    else if (arg.starts_with("--views="))
+      num_views = parse(argv[i], "--views=");
+    else if (arg.starts_with("--elems="))
+      num_elems = parse(argv[i], "--elems=");
+    else if (arg.starts_with("--iters="))
+      iters = parse(argv[i], "--iters=");
+    else if (arg == "-h" || arg == "--help")
+    {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    }
+    else
+    {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (num_elems < 64 || num_elems % 16 != 0 || iters == 0)
+  {
+    std::cerr << argv[0] << ": --elems must be a multiple of 16 (>= 64) "
+              << "and --iters positive\n";
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    auto* domain = lbannv2::coherent_memory_domain();
+    if (!domain)
+    {
+      domain = &lbannv2::EmulatedCoherentMemory::instance();
+      lbannv2::set_coherent_memory_domain(domain);
+    }
+    c10::Device const cpu {c10::kCPU};
+    c10::Device const dev {domain->device_type(), domain->current_device()};
+
+    // The "model": each storage, then its views.
+    std::vector<at::Tensor> tensors;
+    lbannv2::use_coherent_host_allocator();
+    for (size_t s = 0; s < num_storages; ++s)
+    {
+      auto base = at::rand({static_cast<int64_t>(num_elems)});
+      tensors.push_back(base);
+      add_views(base, num_views, tensors);
+    }
+    lbannv2::use_torch_cpu_allocator();
+
+    size_t const storage_bytes = num_storages * num_elems * sizeof(float);
+    size_t view_bytes = 0;
+    for (auto const& t : tensors)
+      view_bytes += t.numel() * t.element_size();
+
+    // Deep copy baseline: what moving the storage would cost.
+    auto start = Clock::now();
+    for (size_t i = 0; i < iters; ++i)
+    {
+      for (size_t s = 0; s < num_storages; ++s)
+        (void) tensors[s * (num_views + 1)].clone();
+    }
+    double const copy_ms = ms_since(start) / iters;
+
+    auto& registry = lbannv2::pointer_registry();
+    auto const before = registry.stats().total;
+    size_t new_bytes = 0;
+    double to_dev_ms = 0., to_cpu_ms = 0.;
+    for (size_t i = 0; i < iters; ++i)
+    {
+      start = Clock::now();
+      auto on_dev = lbannv2::migrate_many(tensors, dev);
+      to_dev_ms += ms_since(start);
+
+      start = Clock::now();
+      tensors = lbannv2::migrate_many(on_dev, cpu);
+      to_cpu_ms += ms_since(start);
+
+      // Both round-trip results are alive here, so memory registered
+      // for either of them shows up as growth.
+      auto const now = registry.stats().total.current_bytes;
+      if (now > before.current_bytes + new_bytes)
+        new_bytes = now - before.current_bytes;
+    }
+    auto const after = registry.stats().total;
+    auto const allocations = after.total_allocations - before.total_allocations;
+
+    std::cout << "domain:               " << domain->name() << "\n"
+              << "device:               " << dev.str() << "\n"
+              << "storages:             " << num_storages << "\n"
+              << "tensors:              " << tensors.size() << "\n"
+              << "storage bytes:        " << storage_bytes << "\n"
+              << "bytes viewed:         " << view_bytes << "\n"
+              << "allocations:          " << allocations << "\n"
+              << "bytes registered:     " << new_bytes << "\n"
+              << "to device ms (mean):  " << to_dev_ms / iters << "\n"
+              << "to cpu ms (mean):     " << to_cpu_ms / iters << "\n"
+              << "deep copy ms (mean):  " << copy_ms << "\n";
+    return allocations == 0 && new_bytes == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
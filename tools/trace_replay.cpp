@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2014-2025 Lawrence Livermore National Security, LLC and other
+// LBANN Project Developers. See the top-level LICENSE file for details.
+//
+// SPDX-License-Identifier: Apache-2.0
+////////////////////////////////////////////////////////////////////////////////
+
+// Replay an allocation trace recorded with LBANNV2_ALLOC_TRACE (or
+// lbannv2.start_allocation_trace()) against a CPU allocator and
+// report how it fared.
+
+#include <lbannv2/memory/allocation_trace.hpp>
+#include <lbannv2/memory/arena_allocator.hpp>
+#include <lbannv2/memory/caching_host_allocator.hpp>
+#include <lbannv2/memory/huge_page_allocator.hpp>
+#include <lbannv2/memory/mmap_file_allocator.hpp>
+#include <lbannv2/memory/numa_allocator.hpp>
+#include <lbannv2/memory/policy_allocator.hpp>
+
+#include <c10/core/Allocator.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace
+{
+
+void usage(char const* const argv0)
+{
+  std::cerr
+    << "Usage: " << argv0 << " [options] <trace>\n"
+    << "\n"
+    << "Options:\n"
+    << "  --allocator=<name>  torch (default), caching, hugepage, numa,\n"
+    << "                      arena, mmap, or spec:<spec> for a policy\n"
+    << "                      stack (see LBANNV2_HOST_ALLOCATOR)\n"
+    << "  --no-touch          Do not write to allocated pages\n"
+    << "  --rss-interval=<n>  Sample the resident set every n events\n"
+    << "                      (default 64)\n";
+}
+
+// Owns the allocator when it is not a singleton.
+std::unique_ptr<c10::Allocator> owned;
+
+c10::Allocator& get_allocator(std::string_view const name)
+{
+  if (name == "torch")
+    return *c10::GetAllocator(c10::kCPU);
+  if (name == "caching")
+    return lbannv2::CachingHostAllocator::instance();
+  if (name == "hugepage")
+    return lbannv2::HugePageAllocator::instance();
+  if (name == "numa")
+    return lbannv2::NumaAllocator::instance();
+  if (name == "arena")
+    return lbannv2::ArenaAllocator::instance();
+  if (name == "mmap")
+    return lbannv2::MmapFileAllocator::instance();
+  if (name.starts_with("spec:"))
+  {
+    owned = lbannv2::make_policy_allocator(name.substr(5));
+    return *owned;
+  }
+  throw std::runtime_error("Unknown allocator \"" + std::string(name) + "\"");
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  std::string_view allocator = "torch";
+  std::string_view trace;
+  lbannv2::TraceReplayOptions opts;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string_view const arg = argv[i];
+    if (arg.starts_with("--allocator="))
+      allocator = arg.substr(std::strlen("--allocator="));
+    else if (arg == "--no-touch")
+      opts.touch = false;
+    else if (arg.starts_with("--rss-interval="))
+      opts.rss_interval =
+        std::strtoull(argv[i] + std::strlen("--rss-interval="), nullptr, 0);
+    else if (arg == "-h" || arg == "--help")
+    {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    }
+    else if (!arg.starts_with("-") && trace.empty())
+      trace = arg;
+    else
+    {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (trace.empty())
+  {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    auto const events = lbannv2::read_allocation_trace(std::string(trace));
+    auto& alloc = get_allocator(allocator);
+    auto const stats = lbannv2::replay_allocation_trace(events, alloc, opts);
+
+    auto const mean = [](double const total, size_t const count) {
+      return count ? total / double(count) : 0.;
+    };
+    std::cout << "trace:                " << trace << "\n"
+              << "allocator:            " << allocator << "\n"
+              << "events:               " << events.size() << "\n"
+              << "allocations:          " << stats.num_allocs << "\n"
+              << "frees:                " << stats.num_frees << "\n"
+              << "unmatched frees:      " << stats.num_unmatched_frees
+              << "\n"
+              << "migrations:           " << stats.num_migrates << "\n"
+              << "peak requested bytes: " << stats.peak_requested_bytes
+              << "\n"
+              << "peak RSS growth:      " << stats.peak_rss_bytes << "\n"
+              << "fragmentation:        " << stats.fragmentation() << "\n"
+              << "alloc ns (mean/max):  "
+              << mean(stats.alloc_ns_total, stats.num_allocs) << " / "
+              << stats.alloc_ns_max << "\n"
+              << "free ns (mean/max):   "
+              << mean(stats.free_ns_total, stats.num_frees) << " / "
+              << stats.free_ns_max << "\n";
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}